@@ -0,0 +1,61 @@
+#include "action_message.hpp"
+
+std::string ActionMessage::toString() const {
+    switch (code) {
+        case ActionMessageCode::None: return "";
+        case ActionMessageCode::GameStarted: return "Game started!";
+        case ActionMessageCode::NewRoundStarted: return "New round started!";
+        case ActionMessageCode::CardDrawn: return "Card drawn successfully.";
+        case ActionMessageCode::DiscardPileTaken: return "Discard pile taken successfully.";
+        case ActionMessageCode::MeldsProcessed: return "Melds processed successfully.";
+        case ActionMessageCode::WentOut: return "Player has gone out successfully.";
+        case ActionMessageCode::TurnOver: return "Turn over successfully.";
+        case ActionMessageCode::TurnReverted: return "Turn reverted successfully.";
+        case ActionMessageCode::RoundNotActive: return "Round not active.";
+        case ActionMessageCode::NotYourTurn: return "Not your turn.";
+        case ActionMessageCode::TooManyRequests: return "Too many requests.";
+        case ActionMessageCode::RoundNotInProgress: return "Not player's turn or round not in progress.";
+        case ActionMessageCode::AlreadyDrewFromDeck: return "You have already drawn from the deck.";
+        case ActionMessageCode::DrawAfterTakingPile:
+            return "You cannot draw from the deck after taking the discard pile.";
+        case ActionMessageCode::TakePileAfterDrawing:
+            return "You cannot take the discard pile after drawing from the deck.";
+        case ActionMessageCode::AlreadyTookPile: return "You have already taken the discard pile.";
+        case ActionMessageCode::MainDeckEmpty: return "Main deck is empty. Try taking the discard pile.";
+        case ActionMessageCode::MainDeckEmptyPileCantBeTaken: return "Main deck is empty. Discard pile can't be taken.";
+        case ActionMessageCode::MeldBeforeDrawing:
+            return "You must draw from the deck or take the discard pile before melding.";
+        case ActionMessageCode::MeldsAlreadyHandled: return "You have already handled melds this turn.";
+        case ActionMessageCode::NoMeldRequest: return "No meld request provided.";
+        case ActionMessageCode::MeldCardNotInHand:
+            return "Wrong meld request: card " + (card ? card->toString() : std::string("?")) + " not in hand";
+        case ActionMessageCode::BlackThreesBeforeThreshold:
+            return "Cannot form any meld containing Black Three cards before round's minimum point threshold was reached.";
+        case ActionMessageCode::SecondBlackThreeMeld: return "Cannot form more than one Black Three meld.";
+        case ActionMessageCode::NoInitialMeld: return "You must initialize at least one meld.";
+        case ActionMessageCode::InitialMeldPointsNotMet:
+            return "Your initial melds must have not less than " + std::to_string(number) + " points.";
+        case ActionMessageCode::BlackThreeMeldWithoutGoingOut:
+            return "You cannot initialize a Black Three meld without going out.";
+        case ActionMessageCode::AddWithoutInitialMelds: return "You cannot add to a meld without initial melds.";
+        case ActionMessageCode::CommitmentMeldMissing: return "Meld with rank " + to_string(rank) + " not found.";
+        case ActionMessageCode::CommitmentMeldTooSmall:
+            return "Meld with rank " + to_string(rank) + " must contain at least " + std::to_string(number) +
+                " cards with rank " + to_string(rank) + ".";
+        case ActionMessageCode::CommitmentCardNotAdded:
+            return "Card with rank " + to_string(rank) + " was not added to the existing meld.";
+        case ActionMessageCode::CommitmentAdditionTooSmall:
+            return "You should add to meld with rank " + to_string(rank) + " at least " + std::to_string(number) +
+                " cards with rank " + to_string(rank) + ".";
+        case ActionMessageCode::CannotGoOut: return "You cannot go out.";
+        case ActionMessageCode::DiscardBeforeDrawing:
+            return "You must draw from the deck or take the discard pile before discarding.";
+        case ActionMessageCode::DiscardNotInHand: return "You cannot discard a card that is not in your hand.";
+        case ActionMessageCode::DiscardBeforeMelding: return "You must handle melds before discarding.";
+        case ActionMessageCode::GoingOutRequirementsNotMet: return "You don't meet the requirements to go out.";
+        case ActionMessageCode::NothingToRevert:
+            return "You can only revert after taking the discard pile or handling melds.";
+        case ActionMessageCode::RuleViolation: return detail;
+    }
+    return "Unknown action message.";
+}
@@ -0,0 +1,115 @@
+#include "client/action_predictor.hpp"
+#include <optional>
+
+// Mirrors TurnManager::handleMelds on copies, so nothing has to be reverted on failure
+std::expected<bool, std::string> ActionPredictor::applyMelds(const std::vector<MeldRequest>& meldRequests,
+    Hand& hand, TeamRoundState& teamRoundState, int teamTotalScore) {
+    if (meldRequests.empty())
+        return std::unexpected("No meld request provided.");
+    for (const auto& request : meldRequests) {
+        for (const auto& card : request.getCards()) {
+            if (!hand.removeCard(card))
+                return std::unexpected("Wrong meld request: card " + card.toString() + " not in hand");
+        }
+    }
+    std::size_t cardsLeftInHandCount = hand.cardCount();
+    bool teamHasInitialRankMeld = teamRoundState.hasMadeInitialRankMeld();
+
+    std::vector<RankMeldProposal> initializationProposals;
+    std::vector<RankMeldProposal> additionProposals;
+    std::optional<BlackThreeMeldProposal> blackThreeProposal;
+    for (const auto& request : meldRequests) {
+        const auto& cards = request.getCards();
+        if (auto rank = request.getRank()) {
+            additionProposals.emplace_back(cards, *rank);
+            continue;
+        }
+        auto suggestedMeld = RuleEngine::suggestMeld(cards);
+        if (!suggestedMeld.has_value())
+            return std::unexpected(suggestedMeld.error());
+        if (suggestedMeld->getType() == CandidateMeldType::BlackThree) {
+            if (!teamHasInitialRankMeld)
+                return std::unexpected("Cannot form any meld containing Black Three cards before round's minimum point threshold was reached.");
+            if (blackThreeProposal.has_value())
+                return std::unexpected("Cannot form more than one Black Three meld.");
+            blackThreeProposal.emplace(cards);
+        } else {
+            initializationProposals.emplace_back(cards, suggestedMeld->getRank().value());
+        }
+    }
+
+    if (initializationProposals.empty() && !teamHasInitialRankMeld)
+        return std::unexpected("You must initialize at least one meld.");
+    auto initializationProofs = RuleEngine::validateRankMeldInitializationProposals(
+        initializationProposals, teamRoundState);
+    if (!initializationProofs.has_value())
+        return std::unexpected(initializationProofs.error());
+    if (!teamHasInitialRankMeld) {
+        auto validateStatus = RuleEngine::validatePointsForInitialMelds(
+            RuleEngine::calculateMeldPoints(initializationProofs.value()), teamTotalScore);
+        if (!validateStatus.has_value())
+            return std::unexpected("Your initial melds must have not less than " +
+                std::to_string(validateStatus.error()) + " points.");
+    }
+    if (!teamHasInitialRankMeld && !additionProposals.empty())
+        return std::unexpected("You cannot add to a meld without initial melds.");
+    auto additionProofs = RuleEngine::validateRankMeldAdditionProposals(additionProposals, teamRoundState);
+    if (!additionProofs.has_value())
+        return std::unexpected(additionProofs.error());
+
+    // A proof no longer holds once a proposal of the same rank changed the meld; check those cards again
+    for (std::size_t i = 0; i < initializationProposals.size(); ++i) {
+        const auto& cards = initializationProposals[i].getCards();
+        auto* meld = teamRoundState.getMeldForRank(initializationProposals[i].getRank());
+        MeldCheck proof = (*initializationProofs)[i];
+        if (!proof->holdsFor(*meld, cards))
+            proof = meld->checkInitialization(cards);
+        if (!proof.has_value())
+            return std::unexpected(proof.error());
+        meld->initialize(cards, proof.value());
+    }
+    for (std::size_t i = 0; i < additionProposals.size(); ++i) {
+        const auto& cards = additionProposals[i].getCards();
+        auto* meld = teamRoundState.getMeldForRank(additionProposals[i].getRank());
+        MeldCheck proof = (*additionProofs)[i];
+        if (!proof->holdsFor(*meld, cards))
+            proof = meld->checkCardsAddition(cards);
+        if (!proof.has_value())
+            return std::unexpected(proof.error());
+        meld->addCards(cards, proof.value());
+    }
+
+    bool canGoingOut = RuleEngine::canGoingOut(cardsLeftInHandCount, teamRoundState);
+    if (!canGoingOut && cardsLeftInHandCount == 0)
+        return std::unexpected("You cannot go out.");
+
+    if (blackThreeProposal.has_value()) {
+        if (!canGoingOut)
+            return std::unexpected("You cannot initialize a Black Three meld without going out.");
+        auto proof = RuleEngine::validateBlackThreeMeldInitializationProposal(
+            blackThreeProposal.value(), teamRoundState);
+        if (!proof.has_value())
+            return std::unexpected(proof.error());
+        teamRoundState.getBlackThreeMeld()->initialize(blackThreeProposal->getCards(), proof.value());
+    }
+    return canGoingOut && cardsLeftInHandCount == 0;
+}
+
+// Mirrors TurnManager::handleDiscard and ServerDeck::discardCard
+std::expected<bool, std::string> ActionPredictor::applyDiscard(const Card& cardToDiscard,
+    Hand& hand, ClientDeck& deck, const TeamRoundState& teamRoundState) {
+    if (!RuleEngine::canDiscard(hand, cardToDiscard))
+        return std::unexpected("You cannot discard a card that is not in your hand.");
+    bool wentOut = false;
+    if (hand.cardCount() == 1) {
+        if (!RuleEngine::canGoingOut(hand.cardCount(), teamRoundState))
+            return std::unexpected("You don't meet the requirements to go out.");
+        wentOut = true;
+    }
+    hand.removeCard(cardToDiscard);
+    CardType type = cardToDiscard.getType();
+    bool freezesPile = type == CardType::BlackThree || type == CardType::Wild;
+    deck = ClientDeck(deck.getMainDeckSize(), cardToDiscard, deck.getDiscardPileSize() + 1,
+        deck.isFrozen() || freezesPile);
+    return wentOut;
+}
@@ -0,0 +1,58 @@
+#include "client/board_state.hpp"
+
+std::optional<std::size_t> BoardState::getMeldIndexForRank(Rank rank) {
+    int rankInt = static_cast<int>(rank);
+    if (rankInt >= static_cast<int>(Rank::Four) && rankInt <= static_cast<int>(Rank::Ace)) {
+        // Rank::Four (4) maps to index 2, Rank::Ace (14) maps to index 12
+        return static_cast<std::size_t>(rankInt - static_cast<int>(Rank::Four) + RANK_MELD_OFFSET);
+    }
+    return std::nullopt; // Invalid rank for a standard meld
+}
+
+const Hand& BoardState::getMyHand() const {
+    static const Hand emptyHand;
+    return myHand ? *myHand : emptyHand;
+}
+
+void BoardState::setMyTeamMelds(const TeamRoundState& teamState) {
+    if (updateMeldViews(myTeamMelds, teamState))
+        myTeamMeldsRevision = nextRevision();
+}
+
+void BoardState::setOpponentTeamMelds(const TeamRoundState& teamState) {
+    if (updateMeldViews(opponentTeamMelds, teamState))
+        opponentTeamMeldsRevision = nextRevision();
+}
+
+void BoardState::setMyHand(const Hand& hand) {
+    // Compared with a copy: the caller may reuse the Hand last given for the new state
+    if (myHandRevision == 0 || myHandCards != hand.getCards()) {
+        myHandRevision = nextRevision();
+        myHandCards = hand.getCards();
+    }
+    myHand = &hand;
+}
+
+bool BoardState::updateMeldViews(std::vector<MeldView>& views, const TeamRoundState& teamState) {
+    const auto& melds = teamState.getMelds();
+    bool changed = views.size() != melds.size();
+    views.resize(melds.size());
+    for (std::size_t i = 0; i < melds.size(); ++i) {
+        // Index 0 and 1 hold the red and black threes, the rest map to Four..Ace
+        Rank rank = i < static_cast<std::size_t>(RANK_MELD_OFFSET) ? Rank::Three :
+            static_cast<Rank>(static_cast<int>(Rank::Four) + static_cast<int>(i) - RANK_MELD_OFFSET);
+        const auto& meld = melds[i];
+        MeldView view = meld->isInitialized() ?
+            MeldView(rank, meld->getWildCardsView(), meld->getNaturalCardsView(), true) :
+            MeldView(rank, {}, {}, false);
+        if (!(views[i] == view))
+            changed = true;
+        views[i] = view; // always re-point, the old storage is about to go away
+    }
+    return changed;
+}
+
+std::uint64_t BoardState::nextRevision() {
+    static std::uint64_t revision = 0;
+    return ++revision;
+}
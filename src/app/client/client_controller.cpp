@@ -1,19 +1,22 @@
 #include "client/client_controller.hpp"
 #include "client/client_network.hpp" // Already included via client_controller.hpp but good for clarity
-#include "client/game_view.hpp"     // Already included via client_controller.hpp
+#include "client/action_predictor.hpp"
 #include <functional>              // For std::bind / lambdas
 #include <iostream>                // For placeholder messages, to be replaced by GameView calls
 #include <string>                 // For std::string
+#include <stdexcept>              // For std::logic_error
+#include "spdlog/spdlog.h"
 
-ClientController::ClientController(std::shared_ptr<ClientNetwork> clientNetwork)
-    : network(clientNetwork), localPlayerName("") {
-    resetTurnActionStatuses();
+ClientController::ClientController(std::shared_ptr<ClientNetwork> clientNetwork,
+    std::unique_ptr<ClientFrontend> frontend, asio::any_io_executor uiExecutor)
+    : network(clientNetwork), localPlayerName(""), view(std::move(frontend)), uiExecutor(uiExecutor),
+      replySignal(uiExecutor, asio::steady_timer::time_point::max()), scoreTimer(uiExecutor) {
     setupNetworkCallbacks();
 }
 
 void ClientController::connect(const std::string& host, const std::string& port) {
     std::string playerNamePlaceholder = "Player"; // Default or last used name
-    localPlayerName = view.promptString("Enter your player name:", playerNamePlaceholder);
+    localPlayerName = view->promptString("Enter your player name:", playerNamePlaceholder);
 
     if (localPlayerName.empty())
         return;
@@ -22,70 +25,78 @@ void ClientController::connect(const std::string& host, const std::string& port)
 }
 
 void ClientController::setupNetworkCallbacks() {
-    network->setOnGameStateUpdate(
-        [this](const ClientGameState& gs) { this->handleGameStateUpdate(gs); });
-    network->setOnActionError(
-        [this](const ActionError& err) { this->handleActionError(err); });
-    network->setOnLoginSuccess(
-        [this]() { this->handleLoginSuccess(); });
-    network->setOnLoginFailure(
-        [this](const std::string& reason) { this->handleLoginFailure(reason); });
-    network->setOnDisconnect(
-        [this]() { this->handleDisconnect(); });
+    // Callbacks run on the network thread: they only hand the event over to the UI executor
+    network->setOnGameStateUpdate([this](ClientGameState gs) {
+        asio::post(uiExecutor, [this, gs = std::move(gs)]() mutable { handleGameStateUpdate(std::move(gs)); });
+    });
+    network->setOnActionError([this](const ActionError& err) {
+        asio::post(uiExecutor, [this, err] { handleActionError(err); });
+    });
+    network->setOnLoginSuccess([this]() {
+        asio::post(uiExecutor, [this] { handleLoginSuccess(); });
+    });
+    network->setOnLoginFailure([this](const std::string& reason) {
+        asio::post(uiExecutor, [this, reason] { handleLoginFailure(reason); });
+    });
+    network->setOnDisconnect([this]() {
+        asio::post(uiExecutor, [this] { handleDisconnect(); });
+    });
 }
 
-void ClientController::resetTurnActionStatuses() {
-    drawDeckAttemptStatus = ActionAttemptStatus::NotAttempted;
-    takeDiscardPileAttemptStatus = ActionAttemptStatus::NotAttempted;
-    meldAttemptStatus = ActionAttemptStatus::NotAttempted;
-    discardAttemptStatus = ActionAttemptStatus::NotAttempted;
+void ClientController::updateBoardState(const ClientGameState& gameState) {
+    const TeamRoundState& myTeamState = predictedState ? predictedState->teamState : gameState.getMyTeamState();
+    // Melds and hand only get a new revision when their content changed
+    currentBoardState.setMyTeamMelds(myTeamState);
+    currentBoardState.setOpponentTeamMelds(gameState.getOpponentTeamState());
+    currentBoardState.setMyHand(predictedState ? predictedState->hand : gameState.getMyHand());
+    currentBoardState.setDeckState(predictedState ? predictedState->deck : gameState.getDeckState());
+    const auto& allPlayersInfo = gameState.getAllPlayersPublicInfo();
+    currentBoardState.setMyPlayer(allPlayersInfo[0]); // Assuming the first player is the current player
+    if (allPlayersInfo.size() == TWO_PLAYERS_GAME) {
+        currentBoardState.setOppositePlayer(allPlayersInfo[1]); // Assuming the second player is the opponent
+    } else if (allPlayersInfo.size() == FOUR_PLAYERS_GAME) {
+        currentBoardState.setLeftPlayer(allPlayersInfo[1]); // Assuming the second player is the left player
+        currentBoardState.setOppositePlayer(allPlayersInfo[2]); // Assuming the third player is the opponent
+        currentBoardState.setRightPlayer(allPlayersInfo[3]); // Assuming the fourth player is the right player
+    }
+    currentBoardState.setMyTeamTotalScore(gameState.getMyTeamTotalScore());
+    currentBoardState.setOpponentTeamTotalScore(gameState.getOpponentTeamTotalScore());
+    currentBoardState.setMyTeamMeldPoints(myTeamState.calculateMeldPoints());
+    currentBoardState.setOpponentTeamMeldPoints(gameState.getOpponentTeamState().calculateMeldPoints());
 }
 
-std::vector<MeldView> ClientController::getMeldViewsFromTeamRoundState(const TeamRoundState& teamRoundState) const {
-    std::vector<MeldView> meldViews;
-    auto redThreeMeld = teamRoundState.getRedThreeMeld();
-    if (redThreeMeld->isInitialized())
-        meldViews.push_back({Rank::Three, redThreeMeld->getCards(), true});
-    else
-        meldViews.push_back({Rank::Three, {}, false});
-    auto blackThreeMeld = teamRoundState.getBlackThreeMeld();
-    if (blackThreeMeld->isInitialized())
-        meldViews.push_back({Rank::Three, blackThreeMeld->getCards(), true});
-    else
-        meldViews.push_back({Rank::Three, {}, false});
-    for (int r = static_cast<int>(Rank::Four); r <= static_cast<int>(Rank::Ace); ++r) {
-        auto rank = static_cast<Rank>(r);
-        auto meld = teamRoundState.getMeldForRank(rank);
-        if (meld->isInitialized())
-            meldViews.push_back({rank, meld->getCards(), true});
-        else
-            meldViews.push_back({rank, {}, false});
-    }
-    return meldViews;
+void ClientController::submitAction(ClientMessageType type, bool flowContinued, TurnPhase nextPhase,
+    TurnPhase rollbackPhase, std::function<void(RequestId)> send) {
+    pendingActions.push_back({nextRequestId++, type, flowContinued, nextPhase, rollbackPhase, std::move(send)});
+    sendNextAction();
 }
 
-BoardState ClientController::getBoardState(const ClientGameState& gameState) const {
-    BoardState boardState;
-    auto myTeamState = gameState.getMyTeamState().clone();
-    auto opponentTeamState = gameState.getOpponentTeamState().clone();
-    boardState.setMyTeamMelds(getMeldViewsFromTeamRoundState(myTeamState)); // wrong temporary
-    boardState.setOpponentTeamMelds(getMeldViewsFromTeamRoundState(opponentTeamState));
-    boardState.setMyHand(gameState.getMyPlayerData().getHand());
-    boardState.setDeckState(gameState.getDeckState());
-    auto allPlayersInfo = gameState.getAllPlayersPublicInfo();
-    boardState.setMyPlayer(allPlayersInfo[0]); // Assuming the first player is the current player
-    if (allPlayersInfo.size() == TWO_PLAYERS_GAME) {
-        boardState.setOppositePlayer(allPlayersInfo[1]); // Assuming the second player is the opponent
-    } else if (allPlayersInfo.size() == FOUR_PLAYERS_GAME) {
-        boardState.setLeftPlayer(allPlayersInfo[1]); // Assuming the second player is the left player
-        boardState.setOppositePlayer(allPlayersInfo[2]); // Assuming the third player is the opponent
-        boardState.setRightPlayer(allPlayersInfo[3]); // Assuming the fourth player is the right player
-    }
-    boardState.setMyTeamTotalScore(gameState.getMyTeamTotalScore());
-    boardState.setOpponentTeamTotalScore(gameState.getOpponentTeamTotalScore());
-    boardState.setMyTeamMeldPoints(myTeamState.calculateMeldPoints());
-    boardState.setOpponentTeamMeldPoints(opponentTeamState.calculateMeldPoints());
-    return boardState;
+void ClientController::sendNextAction() {
+    if (pendingActions.empty() || pendingActions.front().sent)
+        return;
+    auto& action = pendingActions.front();
+    action.sent = true;
+    action.send(action.requestId);
+}
+
+std::unique_ptr<ClientController::PredictedState> ClientController::makePrediction() const {
+    // Predictions stack: the next one starts from the one currently shown
+    if (predictedState)
+        return std::make_unique<PredictedState>(predictedState->hand,
+            predictedState->teamState.clone(), predictedState->deck);
+    return std::make_unique<PredictedState>(latestGameState.getMyHand(),
+        latestGameState.getMyTeamState().clone(), latestGameState.getDeckState());
+}
+
+void ClientController::showPrediction(std::unique_ptr<PredictedState> prediction) {
+    // The previous prediction stays alive until the board has been compared with and re-pointed to the new one
+    auto previousPrediction = std::exchange(predictedState, std::move(prediction));
+    updateBoardState(latestGameState);
+}
+
+void ClientController::dropPrediction() {
+    auto previousPrediction = std::move(predictedState);
+    updateBoardState(latestGameState);
 }
 
 ScoreState ClientController::getScoreState(const ClientGameState& gameState) const {
@@ -100,62 +111,88 @@ ScoreState ClientController::getScoreState(const ClientGameState& gameState) con
     return scoreState;
 }
 
-// --- Callback Handlers from ClientNetwork (Stubs) ---
-void ClientController::handleGameStateUpdate(const ClientGameState& gameState) {
+// --- Callback Handlers from ClientNetwork ---
+void ClientController::handleGameStateUpdate(ClientGameState newGameState) {
+    if (showingScore) {
+        statesAfterScore.push_back(std::move(newGameState)); // Shown once the score has had its time
+        return;
+    }
+    // The previous state stays alive until the board has been compared with and re-pointed to the new one
+    ClientGameState previousGameState = std::exchange(latestGameState, std::move(newGameState));
+    const ClientGameState& gameState = latestGameState;
     bool isMyTurn = gameState.getAllPlayersPublicInfo()[0].isCurrentPlayer();
-    currentBoardState = getBoardState(gameState);
-    auto status = gameState.getStatus();
-    if (isMyTurn &&
-        !status.has_value() || // Turn started
-        (status.has_value() && status.value() == TurnActionStatus::Success_TurnContinues)) {
-        processPlayerTurn();
-    } else {
-        resetTurnActionStatuses();
-        if (gameState.getIsRoundOver()) {
-            view.showStaticScore(getScoreState(gameState));
-            if (!gameState.getIsGameOver())
-                std::this_thread::sleep_for(std::chrono::seconds(SCORE_TIME));
-        }
-        else {
-            view.showStaticBoardWithMessages({gameState.getLastActionDescription()}, currentBoardState);
+    bool turnGoesOn = isMyTurn && !gameState.getIsRoundOver();
+
+    std::optional<PendingAction> confirmed;
+    if (gameState.getRequestId() != NO_REQUEST_ID) {
+        if (!pendingActions.empty() && pendingActions.front().requestId == gameState.getRequestId()) {
+            confirmed = std::move(pendingActions.front());
+            pendingActions.pop_front();
+            spdlog::debug("Request #{} confirmed", gameState.getRequestId());
+        } else {
+            spdlog::warn("State answers request #{} which is not awaiting a reply", gameState.getRequestId());
         }
     }
-}
+    if (!turnGoesOn)
+        pendingActions.clear(); // Nothing queued can apply once the turn is over
+    if (!pendingActions.empty()) {
+        // Keep showing the prediction and let the next queued action go
+        updateBoardState(gameState);
+        return sendNextAction();
+    }
+    bool flowContinued = confirmed && confirmed->flowContinued;
+    if (flowContinued && turnGoesOn && predictedState &&
+        predictedState->hand.getCards() != gameState.getMyHand().getCards())
+        spdlog::warn("Predicted hand differs from the server state, showing the server state.");
+    dropPrediction(); // The server state now includes every predicted action
 
-void ClientController::handleActionError(const ActionError& error) {
-    if (!error.getStatus().has_value()) {
-        // Should not happen
-        throw std::runtime_error("ActionError without status.");    
+    if (turnGoesOn) {
+        if (!turnActive)
+            startTurn(); // The server has just given the player the turn
+        else if (confirmed && !flowContinued)
+            resumeTurn({confirmed->nextPhase});
+        // Otherwise the player has already moved on from this state
+        return;
     }
-    if (drawDeckAttemptStatus == ActionAttemptStatus::Attempting) {
-        drawDeckAttemptStatus = ActionAttemptStatus::NotAttempted;
-    } else if (takeDiscardPileAttemptStatus == ActionAttemptStatus::Attempting) {
-        takeDiscardPileAttemptStatus = ActionAttemptStatus::NotAttempted;
-    } else if (meldAttemptStatus == ActionAttemptStatus::Attempting) {
-        meldAttemptStatus = ActionAttemptStatus::NotAttempted;
-    } else if (discardAttemptStatus == ActionAttemptStatus::Attempting) {
-        discardAttemptStatus = ActionAttemptStatus::NotAttempted;
-    } else {
-        throw std::runtime_error("ActionError occurred but no action was in progress.");
+    if (turnActive)
+        resumeTurn({TurnPhase::Over});
+    if (gameState.getIsRoundOver()) {
+        view->showStaticScore(getScoreState(gameState));
+        if (!gameState.getIsGameOver()) {
+            // Network events keep being handled while the score is shown; the next states wait for it
+            showingScore = true;
+            asio::co_spawn(uiExecutor, holdScore(view->getScoreDisplayTime()), [](std::exception_ptr e) {
+                if (e)
+                    std::rethrow_exception(e);
+            });
+        } else if (view->shouldLeaveAfterGame())
+            network->disconnect();
+    }
+    else {
+        view->showStaticBoardWithMessages({gameState.getLastAction().toString()}, currentBoardState);
     }
+}
 
-    view.restoreInput();
-    if (meldAttemptStatus == ActionAttemptStatus::Succeeded) {
-        return processAfterMelding(error.getMessage());
-    } else if (takeDiscardPileAttemptStatus == ActionAttemptStatus::Succeeded) {
-        return processAfterTakingDiscardPile(error.getMessage());
-    } else if (drawDeckAttemptStatus == ActionAttemptStatus::Succeeded) {
-        return processAfterDrawing(error.getMessage());
-    } else if (discardAttemptStatus == ActionAttemptStatus::Succeeded) {
-        throw std::runtime_error("Discard attempt status should not be succeeded here.");
-    } else if (drawDeckAttemptStatus == ActionAttemptStatus::NotAttempted && 
-                takeDiscardPileAttemptStatus == ActionAttemptStatus::NotAttempted) {
-        return promptAndProcessDrawCardOrTakeDiscardPile(error.getMessage());
+void ClientController::handleActionError(const ActionError& error) {
+    // Actions shed by the server (rate limited, out of turn) come without a status; they are retried alike
+    if (pendingActions.empty() || pendingActions.front().requestId != error.getRequestId()) {
+        spdlog::warn("Ignoring error for request #{} which is not awaiting a reply: {}",
+            error.getRequestId(), error.getMessage().toString());
+        return;
     }
+    PendingAction rejected = std::move(pendingActions.front());
+    // Actions queued behind the rejected one were chosen on top of its prediction
+    pendingActions.clear();
+    spdlog::debug("Request #{} rejected: {}", rejected.requestId, error.getMessage().toString());
+    dropPrediction(); // Roll the board back to the latest confirmed state
+
+    if (turnActive)
+        resumeTurn({rejected.rollbackPhase, error.getMessage().toString(), false,
+            error.getMessage().getCode() == ActionMessageCode::TooManyRequests});
 }
 
 void ClientController::handleLoginSuccess() {
-    resetTurnActionStatuses(); // Good place to ensure fresh start
+    spdlog::debug("Logged in as '{}'", localPlayerName);
 }
 
 void ClientController::handleLoginFailure(const std::string& reason) {
@@ -165,73 +202,124 @@ void ClientController::handleLoginFailure(const std::string& reason) {
 
 void ClientController::handleDisconnect() {
     std::cout << "[ClientController] Disconnected from server." << std::endl; // Placeholder
-    resetTurnActionStatuses(); // Reset statuses
+    pendingActions.clear();
+    if (turnActive)
+        resumeTurn({TurnPhase::Over});
+}
+
+// --- Turn Flow ---
+void ClientController::startTurn() {
+    turnActive = true;
+    // Errors in the turn propagate out of the UI executor's run()
+    asio::co_spawn(uiExecutor, playTurn(), [](std::exception_ptr e) {
+        if (e)
+            std::rethrow_exception(e);
+    });
+}
+
+asio::awaitable<void> ClientController::playTurn() {
+    TurnStep step{TurnPhase::Start};
+    while (step.phase != TurnPhase::Over) {
+        if (step.backOff) {
+            // Give the server's rate limit time to refill, unless the turn ends meanwhile
+            if (auto reply = co_await awaitReply(std::chrono::steady_clock::now() + SHED_RETRY_DELAY))
+                step = std::move(*reply);
+            step.backOff = false;
+            continue;
+        }
+        step = takeStep(step.phase, std::move(step.message));
+        if (step.awaitsReply)
+            step = std::move(*co_await awaitReply());
+    }
+}
+
+asio::awaitable<void> ClientController::holdScore(std::chrono::steady_clock::duration displayTime) {
+    scoreTimer.expires_after(displayTime);
+    asio::error_code error;
+    co_await scoreTimer.async_wait(asio::redirect_error(asio::use_awaitable, error));
+    showingScore = false;
+    // In order, until one of them shows a score again and holds the rest
+    while (!statesAfterScore.empty() && !showingScore) {
+        ClientGameState gameState = std::move(statesAfterScore.front());
+        statesAfterScore.pop_front();
+        handleGameStateUpdate(std::move(gameState));
+    }
 }
 
-// --- Internal Game Logic (Stubs) ---
-void ClientController::processPlayerTurn(std::optional<const std::string> message) {
-    view.restoreInput();
-    if (drawDeckAttemptStatus == ActionAttemptStatus::Attempting) {
-        drawDeckAttemptStatus = ActionAttemptStatus::Succeeded; // Assuming draw was successful
-        return processAfterDrawing(message);
-    } else if (takeDiscardPileAttemptStatus == ActionAttemptStatus::Attempting) {
-        takeDiscardPileAttemptStatus = ActionAttemptStatus::Succeeded; // Assuming take was successful
-        return processAfterTakingDiscardPile(message);
-    } else if (meldAttemptStatus == ActionAttemptStatus::Attempting) {
-        meldAttemptStatus = ActionAttemptStatus::Succeeded; // Assuming meld was successful
-        return processAfterMelding(message);
-    } else if (discardAttemptStatus == ActionAttemptStatus::Attempting) { // Should not happen
-        discardAttemptStatus = ActionAttemptStatus::Succeeded;
-        throw std::runtime_error("Discard attempt status should not be attempting here.");
-    } else if (drawDeckAttemptStatus == ActionAttemptStatus::Succeeded) { // After reset
-        return processAfterDrawing(message);
-    } else if (drawDeckAttemptStatus == ActionAttemptStatus::NotAttempted && 
-                takeDiscardPileAttemptStatus == ActionAttemptStatus::NotAttempted) {
-        return promptAndProcessDrawCardOrTakeDiscardPile(message);
+asio::awaitable<std::optional<ClientController::TurnStep>> ClientController::awaitReply(
+    asio::steady_timer::time_point deadline) {
+    replySignal.expires_at(deadline);
+    while (!turnReply) {
+        asio::error_code error;
+        co_await replySignal.async_wait(asio::redirect_error(asio::use_awaitable, error));
+        if (!error)
+            break; // Deadline passed
     }
+    replySignal.expires_at(asio::steady_timer::time_point::max());
+    co_return std::exchange(turnReply, std::nullopt);
 }
 
-void ClientController::promptAndProcessDrawCardOrTakeDiscardPile
+void ClientController::resumeTurn(TurnStep step) {
+    if (step.phase == TurnPhase::Over)
+        turnActive = false; // A turn the next state gives the player is a new one
+    turnReply = std::move(step);
+    replySignal.cancel(); // The turn takes the step when it next waits
+}
+
+ClientController::TurnStep ClientController::takeStep(TurnPhase phase, std::optional<const std::string> message) {
+    switch (phase) {
+        case TurnPhase::Start:
+            return promptAndProcessDrawCardOrTakeDiscardPile(message);
+        case TurnPhase::AfterDrawing:
+            return processAfterDrawing(message);
+        case TurnPhase::AfterTakingDiscardPile:
+            return processAfterTakingDiscardPile(message);
+        case TurnPhase::AfterMelding:
+            return processAfterMelding(message);
+        case TurnPhase::Over:
+            break;
+    }
+    throw std::logic_error("No step to take once the turn is over");
+}
+
+ClientController::TurnStep ClientController::promptAndProcessDrawCardOrTakeDiscardPile
     (std::optional<const std::string> message) {
-    auto choise = view.promptChoiceWithBoard(
-        "Choose an action:", {"Draw a card from deck", "Take discard pile"}, currentBoardState, message);
-    if (choise == 0) { // Draw from deck
-        drawDeckAttemptStatus = ActionAttemptStatus::Attempting;
-        network->sendDrawDeck();
+    auto action = view->promptTurnAction(
+        {TurnAction::DrawDeck, TurnAction::TakeDiscardPile}, currentBoardState, message);
+    if (action == TurnAction::DrawDeck) {
+        submitAction(ClientMessageType::DrawDeck, false, TurnPhase::AfterDrawing, TurnPhase::Start,
+            [this](RequestId requestId) { network->sendDrawDeck(requestId); });
     } else {
-        takeDiscardPileAttemptStatus = ActionAttemptStatus::Attempting;
-        network->sendTakeDiscardPile();
+        submitAction(ClientMessageType::TakeDiscardPile, false, TurnPhase::AfterTakingDiscardPile, TurnPhase::Start,
+            [this](RequestId requestId) { network->sendTakeDiscardPile(requestId); });
     }
+    return {TurnPhase::Start, std::nullopt, true};
 }
 
-void ClientController::processAfterDrawing(std::optional<const std::string> message) {
-    auto choice = view.promptChoiceWithBoard(
-        "Choose an action:", {"Melding", "Discard a card"}, currentBoardState, message);
-    if (choice == 0) { // Melding
-        processMelding(drawDeckAttemptStatus);
-    } else { // Discard
-        processDiscard();
+ClientController::TurnStep ClientController::processAfterDrawing(std::optional<const std::string> message) {
+    auto action = view->promptTurnAction({TurnAction::Meld, TurnAction::Discard}, currentBoardState, message);
+    if (action == TurnAction::Meld) {
+        return processMelding(TurnPhase::AfterDrawing);
+    } else {
+        return processDiscard(TurnPhase::AfterDrawing);
     }
 }
 
-void ClientController::processAfterTakingDiscardPile(std::optional<const std::string> message) {
-    auto choice = view.promptChoiceWithBoard(
-        "Choose an action:", {"Melding", "Revert"}, currentBoardState, message);
-    if (choice == 0) { // Melding
-        processMelding(takeDiscardPileAttemptStatus);
-    } else { // Discard
-        processRevert();
+ClientController::TurnStep ClientController::processAfterTakingDiscardPile(std::optional<const std::string> message) {
+    auto action = view->promptTurnAction({TurnAction::Meld, TurnAction::Revert}, currentBoardState, message);
+    if (action == TurnAction::Meld) {
+        return processMelding(TurnPhase::AfterTakingDiscardPile);
+    } else {
+        return processRevert(TurnPhase::AfterTakingDiscardPile);
     }
 }
 
-void ClientController::processMelding(ActionAttemptStatus& previousAttemptStatus) {
-    std::vector<MeldRequest> meldRequests = view.runMeldWizard(currentBoardState);
-    if (meldRequests.empty()){
-        previousAttemptStatus = ActionAttemptStatus::Attempting;
-        return processPlayerTurn(); // Go back
-    }
-    
-    auto myTeamMelds = currentBoardState.getMyTeamMelds();
+ClientController::TurnStep ClientController::processMelding(TurnPhase phase) {
+    std::vector<MeldRequest> meldRequests = view->runMeldWizard(currentBoardState);
+    if (meldRequests.empty())
+        return {phase}; // Go back
+
+    const auto& myTeamMelds = currentBoardState.getMyTeamMelds();
     for (auto& meldRequest : meldRequests) {
         auto meldRequestRank = meldRequest.getRank();
         if (meldRequestRank.has_value() && meldRequestRank.value() >= Rank::Four) {
@@ -241,29 +329,51 @@ void ClientController::processMelding(ActionAttemptStatus& previousAttemptStatus
         }
     }
 
-    meldAttemptStatus = ActionAttemptStatus::Attempting;
-    network->sendMeld(meldRequests);
+    auto prediction = makePrediction();
+    auto wentOut = ActionPredictor::applyMelds(meldRequests, prediction->hand, prediction->teamState,
+        currentBoardState.getMyTeamTotalScore());
+    if (!wentOut.has_value())
+        return {phase, wentOut.error()}; // The server would reject the melds the same way, no need to ask it
+    showPrediction(std::move(prediction));
+    auto sendMeld = [this, meldRequests](RequestId requestId) { network->sendMeld(requestId, meldRequests); };
+    if (wentOut.value()) {
+        // Going out ends the round: wait for the server to score it
+        submitAction(ClientMessageType::Meld, false, TurnPhase::Over, phase, std::move(sendMeld));
+        view->showStaticBoardWithMessages({"Going out..."}, currentBoardState);
+        return {phase, std::nullopt, true};
+    }
+    // The turn goes on from the prediction; a rejection brings it back to this phase
+    submitAction(ClientMessageType::Meld, true, TurnPhase::AfterMelding, phase, std::move(sendMeld));
+    return {TurnPhase::AfterMelding};
 }
 
-void ClientController::processAfterMelding(std::optional<const std::string> message) {
-    auto choice = view.promptChoiceWithBoard(
-        "Choose an action:", {"Discard a card", "Revert"}, currentBoardState, message);
-    if (choice == 0) { // Discard
-        processDiscard();
-    } else { // Revert
-        processRevert();
+ClientController::TurnStep ClientController::processAfterMelding(std::optional<const std::string> message) {
+    auto action = view->promptTurnAction({TurnAction::Discard, TurnAction::Revert}, currentBoardState, message);
+    if (action == TurnAction::Discard) {
+        return processDiscard(TurnPhase::AfterMelding);
+    } else {
+        return processRevert(TurnPhase::AfterMelding);
     }
 }
 
-void ClientController::processDiscard() {
-    Card cardToDiscard = view.runDiscardWizard(currentBoardState);
-    discardAttemptStatus = ActionAttemptStatus::Attempting;
-    network->sendDiscard(cardToDiscard);
+ClientController::TurnStep ClientController::processDiscard(TurnPhase phase) {
+    Card cardToDiscard = view->runDiscardWizard(currentBoardState);
+    auto prediction = makePrediction();
+    auto wentOut = ActionPredictor::applyDiscard(cardToDiscard, prediction->hand, prediction->deck,
+        prediction->teamState);
+    if (!wentOut.has_value())
+        return {phase, wentOut.error()};
+    showPrediction(std::move(prediction));
+    submitAction(ClientMessageType::Discard, false, TurnPhase::Over, phase,
+        [this, cardToDiscard](RequestId requestId) { network->sendDiscard(requestId, cardToDiscard); });
+    view->showStaticBoardWithMessages({wentOut.value() ? "Going out..." :
+        "Discarded " + cardToDiscard.toString()}, currentBoardState);
+    return {phase, std::nullopt, true};
 }
 
-void ClientController::processRevert() {
-    takeDiscardPileAttemptStatus = ActionAttemptStatus::NotAttempted;
-    meldAttemptStatus = ActionAttemptStatus::NotAttempted;
-    discardAttemptStatus = ActionAttemptStatus::NotAttempted;
-    network->sendRevert();
-}
\ No newline at end of file
+ClientController::TurnStep ClientController::processRevert(TurnPhase phase) {
+    // If a meld it follows is rejected, the revert is dropped and the turn resumes from the step before the meld
+    submitAction(ClientMessageType::Revert, false, TurnPhase::Start, phase,
+        [this](RequestId requestId) { network->sendRevert(requestId); });
+    return {phase, std::nullopt, true};
+}
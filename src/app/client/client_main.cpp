@@ -3,11 +3,15 @@
 #include <asio.hpp>
 #include <sstream>
 #include <algorithm>
+#include <exception>
+#include <thread>
 #include "game_state.hpp"
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "client/client_network.hpp"
 #include "client/client_controller.hpp"
+#include "client/game_view.hpp"
+#include "client/headless_view.hpp"
 
 // Constants
 constexpr int SERVER_PORT = 12345;
@@ -20,24 +24,76 @@ void configureLogger() {
 }
 
 
+// Usage: canasta_client <player index> [--headless[=stdin]] [--name <name>] [--wire=binary]
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         spdlog::error("Player index not specified!");
         return 1;
     }
 
+    std::optional<HeadlessMode> headlessMode;
+    std::string playerName;
+    WireFormat wireFormat = WireFormat::Compact;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            headlessMode = HeadlessMode::Policy;
+        else if (arg == "--headless=stdin")
+            headlessMode = HeadlessMode::Stdin;
+        else if (arg == "--name" && i + 1 < argc)
+            playerName = argv[++i];
+        else if (arg == "--wire=binary")
+            wireFormat = WireFormat::Binary;
+        else {
+            spdlog::error("Unknown argument: {}", arg);
+            return 1;
+        }
+    }
+    // Scripted players need distinct names without being asked
+    if (headlessMode == HeadlessMode::Policy && playerName.empty())
+        playerName = "Bot" + std::string(argv[1]);
+
     try {
         configureLogger(); // Configure the logger
 
+        // The network runs on its own thread so the connection keeps being served while the
+        // player thinks; the front-end and the game flow run on this one
         asio::io_context ioContext;
+        asio::io_context uiContext;
+        auto uiWork = asio::make_work_guard(uiContext); // Released once the connection has ended
 
         // Connect to the server
         auto clientNetwork = std::make_shared<ClientNetwork>(ioContext);
+        clientNetwork->setWireFormat(wireFormat);
 
-        auto clientController = std::make_shared<ClientController>(clientNetwork);
+        std::unique_ptr<ClientFrontend> frontend;
+        if (headlessMode)
+            frontend = std::make_unique<HeadlessView>(*headlessMode, playerName);
+        else
+            frontend = std::make_unique<GameView>();
+        auto clientController = std::make_shared<ClientController>(clientNetwork, std::move(frontend),
+            uiContext.get_executor());
         clientController->connect("127.0.0.1", std::to_string(SERVER_PORT));
 
-        ioContext.run();
+        std::exception_ptr networkError;
+        std::thread networkThread([&] {
+            try {
+                ioContext.run();
+            } catch (...) {
+                networkError = std::current_exception();
+            }
+            uiWork.reset(); // The events already posted are still handled
+        });
+        try {
+            uiContext.run();
+        } catch (...) {
+            ioContext.stop();
+            networkThread.join();
+            throw;
+        }
+        networkThread.join();
+        if (networkError)
+            std::rethrow_exception(networkError);
     } catch (const std::exception& e) {
         spdlog::error("Error: {}", e.what());
         return 1;
@@ -1,9 +1,8 @@
 #include "client/client_network.hpp"
 #include "spdlog/spdlog.h"
 
-#include <sstream>
+#include <istream>
 #include <vector>
-#include <cstring> // For std::memcpy
 
 
 // --- ClientNetwork Implementation ---
@@ -13,7 +12,7 @@ ClientNetwork::ClientNetwork(asio::io_context& ioCtx)
         socket(ioCtx),
         resolver(ioCtx),
         connected(false),
-        incomingMsgSize(0)
+        writeSignal(ioCtx, asio::steady_timer::time_point::max())
 {
     spdlog::debug("ClientNetwork created.");
 }
@@ -34,17 +33,19 @@ void ClientNetwork::connect(const std::string& host, const std::string& port, co
         return;
     }
     //spdlog::debug("Attempting to connect to {}:{} as '{}'", host, port, playerName);
-    // Start the asynchronous resolve operation.
-    doResolve(host, port, playerName);
+    // The coroutine keeps this object alive until the connection ends
+    asio::co_spawn(ioContext, [self = shared_from_this(), host, port, playerName] {
+        return self->run(host, port, playerName);
+    }, asio::detached);
 }
 
 void ClientNetwork::disconnect() {
-    if (!isConnected()) {
+    // Called from the UI thread as well; only the first call closes the socket
+    if (!connected.exchange(false)) {
         spdlog::warn("disconnect() called but not connected.");
         return;
     }
     spdlog::info("Disconnecting from server...");
-    connected = false; // Mark as disconnected immediately
 
     // Post the socket closure to the io_context to ensure it happens
     // within the ASIO event loop, preventing race conditions.
@@ -60,6 +61,7 @@ void ClientNetwork::disconnect() {
         if (ec) {
             spdlog::error("Socket close error: {}", ec.message());
         }
+        writeSignal.cancel(); // Lets the write loop see the socket is closed
         spdlog::info("Socket closed.");
         // Notify the application layer about the disconnection.
         invokeDisconnectCallback("Disconnected by client request");
@@ -72,31 +74,35 @@ bool ClientNetwork::isConnected() const {
     return connected && socket.is_open();
 }
 
+void ClientNetwork::setWireFormat(WireFormat format) {
+    requestedWireFormat = format;
+}
+
 // --- Sending Actions ---
 
-void ClientNetwork::sendDrawDeck() {
-    spdlog::debug("Queueing DrawDeck request.");
-    queueMessage(ClientMessageType::DrawDeck);
+void ClientNetwork::sendDrawDeck(RequestId requestId) {
+    spdlog::debug("Queueing DrawDeck request #{}.", requestId);
+    queueMessage(ClientMessageType::DrawDeck, requestId);
 }
 
-void ClientNetwork::sendTakeDiscardPile() {
-    spdlog::debug("Queueing TakeDiscardPile request.");
-    queueMessage(ClientMessageType::TakeDiscardPile);
+void ClientNetwork::sendTakeDiscardPile(RequestId requestId) {
+    spdlog::debug("Queueing TakeDiscardPile request #{}.", requestId);
+    queueMessage(ClientMessageType::TakeDiscardPile, requestId);
 }
 
-void ClientNetwork::sendMeld(std::vector<MeldRequest> requests) {
-    spdlog::debug("Queueing Meld request.");
-    queueMessage(ClientMessageType::Meld, requests);
+void ClientNetwork::sendMeld(RequestId requestId, std::vector<MeldRequest> requests) {
+    spdlog::debug("Queueing Meld request #{}.", requestId);
+    queueMessage(ClientMessageType::Meld, requestId, requests);
 }
 
-void ClientNetwork::sendDiscard(Card card) {
-    spdlog::debug("Queueing Discard request for card: {}", card.toString());
-    queueMessage(ClientMessageType::Discard, card);
+void ClientNetwork::sendDiscard(RequestId requestId, Card card) {
+    spdlog::debug("Queueing Discard request #{} for card: {}", requestId, card.toString());
+    queueMessage(ClientMessageType::Discard, requestId, card);
 }
 
-void ClientNetwork::sendRevert() {
-    spdlog::debug("Queueing Revert request.");
-    queueMessage(ClientMessageType::Revert);
+void ClientNetwork::sendRevert(RequestId requestId) {
+    spdlog::debug("Queueing Revert request #{}.", requestId);
+    queueMessage(ClientMessageType::Revert, requestId);
 }
 
 // --- Setting Callbacks ---
@@ -121,220 +127,175 @@ void ClientNetwork::setOnDisconnect(VoidCallback callback) {
     onDisconnectCallback = std::move(callback);
 }
 
-// --- Internal ASIO Handlers ---
-
-void ClientNetwork::doResolve(const std::string& host, const std::string& port, const std::string& playerName) {
-    // Start asynchronous resolve operation
-    resolver.async_resolve(host, port,
-        [this, self = shared_from_this(), playerName](const asio::error_code& ec, const asio::ip::tcp::resolver::results_type& endpoints) {
-            handleResolve(ec, endpoints, playerName);
-        });
-}
+// --- Internal ASIO Coroutines ---
 
-void ClientNetwork::handleResolve(const asio::error_code& ec, const asio::ip::tcp::resolver::results_type& endpoints, const std::string& playerName) {
-    if (!ec) {
-        spdlog::debug("Resolve successful.");
-        // Resolve successful, attempt to connect to the first endpoint.
-        doConnect(endpoints, playerName);
-    } else {
+asio::awaitable<void> ClientNetwork::run(std::string host, std::string port, std::string playerName) {
+    asio::error_code ec;
+    auto endpoints = co_await resolver.async_resolve(host, port, asio::redirect_error(asio::use_awaitable, ec));
+    if (ec) {
         spdlog::error("Resolve failed: {}", ec.message());
         // Handle resolve error (e.g., notify UI)
         invokeDisconnectCallback("Resolve failed: " + ec.message());
+        co_return;
     }
-}
-
-void ClientNetwork::doConnect(const asio::ip::tcp::resolver::results_type& endpoints, const std::string& playerName) {
-    // Start asynchronous connect operation
-    asio::async_connect(socket, endpoints,
-        [this, self = shared_from_this(), playerName](const asio::error_code& ec, const asio::ip::tcp::endpoint& /*endpoint*/) {
-            handleConnect(ec, playerName);
-        });
-}
-
-void ClientNetwork::handleConnect(const asio::error_code& ec, const std::string& playerName) {
-    if (!ec) {
-        //spdlog::debug("Connection successful");
-        connected = true; // Mark as connected
-        clientPlayerName = playerName; // Store player name
-
-        // Connection successful, send the login message
-        sendLogin(playerName);
-
-        // Start reading messages from the server
-        doReadHeader();
-    } else {
-        spdlog::error("Connect failed: {}", ec.message());
+    spdlog::debug("Resolve successful.");
+
+    // Try the endpoints in turn, giving up on all of them after CONNECT_TIMEOUT
+    co_await asio::async_connect(socket, endpoints,
+        asio::cancel_after(CONNECT_TIMEOUT, asio::redirect_error(asio::use_awaitable, ec)));
+    if (ec) {
+        std::string reason = ec == asio::error::operation_aborted ? "timed out" : ec.message();
+        spdlog::error("Connect failed: {}", reason);
         connected = false; // Ensure disconnected state
         // Handle connection error (e.g., notify UI)
-        invokeDisconnectCallback("Connect failed: " + ec.message());
+        invokeDisconnectCallback("Connect failed: " + reason);
         // Clean up socket if connection failed
-        asio::error_code close_ec;
-        socket.close(close_ec);
+        asio::error_code closeEc;
+        socket.close(closeEc);
+        co_return;
     }
+    connected = true; // Mark as connected
+    clientPlayerName = playerName; // Store player name
+    socket.set_option(asio::ip::tcp::no_delay(true), ec); // Actions are small and sent one at a time
+
+    asio::co_spawn(ioContext, [self = shared_from_this()] { return self->writeLoop(); }, asio::detached);
+    // Connection successful, send the login message
+    sendLogin(playerName);
+    // Read messages from the server until the connection ends
+    co_await readLoop();
 }
 
 void ClientNetwork::sendLogin(const std::string& playerName) {
     spdlog::debug("Sending Login message for player '{}'", playerName);
-    queueMessage(ClientMessageType::Login, playerName);
-}
-
-
-void ClientNetwork::doReadHeader() {
-    if (!isConnected()) return; // Don't read if not connected
-
-    readMsgBuffer.resize(sizeof(std::uint32_t)); // Prepare buffer for 4-byte size header
-    asio::async_read(socket, asio::buffer(readMsgBuffer),
-        [this, self = shared_from_this()](const asio::error_code& error, std::size_t bytes_transferred) {
-            handleReadHeader(error, bytes_transferred);
-        });
-}
-
-void ClientNetwork::handleReadHeader(const asio::error_code& error, std::size_t /*bytes_transferred*/) {
-    if (!isConnected()) return; // Check connection status again
-
-    if (!error) {
-        // Copy header data and convert from network to host byte order
-        std::memcpy(&incomingMsgSize, readMsgBuffer.data(), sizeof(std::uint32_t));
-        incomingMsgSize = asio::detail::socket_ops::network_to_host_long(incomingMsgSize);
-
-        // Basic sanity check for message size
-        if (incomingMsgSize > MAX_MESSAGE_SIZE) { // Example limit: 64k
-            spdlog::error("Error: Incoming message size too large ({})", incomingMsgSize);
-            disconnect(); // Disconnect on potentially malicious message
-            return;
-        }
-        // Proceed to read the message body
-        doReadBody();
-    } else {
-        if (error == asio::error::eof) {
-            spdlog::info("Server closed the connection (EOF).");
-            invokeDisconnectCallback("Server closed connection");
-        } else if (error != asio::error::operation_aborted) {
-            spdlog::error("Error reading header: {}", error.message());
-            invokeDisconnectCallback("Read header error: " + error.message());
-        } else {
-            spdlog::debug("Read header operation aborted (likely during disconnect).");
-        }
-        // If an error occurred (EOF or other), ensure we are marked as disconnected
-        if (connected) { // Avoid calling disconnect if already called
-            disconnect();
+    // Always binary: the format asked for applies to the messages after the LoginSuccess
+    queueMessage(ClientMessageType::Login, NO_REQUEST_ID, playerName, requestedWireFormat);
+}
+
+asio::awaitable<void> ClientNetwork::readLoop() {
+    while (isConnected()) {
+        asio::error_code error;
+        std::size_t bytesRead = co_await socket.async_read_some(reader.prepare(),
+            asio::redirect_error(asio::use_awaitable, error));
+        if (!isConnected()) co_return; // Check connection status again
+
+        if (error) {
+            if (error == asio::error::eof) {
+                spdlog::info("Server closed the connection (EOF).");
+                invokeDisconnectCallback("Server closed connection");
+            } else if (error != asio::error::operation_aborted) {
+                spdlog::error("Error reading: {}", error.message());
+                invokeDisconnectCallback("Read error: " + error.message());
+            } else {
+                spdlog::debug("Read operation aborted (likely during disconnect).");
+            }
+            // If an error occurred (EOF or other), ensure we are marked as disconnected
+            if (connected) { // Avoid calling disconnect if already called
+                disconnect();
+            }
+            co_return;
         }
-    }
-}
-
-void ClientNetwork::doReadBody() {
-    if (!isConnected()) return;
+        reader.commit(bytesRead);
 
-    readMsgBuffer.resize(incomingMsgSize); // Resize buffer for the message body
-    asio::async_read(socket, asio::buffer(readMsgBuffer),
-        [this, self = shared_from_this()](const asio::error_code& error, std::size_t bytes_transferred) {
-            handleReadBody(error, bytes_transferred);
-        });
-}
-
-void ClientNetwork::handleReadBody(const asio::error_code& error, std::size_t /*bytes_transferred*/) {
-    if (!isConnected()) return;
-
-    if (!error) {
-        // Message body read successfully, process it
-        processMessage();
-        // Start reading the next message header
-        doReadHeader();
-    } else {
-        if (error == asio::error::eof) {
-            spdlog::info("Server closed the connection (EOF) while reading body.");
-            invokeDisconnectCallback("Server closed connection");
-        } else if (error != asio::error::operation_aborted) {
-            spdlog::error("Error reading body: {}", error.message());
-            invokeDisconnectCallback("Read body error: " + error.message());
-        } else {
-            spdlog::debug("Read body operation aborted (likely during disconnect).");
-        }
-        // If an error occurred (EOF or other), ensure we are marked as disconnected
-        if (connected) { // Avoid calling disconnect if already called
-            disconnect();
+        // Process every complete message before reading again
+        try {
+            while (auto frame = reader.next()) {
+                processMessage(*frame);
+                if (!isConnected()) co_return; // Disconnected by the message (e.g. LoginFailure)
+            }
+        } catch (const std::length_error& e) {
+            spdlog::error("Error: {}", e.what());
+            disconnect(); // Disconnect on potentially malicious message
+            co_return;
         }
     }
 }
 
-void ClientNetwork::doWrite() {
-    if (!isConnected() || writeMsgs.empty()) return;
-
-    // Start asynchronous write of the first message in the queue
-    asio::async_write(socket, asio::buffer(writeMsgs.front()),
-        [this, self = shared_from_this()](const asio::error_code& error, std::size_t bytes_transferred) {
-            handleWrite(error, bytes_transferred);
-        });
-}
-
-void ClientNetwork::handleWrite(const asio::error_code& error, std::size_t /*bytes_transferred*/) {
-    if (!isConnected()) return; // Check connection status
-
-    if (!error) {
-        // Write successful, remove the message from the queue
-        writeMsgs.pop_front();
-        // If there are more messages, start the next write
-        if (!writeMsgs.empty()) {
-            doWrite();
+asio::awaitable<void> ClientNetwork::writeLoop() {
+    std::vector<asio::const_buffer> buffers;
+    while (isConnected()) {
+        if (writeMsgs.empty()) {
+            asio::error_code error;
+            co_await writeSignal.async_wait(asio::redirect_error(asio::use_awaitable, error));
+            continue; // Cancelled by queueMessage or disconnect
         }
-    } else {
-        if (error != asio::error::operation_aborted) {
-            spdlog::error("Error writing message: {}", error.message());
-            invokeDisconnectCallback("Write error: " + error.message());
-            if (connected) { // Avoid calling disconnect if already called
-                disconnect();
-            }
-        } else {
+        // Everything queued so far goes in one write; messages queued meanwhile wait for the next one
+        buffers.clear();
+        for (const auto& message : writeMsgs)
+            buffers.push_back(asio::buffer(message));
+        asio::error_code error;
+        co_await asio::async_write(socket, buffers,
+            asio::cancel_after(WRITE_TIMEOUT, asio::redirect_error(asio::use_awaitable, error)));
+        if (!isConnected()) {
             spdlog::debug("Write operation aborted (likely during disconnect).");
+            co_return;
+        }
+        if (error) {
+            std::string reason = error == asio::error::operation_aborted ? "timed out" : error.message();
+            spdlog::error("Error writing message: {}", reason);
+            invokeDisconnectCallback("Write error: " + reason);
+            disconnect();
+            co_return;
         }
+        writeMsgs.erase(writeMsgs.begin(), writeMsgs.begin() + static_cast<std::ptrdiff_t>(buffers.size()));
     }
 }
 
 // --- Message Processing ---
 
-void ClientNetwork::processMessage() {
+void ClientNetwork::processMessage(std::span<const char> frame) {
     ServerMessageType msgType;
     try {
-        std::istringstream is(std::string(readMsgBuffer.begin(), readMsgBuffer.end()), std::ios::binary);
-        cereal::BinaryInputArchive archive(is);
-
-        archive(msgType); // Read the message type first
-
-        spdlog::trace("Received message of type: {}", static_cast<int>(msgType));
-
-        switch (msgType) {
-            case ServerMessageType::GameStateUpdate: {
-                ClientGameState gameState;
-                archive(gameState); // Deserialize the game state
-                invokeGameStateCallback(gameState);
-                break;
-            }
-            case ServerMessageType::ActionError: {
-                ActionError errorMsg;
-                archive(errorMsg); // Deserialize the error message
-                invokeActionErrorCallback(errorMsg);
-                break;
-            }
-            case ServerMessageType::LoginSuccess: {
-                spdlog::debug("Login successful for player '{}'", clientPlayerName);
-                invokeLoginSuccessCallback();
-                break;
-            }
-            case ServerMessageType::LoginFailure: {
-                std::string reason;
-                archive(reason); // Deserialize the failure reason
-                spdlog::error("Login failed: {}", reason);
-                invokeLoginFailureCallback(reason);
-                // Login failed, so disconnect
-                disconnect();
-                break;
+        FrameStreamBuffer frameBuffer(frame);
+        std::istream is(&frameBuffer);
+        // Binary until the LoginSuccess says otherwise
+        decodeMessage(wireFormat.load(std::memory_order_acquire), is, [&](auto& archive) {
+            archive(msgType); // Read the message type first
+
+            spdlog::trace("Received message of type: {}", static_cast<int>(msgType));
+
+            switch (msgType) {
+                case ServerMessageType::GameStateUpdate: {
+                    ClientGameState gameState;
+                    archive(gameState); // Deserialize the game state
+                    recordReply(gameState.getRequestId());
+                    invokeGameStateCallback(std::move(gameState));
+                    break;
+                }
+                case ServerMessageType::ActionError: {
+                    ActionError errorMsg;
+                    archive(errorMsg); // Deserialize the error message
+                    recordReply(errorMsg.getRequestId());
+                    invokeActionErrorCallback(errorMsg);
+                    break;
+                }
+                case ServerMessageType::LoginSuccess: {
+                    WireFormat grantedFormat = WireFormat::Binary; // Older servers send no format
+                    if (hasMoreFields(is))
+                        archive(grantedFormat);
+                    if (grantedFormat > requestedWireFormat)
+                        throw cereal::Exception("Server granted a wire format that was not asked for");
+                    wireFormat.store(grantedFormat, std::memory_order_release);
+                    spdlog::debug("Login successful for player '{}' (wire format {})", clientPlayerName,
+                        static_cast<int>(grantedFormat));
+                    invokeLoginSuccessCallback();
+                    break;
+                }
+                case ServerMessageType::LoginFailure: {
+                    std::string reason;
+                    archive(reason); // Deserialize the failure reason
+                    spdlog::error("Login failed: {}", reason);
+                    invokeLoginFailureCallback(reason);
+                    // Login failed, so disconnect
+                    disconnect();
+                    break;
+                }
+                default:
+                    spdlog::error("Received unknown message type from server: {}", static_cast<int>(msgType));
+                    // Optionally disconnect on unknown message type
+                    // disconnect();
+                    break;
             }
-            default:
-                spdlog::error("Received unknown message type from server: {}", static_cast<int>(msgType));
-                // Optionally disconnect on unknown message type
-                // disconnect();
-                break;
-        }
+        });
     } catch (const cereal::Exception& e) {
         spdlog::error("Deserialization error (MsgType: {}): {}", static_cast<int>(msgType), e.what());
         // Disconnect on bad message format
@@ -348,52 +309,47 @@ void ClientNetwork::processMessage() {
 
 // --- Sending Logic ---
 
-template <typename T>
-void ClientNetwork::queueMessage(ClientMessageType msgType, const T& data) {
-    if (!isConnected()) {
+template <typename... T>
+void ClientNetwork::queueMessage(ClientMessageType msgType, RequestId requestId, const T&... data) {
+    if (!connected) { // Sent from the UI thread: the flag, unlike the socket, can be read there
         spdlog::warn("Cannot queue message: Not connected.");
         return;
     }
     // Serialize the message with header
-    std::vector<char> message = serializeMessage(msgType, data);
+    std::vector<char> message = serializeMessage(wireFormat.load(std::memory_order_acquire), msgType, requestId, data...);
 
     // Post the queuing and potential write start to the io_context strand
     // to ensure thread safety with the write queue.
-    asio::post(ioContext, [this, self = shared_from_this(), message]() {
-        bool writeInProgress = !writeMsgs.empty();
+    asio::post(ioContext, [this, self = shared_from_this(), requestId, message = std::move(message)]() mutable {
+        if (requestId != NO_REQUEST_ID)
+            requestSendTimes[requestId] = std::chrono::steady_clock::now();
         writeMsgs.push_back(std::move(message));
-        // If no write was in progress, start writing the new message
-        if (!writeInProgress) {
-            doWrite();
-        }
+        writeSignal.cancel(); // Wakes the write loop if it waits for messages
     });
 }
 
-void ClientNetwork::queueMessage(ClientMessageType msgType) {
-    if (!isConnected()) {
-        spdlog::warn("Cannot queue message: Not connected.");
+void ClientNetwork::recordReply(RequestId requestId) {
+    if (requestId == NO_REQUEST_ID)
+        return; // Broadcast not answering any request
+    auto it = requestSendTimes.find(requestId);
+    if (it == requestSendTimes.end()) {
+        spdlog::warn("Reply to unknown request #{}", requestId);
         return;
     }
-    // Serialize the message (type only) with header
-    std::vector<char> message = serializeMessage(msgType);
-
-    asio::post(ioContext, [this, self = shared_from_this(), message]() {
-        bool writeInProgress = !writeMsgs.empty();
-        writeMsgs.push_back(std::move(message));
-        if (!writeInProgress) {
-            doWrite();
-        }
-    });
+    auto roundTrip = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - it->second);
+    spdlog::debug("Request #{} answered in {:.2f} ms", requestId, roundTrip.count() / 1000.0);
+    requestSendTimes.erase(it);
 }
 
 
 // --- Callback Invocation ---
 // These helpers ensure callbacks are only called if they are set.
 
-void ClientNetwork::invokeGameStateCallback(const ClientGameState& state) {
+void ClientNetwork::invokeGameStateCallback(ClientGameState&& state) {
     if (onGameStateUpdateCallback) {
         try {
-            onGameStateUpdateCallback(state);
+            onGameStateUpdateCallback(std::move(state));
         } catch (const std::exception& e) {
             spdlog::error("Exception in onGameStateUpdateCallback: {}", e.what());
         }
@@ -410,7 +366,7 @@ void ClientNetwork::invokeActionErrorCallback(const ActionError& actionError) {
             spdlog::error("Exception in onActionErrorCallback: {}", e.what());
         }
     } else {
-        spdlog::warn("Received ActionError ('{}') but no callback is set.", actionError.getMessage());
+        spdlog::warn("Received ActionError ('{}') but no callback is set.", actionError.getMessage().toString());
     }
 }
 
@@ -1,31 +1,70 @@
 #include "client/game_view.hpp"
-
+#include <chrono>
+#include "spdlog/spdlog.h"
 
 GameView::GameView(): console(), screen(ScreenInteractive::TerminalOutput()) {
     console.clear();
+    screen.TrackMouse(false);
+    // The root only forwards rendering and events to whichever modal is active
+    root = CatchEvent(
+        Renderer([this] { return activeModal ? activeModal->Render() : text(" "); }),
+        [this](Event e) { return activeModal ? activeModal->OnEvent(e) : true; }
+    );
+}
+
+void GameView::runModal(Component modal, const bool& done) {
+    if (!loop)
+        loop = std::make_unique<Loop>(&screen, root);
+    // Keys pressed while the previous frame was shown reach it and are dropped
+    loop->RunOnce();
+    activeModal = std::move(modal);
+    screen.PostEvent(Event::Custom); // draw the modal before the first key press
+    while (!done) {
+        if (loop->HasQuitted())
+            throw std::runtime_error("User interface was closed.");
+        loop->RunOnceBlocking();
+    }
+    // Keep showing the finished modal until something replaces it, but stop reacting to keys
+    activeModal = CatchEvent(activeModal, [](Event) { return true; });
+}
+
+void GameView::showFrame(Element document) {
+    if (!loop)
+        loop = std::make_unique<Loop>(&screen, root);
+    activeModal = CatchEvent(Renderer([document] { return document; }), [](Event) { return true; });
+    screen.PostEvent(Event::Custom);
+    loop->RunOnce();
 }
 
 Element GameView::makeBoard(const BoardState& boardState) {
     const auto myColor = Color::LightSlateBlue;
     const auto oppColor = Color::LightGreenBis; 
-    auto myMeldGrid = makeMeldGrid(boardState.getMyTeamMelds(), myColor);
-    auto opponentMeldGrid = makeMeldGrid(boardState.getOpponentTeamMelds(), oppColor);
-    auto myHandRow = makeHandGrid(boardState.getMyHand());
-    auto deckInfo = makeDeckInfo(boardState.getDeckState());
-    auto scoreInfo = makeScoreInfo(boardState.getMyTeamTotalScore(),
+    // Every part is rebuilt only when the data it shows has changed since the last frame
+    auto myMeldGrid = myMeldGridCache.get(boardState.getMyTeamMeldsRevision(),
+        [&](auto) { return makeMeldGrid(boardState.getMyTeamMelds(), myColor); });
+    auto opponentMeldGrid = opponentMeldGridCache.get(boardState.getOpponentTeamMeldsRevision(),
+        [&](auto) { return makeMeldGrid(boardState.getOpponentTeamMelds(), oppColor); });
+    auto myHandRow = handGridCache.get(boardState.getMyHandRevision(),
+        [&](auto) { return makeHandGrid(boardState.getMyHand()); });
+    auto deckInfo = deckInfoCache.get(boardState.getDeckState(),
+        [&](const auto& deck) { return makeDeckInfo(deck); });
+    const std::array<int, 4> scores = {
+        boardState.getMyTeamTotalScore(),
         boardState.getOpponentTeamTotalScore(),
         boardState.getMyTeamMeldPoints(),
-        boardState.getOpponentTeamMeldPoints(),
-        myColor, oppColor
-    );
-    auto myPlayerInfo = makePlayerInfo(boardState.getMyPlayer());
-    auto opponentPlayerInfo = makePlayerInfo(boardState.getOppositePlayer());
-    auto leftPlayer = boardState.getLeftPlayer();
-    auto leftPlayerInfo = leftPlayer.has_value() ?
-        makePlayerInfo(leftPlayer.value()) : text(" ");
-    auto rightPlayer = boardState.getRightPlayer();
-    auto rightPlayerInfo = rightPlayer.has_value() ?
-        makePlayerInfo(rightPlayer.value()) : text(" ");
+        boardState.getOpponentTeamMeldPoints()
+    };
+    auto scoreInfo = scoreInfoCache.get(scores, [&](const auto& s) {
+        return makeScoreInfo(s[0], s[1], s[2], s[3], myColor, oppColor);
+    });
+    auto makeInfo = [&](const PlayerPublicInfo& player) { return makePlayerInfo(player); };
+    auto makeOptionalInfo = [&](const std::optional<PlayerPublicInfo>& player) {
+        return player.has_value() ? makePlayerInfo(player.value()) : text(" ");
+    };
+    auto myPlayerInfo = myPlayerInfoCache.get(boardState.getMyPlayer(), makeInfo);
+    auto opponentPlayerInfo = oppositePlayerInfoCache.get(boardState.getOppositePlayer(), makeInfo);
+    auto leftPlayerInfo = leftPlayerInfoCache.get(boardState.getLeftPlayer(), makeOptionalInfo);
+    auto rightPlayerInfo = rightPlayerInfoCache.get(boardState.getRightPlayer(), makeOptionalInfo);
 
     // 4) Combine in a vertical stack
     return vbox({
@@ -74,26 +113,24 @@ Element GameView::makeMeldGrid(const std::vector<MeldView>& melds, Color frameCo
             if (meld.getRank() != meldsToPrint.front().getRank())
                 cells.push_back(separator() | color(frameColor));
             
-            auto& meldCards = meld.getCards();
-
             // 1) true canasta indicator: if it is canasta, on the last row show 'C'
-            if (meldCards.size() >= MIN_CANASTA_SIZE && row == MIN_CANASTA_SIZE) {
+            if (meld.size() >= MIN_CANASTA_SIZE && row == MIN_CANASTA_SIZE) {
                 cells.push_back(text(" C ") | color(frameColor) | flex_grow);
                 continue;
             }
 
             // 2) otherwise if this row falls inside the number of cards
-            if (row < meldCards.size()) {
+            if (row < meld.size()) {
                 // a) common meld
-                if (meldCards.size() < MIN_CANASTA_SIZE) {
-                    cells.push_back(makeCardElement(meldCards[row], true));
+                if (meld.size() < MIN_CANASTA_SIZE) {
+                    cells.push_back(makeCardElement(meld[row], true));
 
                 } else {
                     if (row == 0) {
-                        cells.push_back(makeCardElement(meldCards.front(), true));
+                        cells.push_back(makeCardElement(meld.front(), true));
                     } else if (row == 1 &&
-                            meldCards.front().getRank() != meldCards.back().getRank()) {
-                        cells.push_back(makeCardElement(meldCards.back(), true));
+                            meld.front().getRank() != meld.back().getRank()) {
+                        cells.push_back(makeCardElement(meld.back(), true));
                     } else {
                         cells.push_back(text("   ") | flex_grow);
                     }
@@ -113,7 +150,7 @@ Element GameView::makeMeldGrid(const std::vector<MeldView>& melds, Color frameCo
 
 
 Element GameView::makeHandGrid(const Hand& hand) {
-    auto cards = hand.getCards();
+    const auto& cards = hand.getCards();
     if (cards.empty())
         return text("Hand is empty");
     std::vector<std::vector<Card>> cardLayout;
@@ -162,16 +199,6 @@ Element GameView::makeHandGrid(const Hand& hand) {
     return cardsElement;
 }
 
-std::optional<std::size_t> BoardState::getMeldIndexForRank(Rank rank) {
-    int rankInt = static_cast<int>(rank);
-    if (rankInt >= static_cast<int>(Rank::Four) && rankInt <= static_cast<int>(Rank::Ace)) {
-        // Rank::Four (4) maps to index 2, Rank::Ace (14) maps to index 12
-        return static_cast<std::size_t>(rankInt - static_cast<int>(Rank::Four) + RANK_MELD_OFFSET);
-    }
-    return std::nullopt; // Invalid rank for a standard meld
-}
-
-
 // Demo
 Element GameView::makeDeckInfo(const ClientDeck& deck) {
     bool hasTop = deck.getTopDiscardCard().has_value();
@@ -227,15 +254,15 @@ Element GameView::makeCardElement(const Card& card, bool padded) {
 }
 
 std::string GameView::promptString(const std::string& question, std::string& placeholder) {
-    console.clear();
     // 1) local buffer
     std::string buffer;
+    bool done = false;
 
     // 2) Configure InputOption to *reference* that buffer
     InputOption option = InputOption::Default();
     option.content     = &buffer;             // <<–– bind to std::string
     option.placeholder = StringRef(placeholder);        // <<–– bind to the caller’s placeholder
-    option.on_enter    = [&] { screen.ExitLoopClosure()(); };
+    option.on_enter    = [&] { done = true; };
     option.multiline   = false;
 
     // 3) Build & render
@@ -248,26 +275,14 @@ std::string GameView::promptString(const std::string& question, std::string& pla
         }) | border | center;
     });
 
-    screen.Loop(renderer);
-    disableInput();
+    runModal(renderer, done);
     // 4) buffer now holds the final text
     return buffer.substr(0, std::min<int>(buffer.size(), MAX_NAME_LENGTH));
 }
 
-void GameView::disableInput() {
-    if (!inputGuard)
-      inputGuard.emplace();  // now console is in raw/no-echo mode
-}
-
-void GameView::restoreInput() {
-    inputGuard.reset();     // destructor runs, restoring original mode
-}
-
-
 void GameView::showStaticBoardWithMessages(
     const std::vector<std::string>& messages, const BoardState& boardState) {
-    console.clear();
-    disableInput();
+    const auto frameStart = std::chrono::steady_clock::now();
 
     auto boardElem = makeBoard(boardState) | flex_grow;
 
@@ -286,18 +301,11 @@ void GameView::showStaticBoardWithMessages(
         messagePane
     });
 
-    // 5) One-shot render into a virtual Screen
-    auto screenBuff = Screen::Create(
-        Dimension::Full(),        // full terminal width
-        Dimension::Fit(document)  // height = content height
-    );
-    Render(screenBuff, document);
-
-    // 6) Print it
-    std::cout
-    << screenBuff.ResetPosition()
-    << screenBuff.ToString()
-    << std::flush;
+    // 5) Hand it to the persistent screen, which redraws in place
+    showFrame(document);
+    const auto frameTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - frameStart);
+    spdlog::debug("Board frame: {} us", frameTime.count());
 }
 
 Element GameView::makeScoreInfo(int myTeamTotalScore, int opponentTeamTotalScore,
@@ -327,8 +335,7 @@ Element GameView::makePlayerInfo(const PlayerPublicInfo& player) {
 
 
 void GameView::showStaticScore(const ScoreState& scoreState) {
-    console.clear();
-    disableInput();
+    const auto frameStart = std::chrono::steady_clock::now();
 
     // 2) References to your two score‐breakdowns
     const auto& sb  = scoreState.getMyTeamScoreBreakdown();
@@ -416,16 +423,10 @@ void GameView::showStaticScore(const ScoreState& scoreState) {
     | size(HEIGHT, GREATER_THAN, (int)columnNames.size() + PADDING_WITH_MESSAGE)
     | center;
 
-    // 5) One-shot render into a virtual Screen
-    auto screenBuff = Screen::Create(
-        Dimension::Full(),
-        Dimension::Fit(document)
-    );
-    Render(screenBuff, document);
-    std::cout << screenBuff.ResetPosition()
-                << screenBuff.ToString()
-                << std::flush;
-    restoreInput(); // Restore terminal state
+    showFrame(document);
+    const auto frameTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - frameStart);
+    spdlog::debug("Score frame: {} us", frameTime.count());
 }
 
 int GameView::promptChoiceWithBoard(
@@ -434,10 +435,7 @@ int GameView::promptChoiceWithBoard(
     const BoardState& boardState,
     std::optional<const std::string> message) {
 
-    console.clear();
-    auto localScreen = ScreenInteractive::TerminalOutput();
-    localScreen.TrackMouse(false);
-    bool shouldUpdate = true;
+    bool done = false;
 
     // Top: your board, grows to fill
     auto board = makeBoard(boardState) | flex_grow;
@@ -494,29 +492,19 @@ int GameView::promptChoiceWithBoard(
             return true;
         }
         if (e == Event::Return) {
-            // Trigger exit; Loop.RunOnce will see this and quit
-            localScreen.ExitLoopClosure()();
-            shouldUpdate = false;
-            return false;
+            done = true;
+            return true;
         }
         return false;
         }
     );
 
-    // Manual event loop: run until Quit()
-    auto loop = Loop(&localScreen, component);
-    while (!loop.HasQuitted() && shouldUpdate) {
-        loop.RunOnce();
-    }
-
+    runModal(component, done);
     return selected;
 }
 
 std::vector<MeldRequest> GameView::runMeldWizard(const BoardState& boardState) {
-    console.clear();
-    auto localScreen = ScreenInteractive::TerminalOutput();
-    localScreen.TrackMouse(false);
-    bool shouldUpdate = true;
+    bool done = false;
     // 1) Mutable hand + map for meld‐requests
     Hand working = boardState.getMyHand();
     std::map<Rank, MeldRequest> requestMap;
@@ -552,12 +540,12 @@ std::vector<MeldRequest> GameView::runMeldWizard(const BoardState& boardState) {
         return bucket;
     };
 
+    // a) board at top, built once: it does not change while the wizard runs
+    auto boardView = makeBoard(boardState) | flex_grow;
+
     // 3) Build the UI
     Component component = CatchEvent(
     Renderer([&]{    
-        // a) board at top
-        auto boardView = makeBoard(boardState) | flex_grow;
-
         // b) wizard pane
         std::vector<Element> lines;
         if (mode == Mode::PICK_RANK) {
@@ -636,9 +624,8 @@ std::vector<MeldRequest> GameView::runMeldWizard(const BoardState& boardState) {
                 return true;
             }
             if (e==Event::Escape) {
-                localScreen.ExitLoopClosure()();
-                shouldUpdate = false;
-                return false;
+                done = true;
+                return true;
             }
         } else {
         // PICK_CARDS
@@ -691,10 +678,7 @@ std::vector<MeldRequest> GameView::runMeldWizard(const BoardState& boardState) {
     }
     );
 
-    auto loop = Loop(&localScreen, component);
-    while (!loop.HasQuitted() && shouldUpdate) {
-        loop.RunOnce();
-    }
+    runModal(component, done);
 
     // 4) Flatten into vector for server
     std::vector<MeldRequest> result;
@@ -705,12 +689,9 @@ std::vector<MeldRequest> GameView::runMeldWizard(const BoardState& boardState) {
 }
 
 Card GameView::runDiscardWizard(const BoardState& boardState) {
-    console.clear();
-    auto localScreen = ScreenInteractive::TerminalOutput();
-    localScreen.TrackMouse(false);
-    bool shouldUpdate = true;
-    // 1) Working copy of the hand
-    Hand working = boardState.getMyHand();
+    bool done = false;
+    // 1) The hand does not change while choosing
+    const Hand& working = boardState.getMyHand();
 
     // 2) Build a dynamic list of ranks present in hand
     std::vector<Rank> ranks;
@@ -749,10 +730,12 @@ Card GameView::runDiscardWizard(const BoardState& boardState) {
     return bucket;
     };
 
+    // Board does not change while the wizard runs
+    auto boardView = makeBoard(boardState) | flex_grow;
+
     // 3) Build and run the UI
     Component component = CatchEvent(
     Renderer([&] {
-        auto boardView = makeBoard(boardState) | flex_grow;
         std::vector<Element> lines;
 
         if (mode == Mode::PICK_RANK) {
@@ -850,18 +833,14 @@ Card GameView::runDiscardWizard(const BoardState& boardState) {
         if (e == Event::Return) {
             // finalize
             result = bucket[cardIdx];
-            localScreen.ExitLoopClosure()();
-            shouldUpdate = false;
-            return false;
+            done = true;
+            return true;
         }
         }
         return false;
     }
     );
 
-    auto loop = Loop(&localScreen, component);
-    while (!loop.HasQuitted() && shouldUpdate) {
-        loop.RunOnce();
-    }
+    runModal(component, done);
     return result.value();  // always set by Enter in PICK_CARD
 }
@@ -0,0 +1,312 @@
+#include "client/headless_view.hpp"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include "spdlog/spdlog.h"
+
+namespace {
+    constexpr std::string_view RANK_CHARACTERS = "@23456789XJQKA"; // indexed by Rank - 1
+
+    bool offers(const std::vector<TurnAction>& actions, TurnAction action) {
+        return std::find(actions.begin(), actions.end(), action) != actions.end();
+    }
+
+    std::string joinTokens(std::span<const Card> cards) {
+        std::string result;
+        for (const auto& card : cards) {
+            if (!result.empty())
+                result += ' ';
+            result += HeadlessView::cardToken(card);
+        }
+        return result;
+    }
+}
+
+HeadlessView::HeadlessView(HeadlessMode mode, std::string playerName,
+    std::istream& input, std::ostream& output)
+    : mode(mode), playerName(std::move(playerName)), input(input), output(output) {}
+
+std::string HeadlessView::cardToken(const Card& card) {
+    std::string token(1, RANK_CHARACTERS[static_cast<std::size_t>(card.getRank()) - 1]);
+    token += card.getColor() == CardColor::RED ? 'R' : 'B';
+    return token;
+}
+
+std::optional<Card> HeadlessView::parseCardToken(const std::string& token) {
+    if (token.size() != 2)
+        return std::nullopt;
+    auto rankPos = RANK_CHARACTERS.find(static_cast<char>(std::toupper(token[0])));
+    if (rankPos == std::string_view::npos)
+        return std::nullopt;
+    char colorChar = static_cast<char>(std::toupper(token[1]));
+    if (colorChar != 'R' && colorChar != 'B')
+        return std::nullopt;
+    return Card(static_cast<Rank>(rankPos + 1), colorChar == 'R' ? CardColor::RED : CardColor::BLACK);
+}
+
+std::string HeadlessView::promptString(const std::string& question, std::string& placeholder) {
+    if (!playerName.empty())
+        return playerName;
+    if (mode == HeadlessMode::Policy)
+        return placeholder;
+    output << question << " [" << placeholder << "]" << std::endl;
+    std::string line;
+    if (!std::getline(input, line))
+        throw std::runtime_error("Input closed.");
+    return line.empty() ? placeholder : line;
+}
+
+TurnAction HeadlessView::promptTurnAction(const std::vector<TurnAction>& actions, const BoardState& boardState,
+    std::optional<const std::string> message) {
+    if (mode != HeadlessMode::Policy)
+        return ClientFrontend::promptTurnAction(actions, boardState, std::move(message));
+    // The controller only passes a message when the previous action was rejected
+    if (message)
+        spdlog::debug("Action rejected: {}", *message);
+    return choosePolicyAction(actions, boardState, message.has_value());
+}
+
+int HeadlessView::promptChoiceWithBoard(const std::string& question, const std::vector<std::string>& options,
+    const BoardState& boardState, std::optional<const std::string> message) {
+    if (options.empty())
+        throw std::logic_error("No option to choose from.");
+    if (mode == HeadlessMode::Policy)
+        return 0; // The policy only decides turn actions, through promptTurnAction
+    printBoard(boardState);
+    if (message)
+        output << "! " << *message << '\n';
+    output << question << '\n';
+    for (std::size_t i = 0; i < options.size(); ++i)
+        output << "  " << i << ") " << options[i] << '\n';
+    output << std::flush;
+    while (true) {
+        auto line = readLine();
+        int choice = -1;
+        std::istringstream(line) >> choice;
+        if (choice >= 0 && choice < static_cast<int>(options.size()))
+            return choice;
+        output << "Enter a number between 0 and " << options.size() - 1 << std::endl;
+    }
+}
+
+std::vector<MeldRequest> HeadlessView::runMeldWizard(const BoardState& boardState) {
+    if (mode == HeadlessMode::Policy) {
+        lastAction = PolicyAction::Meld;
+        return planMelds(boardState);
+    }
+
+    output << "Enter melds as card groups separated by ';' (e.g. \"5R 5B 2R; KB KB KR\"), "
+           << "or '-' to go back" << std::endl;
+    while (true) {
+        auto line = readLine();
+        if (line == "-")
+            return {};
+        std::vector<MeldRequest> requests;
+        bool valid = true;
+        std::istringstream groups(line);
+        std::string group;
+        while (valid && std::getline(groups, group, ';')) {
+            std::vector<Card> cards;
+            std::optional<Rank> rank;
+            std::istringstream tokens(group);
+            std::string token;
+            while (tokens >> token) {
+                auto card = parseCardToken(token);
+                if (!card) {
+                    output << "Invalid card '" << token << "'" << std::endl;
+                    valid = false;
+                    break;
+                }
+                // The meld rank is taken from its first non-wild card
+                if (!rank && card->getType() != CardType::Wild)
+                    rank = card->getRank();
+                cards.push_back(*card);
+            }
+            if (valid && !cards.empty())
+                requests.emplace_back(cards, rank);
+        }
+        if (valid)
+            return requests;
+    }
+}
+
+Card HeadlessView::runDiscardWizard(const BoardState& boardState) {
+    if (mode == HeadlessMode::Policy) {
+        lastAction = PolicyAction::Discard;
+        auto candidates = rankDiscards(boardState);
+        if (candidates.empty())
+            throw std::runtime_error("Asked to discard with an empty hand.");
+        // A rejected discard is retried with the next candidate
+        return candidates[rejectedDiscards % candidates.size()];
+    }
+
+    output << "Enter the card to discard" << std::endl;
+    while (true) {
+        auto token = readLine();
+        auto card = parseCardToken(token);
+        if (card && boardState.getMyHand().hasCard(*card))
+            return *card;
+        output << "'" << token << "' is not in your hand" << std::endl;
+    }
+}
+
+void HeadlessView::showStaticBoardWithMessages(
+    const std::vector<std::string>& messages, const BoardState& boardState) {
+    if (mode == HeadlessMode::Policy) {
+        for (const auto& message : messages)
+            spdlog::debug("{}", message);
+        return;
+    }
+    printBoard(boardState);
+    for (const auto& message : messages)
+        output << "> " << message << '\n';
+    output << std::flush;
+}
+
+void HeadlessView::showStaticScore(const ScoreState& scoreState) {
+    lastAction = PolicyAction::None;
+    rejectedDiscards = 0;
+    std::string outcome = "round over";
+    if (scoreState.getIsGameOver() && scoreState.getGameOutcome()) {
+        auto gameOutcome = *scoreState.getGameOutcome();
+        outcome = gameOutcome == ClientGameOutcome::Win ? "win" :
+            gameOutcome == ClientGameOutcome::Lose ? "lose" : "draw";
+    }
+    if (mode == HeadlessMode::Policy) {
+        spdlog::info("Score {} vs {} ({})", scoreState.getMyTeamTotalScore(),
+            scoreState.getOpponentTeamTotalScore(), outcome);
+        return;
+    }
+    output << "Round: " << scoreState.getMyTeamScoreBreakdown().calculateTotal() << " vs "
+           << scoreState.getOpponentTeamScoreBreakdown().calculateTotal()
+           << ", game: " << scoreState.getMyTeamTotalScore() << " vs "
+           << scoreState.getOpponentTeamTotalScore() << " (" << outcome << ")" << std::endl;
+}
+
+TurnAction HeadlessView::choosePolicyAction(const std::vector<TurnAction>& actions,
+    const BoardState& boardState, bool lastActionRejected) {
+    if (actions.empty())
+        throw std::logic_error("No action to choose from.");
+    if (lastActionRejected && lastAction == PolicyAction::Discard)
+        ++rejectedDiscards;
+    else if (!lastActionRejected)
+        rejectedDiscards = 0;
+
+    // Start of the turn: draw, fall back to the discard pile if drawing was rejected
+    if (offers(actions, TurnAction::DrawDeck)) {
+        if (lastActionRejected && lastAction == PolicyAction::Draw && offers(actions, TurnAction::TakeDiscardPile)) {
+            lastAction = PolicyAction::TakeDiscardPile;
+            return TurnAction::TakeDiscardPile;
+        }
+        lastAction = PolicyAction::Draw;
+        return TurnAction::DrawDeck;
+    }
+
+    if (offers(actions, TurnAction::Meld)) {
+        bool meldRejected = lastActionRejected && lastAction == PolicyAction::Meld;
+        if (!meldRejected && !planMelds(boardState).empty())
+            return TurnAction::Meld;
+    }
+    if (offers(actions, TurnAction::Discard))
+        return TurnAction::Discard;
+    // Nothing to meld after taking the pile: give it back
+    if (offers(actions, TurnAction::Revert)) {
+        lastAction = PolicyAction::None;
+        return TurnAction::Revert;
+    }
+    return actions.front();
+}
+
+std::vector<MeldRequest> HeadlessView::planMelds(const BoardState& boardState) const {
+    std::map<Rank, std::vector<Card>> naturalsByRank;
+    for (const auto& card : boardState.getMyHand().getCards()) {
+        if (card.getType() == CardType::Natural)
+            naturalsByRank[card.getRank()].push_back(card);
+    }
+
+    const auto& myMelds = boardState.getMyTeamMelds();
+    std::size_t cardsLeft = boardState.getMyHand().cardCount();
+    std::vector<MeldRequest> requests;
+    for (const auto& [rank, naturals] : naturalsByRank) {
+        auto meldIndex = BoardState::getMeldIndexForRank(rank);
+        if (!meldIndex)
+            continue;
+        bool isInitialized = myMelds[*meldIndex].isInitialized();
+        if (!isInitialized && naturals.size() < MIN_NATURALS_FOR_NEW_MELD)
+            continue;
+        // Keep enough cards to be able to discard at the end of the turn
+        if (cardsLeft < naturals.size() + MIN_CARDS_LEFT_AFTER_MELD)
+            continue;
+        cardsLeft -= naturals.size();
+        requests.emplace_back(naturals, rank);
+    }
+    return requests;
+}
+
+std::vector<Card> HeadlessView::rankDiscards(const BoardState& boardState) const {
+    const auto& cards = boardState.getMyHand().getCards();
+    std::map<Rank, std::size_t> rankCounts;
+    for (const auto& card : cards)
+        ++rankCounts[card.getRank()];
+
+    // Lower class is discarded first: black threes, lone naturals, other naturals, wild cards
+    auto discardClass = [&](const Card& card) {
+        switch (card.getType()) {
+            case CardType::BlackThree: return 0;
+            case CardType::Natural: return rankCounts[card.getRank()] == 1 ? 1 : 2;
+            default: return 3;
+        }
+    };
+    std::vector<Card> candidates(cards.begin(), cards.end());
+    std::stable_sort(candidates.begin(), candidates.end(), [&](const Card& a, const Card& b) {
+        if (discardClass(a) != discardClass(b))
+            return discardClass(a) < discardClass(b);
+        return a.getPoints() > b.getPoints(); // shed the heaviest penalty first
+    });
+    return candidates;
+}
+
+std::string HeadlessView::readLine() {
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            return line;
+    }
+    throw std::runtime_error("Input closed.");
+}
+
+void HeadlessView::printBoard(const BoardState& boardState) {
+    const auto& deck = boardState.getDeckState();
+    const auto& hand = boardState.getMyHand();
+    std::vector<Card> handCards(hand.getCards().begin(), hand.getCards().end());
+    output << "Hand: " << joinTokens(handCards) << '\n';
+    output << "Deck: " << deck.getMainDeckSize() << " cards, discard pile: "
+           << deck.getDiscardPileSize() << " cards";
+    if (deck.getTopDiscardCard())
+        output << ", top " << cardToken(*deck.getTopDiscardCard());
+    if (deck.isFrozen())
+        output << ", frozen";
+    output << '\n';
+    auto printMelds = [&](const std::string& label, const std::vector<MeldView>& melds) {
+        output << label << ':';
+        for (const auto& meld : melds) {
+            if (!meld.isInitialized())
+                continue;
+            output << " [" << joinTokens(meld.getWildCards());
+            if (!meld.getWildCards().empty())
+                output << ' ';
+            output << joinTokens(meld.getNaturalCards()) << ']';
+        }
+        output << '\n';
+    };
+    printMelds("My melds", boardState.getMyTeamMelds());
+    printMelds("Opponent melds", boardState.getOpponentTeamMelds());
+    output << "Score: " << boardState.getMyTeamTotalScore() << " vs "
+           << boardState.getOpponentTeamTotalScore() << ", meld points: "
+           << boardState.getMyTeamMeldPoints() << " vs " << boardState.getOpponentTeamMeldPoints() << '\n';
+}
@@ -8,6 +8,7 @@ void Hand::addCard(const Card& card) {
     auto it = std::lower_bound(cards.begin(), cards.end(), card);
     // Insert the card at the found position
     cards.insert(it, card);
+    cardsHash.add(card);
 }
 
 void Hand::addCards(const std::vector<Card>& newCards, bool reversible) {
@@ -28,6 +29,7 @@ void Hand::revertAddCards() {
         throw std::logic_error("No reversible action to revert");
     }
     cards = std::move(backupCards); // Restore the previous state
+    cardsHash = CardMultisetHash(cards);
     hasPendingReversible = false; // Reset the reversible action flag
 }
 
@@ -42,6 +44,7 @@ bool Hand::removeCard(const Card& card) {
     if (it != cards.end()) {
         // Erase the card from the vector
         cards.erase(it);
+        cardsHash.remove(card);
         return true; // Indicate success
     }
     return false; // Indicate card not found
@@ -83,6 +86,7 @@ int Hand::calculatePenalty() const {
 void Hand::reset() {
     cards.clear();
     backupCards.clear();
+    cardsHash.clear();
     hasPendingReversible = false; // Reset the reversible action flag
 }
 
@@ -1,24 +1,46 @@
 
 #include "meld.hpp"
+#include "invariant.hpp"
 
 void BaseMeld::reset() {
     isActive = false;
     points = 0;
     hasPendingReversible = false;
+    cardsHash.clear();
+}
+
+void BaseMeld::initialize(const std::vector<Card>& cards) {
+    auto proof = checkInitialization(cards);
+    if (!proof.has_value())
+        throw std::logic_error("Meld initialization failed: " + proof.error());
+    initialize(cards, proof.value());
+}
+
+void BaseMeld::addCards(const std::vector<Card>& cards, bool reversible) {
+    auto proof = checkCardsAddition(cards);
+    if (!proof.has_value())
+        throw std::logic_error("Meld addition failed: " + proof.error());
+    addCards(cards, proof.value(), reversible);
+}
+
+void BaseMeld::requireProof(const MeldProof& proof, std::span<const Card> cards) const {
+    if (!proof.holdsFor(*this, cards))
+        throw std::logic_error("The proof was not issued by this meld for these cards");
 }
 
 // Implementation of RedThreeMeld::initialize
-void RedThreeMeld::initialize(const std::vector<Card>& cards) {
-    auto status = checkInitialization(cards);
-    assert(status.has_value() && "Red Three Meld initialization failed");
-    redThreeCards = cards;
+void RedThreeMeld::initialize(std::span<const Card> cards, const MeldProof& proof) {
+    requireProof(proof, cards);
+    redThreeCards.assign(cards.begin(), cards.end());
+    cardsHash = CardMultisetHash(cards);
     isActive = true;
-    updatePoints(); // Update points after initialization
+    points = proof.getPoints(); // Computed by the check
 }
 
 // Implementation of RedThreeMeld::validateCards
-Status RedThreeMeld::validateCards(const std::vector<Card>& cards, std::size_t redThreeCount) const {
-    if (cards.size() + redThreeCount > MAX_SPECIAL_MELD_SIZE) {
+MeldCheck RedThreeMeld::validateCards(const std::vector<Card>& cards) const {
+    std::size_t redThreeCount = redThreeCards.size() + cards.size();
+    if (redThreeCount > MAX_SPECIAL_MELD_SIZE) {
         return std::unexpected("Red Three Meld can contain at most " + std::to_string(MAX_SPECIAL_MELD_SIZE) + " cards");
     }
     for (const auto& card : cards) {
@@ -26,11 +48,14 @@ Status RedThreeMeld::validateCards(const std::vector<Card>& cards, std::size_t r
             return std::unexpected("Invalid card " + card.toString() + " for Red Three Meld");
         }
     }
-    return {};
+    int redThreePoints = static_cast<int>(redThreeCount) * Card(Rank::Three, CardColor::RED).getPoints();
+    if (redThreeCount == MAX_SPECIAL_MELD_SIZE)
+        redThreePoints *= 2; // double points for a complete Red Three Meld
+    return prove(cards, redThreeCount, 0, redThreePoints);
 }
 
 // Implementation of RedThreeMeld::checkInitialization
-Status RedThreeMeld::checkInitialization(const std::vector<Card>& cards) const {
+MeldCheck RedThreeMeld::checkInitialization(const std::vector<Card>& cards) const {
     if (isActive) {
         return std::unexpected("Red Three Meld is already initialized");
     }
@@ -41,9 +66,8 @@ Status RedThreeMeld::checkInitialization(const std::vector<Card>& cards) const {
 }
 
 // Implementation of RedThreeMeld::addCard
-void RedThreeMeld::addCards(const std::vector<Card>& cards, bool reversible) {
-    auto status = checkCardsAddition(cards);
-    assert(status.has_value() && "Red Three Meld addition failed");
+void RedThreeMeld::addCards(std::span<const Card> cards, const MeldProof& proof, bool reversible) {
+    requireProof(proof, cards);
     if (reversible) {
         backupRedThreeCards = redThreeCards; // Backup current cards
         hasPendingReversible = true; // Mark as reversible
@@ -51,18 +75,20 @@ void RedThreeMeld::addCards(const std::vector<Card>& cards, bool reversible) {
         hasPendingReversible = false; // No reversible action
     }
     redThreeCards.insert(redThreeCards.end(), cards.begin(), cards.end());
-    updatePoints(); // Update points after adding a card
+    for (const auto& card : cards)
+        cardsHash.add(card);
+    points = proof.getPoints(); // Computed by the check
 }
 
 // Implementation of RedThreeMeld::checkCardAddition
-Status RedThreeMeld::checkCardsAddition(const std::vector<Card>& cards) const {
+MeldCheck RedThreeMeld::checkCardsAddition(const std::vector<Card>& cards) const {
     if (!isActive) {
         return std::unexpected("Red Three Meld is not initialized");
     }
     if (cards.empty()) {
         return std::unexpected("You must add at least 1 card");
     }
-    return validateCards(cards, redThreeCards.size());
+    return validateCards(cards);
 }
 
 // Implementation of RedThreeMeld::getPoints
@@ -83,16 +109,16 @@ void RedThreeMeld::updatePoints() {
 
 
 // Implementation of BlackThreeMeld::initialize
-void BlackThreeMeld::initialize(const std::vector<Card>& cards) {
-    auto status = checkInitialization(cards);
-    assert(status.has_value() && "Black Three Meld initialization failed");
-    blackThreeCards = cards;
+void BlackThreeMeld::initialize(std::span<const Card> cards, const MeldProof& proof) {
+    requireProof(proof, cards);
+    blackThreeCards.assign(cards.begin(), cards.end());
+    cardsHash = CardMultisetHash(cards);
     isActive = true;
-    updatePoints(); // Update points after initialization
+    points = proof.getPoints(); // Computed by the check
 }
 
 // Implementation of BlackThreeMeld::checkInitialization
-Status BlackThreeMeld::checkInitialization(const std::vector<Card>& cards) const {
+MeldCheck BlackThreeMeld::checkInitialization(const std::vector<Card>& cards) const {
     if (isActive) {
         return std::unexpected("Black Three Meld is already initialized");
     }
@@ -107,16 +133,17 @@ Status BlackThreeMeld::checkInitialization(const std::vector<Card>& cards) const
             return std::unexpected("Invalid card " + card.toString() + " for Black Three Meld");
         }
     }
-    return {};
+    int blackThreePoints = static_cast<int>(cards.size()) * Card(Rank::Three, CardColor::BLACK).getPoints();
+    return prove(cards, cards.size(), 0, blackThreePoints);
 }
 
 // Implementation of BlackThreeMeld::addCard
-void BlackThreeMeld::addCards(const std::vector<Card>& cards, bool reversible) {
+void BlackThreeMeld::addCards(std::span<const Card> cards, const MeldProof& proof, bool reversible) {
     throw std::logic_error("BlackThreeMeld: addCards() unsupported");
 }
 
 // Implementation of BlackThreeMeld::checkCardAddition
-Status BlackThreeMeld::checkCardsAddition(const std::vector<Card>& cards) const {
+MeldCheck BlackThreeMeld::checkCardsAddition(const std::vector<Card>& cards) const {
     return std::unexpected("Black Three Meld does not support adding cards");
 }
 
@@ -142,6 +169,7 @@ void RedThreeMeld::revertAddCards() {
         return; // No reversible action
     }
     redThreeCards = backupRedThreeCards; // Restore the count
+    cardsHash = CardMultisetHash(redThreeCards);
     hasPendingReversible = false; // Clear the reversible state
     updatePoints(); // Update points after reverting
 }
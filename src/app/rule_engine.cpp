@@ -1,4 +1,5 @@
-#include "server/rule_engine.hpp"
+#include "rule_engine.hpp"
+#include "invariant.hpp"
 #include <array>
 //#include "spdlog/spdlog.h"
 
@@ -29,41 +30,48 @@ int RuleEngine::calculateCardPoints(const std::vector<Card>& cards) {
     return totalPoints;
 }
 
-std::expected<int, std::string> RuleEngine::validateRankMeldInitializationProposals(
-    const std::vector<RankMeldProposal>& proposals) {
-    int totalPoints = 0;
+std::expected<std::vector<MeldProof>, std::string> RuleEngine::validateRankMeldInitializationProposals(
+    const std::vector<RankMeldProposal>& proposals,
+    const TeamRoundState& teamRoundState) {
+    std::vector<MeldProof> proofs;
+    proofs.reserve(proposals.size());
     for (const auto& proposal : proposals) {
-        // Create and initialize the meld for the given rank
-        const auto meld = createAndInitializeRankMeld(proposal.getCards(), proposal.getRank());
-        if (!meld.has_value())
-            return std::unexpected(meld.error()); // Return the error message
-        //spdlog::debug("Meld created for rank {}: {} cards, {} points", (*meld)->isInitialized(), (*meld)->getCards().size(), (*meld)->getPoints());
-        totalPoints += (*meld)->getPoints();
+        auto proof = RuleEngine::checkInitialization
+        (proposal.getCards(), proposal.getRank(), teamRoundState);
+        if (!proof.has_value())
+            return std::unexpected(proof.error()); // Return the error message
+        proofs.push_back(proof.value());
     }
-    return totalPoints; // Success
+    return proofs; // Success
 }
 
-Status RuleEngine::validateBlackThreeMeldInitializationProposal(
+std::expected<MeldProof, std::string> RuleEngine::validateBlackThreeMeldInitializationProposal(
 const BlackThreeMeldProposal& blackThreeProposal, const TeamRoundState& teamRoundState) {
     const auto blackThreeMeld = teamRoundState.getBlackThreeMeld();
-    assert(blackThreeMeld && "Black Three meld is null");
-    auto status = blackThreeMeld->checkInitialization(blackThreeProposal.getCards());
-    if (!status.has_value())
-        return std::unexpected(status.error());
-    return {}; // Successss
+    CANASTA_INVARIANT(blackThreeMeld, "Black Three meld is null");
+    return blackThreeMeld->checkInitialization(blackThreeProposal.getCards());
 }
 
-Status RuleEngine::validateRankMeldAdditionProposals(
+std::expected<std::vector<MeldProof>, std::string> RuleEngine::validateRankMeldAdditionProposals(
     const std::vector<RankMeldProposal>& proposals,
     const TeamRoundState& teamRoundState) {
+    std::vector<MeldProof> proofs;
+    proofs.reserve(proposals.size());
     for (const auto& proposal : proposals) {
-
-        auto status = RuleEngine::checkCardsAddition
+        auto proof = RuleEngine::checkCardsAddition
         (proposal.getCards(), proposal.getRank(), teamRoundState);
-        if (!status.has_value())
-            return std::unexpected(status.error());
+        if (!proof.has_value())
+            return std::unexpected(proof.error());
+        proofs.push_back(proof.value());
     }
-    return {}; // Success
+    return proofs; // Success
+}
+
+int RuleEngine::calculateMeldPoints(const std::vector<MeldProof>& proofs) {
+    int totalPoints = 0;
+    for (const auto& proof : proofs)
+        totalPoints += proof.getPoints();
+    return totalPoints;
 }
 
 std::expected<void, int> RuleEngine::validatePointsForInitialMelds(
@@ -113,69 +121,21 @@ bool RuleEngine::canGoingOut(std::size_t cardsPotentiallyLeftInHandCount, const
     return cardsPotentiallyLeftInHandCount <= 1 && canastaCount >= MIN_CANASTAS_TO_GO_OUT;
 }
 
-template <Rank R>
-static std::expected<std::unique_ptr<BaseMeld>, std::string>
-createAndInitializeRankMeldImpl(const std::vector<Card>& cards) {
-    auto meldPtr = std::make_unique<Meld<R>>();
-    if (auto status = meldPtr->checkInitialization(cards); !status.has_value()) {
-        return std::unexpected{ status.error() };
-    }
-    meldPtr->initialize(cards);
-    return meldPtr;
-}
-
-std::expected<std::unique_ptr<BaseMeld>, std::string>
-RuleEngine::createAndInitializeRankMeld(const std::vector<Card>& cards, Rank rank)
-{
-    constexpr int FIRST_RANK = static_cast<int>(Rank::Four);
-    constexpr int LAST_RANK  = static_cast<int>(Rank::Ace);
-    constexpr std::size_t COUNT   = LAST_RANK - FIRST_RANK + 1;
-
-    // Once we find the matching R, we store its success/failure here:
-    std::optional<std::expected<std::unique_ptr<BaseMeld>, std::string>>
-        initializationResult;
-
-    // Templated lambda: unpacks Is = 0..COUNT-1 at compile time
-    auto dispatch = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-        (
-            // This fold expands into COUNT runs of the following lambda:
-            [&] {
-                if (initializationResult) 
-                    return;         // already done
-
-                constexpr Rank currentRank =
-                    static_cast<Rank>(FIRST_RANK + Is);
-
-                if (rank == currentRank) {
-                    initializationResult =
-                        createAndInitializeRankMeldImpl<currentRank>(cards);
-                }
-            }(),
-        ...);
-    };
-
-    // Invoke the templated lambda with an index_sequence<0,1,…,COUNT-1>
-    dispatch(std::make_index_sequence<COUNT>{});
-
-    if (initializationResult.has_value())
-        return std::move(*initializationResult);
-
-    return std::unexpected{
-        "Rank " + std::to_string(static_cast<int>(rank))
-        + " is not a valid normal meld rank"
-    };
+MeldCheck RuleEngine::checkInitialization(const std::vector<Card>& cards,
+    Rank rank, const TeamRoundState& teamRoundState) {
+    const BaseMeld* meld = teamRoundState.getMeldForRank(rank);
+    if (!meld)
+        return std::unexpected("Rank " + std::to_string(static_cast<int>(rank))
+            + " is not a valid normal meld rank");
+    return meld->checkInitialization(cards);
 }
 
-Status RuleEngine::checkCardsAddition(const std::vector<Card>& cards,
+MeldCheck RuleEngine::checkCardsAddition(const std::vector<Card>& cards,
     Rank rank, const TeamRoundState& teamRoundState) {
     const BaseMeld* meld = teamRoundState.getMeldForRank(rank);
     if (!meld || !meld->isInitialized())
         return std::unexpected("Meld not initialized for rank " + to_string(rank));
-
-    Status status = meld->checkCardsAddition(cards);
-    if (!status.has_value())
-        return std::unexpected(status.error());
-    return {}; // Success
+    return meld->checkCardsAddition(cards);
 }
 
 std::size_t RuleEngine::getCanastaCount(const std::vector<std::unique_ptr<BaseMeld>>& teamMelds) {
@@ -272,15 +232,15 @@ GameOutcome RuleEngine::checkGameOutcome(int team1TotalScore, int team2TotalScor
 Status RuleEngine::addRedThreeCardsToMeld
 (const std::vector<Card>& redThreeCards, BaseMeld* redThreeMeld) {
     if (redThreeMeld->isInitialized()) {
-        auto status = redThreeMeld->checkCardsAddition(redThreeCards);
-        if (!status.has_value())
-            return std::unexpected(status.error());
-        redThreeMeld->addCards(redThreeCards);
+        auto proof = redThreeMeld->checkCardsAddition(redThreeCards);
+        if (!proof.has_value())
+            return std::unexpected(proof.error());
+        redThreeMeld->addCards(redThreeCards, proof.value());
         return {};
     }
-    auto status = redThreeMeld->checkInitialization(redThreeCards);
-    if (!status.has_value())
-        return std::unexpected(status.error());
-    redThreeMeld->initialize(redThreeCards);
+    auto proof = redThreeMeld->checkInitialization(redThreeCards);
+    if (!proof.has_value())
+        return std::unexpected(proof.error());
+    redThreeMeld->initialize(redThreeCards, proof.value());
     return {};
 }
\ No newline at end of file
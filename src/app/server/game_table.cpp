@@ -0,0 +1,199 @@
+#include "server/game_table.hpp"
+#include "invariant.hpp"
+#include "server/turn_manager.hpp" // TurnActionResult, MeldRequest
+#include "game_state.hpp"   // ClientGameState
+#include "player.hpp"       // Needed for assembling state
+#include "server/make_state.hpp"
+#include "spdlog/spdlog.h"
+#include <vector>
+
+GameTable::GameTable(ServerNetwork& serverNetwork, TableId id, std::size_t playersCount)
+    :   serverNetwork(serverNetwork),
+        id(id),
+        playersCount(playersCount),
+        gameManager(playersCount),
+        gameStrand(asio::make_strand(serverNetwork.ioContext))
+{}
+
+TableId GameTable::getId() const {
+    return id;
+}
+
+asio::strand<asio::io_context::executor_type>& GameTable::getStrand() {
+    return gameStrand;
+}
+
+Status GameTable::join(SessionPtr session, const std::string& playerName) {
+    // The caller turns the login down with the reason
+    if (sessions.count(playerName) > 0)
+        return std::unexpected("Name already taken.");
+    if (closed || sessions.size() == playersCount)
+        return std::unexpected("Game is full.");
+    sessions[playerName] = session;
+    // Send LoginSuccess confirmation, with the format of the messages following it
+    auto successMsg = serializeMessage(ServerMessageType::LoginSuccess, session->getWireFormat());
+    session->deliver(std::move(successMsg));
+    spdlog::info("Player '{}' joined table {}.", playerName, id);
+    asio::post(gameStrand, [this, self = shared_from_this(), playerName]() {
+        auto status = gameManager.addPlayer(playerName);
+        if (!status.has_value()) {
+            // this should never happen—names/counts already checked above—but if it does we log an error.
+            spdlog::error("addPlayer failed on strand: {}", status.error());
+        }
+
+        // once everyone has joined, we can start the game:
+        if (gameManager.allPlayersJoined()) {
+            gameManager.startGame();
+            broadcastGameState(ActionMessageCode::GameStarted);
+        }
+    });
+    return {}; // Indicate success
+}
+
+void GameTable::leave(SessionPtr session) {
+    auto it = sessions.find(session->getPlayerName());
+    if (closed || it == sessions.end() || it->second != session)
+        return; // The game already ended
+    std::string nameToRemove = session->getPlayerName();
+    sessions.erase(it);
+    spdlog::info("Player '{}' left table {}, ending the game.", nameToRemove, id);
+    gameManager.handlePlayerDisconnect(nameToRemove); // Notify game manager
+    serverNetwork.endTable(id);
+}
+
+void GameTable::closeConnections() {
+    closed = true;
+    // Each session holds the table, so the map goes first
+    auto seated = std::move(sessions);
+    sessions.clear();
+    for (const auto& pair : seated)
+        pair.second->close();
+}
+
+template <typename... T>
+void GameTable::deliverToOne(const std::string& playerName, ServerMessageType msgType, const T&... data) {
+    auto it = sessions.find(playerName);
+    if (it != sessions.end()) {
+        it->second->deliver(serializeMessage(it->second->getWireFormat(), msgType, data...));
+    } else {
+        spdlog::warn("Warning: Attempted to deliver message to unknown player: {}", playerName);
+    }
+}
+
+void GameTable::deliverToAll(const std::vector<char>& message) {
+    for (const auto& pair : sessions) {
+        pair.second->deliver(message);
+    }
+}
+
+// --- Action Handlers (Called via gameStrand from Session::processGameMessage) ---
+
+// Helper to send state updates after successful action
+void GameTable::broadcastGameState(const ActionMessage& lastActionMsg, std::optional<TurnActionStatus> status,
+    const std::string& requestingPlayer, RequestId requestId) {
+     // This function MUST run on the gameStrand
+    CANASTA_INVARIANT(gameStrand.running_in_this_thread(), "The game state should only be touched on the game strand");
+
+    bool broadcastNewRound = false;
+    if (auto* roundManager = gameManager.getCurrentRoundManager()) {
+        if (roundManager->isRoundOver()) {
+            spdlog::info("Round is over. Advancing game state.");
+            gameManager.advanceGameState(); // Advance game state
+            if (!gameManager.isGameOver())
+                broadcastNewRound = true;
+        }
+    }
+
+    if (const auto* roundManager = gameManager.getCurrentRoundManager()) {
+        for (const auto& player : gameManager.getAllPlayers()) {
+            const std::string& targetPlayerName = player.getName();
+    
+            // Check if this player is actually connected
+            SessionPtr targetSession;
+            auto it = sessions.find(targetPlayerName);
+            if (it != sessions.end()) {
+                targetSession = it->second;
+            }
+    
+            if (!targetSession) {
+                spdlog::warn("Warning: Attempted to send game state to disconnected player: {}", targetPlayerName);
+                continue; // Skip if player is not connected
+            }
+            // Only send if player is connected
+            try {
+                auto makeStateStartTime = ServerTracing::now();
+                ClientGameState clientGameState = makeClientGameState(
+                    player, *roundManager, gameManager, lastActionMsg, status
+                );
+                if (targetPlayerName == requestingPlayer)
+                    clientGameState.setRequestId(requestId); // Only the requester is waiting for it
+                // Before the state goes out, so the player's next action is not shed
+                targetSession->setHasTurn(!roundManager->isRoundOver() &&
+                    roundManager->getCurrentPlayer().getName() == targetPlayerName);
+                auto serializeStartTime = ServerTracing::now();
+                auto message = serializeMessage(targetSession->getWireFormat(),
+                    ServerMessageType::GameStateUpdate, clientGameState);
+                ServerProfiling::recordStateFrame(message.size());
+                TraceId traceId = ServerTracing::currentTrace();
+                ServerTracing::record("make_state", traceId, makeStateStartTime, serializeStartTime);
+                ServerTracing::record("serialize", traceId, serializeStartTime, TraceClock::now());
+                targetSession->deliver(std::move(message)); // Deliver runs on the session's executor, safe
+    
+            } catch (const std::exception& e) {
+                spdlog::error("Error assembling or serializing game state for {}: {}", targetPlayerName, e.what());
+            }
+        }
+    }
+
+    if (broadcastNewRound) {
+        gameManager.advanceGameState();
+        broadcastGameState(ActionMessageCode::NewRoundStarted);
+    }
+}
+
+// Helper to send error message back to originating player
+void GameTable::sendActionError(const std::string& playerName, const ActionMessage& errorMsg,
+    std::optional<TurnActionStatus> status, RequestId requestId) {
+    // This function MUST run on the gameStrand
+    CANASTA_INVARIANT(gameStrand.running_in_this_thread(), "The game state should only be touched on the game strand");
+    // Rejected actions are part of normal play, not server errors
+    spdlog::info("Action Error for {} (request #{}): {}", playerName, requestId, errorMsg.toString());
+    ActionError actionError {
+        errorMsg,
+        status,
+        requestId
+    };
+    deliverToOne(playerName, ServerMessageType::ActionError, actionError); // Same thread as the sessions
+}
+
+void GameTable::handleClientDrawDeck(const std::string& playerName, RequestId requestId) {
+    dispatchAction(playerName, requestId, [&](RoundManager& rm) {
+        return rm.handleDrawDeckRequest();
+    });
+}
+
+void GameTable::handleClientTakeDiscardPile(const std::string& playerName, RequestId requestId) {
+    dispatchAction(playerName, requestId, [&](RoundManager& rm) {
+        return rm.handleTakeDiscardPileRequest();
+    });
+}
+
+void GameTable::handleClientMeld(const std::string& playerName, RequestId requestId,
+    const std::vector<MeldRequest>& meldRequests) {
+    dispatchAction(playerName, requestId, [&](RoundManager& rm) {
+        return rm.handleMeldRequest(meldRequests);
+    });
+}
+
+void GameTable::handleClientDiscard(const std::string& playerName, RequestId requestId,
+    const Card& cardToDiscard) {
+    dispatchAction(playerName, requestId, [&](RoundManager& rm) {
+        return rm.handleDiscardRequest(cardToDiscard);
+    });
+}
+
+void GameTable::handleClientRevert(const std::string& playerName, RequestId requestId) {
+    dispatchAction(playerName, requestId, [&](RoundManager& rm) {
+        return rm.handleRevertRequest();
+    });
+}
\ No newline at end of file
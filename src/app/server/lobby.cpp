@@ -0,0 +1,50 @@
+#include "server/lobby.hpp"
+#include <algorithm>
+
+Lobby::Lobby(std::size_t shardCount, std::size_t playersCount, HostingMode mode)
+    : shardCount(shardCount), playersCount(playersCount), mode(mode) {}
+
+std::expected<TableSeat, std::string> Lobby::seat(const std::string& playerName) {
+    if (playerNames.contains(playerName))
+        return std::unexpected("Name already taken.");
+    if (!fillingTable) {
+        if (mode == HostingMode::SingleGame && nextTableId > 0)
+            return std::unexpected("Game is full.");
+        fillingTable = TableSeat{nextShard, nextTableId++};
+        nextShard = (nextShard + 1) % shardCount;
+        openTables[*fillingTable];
+    }
+    TableSeat seat = *fillingTable;
+    auto& players = openTables[seat];
+    players.push_back(playerName);
+    playerNames.insert(playerName);
+    if (players.size() == playersCount)
+        fillingTable.reset();
+    return seat;
+}
+
+bool Lobby::abandonSeat(const std::string& playerName, const TableSeat& seat) {
+    auto table = openTables.find(seat);
+    if (table == openTables.end())
+        return false; // Closed meanwhile, the name is already free
+    if (fillingTable != seat)
+        return true; // Full: its players wait for someone who will not come
+    std::erase(table->second, playerName);
+    playerNames.erase(playerName);
+    return false;
+}
+
+void Lobby::closeTable(const TableSeat& seat) {
+    auto table = openTables.find(seat);
+    if (table == openTables.end())
+        return;
+    for (const auto& playerName : table->second)
+        playerNames.erase(playerName);
+    openTables.erase(table);
+    if (fillingTable == seat)
+        fillingTable.reset();
+}
+
+bool Lobby::isOpen(const TableSeat& seat) const {
+    return openTables.contains(seat);
+}
@@ -1,4 +1,5 @@
 #include "server/round_manager.hpp"
+#include "invariant.hpp"
 #include "server/turn_manager.hpp"
 #include "player.hpp"
 #include "team_round_state.hpp"
@@ -16,14 +17,15 @@
 RoundManager::RoundManager(
     const std::vector<std::reference_wrapper<Player>>& players,
     std::reference_wrapper<const Team> team1,
-    std::reference_wrapper<const Team> team2
+    std::reference_wrapper<const Team> team2,
+    std::optional<std::uint32_t> deckSeed
 ) : playersInTurnOrder(players),
     team1(team1), // Store player lists for lookup
     team2(team2),
     team1State(), // Default construct TeamRoundState
     team2State(),
     roundPhase(RoundPhase::NotStarted),
-    serverDeck(), // Default constructor initializes and shuffles
+    serverDeck(deckSeed.has_value() ? ServerDeck(*deckSeed) : ServerDeck()), // Initializes and shuffles
     currentPlayerIndex(0), // Starting player index
     playerWhoWentOut(std::nullopt), // Initialize optional member
     isMainDeckEmpty(false) // Initialize deck empty flag
@@ -63,12 +65,12 @@ TurnActionResult RoundManager::handleDrawDeckRequest() {
     if (roundPhase != RoundPhase::InProgress || !currentTurnManager)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "Not player's turn or round not in progress."
+            ActionMessageCode::RoundNotInProgress
         };
     if (isMainDeckEmpty)
         return {
             TurnActionStatus::Error_MainDeckEmpty,
-            "Main deck is empty. Try taking the discard pile."
+            ActionMessageCode::MainDeckEmpty
         };
     TurnActionResult result = currentTurnManager->handleDrawDeck();
     processTurnResult(result);
@@ -77,13 +79,13 @@ TurnActionResult RoundManager::handleDrawDeckRequest() {
 
 TurnActionResult RoundManager::handleTakeDiscardPileRequest() {
     if (roundPhase != RoundPhase::InProgress || !currentTurnManager) {
-        return {TurnActionStatus::Error_InvalidAction, "Not player's turn or round not in progress."};
+        return {TurnActionStatus::Error_InvalidAction, ActionMessageCode::RoundNotInProgress};
     }
     TurnActionResult result = currentTurnManager->handleTakeDiscardPile();
     if (result.getStatus() != TurnActionStatus::Success_TurnContinues && isMainDeckEmpty)
         result = {
             TurnActionStatus::Error_MainDeckEmptyDiscardPileCantBeTaken,
-            "Main deck is empty. Discard pile can't be taken."
+            ActionMessageCode::MainDeckEmptyPileCantBeTaken
         };
     processTurnResult(result);
     return result;
@@ -91,7 +93,7 @@ TurnActionResult RoundManager::handleTakeDiscardPileRequest() {
 
 TurnActionResult RoundManager::handleMeldRequest(const std::vector<MeldRequest>& meldRequests) {
     if (roundPhase != RoundPhase::InProgress || !currentTurnManager) {
-        return {TurnActionStatus::Error_InvalidAction, "Not player's turn or round not in progress."};
+        return {TurnActionStatus::Error_InvalidAction, ActionMessageCode::RoundNotInProgress};
     }
     TurnActionResult result = currentTurnManager->handleMelds(meldRequests);
     processTurnResult(result);
@@ -100,7 +102,7 @@ TurnActionResult RoundManager::handleMeldRequest(const std::vector<MeldRequest>&
 
 TurnActionResult RoundManager::handleDiscardRequest(const Card& cardToDiscard) {
     if (roundPhase != RoundPhase::InProgress || !currentTurnManager) {
-        return {TurnActionStatus::Error_InvalidAction, "Not player's turn or round not in progress."};
+        return {TurnActionStatus::Error_InvalidAction, ActionMessageCode::RoundNotInProgress};
     }
     TurnActionResult result = currentTurnManager->handleDiscard(cardToDiscard);
     processTurnResult(result);
@@ -109,7 +111,7 @@ TurnActionResult RoundManager::handleDiscardRequest(const Card& cardToDiscard) {
 
 TurnActionResult RoundManager::handleRevertRequest() {
     if (roundPhase != RoundPhase::InProgress || !currentTurnManager) {
-        return {TurnActionStatus::Error_InvalidAction, "Not player's turn or round not in progress."};
+        return {TurnActionStatus::Error_InvalidAction, ActionMessageCode::RoundNotInProgress};
     }
     spdlog::debug("Handling revert request for player: {}", getCurrentPlayer().getName());
     TurnActionResult result = currentTurnManager->handleRevert();
@@ -172,13 +174,13 @@ void RoundManager::dealInitialHands() {
             std::vector<Card> redThreeCards;
             while (true) {
                 auto maybeCard = serverDeck.drawCard();
-                assert(maybeCard.has_value() && "Deck should not be empty when dealing initial hands");
+                CANASTA_INVARIANT(maybeCard.has_value(), "Deck should not be empty when dealing initial hands");
                 Card card = maybeCard.value();
                 if (card.getType() != CardType::RedThree){ // First non-Red Three card
                     if (!redThreeCards.empty()) {
                         auto status = RuleEngine::addRedThreeCardsToMeld(redThreeCards, 
                             playerTeamState.getRedThreeMeld());
-                        assert(status.has_value() && "Failed to add Red Three cards to meld");
+                        CANASTA_INVARIANT(status.has_value(), "Failed to add Red Three cards to meld");
                     }
                     playerHand.addCard(card);
                     break; // Exit loop
@@ -341,4 +343,13 @@ TeamRoundState RoundManager::getTeamStateForTeam(const Team& team) const {
         return team2State.clone();
     }
     throw std::logic_error("Team " + team.getName() + " not found in RoundManager.");
-}
\ No newline at end of file
+}
+std::uint64_t RoundManager::getStateHash() const {
+    std::uint64_t hash = serverDeck.getHash()
+        ^ zobristPlace(ZobristPlace::Team, 0, team1State.getHash())
+        ^ zobristPlace(ZobristPlace::Team, 1, team2State.getHash())
+        ^ zobristPlace(ZobristPlace::CurrentPlayer, 0, currentPlayerIndex);
+    for (std::size_t seat = 0; seat < playersInTurnOrder.size(); ++seat)
+        hash ^= zobristPlace(ZobristPlace::Hand, seat, playersInTurnOrder[seat].get().getHand().getHash());
+    return hash;
+}
@@ -1,15 +1,18 @@
 
 #include "server/server_deck.hpp"
+#include "invariant.hpp"
 #include <stdexcept> // For std::runtime_error (optional, for errors)
 #include <utility>   // For std::move
-#include <cassert>   // For assert
 
 // Constructor - Initializes and shuffles a 108-card Canasta deck
-ServerDeck::ServerDeck(): isDiscardPileFrozen(false),
+ServerDeck::ServerDeck(): ServerDeck(std::random_device{}()) {}
+
+// Constructor - Same as above, with a reproducible shuffle
+ServerDeck::ServerDeck(std::uint32_t seed): isDiscardPileFrozen(false),
                         backupIsDiscardPileFrozen(false),
                         hasPendingReversible(false) {
     initializeMainDeck();
-    shuffle();
+    shuffle(seed);
     initializeDiscardPile();
 }
 
@@ -45,10 +48,11 @@ void ServerDeck::initializeMainDeck() {
 // Initialize the discard pile
 void ServerDeck::initializeDiscardPile() {
     discardPile.clear(); // Ensure discard pile is empty before initializing
+    discardPileHash.clear();
     // Draw cards until a non-Red Three is found for the initial discard
     while (true) {
         std::optional<Card> topCardOpt = drawCard();
-        assert(topCardOpt.has_value() && "Deck should not be empty when initializing discard pile");
+        CANASTA_INVARIANT(topCardOpt.has_value(), "Deck should not be empty when initializing discard pile");
         Card topCard = *topCardOpt;
 
         if (topCard.getType() == CardType::RedThree) {
@@ -64,9 +68,8 @@ void ServerDeck::initializeDiscardPile() {
 }
 
 // Shuffle the main deck
-void ServerDeck::shuffle() {
-    std::random_device rd;
-    std::mt19937 g(rd());
+void ServerDeck::shuffle(std::uint32_t seed) {
+    std::mt19937 g(seed);
     std::shuffle(mainDeck.begin(), mainDeck.end(), g);
 }
 
@@ -84,6 +87,7 @@ std::optional<Card> ServerDeck::drawCard() {
 // Add a card to the discard pile
 void ServerDeck::discardCard(const Card& card) {
     discardPile.push_back(card);
+    discardPileHash.add(card);
     // Freeze the pile if a Black Three or a wild card (Joker, Two) is discarded
     CardType type = card.getType();
     if (type == CardType::BlackThree || type == CardType::Wild) {
@@ -126,6 +130,7 @@ ServerDeck::takeDiscardPile(bool reversible) {
     std::vector<Card> takenPile = std::move(discardPile);
     // discardPile is now guaranteed to be empty after the move
     discardPile.clear(); // Explicitly clear just in case (though move should suffice)
+    discardPileHash.clear();
     unfreezePile();      // Taking the pile always unfreezes it
     return takenPile;
 }
@@ -136,6 +141,7 @@ void ServerDeck::revertTakeDiscardPile() {
         throw std::logic_error("No reversible action to revert");
     }
     discardPile = std::move(backupDiscardPile);
+    discardPileHash = CardMultisetHash(discardPile);
     isDiscardPileFrozen = backupIsDiscardPileFrozen;
     hasPendingReversible = false;
 }
@@ -165,6 +171,15 @@ bool ServerDeck::isFrozen() const {
     return isDiscardPileFrozen;
 }
 
+// Hash of the pile cards combined with the top card, the frozen flag and the main deck size
+std::uint64_t ServerDeck::getHash() const {
+    std::uint64_t topKind = discardPile.empty() ? CARD_KIND_COUNT : cardKindIndex(discardPile.back());
+    return zobristPlace(ZobristPlace::DiscardPile, 0, discardPileHash.value())
+        ^ zobristPlace(ZobristPlace::DiscardTop, 0, topKind)
+        ^ zobristPlace(ZobristPlace::DiscardFrozen, 0, isDiscardPileFrozen)
+        ^ zobristPlace(ZobristPlace::MainDeckSize, 0, mainDeck.size());
+}
+
 // --- Private Methods ---
 
 // Explicitly freeze the discard pile.
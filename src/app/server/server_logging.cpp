@@ -38,15 +38,20 @@ namespace spdlog {
     } // namespace sinks
 } // namespace spdlog
 
+std::filesystem::path getLogDirectory()
+{
+    namespace fs = std::filesystem;
+    if (auto* env = std::getenv("LOG_DIR")) return env;
+    return fs::current_path().parent_path().parent_path() / "logs";
+}
+
 void initLogger()
 {
     namespace fs = std::filesystem;
     namespace lvl = spdlog::level;
     
     // Create a directory for logs if it doesn't exist
-    fs::path logDir;
-    if (auto* env = std::getenv("LOG_DIR")) logDir = env;
-    else                                   logDir = fs::current_path().parent_path().parent_path() / "logs";
+    fs::path logDir = getLogDirectory();
     fs::create_directories(logDir);
 
     spdlog::init_thread_pool(8192, 1);
@@ -6,13 +6,15 @@
 #include <thread>
 #include <chrono>
 #include <sstream>
+#include <algorithm>
 #include "spdlog/spdlog.h"
 #include "asio.hpp"
 #include "cereal/archives/binary.hpp"
 #include <cereal/types/string.hpp>
 #include "server/server_logging.hpp"
-#include "server/server_network.hpp"
-#include "server/game_manager.hpp"
+#include "server/server_tracing.hpp"
+#include "server/server_profiling.hpp"
+#include "server/sharded_server.hpp"
 
 #include "game_state.hpp"
 //#include "cereal/cereal.hpp"
@@ -25,6 +27,7 @@
 
 // Server constants
 constexpr int PORT = 12345;
+constexpr int DEFAULT_STATS_INTERVAL_SECONDS = 15;
 
 // Launch a terminal for each player
 void launchTerminal(int playerIndex) {
@@ -52,6 +55,44 @@ void detectOSAndLaunchTerminals(int playersCount) {
     }
 }
 
+// Write the trace spans recorded so far next to the logs
+void dumpTrace() {
+    static int dumpCount = 0;
+    auto path = getLogDirectory() / ("trace-" + std::to_string(++dumpCount) + ".json");
+    auto spanCount = ServerTracing::dumpChromeTrace(path);
+    if (spanCount.has_value())
+        spdlog::info("Wrote {} trace spans to {}", spanCount.value(), path.string());
+    else
+        spdlog::error("Could not write the trace to {}", path.string());
+}
+
+#ifndef _WIN32
+// Dump the trace each time SIGUSR1 is received (kill -USR1 <server pid>)
+void awaitTraceDumpSignal(asio::signal_set& signals) {
+    signals.async_wait([&signals](const asio::error_code& error, int /*signal*/) {
+        if (error)
+            return; // Cancelled on shutdown
+        dumpTrace();
+        awaitTraceDumpSignal(signals);
+    });
+}
+#endif
+
+// Rewrite the stats file every interval, for the node exporter textfile collector
+void scheduleStatsExport(asio::steady_timer& timer, std::chrono::seconds interval) {
+    timer.expires_after(interval);
+    timer.async_wait([&timer, interval](const asio::error_code& error) {
+        if (error)
+            return; // Cancelled on shutdown
+        auto path = getLogDirectory() / "canasta_server.prom";
+        if (!ServerProfiling::writePrometheusFile(path))
+            spdlog::error("Could not write the stats to {}", path.string());
+        scheduleStatsExport(timer, interval);
+    });
+}
+
+// Usage: canasta_server <2|4> [--no-terminals] [--trace[=N]] [--stats[=seconds]] [--rate-limit=N] [--wire=binary|compact]
+//                      [--shards[=N]]
 int main(int argc, char* argv[]) {
     initLogger();
     if (argc < 2) {
@@ -59,6 +100,44 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     int playersCount = std::stoi(argv[1]);
+    bool launchTerminals = true;
+    int statsIntervalSeconds = 0; // No export
+    double actionsPerSecond = DEFAULT_ACTIONS_PER_SECOND;
+    WireFormat wireFormat = WireFormat::Compact;
+    std::size_t shardCount = 1;
+    HostingMode hostingMode = HostingMode::SingleGame;
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--no-terminals") {
+            // Clients started separately (e.g. headless ones) need no terminal windows
+            launchTerminals = false;
+        } else if (option == "--trace") {
+            ServerTracing::enable(1);
+        } else if (option.starts_with("--trace=")) {
+            // Trace one request out of N
+            ServerTracing::enable(static_cast<std::uint32_t>(std::stoul(option.substr(8))));
+        } else if (option == "--stats") {
+            statsIntervalSeconds = DEFAULT_STATS_INTERVAL_SECONDS;
+        } else if (option.starts_with("--stats=")) {
+            statsIntervalSeconds = std::max(1, std::stoi(option.substr(8)));
+        } else if (option.starts_with("--rate-limit=")) {
+            // Actions per second allowed to each client, 0 for no limit
+            actionsPerSecond = std::max(0.0, std::stod(option.substr(13)));
+        } else if (option == "--wire=binary") {
+            // Keep every client on the binary archive, e.g. to compare frame sizes
+            wireFormat = WireFormat::Binary;
+        } else if (option == "--wire=compact") {
+            wireFormat = WireFormat::Compact;
+        } else if (option == "--shards" || option.starts_with("--shards=")) {
+            // Host tables until stopped, on one shard per core or the given number of shards
+            hostingMode = HostingMode::Tables;
+            shardCount = option == "--shards" ? std::max(1u, std::thread::hardware_concurrency()) :
+                static_cast<std::size_t>(std::max(1, std::stoi(option.substr(9))));
+        } else {
+            spdlog::error("Unknown option: {}", option);
+            return 1;
+        }
+    }
     if (playersCount != 2 && playersCount != 4) {
         spdlog::error("Invalid number of players. Must be either 2 or 4.");
         return 1;
@@ -66,25 +145,51 @@ int main(int argc, char* argv[]) {
     spdlog::info("----------Canasta Server is starting----------");
 
     try {
-        // 3) construct the core game manager
-        GameManager gameManager(static_cast<std::size_t>(playersCount));
-
-        // 4) set up ASIO
-        asio::io_context ioContext;
-
-        // listen on all interfaces, port SERVER_PORT
+        // listen on all interfaces, port SERVER_PORT; each shard runs its own io_context and tables
         asio::ip::tcp::endpoint endpoint{ asio::ip::tcp::v4(), PORT};
-        ServerNetwork server(ioContext, endpoint, gameManager);
+        ShardedServer server(shardCount, endpoint, static_cast<std::size_t>(playersCount), hostingMode);
+        server.setActionRateLimit(actionsPerSecond, std::max(DEFAULT_ACTION_BURST, 2 * actionsPerSecond));
+        server.setWireFormat(wireFormat);
+        if (hostingMode == HostingMode::Tables)
+            spdlog::info("Hosting tables of {} players on {} shards", playersCount, shardCount);
+
+        // Timers and signals are handled on the first shard
+        asio::io_context& ioContext = server.getShard(0).getIoContext();
+        asio::steady_timer statsTimer(ioContext);
+        if (statsIntervalSeconds > 0) {
+            ServerProfiling::enable();
+            scheduleStatsExport(statsTimer, std::chrono::seconds(statsIntervalSeconds));
+        }
 
-        // 5) begin accepting connections
-        server.startAccept();
+#ifndef _WIN32
+        asio::signal_set traceDumpSignals(ioContext);
+        if (ServerTracing::isEnabled()) {
+            traceDumpSignals.add(SIGUSR1);
+            awaitTraceDumpSignal(traceDumpSignals);
+        }
+        // Hosting tables goes on until the server is stopped
+        asio::signal_set stopSignals(ioContext);
+        if (hostingMode == HostingMode::Tables) {
+            stopSignals.add(SIGTERM);
+            stopSignals.add(SIGINT);
+            stopSignals.async_wait([&server](const asio::error_code& error, int /*signal*/) {
+                if (!error)
+                    server.stop();
+            });
+        }
+#endif
 
         // 6) fire up each client in its own terminal window
-        detectOSAndLaunchTerminals(playersCount);
+        if (launchTerminals)
+            detectOSAndLaunchTerminals(playersCount);
 
-        // 7) run the ASIO loop (this will block until you call ioContext.stop())
-        ioContext.run();
+        // 7) accept connections and run the shards (this will block until you call server.stop())
+        server.run();
 
+        if (ServerTracing::isEnabled())
+            dumpTrace();
+        if (ServerProfiling::isEnabled())
+            ServerProfiling::writePrometheusFile(getLogDirectory() / "canasta_server.prom");
         spdlog::info("Server shutting down cleanly.");
     }
     catch (std::exception& e) {
@@ -1,192 +1,357 @@
 #include "server/server_network.hpp"
-#include "server/game_manager.hpp"
+#include "invariant.hpp"
+#include "server/game_table.hpp"
+#include "server/sharded_server.hpp"
 #include "server/turn_manager.hpp" // TurnActionResult, MeldRequest
-#include "game_state.hpp"   // ClientGameState
-#include "player.hpp"       // Needed for assembling state
-#include "server/make_state.hpp"
 #include "spdlog/spdlog.h"
 #include <stdexcept>
+#include <algorithm>
 #include <vector>
 
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 
 // --- Session Implementation ---
 
-Session::Session(asio::ip::tcp::socket socket, ServerNetwork& serverNetwork, asio::strand<asio::io_context::executor_type>& gameStrand)
-    :   socket(std::move(socket)),
+SessionPtr Session::create(std::shared_ptr<SessionPool> pool, asio::ip::tcp::socket socket,
+    ServerNetwork& serverNetwork) {
+    void* block = pool->allocate();
+    try {
+        SessionBuffers buffers = pool->acquireBuffers();
+        return SessionPtr(new (block) Session(pool, std::move(buffers), std::move(socket), serverNetwork));
+    } catch (...) {
+        pool->deallocate(block);
+        throw;
+    }
+}
+
+Session::Session(std::shared_ptr<SessionPool> pool, SessionBuffers buffers, asio::ip::tcp::socket socket,
+    ServerNetwork& serverNetwork)
+    :   pool(std::move(pool)),
+        socket(std::move(socket)),
         serverNetwork(serverNetwork),
-        gameStrand(gameStrand),
-        incomingMsgSize(0),
-        joined(false)
+        reader(std::move(buffers.readBuffer)),
+        writeMsgs(std::move(buffers.writeQueue)),
+        writeBuffers(std::move(buffers.writeBuffers)),
+        writeSignal(this->socket.get_executor(), asio::steady_timer::time_point::max()),
+        loginDeadline(this->socket.get_executor()),
+        deliverMemory(*this),
+        requestMemory(*this),
+        joined(false),
+        actionLimiter(serverNetwork.actionBurst, serverNetwork.actionsPerSecond)
 {}
 
+Session::~Session() {
+    pool->releaseBuffers({reader.releaseBuffer(), std::move(writeMsgs), std::move(writeBuffers)});
+}
+
+void Session::addReference() noexcept {
+    references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Session::releaseReference() noexcept {
+    // Everything done through other references happens before the destruction
+    if (references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    std::shared_ptr<SessionPool> sessionPool = pool;
+    this->~Session();
+    sessionPool->deallocate(this);
+}
+
 void Session::start() {
     // Initially, expect a Login message from the client
-    spdlog::info("Session started for {}. Waiting for Login.", socket.remote_endpoint().address().to_string());
-    doReadHeader();
-}
-
-void Session::deliver(const std::vector<char>& message) {
-    // Post the write operation to the socket's implicit strand
-    asio::post(socket.get_executor(),
-        [this, self = shared_from_this(), message]() {
-            bool writeInProgress = !writeMsgs.empty();
-            writeMsgs.push_back(message);
-            if (!writeInProgress) {
-                doWrite();
-            }
-        });
+    asio::error_code ec;
+    auto endpoint = socket.remote_endpoint(ec); // Fails if the client is already gone, as the first read will
+    spdlog::info("Session started for {}. Waiting for Login.", endpoint.address().to_string());
+    socket.set_option(asio::ip::tcp::no_delay(true), ec); // Frames are small and already batched by the write loop
+    spawnLoops(true);
 }
 
-const std::string& Session::getPlayerName() const {
-    return playerName;
+void Session::resume(std::string playerName, WireFormat format) {
+    this->playerName = std::move(playerName);
+    wireFormat.store(format, std::memory_order_release);
+    seatRequested = true; // Granted on the shard the player logged in on
+    asio::error_code ec;
+    socket.set_option(asio::ip::tcp::no_delay(true), ec); // Not inherited from the released socket's options
+    spawnLoops(false);
 }
 
-void Session::doReadHeader() {
-    readMsgBuffer.resize(sizeof(std::uint32_t)); // Prepare buffer for 4-byte size header
-    asio::async_read(socket, asio::buffer(readMsgBuffer),
-        [this, self = shared_from_this()](const asio::error_code& error, std::size_t bytes_transferred) {
-            handleReadHeader(error, bytes_transferred);
-        });
+void Session::spawnLoops(bool awaitingLogin) {
+    if (awaitingLogin) {
+        loginDeadline.expires_after(LOGIN_TIMEOUT);
+        awaitLoginDeadline();
+    }
+    // Each loop keeps the session alive until it ends
+    asio::co_spawn(socket.get_executor(), [self = SessionPtr(this)] { return self->readLoop(); }, asio::detached);
+    asio::co_spawn(socket.get_executor(), [self = SessionPtr(this)] { return self->writeLoop(); }, asio::detached);
 }
 
-void Session::handleReadHeader(const asio::error_code& error, std::size_t /*bytes_transferred*/) {
-    if (!error) {
-        // Copy header data and convert from network to host byte order
-        std::memcpy(&incomingMsgSize, readMsgBuffer.data(), sizeof(std::uint32_t));
-        incomingMsgSize = asio::detail::socket_ops::network_to_host_long(incomingMsgSize);
-
-        // Basic sanity check for message size (e.g., prevent huge allocations)
-        if (incomingMsgSize > MAX_MESSAGE_SIZE) { // Example limit: 64k
-            spdlog::error("Error: Incoming message size too large ({}) from {}", incomingMsgSize, playerName);
-            serverNetwork.leave(shared_from_this()); // Disconnect client
+void Session::awaitLoginDeadline() {
+    loginDeadline.async_wait([this, self = SessionPtr(this)](const asio::error_code& error) {
+        if (error || joined || !socket.is_open())
+            return; // Cancelled, seated or already closed
+        if (seatRequested) {
+            // The lobby has the Login; look again once it had time to answer
+            loginDeadline.expires_after(LOGIN_TIMEOUT);
+            awaitLoginDeadline();
             return;
         }
+        spdlog::error("No Login within {} s, closing the connection.", LOGIN_TIMEOUT.count());
+        close(); // The read loop ends on the closed socket
+    });
+}
 
-        doReadBody();
-    } else {
-        if (error != asio::error::operation_aborted) {
-            spdlog::error("Error reading header from {}: {}", playerName, error.message());
-            serverNetwork.leave(shared_from_this());
-        }
-         // else: operation aborted, likely during shutdown, do nothing
-    }
+void Session::joinTable(std::shared_ptr<GameTable> table) {
+    this->table = std::move(table);
+    joined = true;
+    loginDeadline.cancel();
 }
 
-void Session::doReadBody() {
-    readMsgBuffer.resize(incomingMsgSize); // Resize buffer for the message body
-    asio::async_read(socket, asio::buffer(readMsgBuffer),
-        [this, self = shared_from_this()](const asio::error_code& error, std::size_t bytes_transferred) {
-            handleReadBody(error, bytes_transferred);
-        });
+void Session::endSeatRequest() {
+    seatRequested = false;
 }
 
-void Session::handleReadBody(const asio::error_code& error, std::size_t /*bytes_transferred*/) {
-    if (!error) {
-        processMessage(); // Process the complete message
-        doReadHeader();   // Start reading the next message header
-    } else {
-        if (error != asio::error::operation_aborted) {
-            spdlog::error("Error reading body from {}: {}", playerName, error.message());
-            serverNetwork.leave(shared_from_this());
-        }
-          // else: operation aborted
-    }
+const std::shared_ptr<GameTable>& Session::getTable() const {
+    return table;
 }
 
-void Session::doWrite() {
-    if (writeMsgs.empty()) return; // Should not happen if called correctly
+bool Session::isConnected() const {
+    return socket.is_open();
+}
 
-    asio::async_write(socket, asio::buffer(writeMsgs.front()),
-        [this, self = shared_from_this()](const asio::error_code& error, std::size_t bytes_transferred) {
-            handleWrite(error, bytes_transferred);
-        });
+ConnectionHandoff Session::releaseConnection() {
+    auto protocol = socket.local_endpoint().protocol();
+    // Cancels the pending read, and the read loop ends as the socket is no longer open
+    auto handle = socket.release();
+    writeSignal.cancel();
+    loginDeadline.cancel();
+    return ConnectionHandoff(protocol, handle, playerName, getWireFormat());
+}
+
+void Session::deliver(std::vector<char> message, TraceId traceId) {
+    auto queuedAt = ServerTracing::now();
+    // Queue right away when already on the socket's executor, as when answering from the read loop
+    asio::dispatch(socket.get_executor(), bindHandlerMemory(deliverMemory,
+        [this, self = SessionPtr(this), message = std::move(message), traceId, queuedAt]() mutable {
+            writeMsgs.push_back({std::move(message), traceId, queuedAt});
+            writeSignal.cancel(); // Wakes the write loop if it waits for messages
+        }));
+}
+
+const std::string& Session::getPlayerName() const {
+    return playerName;
+}
+
+void Session::setHasTurn(bool hasTurn) {
+    this->hasTurn.store(hasTurn, std::memory_order_release);
+}
+
+WireFormat Session::getWireFormat() const {
+    return wireFormat.load(std::memory_order_acquire);
 }
 
-void Session::handleWrite(const asio::error_code& error, std::size_t /*bytes_transferred*/) {
-    if (!error) {
-        writeMsgs.pop_front();
-        if (!writeMsgs.empty()) {
-            doWrite(); // Write next message in queue
+void Session::shedAction(RequestId requestId, ShedReason reason) {
+    ServerProfiling::recordShedAction(reason);
+    ActionMessageCode errorCode = reason == ShedReason::RateLimited ?
+        ActionMessageCode::TooManyRequests : ActionMessageCode::NotYourTurn;
+    spdlog::debug("Shedding request #{} from {}: {}", requestId, playerName, ActionMessage(errorCode).toString());
+    ActionError actionError{errorCode, std::nullopt, requestId};
+    deliver(serializeMessage(getWireFormat(), ServerMessageType::ActionError, actionError));
+}
+
+asio::awaitable<void> Session::readLoop() {
+    for (;;) {
+        asio::error_code error;
+        std::size_t bytesRead =
+            co_await socket.async_read_some(reader.prepare(), asio::redirect_error(asio::use_awaitable, error));
+        if (error) {
+            if (!socket.is_open())
+                co_return; // Closed after a write error, a missed login deadline or handed off, already handled
+            if (error == asio::error::operation_aborted)
+                spdlog::info("Read from {} cancelled, closing the connection.", playerName);
+            else
+                spdlog::error("Error reading from {}: {}", playerName, error.message());
+            serverNetwork.leave(SessionPtr(this));
+            close();
+            co_return;
         }
-    } else {
-        if (error != asio::error::operation_aborted) {
-            spdlog::error("Error writing to {}: {}", playerName, error.message());
-            serverNetwork.leave(shared_from_this());
-        } else {
-            spdlog::debug("Write operation aborted (likely during disconnect).");
+        if (!reader.hasPartialMessage())
+            readStartTime = ServerTracing::now();
+        reader.commit(bytesRead);
+
+        // Process every complete message before reading again
+        try {
+            while (auto frame = reader.next())
+                processMessage(*frame);
+        } catch (const std::length_error& e) {
+            spdlog::error("Error: {} from {}", e.what(), playerName);
+            serverNetwork.leave(SessionPtr(this)); // Disconnect client
+            close();
+            co_return;
+        }
+    }
+}
+
+asio::awaitable<void> Session::writeLoop() {
+    while (socket.is_open()) {
+        if (writeMsgs.empty()) {
+            asio::error_code error;
+            co_await writeSignal.async_wait(asio::redirect_error(asio::use_awaitable, error));
+            continue; // Cancelled by deliver or close
+        }
+        // Everything queued so far goes in one write; messages queued meanwhile wait for the next one
+        writeBuffers.clear();
+        for (const auto& message : writeMsgs)
+            writeBuffers.push_back(asio::buffer(message.data));
+        asio::error_code error;
+        co_await asio::async_write(socket, writeBuffers,
+            asio::cancel_after(WRITE_TIMEOUT, asio::redirect_error(asio::use_awaitable, error)));
+        if (error) {
+            if (!socket.is_open()) {
+                spdlog::debug("Write operation aborted (likely during disconnect).");
+                co_return;
+            }
+            if (error == asio::error::operation_aborted)
+                spdlog::error("Writing to {} timed out after {} s", playerName, WRITE_TIMEOUT.count());
+            else
+                spdlog::error("Error writing to {}: {}", playerName, error.message());
+            serverNetwork.leave(SessionPtr(this));
+            close();
+            co_return;
         }
+        auto writtenAt = TraceClock::now();
+        auto writtenEnd = writeMsgs.begin() + static_cast<std::ptrdiff_t>(writeBuffers.size());
+        for (auto written = writeMsgs.begin(); written != writtenEnd; ++written)
+            ServerTracing::record("write", written->traceId, written->queuedAt, writtenAt);
+        writeMsgs.erase(writeMsgs.begin(), writtenEnd);
     }
 }
 
-void Session::processMessage() {
+void Session::close() {
+    asio::error_code ec;
+    socket.close(ec);
+    writeSignal.cancel();
+    loginDeadline.cancel();
+}
+
+void Session::processMessage(std::span<const char> frame) {
+    auto decodeStartTime = ServerTracing::now();
     ClientMessageType msgType;
     try {
-        std::istringstream is(std::string(readMsgBuffer.begin(), readMsgBuffer.end()), std::ios::binary);
-        cereal::BinaryInputArchive archive(is);
-
-        archive(msgType); // Read the message type first
+        FrameStreamBuffer frameBuffer(frame);
+        std::istream is(&frameBuffer);
+        RequestId requestId = NO_REQUEST_ID;
 
         if (!joined) {
-            // Only accept Login message if not joined
-            processLoginMessage(msgType, archive);
+            // Only accept Login message if not joined; it is always binary
+            cereal::BinaryInputArchive archive(is);
+            archive(msgType); // Read the message type first
+            archive(requestId); // Every client message carries its request id
+            processLoginMessage(msgType, is, archive);
         } else {
             // If joined, process game actions. Deserialize payload *before* posting to strand.
-            processGameMessage(msgType, archive);
+            TraceId traceId = ServerTracing::startTrace();
+            TraceScope traceScope(traceId); // Followed to the strand and into the replies
+            decodeMessage(getWireFormat(), is, [&](auto& archive) {
+                archive(msgType);
+                archive(requestId);
+                spdlog::debug("Request #{} from {}: type {}", requestId, playerName, static_cast<int>(msgType));
+                processGameMessage(msgType, requestId, archive);
+            });
+            ServerTracing::record("read", traceId, readStartTime, decodeStartTime);
+            ServerTracing::record("decode", traceId, decodeStartTime, TraceClock::now());
         }
     } catch (const cereal::Exception& e) {
         spdlog::error("Deserialization error for {} (MsgType: {}): {}", playerName, static_cast<int>(msgType), e.what());
         // Consider disconnecting client on bad message format
-        serverNetwork.leave(shared_from_this());
+        serverNetwork.leave(SessionPtr(this));
     } catch (const std::exception& e) {
         spdlog::error("Error processing message for {}: {}", playerName, e.what());
         // Consider disconnecting client
-        serverNetwork.leave(shared_from_this());
+        serverNetwork.leave(SessionPtr(this));
     }
 }
 
-void Session::processLoginMessage(ClientMessageType msgType, cereal::BinaryInputArchive& archive) {
+void Session::processLoginMessage(ClientMessageType msgType, std::istream& payload,
+    cereal::BinaryInputArchive& archive) {
     if (msgType != ClientMessageType::Login) {
         spdlog::error("Expected Login but got {} from unjoined client {}. Ignoring.", 
             int(msgType), socket.remote_endpoint().address().to_string());
         return; // or call serverNetwork.leave(...)
     }
+    if (seatRequested) {
+        // The name of the first Login is held in the lobby until it answers
+        spdlog::warn("Ignoring another Login from {} while the first one is handled.", playerName);
+        return;
+    }
     std::string nameAttempt;
-    archive(nameAttempt); // Deserialize player name
-    // Dispatch login attempt to the server network logic (which might check name validity/availability)
-    asio::post(serverNetwork.ioContext, [this, self = shared_from_this(), nameAttempt]() {
-        // Basic validation: Check if name is empty
-        if (nameAttempt.empty()) {
-            spdlog::error("Login failed: Empty name received.");
-            auto errorMsg = serializeMessage(ServerMessageType::LoginFailure, std::string("Name cannot be empty."));
-            deliver(errorMsg);
+    loadBoundedString(archive, nameAttempt, MAX_DECODED_STRING_SIZE); // Deserialize player name
+    WireFormat requestedFormat = WireFormat::Binary; // What clients asking for nothing understand
+    if (hasMoreFields(payload))
+        archive(requestedFormat);
+    // Basic validation: Check if name is empty
+    if (nameAttempt.empty()) {
+        spdlog::error("Login failed: Empty name received.");
+        auto errorMsg = serializeMessage(ServerMessageType::LoginFailure, std::string("Name cannot be empty."));
+        deliver(std::move(errorMsg));
+        return;
+    }
+    playerName = std::move(nameAttempt);
+    // Unknown formats from newer clients fall back to the best one the server grants
+    wireFormat.store(std::min(requestedFormat, serverNetwork.maxWireFormat), std::memory_order_release);
+    // The lobby checks the name and seats the player, on this shard or another one
+    seatRequested = true;
+    serverNetwork.login(SessionPtr(this));
+}
+
+template <typename Handler>
+void Session::postToGameStrand(ClientMessageType msgType, Handler&& handler) {
+    auto postedAt = ServerTracing::now();
+    asio::post(table->getStrand(), bindHandlerMemory(requestMemory,
+        [msgType, traceId = ServerTracing::currentTrace(), postedAt,
+            handler = std::forward<Handler>(handler)]() mutable {
+            TraceScope traceScope(traceId);
+            ServerTracing::record("strand_wait", traceId, postedAt, TraceClock::now());
+            ActionProfile profile(msgType);
+            handler();
+        }));
+}
+
+template <class Archive>
+void Session::processGameMessage(ClientMessageType msgType, RequestId requestId, Archive& archive) {
+    // Shed floods and out of turn actions before decoding their payload or touching the strand
+    if (msgType != ClientMessageType::Login) {
+        if (!actionLimiter.tryConsume()) {
+            shedAction(requestId, ShedReason::RateLimited);
             return;
         }
-        playerName = nameAttempt;
-        auto joinStatus = serverNetwork.join(shared_from_this(), playerName);
-        if (joinStatus.has_value()){
-            joined = true;
+        if (!hasTurn.load(std::memory_order_acquire)) {
+            shedAction(requestId, ShedReason::OutOfTurn);
+            return;
         }
-    });
-}
-
-void Session::processGameMessage(ClientMessageType msgType, cereal::BinaryInputArchive& archive) {
+    }
     switch (msgType) {
         case ClientMessageType::DrawDeck:
-            asio::post(gameStrand, [this, self = shared_from_this()]() {
-                serverNetwork.handleClientDrawDeck(playerName);
+            postToGameStrand(msgType, [this, self = SessionPtr(this), requestId]() {
+                table->handleClientDrawDeck(playerName, requestId);
             });
             break;
         case ClientMessageType::TakeDiscardPile:
-            asio::post(gameStrand, [this, self = shared_from_this()]() {
-                serverNetwork.handleClientTakeDiscardPile(playerName);
+            postToGameStrand(msgType, [this, self = SessionPtr(this), requestId]() {
+                table->handleClientTakeDiscardPile(playerName, requestId);
             });
             break;
         case ClientMessageType::Meld:
             {
                 std::vector<MeldRequest> requests;
-                archive(requests); // Deserialize payload now
-                asio::post(gameStrand, [this, self = shared_from_this(), requests /* capture data */]() {
-                    serverNetwork.handleClientMeld(playerName, requests);
+                loadBoundedVector(archive, requests, MAX_DECODED_MELD_REQUESTS); // Deserialize payload now
+                postToGameStrand(msgType, [this, self = SessionPtr(this), requestId, requests /* capture data */]() {
+                    table->handleClientMeld(playerName, requestId, requests);
                 });
             }
             break;
@@ -194,14 +359,14 @@ void Session::processGameMessage(ClientMessageType msgType, cereal::BinaryInputA
             {
                 Card cardToDiscard;
                 archive(cardToDiscard); // Deserialize payload now
-                asio::post(gameStrand, [this, self = shared_from_this(), cardToDiscard /* capture data */]() {
-                    serverNetwork.handleClientDiscard(playerName, cardToDiscard);
+                postToGameStrand(msgType, [this, self = SessionPtr(this), requestId, cardToDiscard /* capture data */]() {
+                    table->handleClientDiscard(playerName, requestId, cardToDiscard);
                 });
             }
             break;
         case ClientMessageType::Revert:
-            asio::post(gameStrand, [this, self = shared_from_this()]() {
-                serverNetwork.handleClientRevert(playerName);
+            postToGameStrand(msgType, [this, self = SessionPtr(this), requestId]() {
+                table->handleClientRevert(playerName, requestId);
             });
             break;
         case ClientMessageType::Login:
@@ -216,27 +381,94 @@ void Session::processGameMessage(ClientMessageType msgType, cereal::BinaryInputA
 }
 
 
+// --- ConnectionHandoff Implementation ---
+
+ConnectionHandoff::ConnectionHandoff(asio::ip::tcp protocol, asio::ip::tcp::socket::native_handle_type handle,
+    std::string playerName, WireFormat wireFormat)
+    :   protocol(protocol),
+        handle(handle),
+        playerName(std::move(playerName)),
+        wireFormat(wireFormat)
+{}
+
+ConnectionHandoff::ConnectionHandoff(ConnectionHandoff&& other) noexcept
+    :   protocol(other.protocol),
+        handle(std::exchange(other.handle, std::nullopt)),
+        playerName(std::move(other.playerName)),
+        wireFormat(other.wireFormat)
+{}
+
+ConnectionHandoff::~ConnectionHandoff() {
+    if (!handle)
+        return;
+#ifdef _WIN32
+    ::closesocket(*handle);
+#else
+    ::close(*handle);
+#endif
+}
+
+asio::ip::tcp::socket ConnectionHandoff::adopt(asio::io_context& ioContext) {
+    asio::ip::tcp::socket socket(ioContext, protocol, *handle); // Closed by the destructor if this throws
+    handle.reset();
+    return socket;
+}
+
+const std::string& ConnectionHandoff::getPlayerName() const {
+    return playerName;
+}
+
+WireFormat ConnectionHandoff::getWireFormat() const {
+    return wireFormat;
+}
+
+
 // --- ServerNetwork Implementation ---
 
-ServerNetwork::ServerNetwork(asio::io_context& ioContext,
-                                const asio::ip::tcp::endpoint& endpoint,
-                                GameManager& gameManager)
-    :   ioContext(ioContext),
-        acceptor(ioContext, endpoint),
-        gameManager(gameManager),
-        gameStrand(asio::make_strand(ioContext)) // Initialize the strand
+#ifdef SO_REUSEPORT
+// Lets every shard bind the same port, the kernel spreading the connections among them
+using ReusePort = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+ServerNetwork::ServerNetwork(ShardedServer& server, std::size_t shardIndex, asio::io_context& ioContext,
+                                const asio::ip::tcp::endpoint& endpoint, bool reusePort)
+    :   server(server),
+        shardIndex(shardIndex),
+        ioContext(ioContext),
+        acceptor(ioContext),
+        sessionPool(std::make_shared<SessionPool>(sizeof(Session)))
 {
-    spdlog::info("ServerNetwork created. Listening on {}", endpoint.address().to_string());
+    static_assert(alignof(Session) <= alignof(std::max_align_t), "Session blocks are only aligned for std::max_align_t");
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+    if (reusePort) {
+#ifdef SO_REUSEPORT
+        acceptor.set_option(ReusePort(true));
+#else
+        throw std::runtime_error("Several shards need SO_REUSEPORT, which this platform lacks");
+#endif
+    }
+    acceptor.bind(endpoint);
+    acceptor.listen();
+    spdlog::info("ServerNetwork of shard {} created. Listening on {}", shardIndex, endpoint.address().to_string());
+}
+
+ServerNetwork::~ServerNetwork() {
+    // Sessions and their tables hold each other until the tables let go
+    for (const auto& pair : tables)
+        pair.second->closeConnections();
 }
 
 void ServerNetwork::startAccept() {
     acceptor.async_accept(
         [this](const asio::error_code& error, asio::ip::tcp::socket socket) {
             if (!error) {
-                // Create session on the io_context, pass gameStrand
-                auto newSession = std::make_shared<Session>(std::move(socket), *this, gameStrand);
-                // Don't add to sessions map yet, wait for login message
+                // Create session on the shard's io_context
+                auto newSession = Session::create(sessionPool, std::move(socket), *this);
+                // Not at a table yet, wait for login message
                 newSession->start(); // Start reading from the new client
+            } else if (error == asio::error::operation_aborted) {
+                return; // Acceptor closed on shutdown
             } else {
                 spdlog::error("Accept error: {}", error.message());
             }
@@ -245,175 +477,123 @@ void ServerNetwork::startAccept() {
         });
 }
 
-Status ServerNetwork::join(SessionPtr session, const std::string& playerName) {
-    // This should ideally run on the main io_context thread or be protected
-    {
-        std::lock_guard<std::mutex> lock(sessionsMutex);
-        if (sessions.count(playerName) > 0) {
-            spdlog::error("Player name '{}' already taken.", playerName);
-            auto errorMsg = serializeMessage(ServerMessageType::LoginFailure, std::string("Name already taken."));
-            session->deliver(errorMsg);
-            return std::unexpected("Name already taken.");
-        }
-        if (gameManager.allPlayersJoined()) {
-            spdlog::error("Game is full. Cannot join.");
-            auto errorMsg = serializeMessage(ServerMessageType::LoginFailure, std::string("Game is full."));
-            session->deliver(errorMsg);
-            return std::unexpected("Game is full.");
-        }
-        sessions[playerName] = session;
-        // Send LoginSuccess confirmation
-        auto successMsg = serializeMessage(ServerMessageType::LoginSuccess);
-        session->deliver(successMsg);
-        spdlog::info("Player '{}' joined.", playerName);
-    }
-    asio::post(gameStrand, [this, playerName = std::move(playerName)]() mutable {
-        auto status = gameManager.addPlayer(playerName);
-        if (!status.has_value()) {
-            // this should never happen—names/counts already checked above—but if it does we log an error.
-            spdlog::error("addPlayer failed on strand: {}", status.error());
-        }
+void ServerNetwork::setActionRateLimit(double actionsPerSecond, double burst) {
+    this->actionsPerSecond = actionsPerSecond;
+    actionBurst = burst;
+}
 
-        // once everyone has joined, we can start the game:
-        if (gameManager.allPlayersJoined()) {
-            gameManager.startGame();
-            broadcastGameState("Game started!");
-        }
-    });
-    return {}; // Indicate success
+void ServerNetwork::setWireFormat(WireFormat format) {
+    maxWireFormat = format;
 }
 
-void ServerNetwork::leave(SessionPtr session) {
-    // This can be called from session's strand or acceptor's thread
-    std::lock_guard<std::mutex> lock(sessionsMutex);
-    std::string nameToRemove = session->getPlayerName();
-    if (!nameToRemove.empty()) {
-        sessions.erase(nameToRemove);
-        spdlog::info("Player '{}' left, shutting down server..", nameToRemove);
-        
-        asio::error_code ec;
-        acceptor.close(ec);
-        if (ec) spdlog::warn("Error closing acceptor: {}", ec.message());
-        // 2) abort all outstanding async ops and break run():
-        ioContext.stop();
-        gameManager.handlePlayerDisconnect(nameToRemove); // Notify game manager
-    } else {
-        spdlog::info("Unidentified session disconnected.");
-    }
-    // Session object will be destroyed when shared_ptr count goes to 0
+std::size_t ServerNetwork::getLiveSessionCount() const {
+    return sessionPool->liveSessions();
 }
 
-void ServerNetwork::deliverToOne(const std::string& playerName, const std::vector<char>& message) {
-    std::lock_guard<std::mutex> lock(sessionsMutex);
-    auto it = sessions.find(playerName);
-    if (it != sessions.end()) {
-        it->second->deliver(message);
-    } else {
-        spdlog::warn("Warning: Attempted to deliver message to unknown player: {}", playerName);
-    }
+void ServerNetwork::login(SessionPtr session) {
+    server.requestSeat(shardIndex, std::move(session));
 }
 
-void ServerNetwork::deliverToAll(const std::vector<char>& message) {
-    std::lock_guard<std::mutex> lock(sessionsMutex);
-    for (const auto& pair : sessions) {
-        pair.second->deliver(message);
+void ServerNetwork::seat(SessionPtr session, TableId tableId) {
+    if (closingTables.contains(tableId)) {
+        refuseLogin(std::move(session), "Table closed.");
+        return;
     }
+    auto& table = tables[tableId];
+    if (!table)
+        table = std::make_shared<GameTable>(*this, tableId, server.getPlayersCount());
+    if (auto status = table->join(session, session->getPlayerName()); !status.has_value()) {
+        // The lobby gave a seat the table cannot take: free it, and let the player log in again
+        server.abandonSeat(shardIndex, session->getPlayerName(), {shardIndex, tableId});
+        refuseLogin(std::move(session), status.error());
+        return;
+    }
+    session->joinTable(table);
+    // Lost while the lobby seated them: leaving ends the game like any other player leaving
+    if (!session->isConnected())
+        table->leave(session);
 }
 
-// --- Action Handlers (Called via gameStrand from Session::processMessage) ---
-
-// Helper to send state updates after successful action
-void ServerNetwork::broadcastGameState(const std::string& lastActionMsg, std::optional<TurnActionStatus> status) {
-     // This function MUST run on the gameStrand
-    assert(gameStrand.running_in_this_thread());
-
-    bool broadcastNewRound = false;
-    if (auto* roundManager = gameManager.getCurrentRoundManager()) {
-        if (roundManager->isRoundOver()) {
-            spdlog::info("Round is over. Advancing game state.");
-            gameManager.advanceGameState(); // Advance game state
-            if (!gameManager.isGameOver())
-                broadcastNewRound = true;
-        }
+void ServerNetwork::handOff(SessionPtr session, TableSeat seat) {
+    if (!session->isConnected()) {
+        server.abandonSeat(shardIndex, session->getPlayerName(), seat);
+        return;
     }
-
-    if (const auto* roundManager = gameManager.getCurrentRoundManager()) {
-        for (const auto& player : gameManager.getAllPlayers()) {
-            const std::string& targetPlayerName = player.getName();
-    
-            // Check if this player is actually connected
-            SessionPtr targetSession;
-            { // Scope for lock
-                std::lock_guard<std::mutex> lock(sessionsMutex);
-                auto it = sessions.find(targetPlayerName);
-                if (it != sessions.end()) {
-                    targetSession = it->second;
-                }
-            } // Unlock mutex
-    
-            if (!targetSession) {
-                spdlog::warn("Warning: Attempted to send game state to disconnected player: {}", targetPlayerName);
-                continue; // Skip if player is not connected
-            }
-            // Only send if player is connected
-            try {
-                ClientGameState clientGameState = makeClientGameState(
-                    player, *roundManager, gameManager, lastActionMsg, status
-                );
-                auto message = serializeMessage(ServerMessageType::GameStateUpdate, clientGameState);
-                targetSession->deliver(message); // Deliver uses session's post, safe
-    
-            } catch (const std::exception& e) {
-                spdlog::error("Error assembling or serializing game state for {}: {}", targetPlayerName, e.what());
-            }
-        }
+    try {
+        server.forwardConnection(shardIndex, session->releaseConnection(), seat);
+    } catch (const asio::system_error& e) {
+        spdlog::error("Could not hand {} over to shard {}: {}", session->getPlayerName(), seat.shard, e.what());
+        session->close();
+        server.abandonSeat(shardIndex, session->getPlayerName(), seat);
     }
+}
 
-    if (broadcastNewRound) {
-        gameManager.advanceGameState();
-        broadcastGameState("New round started!");
+void ServerNetwork::adopt(ConnectionHandoff connection, TableId tableId) {
+    SessionPtr session;
+    try {
+        session = Session::create(sessionPool, connection.adopt(ioContext), *this);
+    } catch (const asio::system_error& e) {
+        spdlog::error("Could not take over the connection of {}: {}", connection.getPlayerName(), e.what());
+        closeTable(tableId); // The player will not come
+        return;
     }
+    session->resume(connection.getPlayerName(), connection.getWireFormat());
+    seat(std::move(session), tableId);
 }
 
-// Helper to send error message back to originating player
-void ServerNetwork::sendActionError(const std::string& playerName, const std::string& errorMsg, std::optional<TurnActionStatus> status) {
-    // This function MUST run on the gameStrand
-    assert(gameStrand.running_in_this_thread());
-    spdlog::error("Action Error for {}: {}", playerName, errorMsg);
-    ActionError actionError {
-        errorMsg,
-        status
-    };
-    auto message = serializeMessage(ServerMessageType::ActionError, actionError);
-    deliverToOne(playerName, message); // deliverToOne is thread-safe
+void ServerNetwork::refuseLogin(SessionPtr session, const std::string& reason) {
+    spdlog::error("Login of '{}' failed: {}", session->getPlayerName(), reason);
+    session->endSeatRequest();
+    session->deliver(serializeMessage(ServerMessageType::LoginFailure, reason));
 }
 
-void ServerNetwork::handleClientDrawDeck(const std::string& playerName) {
-    dispatchAction(playerName, [&](RoundManager& rm) {
-        return rm.handleDrawDeckRequest();
-    });
+void ServerNetwork::refuseLogin(ConnectionHandoff connection, const std::string& reason) {
+    SessionPtr session;
+    try {
+        session = Session::create(sessionPool, connection.adopt(ioContext), *this);
+    } catch (const asio::system_error& e) {
+        spdlog::error("Could not take back the connection of {}: {}", connection.getPlayerName(), e.what());
+        return;
+    }
+    session->start(); // Waiting for another Login
+    spdlog::error("Login of '{}' failed: {}", connection.getPlayerName(), reason);
+    session->deliver(serializeMessage(ServerMessageType::LoginFailure, reason));
 }
 
-void ServerNetwork::handleClientTakeDiscardPile(const std::string& playerName) {
-    dispatchAction(playerName, [&](RoundManager& rm) {
-        return rm.handleTakeDiscardPileRequest();
-    });
+void ServerNetwork::leave(SessionPtr session) {
+    // This can be called from the session's read or write loop
+    if (const auto& table = session->getTable())
+        table->leave(session);
+    else
+        spdlog::info("Unidentified session disconnected.");
+    // Session object will be destroyed when its reference count goes to 0
 }
 
-void ServerNetwork::handleClientMeld(const std::string& playerName, const std::vector<MeldRequest>& meldRequests) {
-    dispatchAction(playerName, [&](RoundManager& rm) {
-        return rm.handleMeldRequest(meldRequests);
-    });
+void ServerNetwork::endTable(TableId tableId) {
+    if (server.getHostingMode() == HostingMode::SingleGame) {
+        spdlog::info("Shutting down server..");
+        asio::error_code ec;
+        acceptor.close(ec);
+        if (ec) spdlog::warn("Error closing acceptor: {}", ec.message());
+        // abort all outstanding async ops and break run():
+        server.stop();
+        return;
+    }
+    closeTable(tableId);
 }
 
-void ServerNetwork::handleClientDiscard(const std::string& playerName, const Card& cardToDiscard) {
-    dispatchAction(playerName, [&](RoundManager& rm) {
-        return rm.handleDiscardRequest(cardToDiscard);
-    });
+void ServerNetwork::closeTable(TableId tableId) {
+    if (!closingTables.insert(tableId).second)
+        return; // Already closed
+    if (auto it = tables.find(tableId); it != tables.end()) {
+        auto table = std::move(it->second);
+        tables.erase(it);
+        table->closeConnections();
+    }
+    spdlog::info("Table {} closed on shard {}.", tableId, shardIndex);
+    server.reportTableClosed(shardIndex, tableId);
 }
 
-void ServerNetwork::handleClientRevert(const std::string& playerName) {
-    dispatchAction(playerName, [&](RoundManager& rm) {
-        return rm.handleRevertRequest();
-    });
-}
\ No newline at end of file
+void ServerNetwork::forgetTable(TableId tableId) {
+    closingTables.erase(tableId);
+}
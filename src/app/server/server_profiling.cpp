@@ -0,0 +1,341 @@
+#include "server/server_profiling.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "spdlog/spdlog.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// --- Allocation counting ---
+
+namespace {
+    // Plain thread_locals: no constructor, so they are safe to touch from operator new
+    thread_local std::uint64_t allocationCount = 0;
+    thread_local std::uint64_t allocatedBytes = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    allocatedBytes += size;
+    if (size == 0)
+        size = 1;
+    while (true) {
+        if (void* memory = std::malloc(size))
+            return memory;
+        auto handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t /*size*/) noexcept {
+    std::free(memory);
+}
+
+// --- PerfCounterGroup ---
+
+#ifdef __linux__
+namespace {
+    int openCounter(std::uint64_t config, int groupFd) {
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        // Counts the calling thread on any CPU
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+}
+
+PerfCounterGroup::PerfCounterGroup() {
+    leaderFd = openCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (leaderFd == -1)
+        return;
+    instructionsFd = openCounter(PERF_COUNT_HW_INSTRUCTIONS, leaderFd);
+    cacheMissesFd = openCounter(PERF_COUNT_HW_CACHE_MISSES, leaderFd);
+    if (instructionsFd == -1 || cacheMissesFd == -1) {
+        // All or nothing, so the counts of one action always come from the same group
+        for (int fd : {leaderFd, instructionsFd, cacheMissesFd}) {
+            if (fd != -1)
+                close(fd);
+        }
+        leaderFd = instructionsFd = cacheMissesFd = -1;
+    }
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+    for (int fd : {cacheMissesFd, instructionsFd, leaderFd}) {
+        if (fd != -1)
+            close(fd);
+    }
+}
+
+PerfCounts PerfCounterGroup::read() const {
+    if (leaderFd == -1)
+        return {};
+    // PERF_FORMAT_GROUP layout: number of counters, then their values in opening order
+    struct {
+        std::uint64_t count;
+        std::uint64_t values[3];
+    } group{};
+    if (::read(leaderFd, &group, sizeof(group)) != static_cast<ssize_t>(sizeof(group)) || group.count != 3)
+        return {};
+    return {group.values[0], group.values[1], group.values[2]};
+}
+#else
+PerfCounterGroup::PerfCounterGroup() = default;
+PerfCounterGroup::~PerfCounterGroup() = default;
+
+PerfCounts PerfCounterGroup::read() const {
+    return {};
+}
+#endif
+
+bool PerfCounterGroup::isAvailable() const {
+    return leaderFd != -1;
+}
+
+// --- ServerProfiling ---
+
+namespace {
+    std::atomic<bool> profilingEnabled{false};
+    std::atomic<bool> countersAvailable{false}; // Set once a thread managed to open its counters
+
+    // Counters kept on every action, one set per thread so shards on different cores do not share
+    // a cache line; only the owning thread writes them, the export adds them up
+    struct ActionTallies {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> wallNs{0};
+        std::atomic<std::uint64_t> allocations{0};
+        std::atomic<std::uint64_t> allocatedBytes{0};
+        std::atomic<std::uint64_t> cycles{0};
+        std::atomic<std::uint64_t> instructions{0};
+        std::atomic<std::uint64_t> cacheMisses{0};
+    };
+
+    struct ThreadTallies {
+        std::array<ActionTallies, ServerProfiling::MESSAGE_TYPE_COUNT> actions{}; // Indexed by ClientMessageType
+        std::array<std::atomic<std::uint64_t>, 2> shedActions{}; // Indexed by ShedReason
+        std::atomic<std::uint64_t> stateFrames{0};
+        std::atomic<std::uint64_t> stateFrameBytes{0};
+    };
+
+    // Registered once per thread and kept after the thread exits, so its counts are not lost
+    std::mutex talliesMutex;
+    std::vector<std::shared_ptr<ThreadTallies>> allTallies;
+
+    ThreadTallies& threadTallies() {
+        thread_local std::shared_ptr<ThreadTallies> tallies = [] {
+            auto newTallies = std::make_shared<ThreadTallies>();
+            std::lock_guard<std::mutex> lock(talliesMutex);
+            allTallies.push_back(newTallies);
+            return newTallies;
+        }();
+        return *tallies;
+    }
+
+    // Adds up a counter of every thread
+    template <class Counter>
+    std::uint64_t sumTallies(Counter counter) {
+        std::lock_guard<std::mutex> lock(talliesMutex);
+        std::uint64_t sum = 0;
+        for (const auto& tallies : allTallies)
+            sum += counter(*tallies).load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    // Bumps a counter only its thread writes, without a locked read-modify-write
+    void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    const char* messageTypeLabel(std::size_t index) {
+        static constexpr std::array<const char*, ServerProfiling::MESSAGE_TYPE_COUNT> labels = {
+            "Login", "DrawDeck", "TakeDiscardPile", "Meld", "Discard", "Revert"};
+        return labels[index];
+    }
+
+    // Counters of the calling thread, opened the first time the thread profiles an action
+    const PerfCounterGroup& threadCounters() {
+        thread_local PerfCounterGroup counters;
+        thread_local bool reported = false;
+        if (!reported) {
+            reported = true;
+            if (counters.isAvailable())
+                countersAvailable.store(true, std::memory_order_relaxed);
+            else
+                spdlog::warn("Hardware counters unavailable, profiling time and allocations only.");
+        }
+        return counters;
+    }
+}
+
+void ServerProfiling::enable() {
+    profilingEnabled.store(true, std::memory_order_release);
+}
+
+bool ServerProfiling::isEnabled() {
+    return profilingEnabled.load(std::memory_order_relaxed);
+}
+
+std::uint64_t ServerProfiling::threadAllocationCount() {
+    return allocationCount;
+}
+
+std::uint64_t ServerProfiling::threadAllocatedBytes() {
+    return allocatedBytes;
+}
+
+void ServerProfiling::record(ClientMessageType msgType, const ActionStats& cost) {
+    ActionTallies& tallies = threadTallies().actions[static_cast<std::size_t>(msgType)];
+    bump(tallies.count, cost.count);
+    bump(tallies.wallNs, cost.wallNs);
+    bump(tallies.allocations, cost.allocations);
+    bump(tallies.allocatedBytes, cost.allocatedBytes);
+    bump(tallies.cycles, cost.counters.cycles);
+    bump(tallies.instructions, cost.counters.instructions);
+    bump(tallies.cacheMisses, cost.counters.cacheMisses);
+}
+
+void ServerProfiling::recordShedAction(ShedReason reason) {
+    bump(threadTallies().shedActions[static_cast<std::size_t>(reason)], 1);
+}
+
+std::uint64_t ServerProfiling::shedActionCount(ShedReason reason) {
+    return sumTallies([reason](ThreadTallies& tallies) -> auto& {
+        return tallies.shedActions[static_cast<std::size_t>(reason)];
+    });
+}
+
+void ServerProfiling::recordStateFrame(std::size_t bytes) {
+    ThreadTallies& tallies = threadTallies();
+    bump(tallies.stateFrames, 1);
+    bump(tallies.stateFrameBytes, bytes);
+}
+
+std::array<ActionStats, ServerProfiling::MESSAGE_TYPE_COUNT> ServerProfiling::snapshot() {
+    std::array<ActionStats, MESSAGE_TYPE_COUNT> statsByType{};
+    std::lock_guard<std::mutex> lock(talliesMutex);
+    for (const auto& tallies : allTallies) {
+        for (std::size_t i = 0; i < MESSAGE_TYPE_COUNT; ++i) {
+            const ActionTallies& action = tallies->actions[i];
+            ActionStats& stats = statsByType[i];
+            stats.count += action.count.load(std::memory_order_relaxed);
+            stats.wallNs += action.wallNs.load(std::memory_order_relaxed);
+            stats.allocations += action.allocations.load(std::memory_order_relaxed);
+            stats.allocatedBytes += action.allocatedBytes.load(std::memory_order_relaxed);
+            stats.counters.cycles += action.cycles.load(std::memory_order_relaxed);
+            stats.counters.instructions += action.instructions.load(std::memory_order_relaxed);
+            stats.counters.cacheMisses += action.cacheMisses.load(std::memory_order_relaxed);
+        }
+    }
+    return statsByType;
+}
+
+bool ServerProfiling::writePrometheusFile(const std::filesystem::path& path) {
+    auto stats = snapshot();
+    auto tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath);
+        if (!out)
+            return false;
+        auto writeMetric = [&](const char* name, const char* help, auto value) {
+            out << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << " counter\n";
+            for (std::size_t i = 0; i < MESSAGE_TYPE_COUNT; ++i)
+                out << name << "{type=\"" << messageTypeLabel(i) << "\"} " << value(stats[i]) << '\n';
+        };
+        writeMetric("canasta_actions_total", "Messages handled on the game strand.",
+            [](const ActionStats& s) { return s.count; });
+        writeMetric("canasta_action_seconds_total", "Time spent on the game strand.",
+            [](const ActionStats& s) { return static_cast<double>(s.wallNs) / 1e9; });
+        writeMetric("canasta_action_allocations_total", "Allocations made on the game strand.",
+            [](const ActionStats& s) { return s.allocations; });
+        writeMetric("canasta_action_allocated_bytes_total", "Bytes allocated on the game strand.",
+            [](const ActionStats& s) { return s.allocatedBytes; });
+        out << "# HELP canasta_shed_actions_total Actions rejected before reaching the game strand.\n"
+            << "# TYPE canasta_shed_actions_total counter\n"
+            << "canasta_shed_actions_total{reason=\"rate_limited\"} "
+            << shedActionCount(ShedReason::RateLimited) << '\n'
+            << "canasta_shed_actions_total{reason=\"out_of_turn\"} "
+            << shedActionCount(ShedReason::OutOfTurn) << '\n';
+        out << "# HELP canasta_state_frames_total Game state frames sent to clients.\n"
+            << "# TYPE canasta_state_frames_total counter\n"
+            << "canasta_state_frames_total "
+            << sumTallies([](ThreadTallies& tallies) -> auto& { return tallies.stateFrames; }) << '\n'
+            << "# HELP canasta_state_frame_bytes_total Bytes of the game state frames sent to clients.\n"
+            << "# TYPE canasta_state_frame_bytes_total counter\n"
+            << "canasta_state_frame_bytes_total "
+            << sumTallies([](ThreadTallies& tallies) -> auto& { return tallies.stateFrameBytes; }) << '\n';
+        // Left out rather than reported as zero when the counters are unavailable
+        if (countersAvailable.load(std::memory_order_relaxed)) {
+            writeMetric("canasta_action_cpu_cycles_total", "User space CPU cycles on the game strand.",
+                [](const ActionStats& s) { return s.counters.cycles; });
+            writeMetric("canasta_action_instructions_total", "User space instructions on the game strand.",
+                [](const ActionStats& s) { return s.counters.instructions; });
+            writeMetric("canasta_action_cache_misses_total", "Cache misses on the game strand.",
+                [](const ActionStats& s) { return s.counters.cacheMisses; });
+        }
+        if (!out)
+            return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+// --- ActionProfile ---
+
+ActionProfile::ActionProfile(ClientMessageType msgType)
+    : msgType(msgType), active(ServerProfiling::isEnabled()) {
+    if (!active)
+        return;
+    startCounters = threadCounters().read(); // Opens the counters first, outside the measured allocations
+    startAllocations = ServerProfiling::threadAllocationCount();
+    startAllocatedBytes = ServerProfiling::threadAllocatedBytes();
+    startTime = std::chrono::steady_clock::now();
+}
+
+ActionProfile::~ActionProfile() {
+    if (!active)
+        return;
+    auto endTime = std::chrono::steady_clock::now();
+    PerfCounts endCounters = threadCounters().read();
+    ActionStats cost;
+    cost.count = 1;
+    cost.wallNs = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+    cost.allocations = ServerProfiling::threadAllocationCount() - startAllocations;
+    cost.allocatedBytes = ServerProfiling::threadAllocatedBytes() - startAllocatedBytes;
+    cost.counters = {endCounters.cycles - startCounters.cycles,
+        endCounters.instructions - startCounters.instructions,
+        endCounters.cacheMisses - startCounters.cacheMisses};
+    ServerProfiling::record(msgType, cost);
+}
@@ -0,0 +1,144 @@
+#include "server/server_tracing.hpp"
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    std::atomic<bool> tracingEnabled{false};
+    std::atomic<std::uint32_t> tracingSampleInterval{1};
+    const TraceClock::time_point traceEpoch = TraceClock::now();
+
+    // One slot of a ring; the sequence is odd while the owning thread rewrites the slot,
+    // so a concurrent dump can skip torn spans instead of locking
+    struct TraceSlot {
+        std::atomic<std::uint64_t> sequence{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<TraceId> traceId{NO_TRACE_ID};
+        std::atomic<std::int64_t> startNs{0};
+        std::atomic<std::int64_t> durationNs{0};
+    };
+
+    struct TraceRing {
+        explicit TraceRing(std::uint32_t threadId) : threadId(threadId) {}
+
+        const std::uint32_t threadId;
+        std::atomic<std::uint64_t> written{0}; // Spans ever written by the owner
+        std::array<TraceSlot, ServerTracing::RING_CAPACITY> slots;
+    };
+
+    // Rings are registered once per thread and kept after the thread exits, so late spans can be dumped
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<TraceRing>> rings;
+
+    TraceRing& threadRing() {
+        thread_local std::shared_ptr<TraceRing> ring = [] {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            auto newRing = std::make_shared<TraceRing>(static_cast<std::uint32_t>(rings.size() + 1));
+            rings.push_back(newRing);
+            return newRing;
+        }();
+        return *ring;
+    }
+
+    thread_local TraceId currentTraceId = NO_TRACE_ID;
+    thread_local std::uint64_t requestsDecoded = 0; // On this thread since tracing was enabled
+
+    std::int64_t sinceEpochNs(TraceClock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - traceEpoch).count();
+    }
+}
+
+void ServerTracing::enable(std::uint32_t sampleInterval) {
+    tracingSampleInterval.store(sampleInterval == 0 ? 1 : sampleInterval, std::memory_order_relaxed);
+    tracingEnabled.store(true, std::memory_order_release);
+}
+
+bool ServerTracing::isEnabled() {
+    return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+TraceId ServerTracing::startTrace() {
+    if (!isEnabled())
+        return NO_TRACE_ID;
+    std::uint64_t count = ++requestsDecoded;
+    if (count % tracingSampleInterval.load(std::memory_order_relaxed) != 0)
+        return NO_TRACE_ID;
+    // Ring ids start at 1, so a traced request never gets NO_TRACE_ID
+    return (TraceId{threadRing().threadId} << 40) | (count & ((TraceId{1} << 40) - 1));
+}
+
+TraceId ServerTracing::currentTrace() {
+    return currentTraceId;
+}
+
+void ServerTracing::setCurrentTrace(TraceId traceId) {
+    currentTraceId = traceId;
+}
+
+TraceClock::time_point ServerTracing::now() {
+    return isEnabled() ? TraceClock::now() : TraceClock::time_point{};
+}
+
+void ServerTracing::record(const char* name, TraceId traceId,
+    TraceClock::time_point start, TraceClock::time_point end) {
+    if (start == TraceClock::time_point{} || traceId == NO_TRACE_ID)
+        return;
+    TraceRing& ring = threadRing();
+    std::uint64_t index = ring.written.load(std::memory_order_relaxed);
+    TraceSlot& slot = ring.slots[index % RING_CAPACITY];
+    std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.traceId.store(traceId, std::memory_order_relaxed);
+    slot.startNs.store(sinceEpochNs(start), std::memory_order_relaxed);
+    slot.durationNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+std::optional<std::size_t> ServerTracing::dumpChromeTrace(const std::filesystem::path& path) {
+    std::vector<std::shared_ptr<TraceRing>> ringsToDump;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        ringsToDump = rings;
+    }
+    std::ofstream out(path);
+    if (!out)
+        return std::nullopt;
+
+    std::size_t spanCount = 0;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    for (const auto& ring : ringsToDump) {
+        std::uint64_t written = ring->written.load(std::memory_order_acquire);
+        std::uint64_t first = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+        for (std::uint64_t index = first; index < written; ++index) {
+            const TraceSlot& slot = ring->slots[index % RING_CAPACITY];
+            std::uint64_t sequenceBefore = slot.sequence.load(std::memory_order_acquire);
+            const char* name = slot.name.load(std::memory_order_relaxed);
+            TraceId traceId = slot.traceId.load(std::memory_order_relaxed);
+            std::int64_t startNs = slot.startNs.load(std::memory_order_relaxed);
+            std::int64_t durationNs = slot.durationNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequenceBefore % 2 != 0 || slot.sequence.load(std::memory_order_relaxed) != sequenceBefore)
+                continue; // Being rewritten by its thread
+            // Complete events ("X") take microseconds
+            out << (spanCount++ == 0 ? "" : ",")
+                << "{\"name\":\"" << name << "\",\"cat\":\"canasta\",\"ph\":\"X\""
+                << ",\"ts\":" << static_cast<double>(startNs) / 1000.0
+                << ",\"dur\":" << static_cast<double>(durationNs) / 1000.0
+                << ",\"pid\":1,\"tid\":" << ring->threadId
+                << ",\"args\":{\"trace\":" << traceId << "}}";
+        }
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+    if (!out)
+        return std::nullopt;
+    return spanCount;
+}
@@ -0,0 +1,54 @@
+#include "server/session_pool.hpp"
+#include <utility>
+
+SessionPool::SessionPool(std::size_t sessionSize)
+    // Blocks are laid out back to back, so each is rounded up to keep the next one aligned
+    : blockSize((sessionSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t)) {}
+
+void* SessionPool::allocate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeBlocks.empty()) {
+        auto& slab = slabs.emplace_back(std::make_unique_for_overwrite<std::byte[]>(blockSize * SESSIONS_PER_SLAB));
+        freeBlocks.reserve(slabs.size() * SESSIONS_PER_SLAB);
+        // Handed out from the front of the slab first
+        for (std::size_t i = SESSIONS_PER_SLAB; i-- > 0;)
+            freeBlocks.push_back(slab.get() + i * blockSize);
+    }
+    void* block = freeBlocks.back();
+    freeBlocks.pop_back();
+    ++liveCount;
+    return block;
+}
+
+void SessionPool::deallocate(void* block) noexcept {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBlocks.push_back(block); // Has room: reserved for every block when the slab was added
+    --liveCount;
+}
+
+SessionBuffers SessionPool::acquireBuffers() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeBuffers.empty())
+        return {};
+    SessionBuffers buffers = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return buffers;
+}
+
+void SessionPool::releaseBuffers(SessionBuffers buffers) noexcept {
+    if (buffers.readBuffer.size() > READ_BUFFER_SIZE)
+        buffers.readBuffer = {}; // Only large messages need it that big
+    buffers.writeQueue.clear();
+    buffers.writeBuffers.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+        freeBuffers.push_back(std::move(buffers));
+    } catch (const std::bad_alloc&) {
+        // Dropped, the next session allocates its own
+    }
+}
+
+std::size_t SessionPool::liveSessions() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return liveCount;
+}
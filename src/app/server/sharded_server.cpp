@@ -0,0 +1,251 @@
+#include "server/sharded_server.hpp"
+#include "invariant.hpp"
+#include "spdlog/spdlog.h"
+#include <exception>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+    // Keeps the calling thread on one core, so its shard's data stays in that core's caches
+    void pinToCore(std::size_t shardIndex) {
+#ifdef __linux__
+        unsigned cores = std::thread::hardware_concurrency();
+        if (cores == 0)
+            return;
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(shardIndex % cores, &cpus);
+        if (int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus); error != 0)
+            spdlog::warn("Could not pin shard {} to core {} (error {})", shardIndex, shardIndex % cores, error);
+#else
+        (void)shardIndex; // Shards are left to the scheduler
+#endif
+    }
+}
+
+// --- ShardMailbox Implementation ---
+
+ShardMailbox::ShardMailbox(asio::io_context& producerContext, asio::io_context& consumerContext)
+    :   producerContext(producerContext),
+        consumerContext(consumerContext)
+{}
+
+void ShardMailbox::send(ShardTask task) {
+    // Behind the overflow when there is one, to keep the tasks in order
+    if (overflow.empty() && queue.tryPush(std::move(task))) {
+        scheduleDrain();
+        return;
+    }
+    overflow.push_back(std::move(task));
+    if (!flushPending) {
+        flushPending = true;
+        asio::post(producerContext, [this] { flushOverflow(); });
+    }
+}
+
+void ShardMailbox::scheduleDrain() {
+    // Publishes the tasks pushed so far to the drain that clears the flag
+    if (!drainPending.exchange(true, std::memory_order_acq_rel))
+        asio::post(consumerContext, [this] { drain(); });
+}
+
+void ShardMailbox::drain() {
+    // Cleared first: a task pushed from now on either is seen below or posts another drain
+    drainPending.exchange(false, std::memory_order_acq_rel);
+    ShardTask task;
+    for (std::size_t i = 0; i < SHARD_MAILBOX_CAPACITY && queue.tryPop(task); ++i)
+        task();
+    if (queue.tryPop(task)) {
+        // A steady stream from the producer; let the shard's other handlers run in between
+        task();
+        scheduleDrain();
+    }
+}
+
+void ShardMailbox::flushOverflow() {
+    flushPending = false;
+    while (!overflow.empty() && queue.tryPush(std::move(overflow.front())))
+        overflow.pop_front();
+    scheduleDrain();
+    if (!overflow.empty()) {
+        flushPending = true;
+        asio::post(producerContext, [this] { flushOverflow(); }); // Again once the consumer made room
+    }
+}
+
+// --- ServerShard Implementation ---
+
+ServerShard::ServerShard(ShardedServer& server, std::size_t index, const asio::ip::tcp::endpoint& endpoint,
+    bool reusePort)
+    :   ioContext(1), // Run by one thread only
+        network(server, index, ioContext, endpoint, reusePort)
+{}
+
+asio::io_context& ServerShard::getIoContext() {
+    return ioContext;
+}
+
+ServerNetwork& ServerShard::getNetwork() {
+    return network;
+}
+
+const ServerNetwork& ServerShard::getNetwork() const {
+    return network;
+}
+
+// --- ShardedServer Implementation ---
+
+ShardedServer::ShardedServer(std::size_t shardCount, const asio::ip::tcp::endpoint& endpoint,
+    std::size_t playersCount, HostingMode mode)
+    :   playersCount(playersCount),
+        mode(mode),
+        mailboxes(shardCount * shardCount),
+        lobby(shardCount, playersCount, mode)
+{
+    CANASTA_INVARIANT(shardCount > 0, "A server has at least one shard");
+    shards.reserve(shardCount);
+    for (std::size_t i = 0; i < shardCount; ++i)
+        shards.push_back(std::make_unique<ServerShard>(*this, i, endpoint, shardCount > 1));
+}
+
+ShardedServer::~ShardedServer() {
+    stop();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void ShardedServer::run() {
+    for (auto& shard : shards)
+        shard->getNetwork().startAccept();
+    for (std::size_t i = 1; i < shards.size(); ++i) {
+        threads.emplace_back([this, i] {
+            pinToCore(i);
+            try {
+                shards[i]->getIoContext().run();
+            } catch (const std::exception& e) {
+                spdlog::error("Shard {} failed: {}", i, e.what());
+                stop();
+            }
+        });
+    }
+    if (shards.size() > 1)
+        pinToCore(0); // After starting the other threads, which would inherit the affinity
+    try {
+        shards[0]->getIoContext().run();
+    } catch (...) {
+        stop();
+        throw;
+    }
+    stop(); // When the first shard ends, they all do
+    for (auto& thread : threads)
+        thread.join();
+    threads.clear();
+}
+
+void ShardedServer::stop() {
+    for (auto& shard : shards)
+        shard->getIoContext().stop();
+}
+
+void ShardedServer::setActionRateLimit(double actionsPerSecond, double burst) {
+    for (auto& shard : shards)
+        shard->getNetwork().setActionRateLimit(actionsPerSecond, burst);
+}
+
+void ShardedServer::setWireFormat(WireFormat format) {
+    for (auto& shard : shards)
+        shard->getNetwork().setWireFormat(format);
+}
+
+std::size_t ShardedServer::getShardCount() const {
+    return shards.size();
+}
+
+ServerShard& ShardedServer::getShard(std::size_t index) {
+    return *shards[index];
+}
+
+std::size_t ShardedServer::getPlayersCount() const {
+    return playersCount;
+}
+
+HostingMode ShardedServer::getHostingMode() const {
+    return mode;
+}
+
+std::size_t ShardedServer::getLiveSessionCount() const {
+    std::size_t count = 0;
+    for (const auto& shard : shards)
+        count += shard->getNetwork().getLiveSessionCount();
+    return count;
+}
+
+void ShardedServer::send(std::size_t from, std::size_t to, ShardTask task) {
+    CANASTA_INVARIANT(shards[from]->getIoContext().get_executor().running_in_this_thread(),
+        "A mailbox is only written by the shard it sends from");
+    if (from == to) {
+        asio::post(shards[to]->getIoContext(), std::move(task));
+        return;
+    }
+    auto& mailbox = mailboxes[from * shards.size() + to];
+    if (!mailbox) // Only the sending shard touches its mailboxes' slots
+        mailbox = std::make_unique<ShardMailbox>(shards[from]->getIoContext(), shards[to]->getIoContext());
+    mailbox->send(std::move(task));
+}
+
+void ShardedServer::requestSeat(std::size_t from, SessionPtr session) {
+    std::string playerName = session->getPlayerName();
+    // The session rides along to the lobby and back without being touched there
+    send(from, LOBBY_SHARD, [this, from, playerName = std::move(playerName), session = std::move(session)]() mutable {
+        auto seat = lobby.seat(playerName);
+        send(LOBBY_SHARD, from, [this, from, seat = std::move(seat), session = std::move(session)]() mutable {
+            ServerNetwork& network = shards[from]->getNetwork();
+            if (!seat.has_value())
+                network.refuseLogin(std::move(session), seat.error());
+            else if (seat->shard == from)
+                network.seat(std::move(session), seat->table);
+            else
+                network.handOff(std::move(session), *seat);
+        });
+    });
+}
+
+void ShardedServer::forwardConnection(std::size_t from, ConnectionHandoff connection, TableSeat seat) {
+    // Through the lobby, so the connection reaches the table's shard behind everything the lobby
+    // told that shard about the table before, its closing included
+    send(from, LOBBY_SHARD, [this, from, connection = std::move(connection), seat]() mutable {
+        if (lobby.isOpen(seat)) {
+            send(LOBBY_SHARD, seat.shard, [this, connection = std::move(connection), seat]() mutable {
+                shards[seat.shard]->getNetwork().adopt(std::move(connection), seat.table);
+            });
+        } else {
+            send(LOBBY_SHARD, from, [this, from, connection = std::move(connection)]() mutable {
+                shards[from]->getNetwork().refuseLogin(std::move(connection), "Table closed.");
+            });
+        }
+    });
+}
+
+void ShardedServer::abandonSeat(std::size_t from, const std::string& playerName, TableSeat seat) {
+    send(from, LOBBY_SHARD, [this, playerName, seat] {
+        if (lobby.abandonSeat(playerName, seat)) {
+            send(LOBBY_SHARD, seat.shard, [this, seat] {
+                shards[seat.shard]->getNetwork().closeTable(seat.table);
+            });
+        }
+    });
+}
+
+void ShardedServer::reportTableClosed(std::size_t from, TableId table) {
+    send(from, LOBBY_SHARD, [this, from, table] {
+        lobby.closeTable({from, table});
+        // Every seat the lobby gave at the table is on its way before this
+        send(LOBBY_SHARD, from, [this, from, table] {
+            shards[from]->getNetwork().forgetTable(table);
+        });
+    });
+}
@@ -1,7 +1,8 @@
 #include "server/turn_manager.hpp"
 #include <stdexcept> // For potential exceptions if needed
 #include <numeric>   // For std::accumulate if calculating points
-#include <cassert>
+#include "invariant.hpp"
+#include <array>
 #include "spdlog/spdlog.h" // For logging
 
 // --- Constructor ---
@@ -29,13 +30,13 @@ TurnActionResult TurnManager::handleDrawDeck() {
     if (drewFromDeck)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You have already drawn from the deck."
+            ActionMessageCode::AlreadyDrewFromDeck
         }; 
 
     if (tookDiscardPile)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You cannot draw from the deck after taking the discard pile."
+            ActionMessageCode::DrawAfterTakingPile
         };
 
     auto maybeDrawnCard = drawUntilNonRedThree(serverDeck.get());
@@ -47,7 +48,7 @@ TurnActionResult TurnManager::handleDrawDeck() {
 
     return {
         TurnActionStatus::Success_TurnContinues,
-        "Card drawn successfully."
+        ActionMessageCode::CardDrawn
     };
 }
 
@@ -55,16 +56,16 @@ TurnActionResult TurnManager::handleTakeDiscardPile() {
     if (drewFromDeck)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You cannot take the discard pile after drawing from the deck."
+            ActionMessageCode::TakePileAfterDrawing
         };
     if (tookDiscardPile)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You have already taken the discard pile."
+            ActionMessageCode::AlreadyTookPile
         };
 
     auto topDiscard = serverDeck.get().getTopDiscard();
-    assert(topDiscard.has_value() && "Invariant violated: top discard should never be nullopt");
+    CANASTA_INVARIANT(topDiscard.has_value(), "top discard should never be nullopt");
     Card topDiscardCard = topDiscard.value();
 
     auto checkTakingDiscardPileResult = RuleEngine::checkTakingDiscardPile(
@@ -76,7 +77,7 @@ TurnActionResult TurnManager::handleTakeDiscardPile() {
     if (!checkTakingDiscardPileResult.has_value()) {
         return {
             TurnActionStatus::Error_InvalidAction,
-            checkTakingDiscardPileResult.error()
+            ActionMessage(checkTakingDiscardPileResult.error())
         };
     }
     
@@ -87,7 +88,7 @@ TurnActionResult TurnManager::handleTakeDiscardPile() {
     if (!takeDiscardPileResult.has_value()) {
         return {
             TurnActionStatus::Error_InvalidAction,
-            takeDiscardPileResult.error()
+            ActionMessage(takeDiscardPileResult.error())
         };
     }
     //hand.get().addCards(takeDiscardPileResult.value(), !teamHasInitialRankMeld);
@@ -102,7 +103,7 @@ TurnActionResult TurnManager::handleTakeDiscardPile() {
     tookDiscardPile = true; // Assume success for now
     return {
         TurnActionStatus::Success_TurnContinues,
-        "Discard pile taken successfully."
+        ActionMessageCode::DiscardPileTaken
     };
 }
 
@@ -110,12 +111,12 @@ TurnActionResult TurnManager::handleMelds(const std::vector<MeldRequest>& meldRe
     if (!drewFromDeck && !tookDiscardPile)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You must draw from the deck or take the discard pile before melding."
+            ActionMessageCode::MeldBeforeDrawing
         };
     if (meldsHandled)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You have already handled melds this turn."
+            ActionMessageCode::MeldsAlreadyHandled
         };
 
     auto checkResult = checkMeldRequestsCardsInHand(meldRequests);
@@ -136,51 +137,56 @@ TurnActionResult TurnManager::handleMelds(const std::vector<MeldRequest>& meldRe
         return meldSuggestionsStatus.error();
 
     // Check if the rank initialization proposals are valid
-    auto rankInitializationStatus = processRankInitializationProposals(rankInitializationProposals);
-    if (!rankInitializationStatus.has_value())
-        return rankInitializationStatus.error();
+    auto rankInitializationProofs = processRankInitializationProposals(rankInitializationProposals);
+    if (!rankInitializationProofs.has_value())
+        return rankInitializationProofs.error();
 
     // Check if the rank addition proposals are valid
-    auto rankAdditionStatus = processRankAdditionProposals(rankAdditionProposals);
-    if (!rankAdditionStatus.has_value())
-        return rankAdditionStatus.error();
-
-    initializeRankMelds(rankInitializationProposals);
-    addCardsToExistingMelds(rankAdditionProposals);
-
-    auto canGoingOut = RuleEngine::canGoingOut(
-        cardsPotentiallyLeftInHandCount, teamRoundState.get());
-
-    if (!canGoingOut && cardsPotentiallyLeftInHandCount == 0) { // wants to go out but can't
-        revertRankMeldActions(rankInitializationProposals, rankAdditionProposals);
+    auto rankAdditionProofs = processRankAdditionProposals(rankAdditionProposals);
+    if (!rankAdditionProofs.has_value())
+        return rankAdditionProofs.error();
+
+    // Stage the melds to see the canastas they make; nothing is applied until every check passed,
+    // and the proofs let the melds take the cards without checking them again
+    SpeculativeState speculation(hand.get(), teamRoundState.get());
+    auto stageStatus = stageRankMelds(speculation, rankInitializationProposals, rankInitializationProofs.value(),
+        rankAdditionProposals, rankAdditionProofs.value());
+    if (!stageStatus.has_value())
+        return stageStatus.error();
+    bool canGoingOut = cardsPotentiallyLeftInHandCount <= 1
+        && speculation.canastaCount() >= RuleEngine::MIN_CANASTAS_TO_GO_OUT;
+
+    if (!canGoingOut && cardsPotentiallyLeftInHandCount == 0) // wants to go out but can't
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You cannot go out."
+            ActionMessageCode::CannotGoOut
         };
-    }
 
     // Check if the black three initialization proposal is valid
-    auto blackThreeInitializationStatus = processBlackThreeInitializationProposal(
+    auto blackThreeInitializationProof = processBlackThreeInitializationProposal(
         blackThreeInitializationProposal, canGoingOut);
-    if (!blackThreeInitializationStatus.has_value()) {
-        // Revert rank initialization and addition proposals in order to maintain consistency
-        revertRankMeldActions(rankInitializationProposals, rankAdditionProposals);
-        return blackThreeInitializationStatus.error();
+    if (!blackThreeInitializationProof.has_value())
+        return blackThreeInitializationProof.error();
+    if (blackThreeInitializationProposal.has_value()) {
+        auto status = speculation.stageBlackThreeMeld(blackThreeInitializationProposal->getCards(),
+            blackThreeInitializationProof.value().value());
+        if (!status.has_value()) // Should never happen
+            throw std::runtime_error(status.error());
     }
 
-    initializeBlackThreeMeld(blackThreeInitializationProposal);
+    speculation.commit(hand.get(), teamRoundState.get());
     
     meldsHandled = true; // Mark that melds have been handled
 
     if (canGoingOut && cardsPotentiallyLeftInHandCount == 0) // immediate going out
         return {
             TurnActionStatus::Success_WentOut,
-            "Player has gone out successfully."
+            ActionMessageCode::WentOut
         };
     
     return {
         TurnActionStatus::Success_TurnContinues,
-        "Melds processed successfully."
+        ActionMessageCode::MeldsProcessed
     };
 }
 
@@ -190,18 +196,18 @@ TurnActionResult TurnManager::handleDiscard(const Card& cardToDiscard) {
     if (!drewFromDeck && !tookDiscardPile)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You must draw from the deck or take the discard pile before discarding."
+            ActionMessageCode::DiscardBeforeDrawing
         };
-    assert(!hand.get().isEmpty() && "Invariant violated: hand should not be empty");
+    CANASTA_INVARIANT(!hand.get().isEmpty(), "hand should not be empty");
     if (!RuleEngine::canDiscard(hand.get(), cardToDiscard))
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You cannot discard a card that is not in your hand."
+            ActionMessageCode::DiscardNotInHand
         };
     if (tookDiscardPile && !meldsHandled)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You must handle melds before discarding."
+            ActionMessageCode::DiscardBeforeMelding
         };
 
     auto handCardCount = hand.get().cardCount();
@@ -211,20 +217,21 @@ TurnActionResult TurnManager::handleDiscard(const Card& cardToDiscard) {
         if (!canGoingOut)
             return {
                 TurnActionStatus::Error_InvalidAction,
-                "You don't meet the requirements to go out."
+                ActionMessageCode::GoingOutRequirementsNotMet
             };
     }
-    assert(hand.get().removeCard(cardToDiscard) && "Invariant violated: card should be in hand");
+    bool removed = hand.get().removeCard(cardToDiscard);
+    CANASTA_INVARIANT(removed, "card should be in hand");
     serverDeck.get().discardCard(cardToDiscard);
     if (canGoingOut)
         return {
             TurnActionStatus::Success_WentOut,
-            "Player has gone out successfully."
+            ActionMessageCode::WentOut
         };
     
     return {
         TurnActionStatus::Success_TurnOver,
-        "Turn over successfully."
+        ActionMessageCode::TurnOver
     };
 }
 
@@ -232,7 +239,7 @@ TurnActionResult TurnManager::handleRevert() {
     if (!tookDiscardPile && !meldsHandled)
         return {
             TurnActionStatus::Error_InvalidAction,
-            "You can only revert after taking the discard pile or handling melds."
+            ActionMessageCode::NothingToRevert
         };
     spdlog::debug("Reverting turn for player: {}", player.get().getName());
     if (meldsHandled) {
@@ -245,7 +252,7 @@ TurnActionResult TurnManager::handleRevert() {
     }
     return {
         TurnActionStatus::Success_TurnContinues,
-        "Turn reverted successfully."
+        ActionMessageCode::TurnReverted
     };
 }
 
@@ -256,24 +263,28 @@ std::expected<std::size_t, TurnActionResult> TurnManager::checkMeldRequestsCards
     if (meldRequests.empty())
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            "No meld request provided."
+            ActionMessageCode::NoMeldRequest
         });
-    auto cardsInHand = std::deque<Card>(hand.get().getCards());
+    // Count the cards in hand by rank and color, so each requested card is checked in constant time
+    std::array<std::size_t, CARD_KIND_COUNT> cardsInHand{};
+    for (const auto& card : hand.get().getCards())
+        ++cardsInHand[cardKindIndex(card)];
+    std::size_t cardsLeftInHandCount = hand.get().cardCount();
     for (const auto& request : meldRequests) {
         auto& requestCards = request.getCards();
         for (const auto& card : requestCards) {
-            auto it = std::find(cardsInHand.begin(), cardsInHand.end(), card);
-            if (it == cardsInHand.end()) {
+            auto& count = cardsInHand[cardKindIndex(card)];
+            if (count == 0) {
                 return std::unexpected(TurnActionResult{
                     TurnActionStatus::Error_InvalidMeld,
-                    "Wrong meld request: card " + card.toString() + " not in hand"
+                    ActionMessage(ActionMessageCode::MeldCardNotInHand, card)
                 });
-            } else {
-                cardsInHand.erase(it); // Remove the card from the temporary vector
             }
+            --count; // Each card of the hand can be used once
+            --cardsLeftInHandCount;
         }
     }
-    return cardsInHand.size(); // Return the number of cards left in hand
+    return cardsLeftInHandCount; // Return the number of cards left in hand
 }
 
 void TurnManager::processMeldRequests(
@@ -310,7 +321,7 @@ std::expected<void, TurnActionResult> TurnManager::processMeldSuggestions(
         if (!suggestedMeld.has_value())
             return std::unexpected(TurnActionResult{
                 TurnActionStatus::Error_InvalidMeld,
-                suggestedMeld.error()
+                ActionMessage(suggestedMeld.error())
             });
         auto meld = suggestedMeld.value();
         auto possibleRank = meld.getRank();
@@ -318,18 +329,18 @@ std::expected<void, TurnActionResult> TurnManager::processMeldSuggestions(
             if (!teamHasInitialRankMeld)
                 return std::unexpected(TurnActionResult{
                     TurnActionStatus::Error_InvalidMeld,
-                    "Cannot form any meld containing Black Three cards before round's minimum point threshold was reached."
+                    ActionMessageCode::BlackThreesBeforeThreshold
                 });
             else if (blackThreeInitializationProposal.has_value())
                 return std::unexpected(TurnActionResult{
                     TurnActionStatus::Error_InvalidMeld,
-                    "Cannot form more than one Black Three meld."
+                    ActionMessageCode::SecondBlackThreeMeld
                 });
             blackThreeInitializationProposal = BlackThreeMeldProposal{
                 meldSuggestion
             };
         } else {
-            assert(possibleRank.has_value() && "Invariant violated: possibleRank should never be nullopt here");
+            CANASTA_INVARIANT(possibleRank.has_value(), "possibleRank should never be nullopt here");
             rankInitializationProposals.push_back(RankMeldProposal{
                 meldSuggestion,
                 possibleRank.value()
@@ -339,12 +350,12 @@ std::expected<void, TurnActionResult> TurnManager::processMeldSuggestions(
     return {}; // Return success
 }
 
-std::expected<void, TurnActionResult> TurnManager::processRankInitializationProposals
+std::expected<std::vector<MeldProof>, TurnActionResult> TurnManager::processRankInitializationProposals
 (const std::vector<RankMeldProposal>& rankInitializationProposals) const {
     if (rankInitializationProposals.empty() && !teamHasInitialRankMeld)
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            "You must initialize at least one meld."
+            ActionMessageCode::NoInitialMeld
         });
     for (std::size_t i = 0; i < rankInitializationProposals.size(); ++i) {
         auto& proposal = rankInitializationProposals[i];
@@ -355,73 +366,78 @@ std::expected<void, TurnActionResult> TurnManager::processRankInitializationProp
             spdlog::debug("Card {}: {}", i + 1, card.toString());
         }
     }
-    auto maybePoints = RuleEngine::validateRankMeldInitializationProposals(
-        rankInitializationProposals
+    auto maybeProofs = RuleEngine::validateRankMeldInitializationProposals(
+        rankInitializationProposals, teamRoundState.get()
     );
-    if (!maybePoints.has_value())
+    if (!maybeProofs.has_value())
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            maybePoints.error()
+            ActionMessage(maybeProofs.error())
         });
-    spdlog::debug("Rank initialization proposals points: {}", maybePoints.value());
+    int points = RuleEngine::calculateMeldPoints(maybeProofs.value());
+    spdlog::debug("Rank initialization proposals points: {}", points);
     if (!teamHasInitialRankMeld) {
         auto validateStatus = RuleEngine::validatePointsForInitialMelds(
-            maybePoints.value(), teamTotalScore);
+            points, teamTotalScore);
 
         if (!validateStatus.has_value())
             return std::unexpected(TurnActionResult{
                 TurnActionStatus::Error_MeldRequirementNotMet,
-                "Your initial melds must have not less than " +
-                std::to_string(validateStatus.error()) +
-                " points."
+                ActionMessage(ActionMessageCode::InitialMeldPointsNotMet, validateStatus.error())
             });
     }
-    if (commitment.has_value() && commitment.value().getType() == MeldCommitmentType::Initialize)
-        return checkInitializationCommitment(rankInitializationProposals, commitment.value());
-    return {}; // Return success
+    if (commitment.has_value() && commitment.value().getType() == MeldCommitmentType::Initialize) {
+        auto commitmentStatus = checkInitializationCommitment(rankInitializationProposals, commitment.value());
+        if (!commitmentStatus.has_value())
+            return std::unexpected(commitmentStatus.error());
+    }
+    return std::move(maybeProofs.value()); // Return success
 }
 
-std::expected<void, TurnActionResult> TurnManager::processBlackThreeInitializationProposal
+std::expected<std::optional<MeldProof>, TurnActionResult> TurnManager::processBlackThreeInitializationProposal
 (const std::optional<BlackThreeMeldProposal>& blackThreeProposal,
     bool canGoingOut) const {
     if (!blackThreeProposal.has_value())
-        return {}; // No Black Three proposal to process
+        return std::nullopt; // No Black Three proposal to process
     if (!canGoingOut)
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            "You cannot initialize a Black Three meld without going out."
+            ActionMessageCode::BlackThreeMeldWithoutGoingOut
         });
-    auto status = RuleEngine::validateBlackThreeMeldInitializationProposal(
+    auto proof = RuleEngine::validateBlackThreeMeldInitializationProposal(
         blackThreeProposal.value(),
         teamRoundState.get()
     );
-    if (!status.has_value())
+    if (!proof.has_value())
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            status.error()
+            ActionMessage(proof.error())
         });
-    return {}; // Return success
+    return proof.value(); // Return success
 }
 
-std::expected<void, TurnActionResult> TurnManager::processRankAdditionProposals
+std::expected<std::vector<MeldProof>, TurnActionResult> TurnManager::processRankAdditionProposals
 (const std::vector<RankMeldProposal>& rankAdditionProposals) const {
     if (!teamHasInitialRankMeld && !rankAdditionProposals.empty())
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidAction,
-            "You cannot add to a meld without initial melds."
+            ActionMessageCode::AddWithoutInitialMelds
         });
-    auto additionStatus = RuleEngine::validateRankMeldAdditionProposals(
+    auto maybeProofs = RuleEngine::validateRankMeldAdditionProposals(
         rankAdditionProposals,
         teamRoundState.get()
     );
-    if (!additionStatus.has_value())
+    if (!maybeProofs.has_value())
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            additionStatus.error()
+            ActionMessage(maybeProofs.error())
         });
-    if (commitment.has_value() && commitment.value().getType() == MeldCommitmentType::AddToExisting)
-        return checkAddToExistingCommitment(rankAdditionProposals, commitment.value());
-    return {}; // Return success
+    if (commitment.has_value() && commitment.value().getType() == MeldCommitmentType::AddToExisting) {
+        auto commitmentStatus = checkAddToExistingCommitment(rankAdditionProposals, commitment.value());
+        if (!commitmentStatus.has_value())
+            return std::unexpected(commitmentStatus.error());
+    }
+    return std::move(maybeProofs.value()); // Return success
 }
 
 
@@ -433,7 +449,7 @@ std::expected<Card, TurnActionResult> TurnManager::drawUntilNonRedThree(ServerDe
         if (!maybeCard.has_value()) {
             return std::unexpected(TurnActionResult{
                 TurnActionStatus::Error_MainDeckEmpty,
-                "Main deck is empty. Try taking the discard pile."
+                ActionMessageCode::MainDeckEmpty
             });
         }
 
@@ -445,7 +461,7 @@ std::expected<Card, TurnActionResult> TurnManager::drawUntilNonRedThree(ServerDe
                 if (!status.has_value())
                     return std::unexpected(TurnActionResult{
                         TurnActionStatus::Error_InvalidAction,
-                        status.error()
+                        ActionMessage(status.error())
                     });
             }
             return card; // Return the first non-Red Three card
@@ -470,7 +486,7 @@ const MeldCommitment& initializationCommitment) const {
     if (commitmentProposal == initializationProposals.end())
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            "Meld with rank " + to_string(initializationCommitmentRank) + " not found."
+            ActionMessage(ActionMessageCode::CommitmentMeldMissing, initializationCommitmentRank)
         });
     std::size_t commitmentCardCount = 0;
     auto& commitmentProposalCards = commitmentProposal->getCards();
@@ -481,9 +497,8 @@ const MeldCommitment& initializationCommitment) const {
     if (commitmentCardCount < initializationCommitmentCount)
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            "Meld with rank " + to_string(initializationCommitmentRank) +
-            " must contain at least " + std::to_string(initializationCommitmentCount) +
-            " cards with rank " + to_string(initializationCommitmentRank) + "."
+            ActionMessage(ActionMessageCode::CommitmentMeldTooSmall, initializationCommitmentRank,
+                static_cast<std::int32_t>(initializationCommitmentCount))
         });
     return {}; // Return success
 }
@@ -503,8 +518,7 @@ const MeldCommitment& addToExistingCommitment) const {
     if (commitmentProposal == additionProposals.end())
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            "Card with rank " + to_string(addToExistingCommitmentRank) + 
-            " was not added to the existing meld."
+            ActionMessage(ActionMessageCode::CommitmentCardNotAdded, addToExistingCommitmentRank)
         });
     std::size_t commitmentCardCount = 0;
     auto& commitmentProposalCards = commitmentProposal->getCards();
@@ -515,35 +529,46 @@ const MeldCommitment& addToExistingCommitment) const {
     if (commitmentCardCount < addToExistingCommitmentCount)
         return std::unexpected(TurnActionResult{
             TurnActionStatus::Error_InvalidMeld,
-            "You should add to meld with rank " + to_string(addToExistingCommitmentRank) +
-            " at least " + std::to_string(addToExistingCommitmentCount) +
-            " cards with rank " + to_string(addToExistingCommitmentRank) + "."
+            ActionMessage(ActionMessageCode::CommitmentAdditionTooSmall, addToExistingCommitmentRank,
+                static_cast<std::int32_t>(addToExistingCommitmentCount))
         });
     return {}; // Return success
 }
 
-void TurnManager::initializeRankMelds(
-    const std::vector<RankMeldProposal>& rankInitializationProposals) {
-    for (const auto& proposal : rankInitializationProposals) {
-        auto* meld = teamRoundState.get().getMeldForRank(proposal.getRank());
-        assert(meld && "Invariant violated: meld should never be nullopt here");
-        auto& proposalCards = proposal.getCards();
-        auto status = meld->checkInitialization(proposalCards);
-        if (!status.has_value()) // Should never happen
-            throw std::runtime_error(status.error());
-        meld->initialize(proposalCards);
-        for (const auto& card : proposalCards) {
-            // Remove the cards from the hand
-            assert(hand.get().removeCard(card) && "Card should be in hand");
-        }
+std::expected<void, TurnActionResult> TurnManager::stageRankMelds(SpeculativeState& speculation,
+    const std::vector<RankMeldProposal>& rankInitializationProposals,
+    const std::vector<MeldProof>& initializationProofs,
+    const std::vector<RankMeldProposal>& additionProposals,
+    const std::vector<MeldProof>& additionProofs) {
+    // Each proposal was validated against the real meld alone; staging fails only when proposals of the
+    // same rank do not fit together (a meld initialized twice, too many wild cards in all)
+    for (std::size_t i = 0; i < rankInitializationProposals.size(); ++i) {
+        const auto& proposal = rankInitializationProposals[i];
+        auto status = speculation.stageMeldInitialization(proposal.getRank(), proposal.getCards(),
+            initializationProofs[i]);
+        if (!status.has_value())
+            return std::unexpected(TurnActionResult{
+                TurnActionStatus::Error_InvalidMeld,
+                ActionMessage(status.error())
+            });
     }
+    for (std::size_t i = 0; i < additionProposals.size(); ++i) {
+        const auto& proposal = additionProposals[i];
+        auto status = speculation.stageMeldAddition(proposal.getRank(), proposal.getCards(), additionProofs[i]);
+        if (!status.has_value())
+            return std::unexpected(TurnActionResult{
+                TurnActionStatus::Error_InvalidMeld,
+                ActionMessage(status.error())
+            });
+    }
+    return {};
 }
 
 void TurnManager::revertRankMeldsInitialization(
     const std::vector<RankMeldProposal>& rankInitializationProposals) {
     for (const auto& proposal : rankInitializationProposals) {
         auto* meld = teamRoundState.get().getMeldForRank(proposal.getRank());
-        assert(meld && meld->isInitialized() && "Invariant violated: meld should always be initialized here");
+        CANASTA_INVARIANT(meld && meld->isInitialized(), "meld should always be initialized here");
         meld->reset();
         auto& proposalCards = proposal.getCards();
         // Revert the hand state
@@ -553,28 +578,11 @@ void TurnManager::revertRankMeldsInitialization(
     }
 }
 
-void TurnManager::addCardsToExistingMelds(
-    const std::vector<RankMeldProposal>& additionProposals) {
-    for (const auto& proposal : additionProposals) {
-        auto& proposalCards = proposal.getCards();
-        auto* meld = teamRoundState.get().getMeldForRank(proposal.getRank());
-        assert(meld && "Invariant violated: meld should never be nullopt here");
-        auto status = meld->checkCardsAddition(proposalCards);
-        if (!status.has_value()) // Should never happen
-            throw std::runtime_error(status.error());
-        meld->addCards(proposalCards, /*reversible = */true);
-        for (const auto& card : proposalCards) {
-            // Remove the cards from the hand
-            assert(hand.get().removeCard(card) && "Card should be in hand");
-        }
-    }
-}
-
 void TurnManager::revertRankMeldsAddition(
     const std::vector<RankMeldProposal>& additionProposals) {
     for (const auto& proposal : additionProposals) {
         auto* meld = teamRoundState.get().getMeldForRank(proposal.getRank());
-        assert(meld && meld->isInitialized() && "Invariant violated: meld should always be initialized here");
+        CANASTA_INVARIANT(meld && meld->isInitialized(), "meld should always be initialized here");
         meld->revertAddCards(); // should work
         auto& proposalCards = proposal.getCards();
         for (const auto& card : proposalCards) {
@@ -584,27 +592,9 @@ void TurnManager::revertRankMeldsAddition(
 }
 
 
-void TurnManager::initializeBlackThreeMeld(
-    const std::optional<BlackThreeMeldProposal>& blackThreeProposal) {
-    if (!blackThreeProposal.has_value())
-        return; // No Black Three proposal to initialize
-    auto* meld = teamRoundState.get().getBlackThreeMeld();
-    assert(meld && "Invariant violated: meld should never be nullopt here");
-    auto blackThreeCards = blackThreeProposal.value().getCards();
-    auto status = meld->checkInitialization(blackThreeCards);
-    if (!status.has_value()) // Should never happen
-        throw std::runtime_error(status.error());
-    // If we got here it means the turn and round are ended by this player
-    meld->initialize(blackThreeCards);
-    for (const auto& card : blackThreeCards) {
-        // Remove the cards from the hand
-        assert(hand.get().removeCard(card) && "Card should be in hand");
-    }
-}
-
 // need to call when 
 void TurnManager::revertTakeDiscardPileAction() {
-    assert(tookDiscardPile && "Invariant violated: tookDiscardPile should be true here");
+    CANASTA_INVARIANT(tookDiscardPile, "tookDiscardPile should be true here");
     
     serverDeck.get().revertTakeDiscardPile(); // Revert the discard pile action
     hand.get().revertAddCards(); // Revert the hand state
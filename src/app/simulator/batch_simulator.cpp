@@ -0,0 +1,302 @@
+#include "simulator/batch_simulator.hpp"
+#include <algorithm>
+#include <numeric>
+#include "meld.hpp"
+#include "rule_engine.hpp"
+
+BatchSimulator::BatchSimulator(std::size_t playerCount) : playerCount(playerCount) {}
+
+std::vector<SimulationResult> BatchSimulator::run(std::span<const std::uint32_t> seeds) {
+    reset(seeds.size());
+    for (std::size_t game = 0; game < gameCount; ++game)
+        dealRound(game, seeds[game]);
+
+    for (std::uint32_t turn = 0; turn < SIMULATION_MAX_TURNS && !runningGames.empty(); ++turn) {
+        std::size_t player = turn % playerCount;
+        drawPhase(player);
+        takePhase(player);
+        meldPhase(player);
+        discardPhase(player, turn);
+        std::erase_if(runningGames, [this](std::uint32_t game) {
+            return statuses[game] != static_cast<std::uint8_t>(RoundStatus::Running);
+        });
+    }
+    for (std::uint32_t game : runningGames)
+        finishRound(game, RoundStatus::Stalled); // Turn limit
+    scorePhase();
+
+    std::vector<SimulationResult> results(gameCount);
+    for (std::size_t game = 0; game < gameCount; ++game) {
+        auto& result = results[game];
+        switch (static_cast<RoundStatus>(statuses[game])) {
+            case RoundStatus::WentOut: result.outcome = SimulationOutcome::WentOut; break;
+            case RoundStatus::DeckExhausted: result.outcome = SimulationOutcome::DeckExhausted; break;
+            default: result.outcome = SimulationOutcome::Stalled; break;
+        }
+        result.turns = turns[game];
+        if (result.outcome != SimulationOutcome::Stalled) {
+            for (std::size_t team = 0; team < SIMULATION_TEAM_COUNT; ++team)
+                result.teamScores[team] = scores[team * gameCount + game];
+        }
+        result.stateDigest = digestState(game);
+    }
+    return results;
+}
+
+void BatchSimulator::reset(std::size_t games) {
+    gameCount = games;
+    runningGames.resize(games);
+    std::iota(runningGames.begin(), runningGames.end(), 0u);
+    decks.assign(games * SIMULATION_DECK_SIZE, 0);
+    deckSizes.assign(games, 0);
+    deckEmpty.assign(games, 0);
+    pileCounts.assign(CARD_KIND_COUNT * games, 0);
+    pileSizes.assign(games, 0);
+    pileTops.assign(games, NO_CARD);
+    pileFrozen.assign(games, 0);
+    hands.assign(playerCount * CARD_KIND_COUNT * games, 0);
+    handSizes.assign(playerCount * games, 0);
+    melds.assign(SIMULATION_TEAM_COUNT * RANK_MELD_COUNT * games, 0);
+    redThrees.assign(SIMULATION_TEAM_COUNT * games, 0);
+    takenRanks.assign(games, NO_CARD);
+    views.resize(games);
+    statuses.assign(games, static_cast<std::uint8_t>(RoundStatus::Running));
+    winningTeams.assign(games, 0);
+    turns.assign(games, 0);
+    scores.assign(SIMULATION_TEAM_COUNT * games, 0);
+}
+
+void BatchSimulator::dealRound(std::size_t game, std::uint32_t seed) {
+    SimulationDeal deal = dealSimulatedRound(seed, playerCount);
+    std::copy(deal.deck.begin(), deal.deck.end(), decks.begin() + static_cast<std::ptrdiff_t>(game * SIMULATION_DECK_SIZE));
+    deckSizes[game] = static_cast<std::uint8_t>(deal.deckSize);
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+        pileCounts[kind * gameCount + game] = deal.pile[kind];
+    pileSizes[game] = static_cast<std::uint8_t>(deal.pileSize);
+    pileTops[game] = deal.pileTop;
+    pileFrozen[game] = deal.pileFrozen;
+    for (std::size_t player = 0; player < playerCount; ++player) {
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+            hand(player, kind, game) = deal.hands[player][kind];
+        handSizes[player * gameCount + game] = deal.handSizes[player];
+    }
+    for (std::size_t team = 0; team < SIMULATION_TEAM_COUNT; ++team)
+        redThrees[team * gameCount + game] = deal.redThrees[team];
+}
+
+PolicyView BatchSimulator::makeView(std::size_t player, std::size_t game) {
+    PolicyView view;
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+        view.hand[kind] = hand(player, kind, game);
+    view.handSize = handSizes[player * gameCount + game];
+    std::size_t team = player % SIMULATION_TEAM_COUNT;
+    for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+        view.melds[rankMeld] = meld(team, rankMeld, game);
+        if (view.melds[rankMeld] >= MIN_CANASTA_SIZE)
+            ++view.canastaCount;
+    }
+    return view;
+}
+
+void BatchSimulator::finishRound(std::size_t game, RoundStatus status) {
+    statuses[game] = static_cast<std::uint8_t>(status);
+}
+
+void BatchSimulator::drawPhase(std::size_t player) {
+    const auto& infos = cardKindInfos();
+    std::size_t team = player % SIMULATION_TEAM_COUNT;
+    for (std::uint32_t game : runningGames) {
+        takenRanks[game] = NO_CARD;
+        if (deckEmpty[game])
+            continue;
+        std::size_t drawnRedThrees = 0;
+        while (true) {
+            if (deckSizes[game] == 0) {
+                deckEmpty[game] = 1; // Red threes drawn on the way are lost, like in TurnManager
+                break;
+            }
+            std::uint8_t kind = decks[game * SIMULATION_DECK_SIZE + --deckSizes[game]];
+            if (infos[kind].type == CardType::RedThree) {
+                ++drawnRedThrees;
+                continue;
+            }
+            redThrees[team * gameCount + game] += static_cast<std::uint8_t>(drawnRedThrees);
+            ++hand(player, kind, game);
+            ++handSizes[player * gameCount + game];
+            break;
+        }
+    }
+}
+
+void BatchSimulator::takePhase(std::size_t player) {
+    const auto& infos = cardKindInfos();
+    std::size_t team = player % SIMULATION_TEAM_COUNT;
+    for (std::uint32_t game : runningGames) {
+        if (!deckEmpty[game])
+            continue;
+        // The pile can't be taken from under a wild card or a black three
+        const CardKindInfo& top = infos[pileTops[game]];
+        bool canTake = false;
+        if (top.type == CardType::Natural) {
+            std::size_t topNaturals = hand(player, cardKindIndex(top.rank, CardColor::RED), game)
+                + hand(player, cardKindIndex(top.rank, CardColor::BLACK), game);
+            bool hasInitialMeld = false;
+            for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld)
+                hasInitialMeld = hasInitialMeld || meld(team, rankMeld, game) > 0;
+            canTake = SimulationRules::canTakeDiscardPile(topNaturals, meld(team, rankMeldIndex(top.rank), game),
+                hasInitialMeld, pileFrozen[game]);
+        }
+        if (!canTake) {
+            finishRound(game, RoundStatus::DeckExhausted);
+            continue;
+        }
+        // Moved to the hand once the melds honoring the commitment are accepted
+        takenRanks[game] = static_cast<std::uint8_t>(top.rank);
+    }
+}
+
+void BatchSimulator::meldPhase(std::size_t player) {
+    std::size_t team = player % SIMULATION_TEAM_COUNT;
+    for (std::uint32_t game : runningGames) {
+        if (statuses[game] != static_cast<std::uint8_t>(RoundStatus::Running))
+            continue;
+        PolicyView& view = views[game];
+        view = makeView(player, game);
+        bool tookPile = takenRanks[game] != NO_CARD;
+        if (tookPile) {
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+                view.hand[kind] += pileCounts[kind * gameCount + game];
+            view.handSize += pileSizes[game];
+        }
+        std::optional<Rank> priorityRank;
+        if (tookPile)
+            priorityRank = static_cast<Rank>(takenRanks[game]);
+        MeldPlan plan = SimulationPolicy::planMelds(view, priorityRank);
+        bool isValid = plan != 0 && SimulationRules::isValidMeldPlan(view, plan, priorityRank, pileFrozen[game]);
+        if (tookPile && !isValid) {
+            // The pile cannot be kept without melding; it stays where it was
+            finishRound(game, RoundStatus::Stalled);
+            continue;
+        }
+        if (tookPile) {
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+                hand(player, kind, game) = view.hand[kind];
+                pileCounts[kind * gameCount + game] = 0;
+            }
+            handSizes[player * gameCount + game] = static_cast<std::uint8_t>(view.handSize);
+            pileSizes[game] = 0;
+            pileTops[game] = NO_CARD;
+            pileFrozen[game] = 0;
+        }
+        if (!isValid)
+            continue;
+        for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+            if ((plan >> rankMeld & 1u) == 0)
+                continue;
+            Rank rank = rankOfMeld(rankMeld);
+            std::size_t naturals = naturalsOfRank(view, rank);
+            hand(player, cardKindIndex(rank, CardColor::RED), game) = 0;
+            hand(player, cardKindIndex(rank, CardColor::BLACK), game) = 0;
+            meld(team, rankMeld, game) += static_cast<std::uint8_t>(naturals);
+            handSizes[player * gameCount + game] -= static_cast<std::uint8_t>(naturals);
+            // Keep the view current for the discard phase
+            view.hand[cardKindIndex(rank, CardColor::RED)] = 0;
+            view.hand[cardKindIndex(rank, CardColor::BLACK)] = 0;
+            view.handSize -= naturals;
+            if (view.melds[rankMeld] < MIN_CANASTA_SIZE && view.melds[rankMeld] + naturals >= MIN_CANASTA_SIZE)
+                ++view.canastaCount;
+            view.melds[rankMeld] += static_cast<std::uint8_t>(naturals);
+        }
+        if (view.handSize == 0) {
+            winningTeams[game] = static_cast<std::uint8_t>(team);
+            finishRound(game, RoundStatus::WentOut);
+        }
+    }
+}
+
+void BatchSimulator::discardPhase(std::size_t player, std::uint32_t turn) {
+    const auto& infos = cardKindInfos();
+    std::size_t team = player % SIMULATION_TEAM_COUNT;
+    for (std::uint32_t game : runningGames) {
+        if (statuses[game] != static_cast<std::uint8_t>(RoundStatus::Running))
+            continue;
+        const PolicyView& view = views[game];
+        std::size_t kind = SimulationPolicy::chooseDiscard(view);
+        if (view.handSize == 1 && view.canastaCount < RuleEngine::MIN_CANASTAS_TO_GO_OUT) {
+            finishRound(game, RoundStatus::Stalled);
+            continue;
+        }
+        --hand(player, kind, game);
+        --handSizes[player * gameCount + game];
+        ++pileCounts[kind * gameCount + game];
+        ++pileSizes[game];
+        pileTops[game] = static_cast<std::uint8_t>(kind);
+        if (freezesDiscardPile(infos[kind].type))
+            pileFrozen[game] = 1;
+        if (view.handSize == 1) {
+            winningTeams[game] = static_cast<std::uint8_t>(team);
+            finishRound(game, RoundStatus::WentOut);
+        } else {
+            turns[game] = turn + 1;
+        }
+    }
+}
+
+void BatchSimulator::scorePhase() {
+    // Column loops over all the rounds, simple enough for the compiler to vectorize
+    const auto& infos = cardKindInfos();
+    std::vector<std::uint8_t> hasInitialMeld(SIMULATION_TEAM_COUNT * gameCount, 0);
+    for (std::size_t team = 0; team < SIMULATION_TEAM_COUNT; ++team) {
+        std::int32_t* teamScores = scores.data() + team * gameCount;
+        std::uint8_t* teamHasInitialMeld = hasInitialMeld.data() + team * gameCount;
+        for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+            const std::int32_t points = infos[cardKindIndex(rankOfMeld(rankMeld), CardColor::RED)].points;
+            const std::uint8_t* meldSizes = melds.data() + (team * RANK_MELD_COUNT + rankMeld) * gameCount;
+            for (std::size_t game = 0; game < gameCount; ++game) {
+                std::int32_t size = meldSizes[game];
+                teamScores[game] += size * points + (size >= static_cast<std::int32_t>(MIN_CANASTA_SIZE) ? NATURAL_CANASTA_BONUS : 0);
+                teamHasInitialMeld[game] |= size > 0;
+            }
+        }
+        // Red threes count against a team without melds, double when all four are there
+        const std::int32_t redThreePoints = infos[cardKindIndex(Rank::Three, CardColor::RED)].points;
+        const std::uint8_t* teamRedThrees = redThrees.data() + team * gameCount;
+        for (std::size_t game = 0; game < gameCount; ++game) {
+            std::int32_t count = teamRedThrees[game];
+            std::int32_t points = count * redThreePoints * (count == static_cast<std::int32_t>(MAX_SPECIAL_MELD_SIZE) ? 2 : 1);
+            teamScores[game] += teamHasInitialMeld[game] ? points : -points;
+        }
+    }
+    for (std::size_t player = 0; player < playerCount; ++player) {
+        std::int32_t* teamScores = scores.data() + (player % SIMULATION_TEAM_COUNT) * gameCount;
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+            const std::int32_t points = infos[kind].points;
+            const std::uint8_t* counts = hands.data() + (player * CARD_KIND_COUNT + kind) * gameCount;
+            for (std::size_t game = 0; game < gameCount; ++game)
+                teamScores[game] -= counts[game] * points;
+        }
+    }
+    for (std::size_t game = 0; game < gameCount; ++game) {
+        if (statuses[game] == static_cast<std::uint8_t>(RoundStatus::WentOut))
+            scores[winningTeams[game] * gameCount + game] += RuleEngine::GOING_OUT_BONUS;
+    }
+}
+
+std::uint64_t BatchSimulator::digestState(std::size_t game) const {
+    // Same order as ScalarSimulator: hands, then team melds, then the deck
+    StateDigest digest;
+    for (std::size_t player = 0; player < playerCount; ++player) {
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+            digest.add(hands[(player * CARD_KIND_COUNT + kind) * gameCount + game]);
+    }
+    for (std::size_t team = 0; team < SIMULATION_TEAM_COUNT; ++team) {
+        digest.add(redThrees[team * gameCount + game]);
+        for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld)
+            digest.add(melds[(team * RANK_MELD_COUNT + rankMeld) * gameCount + game]);
+    }
+    digest.add(deckSizes[game]);
+    digest.add(pileSizes[game]);
+    digest.add(pileFrozen[game]);
+    digest.add(pileTops[game]);
+    return digest.value();
+}
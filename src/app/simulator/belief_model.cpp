@@ -0,0 +1,223 @@
+#include "simulator/belief_model.hpp"
+#include <algorithm>
+#include "invariant.hpp"
+#include <numeric>
+
+namespace {
+    constexpr std::size_t RED_THREE_KIND = cardKindIndex(Rank::Three, CardColor::RED);
+}
+
+BeliefModel::BeliefModel(const SimulationDeal& deal, std::size_t playerCount, std::size_t observer,
+    BeliefModelOptions options)
+    : options(options), playerCount(playerCount), observer(observer) {
+    const auto& infos = cardKindInfos();
+    // The shuffled deck still holds the whole 108 cards, dealt ones included
+    for (auto kind : deal.deck)
+        ++hiddenCopies[kind];
+
+    // What the observer sees: their hand, the red threes set aside and the top of the pile
+    knownCards[observer] = deal.hands[observer];
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+        hiddenCopies[kind] -= deal.hands[observer][kind];
+    for (auto count : deal.redThrees)
+        hiddenCopies[RED_THREE_KIND] -= count;
+    // Red threes drawn for the initial pile are out of the round; the sizes tell how many
+    std::size_t placedCards = deal.deckSize + deal.pileSize
+        + std::accumulate(deal.redThrees.begin(), deal.redThrees.end(), std::size_t{0});
+    for (std::size_t player = 0; player < playerCount; ++player)
+        placedCards += deal.handSizes[player];
+    hiddenCopies[RED_THREE_KIND] -= SIMULATION_DECK_SIZE - placedCards;
+    --hiddenCopies[deal.pileTop];
+    knownPile[deal.pileTop] = 1;
+    pileTop = deal.pileTop;
+
+    // Red threes are never kept in a hand, and only wild cards and black threes are buried under the first natural
+    for (std::size_t player = 0; player < playerCount; ++player) {
+        if (player == observer)
+            continue;
+        hiddenSlots[player] = deal.handSizes[player];
+        weights[player].fill(1);
+        weights[player][RED_THREE_KIND] = 0;
+    }
+    hiddenSlots[DeckLocation] = deal.deckSize;
+    weights[DeckLocation].fill(1);
+    hiddenSlots[BuriedPileLocation] = deal.pileSize - 1;
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+        weights[BuriedPileLocation][kind] = freezesDiscardPile(infos[kind].type) ? 1 : 0;
+
+    CANASTA_INVARIANT_FULL(std::accumulate(hiddenCopies.begin(), hiddenCopies.end(), std::size_t{0})
+        == std::accumulate(hiddenSlots.begin(), hiddenSlots.end(), std::size_t{0}), "Every hidden card should have a hidden place");
+}
+
+void BeliefModel::observe(const TurnObservation& turn) {
+    const auto& infos = cardKindInfos();
+    std::size_t player = turn.player;
+    bool own = player == observer;
+
+    if (turn.tookPile) {
+        // The observer sees the buried cards when taking the pile; for the others they stay hidden in the hand
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+            std::uint8_t taken = own ? turn.pickedUp[kind] : knownPile[kind];
+            if (own)
+                hiddenCopies[kind] -= taken - knownPile[kind];
+            knownCards[player][kind] += taken;
+        }
+        if (!own)
+            addHiddenSlots(player, BuriedPileLocation, hiddenSlots[BuriedPileLocation]);
+        hiddenSlots[BuriedPileLocation] = 0;
+        knownPile = {};
+        pileTop = CARD_KIND_COUNT;
+    } else {
+        hiddenCopies[RED_THREE_KIND] -= turn.redThreesSetAside;
+        hiddenSlots[DeckLocation] -= turn.cardsDrawn;
+        if (own) {
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+                hiddenCopies[kind] -= turn.pickedUp[kind];
+                knownCards[player][kind] += turn.pickedUp[kind];
+            }
+        } else {
+            // Evidence on the hand before the draw, so the drawn card is not weighed
+            if (pileTop != CARD_KIND_COUNT && infos[pileTop].type == CardType::Natural)
+                weighRank(player, infos[pileTop].rank, options.declineFactor);
+            addHiddenSlots(player, DeckLocation, turn.cardsDrawn - turn.redThreesSetAside);
+        }
+    }
+
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+        if (turn.melded[kind] == 0)
+            continue;
+        revealFromHand(player, kind, turn.melded[kind]);
+        // Both colors of a rank are next to each other; weigh the rank once
+        if (!own && (kind % 2 == 0 || turn.melded[kind - 1] == 0))
+            weighRank(player, infos[kind].rank, options.meldFactor);
+    }
+
+    if (turn.discard != CARD_KIND_COUNT) {
+        revealFromHand(player, turn.discard, 1);
+        if (!own && infos[turn.discard].type == CardType::Natural)
+            weighRank(player, infos[turn.discard].rank, options.discardFactor);
+        ++knownPile[turn.discard];
+        pileTop = turn.discard;
+    }
+    expectedUpToDate = false;
+}
+
+const std::array<double, CARD_KIND_COUNT>& BeliefModel::expectedHand(std::size_t player) {
+    if (!expectedUpToDate)
+        balance();
+    return expected[player];
+}
+
+std::size_t BeliefModel::getHandSize(std::size_t player) const {
+    return std::accumulate(knownCards[player].begin(), knownCards[player].end(), hiddenSlots[player]);
+}
+
+BeliefSample BeliefModel::sample(std::mt19937_64& generator) const {
+    BeliefSample result;
+    result.hands = knownCards;
+    result.pile = knownPile;
+    std::array<std::uint8_t, CARD_KIND_COUNT> remaining = hiddenCopies;
+    std::size_t remainingCount = std::accumulate(remaining.begin(), remaining.end(), std::size_t{0});
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    // Each card is drawn in proportion to copies x weight, while the prior deals it in proportion to copies:
+    // the importance weight of a card is the total of copies x weight over the remaining copies
+    auto place = [&](std::size_t location, std::array<std::uint8_t, CARD_KIND_COUNT>& target) {
+        const auto& placeWeights = weights[location];
+        for (std::size_t slot = 0; slot < hiddenSlots[location]; ++slot) {
+            double total = 0;
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+                total += remaining[kind] * placeWeights[kind];
+            // The evidence rules out every card left: keep the sizes right and give the sample no weight
+            bool ruledOut = total <= 0;
+            if (ruledOut) {
+                total = static_cast<double>(remainingCount);
+                result.weight = 0;
+            }
+            double point = uniform(generator) * total;
+            std::size_t kind = 0;
+            for (; kind + 1 < CARD_KIND_COUNT; ++kind) {
+                point -= remaining[kind] * (ruledOut ? 1 : placeWeights[kind]);
+                if (point < 0 && remaining[kind] > 0)
+                    break;
+            }
+            while (remaining[kind] == 0) // Rounding left the point past the last card
+                --kind;
+            result.weight *= total / static_cast<double>(remainingCount);
+            --remaining[kind];
+            --remainingCount;
+            ++target[kind];
+        }
+    };
+
+    place(BuriedPileLocation, result.pile);
+    for (std::size_t player = 0; player < playerCount; ++player) {
+        if (player != observer)
+            place(player, result.hands[player]);
+    }
+
+    // The deck takes whatever is left, in any order
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+        for (std::uint8_t copy = 0; copy < remaining[kind]; ++copy)
+            result.deck[result.deckSize++] = static_cast<std::uint8_t>(kind);
+    }
+    CANASTA_INVARIANT(result.deckSize == hiddenSlots[DeckLocation], "The deck should take the last hidden cards");
+    std::shuffle(result.deck.begin(), result.deck.begin() + static_cast<std::ptrdiff_t>(result.deckSize), generator);
+    return result;
+}
+
+void BeliefModel::revealFromHand(std::size_t player, std::size_t kind, std::uint8_t count) {
+    std::uint8_t fromKnown = std::min(knownCards[player][kind], count);
+    knownCards[player][kind] -= fromKnown;
+    std::uint8_t fromHidden = count - fromKnown;
+    CANASTA_INVARIANT(hiddenSlots[player] >= fromHidden && hiddenCopies[kind] >= fromHidden, "Revealed cards should have been hidden in the hand");
+    hiddenSlots[player] -= fromHidden;
+    hiddenCopies[kind] -= fromHidden;
+}
+
+void BeliefModel::addHiddenSlots(std::size_t location, std::size_t from, std::size_t count) {
+    if (count == 0)
+        return;
+    // The place holds a mix of its old cards and the new ones, weighted by their numbers
+    double oldShare = static_cast<double>(hiddenSlots[location]) / static_cast<double>(hiddenSlots[location] + count);
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+        weights[location][kind] = oldShare * weights[location][kind] + (1 - oldShare) * weights[from][kind];
+    if (location < SIMULATION_MAX_PLAYERS)
+        weights[location][RED_THREE_KIND] = 0;
+    hiddenSlots[location] += count;
+}
+
+void BeliefModel::weighRank(std::size_t player, Rank rank, double factor) {
+    weights[player][cardKindIndex(rank, CardColor::RED)] *= factor;
+    weights[player][cardKindIndex(rank, CardColor::BLACK)] *= factor;
+}
+
+void BeliefModel::balance() {
+    // Expected hidden cards of kind k at place p: rowScale[p] * weights[p][k] * columnScale[k], scaled in turn
+    // so that the places hold their hidden cards and the kinds their hidden copies
+    std::array<double, BELIEF_LOCATION_COUNT> rowScale{};
+    std::array<double, CARD_KIND_COUNT> columnScale{};
+    for (std::size_t location = 0; location < BELIEF_LOCATION_COUNT; ++location)
+        rowScale[location] = hiddenSlots[location] > 0 ? 1 : 0;
+    for (std::size_t iteration = 0; iteration < options.iterations; ++iteration) {
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+            double total = 0;
+            for (std::size_t location = 0; location < BELIEF_LOCATION_COUNT; ++location)
+                total += rowScale[location] * weights[location][kind];
+            columnScale[kind] = total > 0 ? hiddenCopies[kind] / total : 0;
+        }
+        for (std::size_t location = 0; location < BELIEF_LOCATION_COUNT; ++location) {
+            double total = 0;
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+                total += weights[location][kind] * columnScale[kind];
+            rowScale[location] = total > 0 ? static_cast<double>(hiddenSlots[location]) / total : 0;
+        }
+    }
+    for (std::size_t location = 0; location < BELIEF_LOCATION_COUNT; ++location) {
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+            double known = location < SIMULATION_MAX_PLAYERS ? knownCards[location][kind] : 0;
+            expected[location][kind] = known + rowScale[location] * weights[location][kind] * columnScale[kind];
+        }
+    }
+    expectedUpToDate = true;
+}
@@ -0,0 +1,499 @@
+#include "simulator/endgame_solver.hpp"
+#include <algorithm>
+#include "invariant.hpp"
+#include <thread>
+#include "meld.hpp"
+#include "rule_engine.hpp"
+#include "zobrist.hpp"
+
+namespace {
+    constexpr int INFINITE_VALUE = 1 << 20;
+    constexpr std::size_t COMPLETE_DEPTH = 0xff; // Table depth of a subtree searched to the end of the round
+    constexpr std::uint64_t NODES_BETWEEN_CLOCK_CHECKS = 1024;
+    constexpr std::uint64_t GENERATION_MASK = 0xf; // The table is only cleared once the generations wrap
+
+    enum class Bound : std::uint64_t {
+        Exact,
+        Lower,
+        Upper
+    };
+
+    // XOR of the keys of the first copies of a kind, indexed by [kind][count], as CardMultisetHash adds them
+    const auto& copyKeys() {
+        static const auto keys = [] {
+            std::array<std::array<std::uint64_t, ZOBRIST_MAX_COPIES + 1>, CARD_KIND_COUNT> result{};
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+                for (std::size_t count = 1; count <= ZOBRIST_MAX_COPIES; ++count)
+                    result[kind][count] = result[kind][count - 1] ^ ZOBRIST_CARD_KEYS[kind * ZOBRIST_MAX_COPIES + count - 1];
+            }
+            return result;
+        }();
+        return keys;
+    }
+
+    std::uint64_t hashCounts(const std::array<std::uint8_t, CARD_KIND_COUNT>& counts) {
+        std::uint64_t hash = 0;
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+            hash ^= copyKeys()[kind][std::min<std::size_t>(counts[kind], ZOBRIST_MAX_COPIES)];
+        return hash;
+    }
+
+    // Table data: value, depth, bound, best move and generation packed in 64 bits
+    std::uint64_t packEntry(int value, std::size_t depth, Bound bound, std::optional<EndgameMove> move, std::uint64_t generation) {
+        std::uint64_t data = static_cast<std::uint32_t>(value);
+        data |= (generation & GENERATION_MASK) << 60;
+        data |= static_cast<std::uint64_t>(std::min(depth, COMPLETE_DEPTH)) << 32;
+        data |= static_cast<std::uint64_t>(bound) << 40;
+        if (move.has_value()) {
+            data |= static_cast<std::uint64_t>(move->takePile) << 42;
+            data |= static_cast<std::uint64_t>(move->plan) << 43;
+            data |= static_cast<std::uint64_t>(move->discard) << 54;
+            data |= std::uint64_t{1} << 59;
+        }
+        return data;
+    }
+
+    int entryValue(std::uint64_t data) { return static_cast<std::int32_t>(static_cast<std::uint32_t>(data)); }
+    std::size_t entryDepth(std::uint64_t data) { return data >> 32 & 0xff; }
+    Bound entryBound(std::uint64_t data) { return static_cast<Bound>(data >> 40 & 0x3); }
+
+    std::optional<EndgameMove> entryMove(std::uint64_t data) {
+        if ((data >> 59 & 1) == 0)
+            return std::nullopt;
+        return EndgameMove{(data >> 42 & 1) != 0, static_cast<MeldPlan>(data >> 43 & 0x7ff),
+            static_cast<std::uint8_t>(data >> 54 & 0x1f)};
+    }
+
+    // Meld the planned ranks in a view, as play() does on the state
+    void meldInView(PolicyView& view, MeldPlan plan) {
+        for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+            if ((plan >> rankMeld & 1u) == 0)
+                continue;
+            Rank rank = rankOfMeld(rankMeld);
+            std::size_t naturals = naturalsOfRank(view, rank);
+            view.hand[cardKindIndex(rank, CardColor::RED)] = 0;
+            view.hand[cardKindIndex(rank, CardColor::BLACK)] = 0;
+            view.handSize -= naturals;
+            if (view.melds[rankMeld] < MIN_CANASTA_SIZE && view.melds[rankMeld] + naturals >= MIN_CANASTA_SIZE)
+                ++view.canastaCount;
+            view.melds[rankMeld] += static_cast<std::uint8_t>(naturals);
+        }
+    }
+
+    bool canDiscard(const PolicyView& view, std::size_t kind) {
+        return view.hand[kind] > 0
+            && (view.handSize > 1 || view.canastaCount >= RuleEngine::MIN_CANASTAS_TO_GO_OUT);
+    }
+}
+
+EndgameState EndgameState::fromDeal(const SimulationDeal& deal, std::size_t playerCount) {
+    EndgameState state;
+    state.deck = deal.deck;
+    state.deckSize = static_cast<std::uint8_t>(deal.deckSize);
+    state.hands = deal.hands;
+    state.handSizes = deal.handSizes;
+    state.redThrees = deal.redThrees;
+    state.pile = deal.pile;
+    state.pileSize = static_cast<std::uint8_t>(deal.pileSize);
+    state.pileTop = deal.pileTop;
+    state.pileFrozen = deal.pileFrozen;
+    state.playerCount = static_cast<std::uint8_t>(playerCount);
+    return state;
+}
+
+bool EndgameState::canDraw() const {
+    // Red threes drawn are replaced; when only red threes are left they are lost, like in TurnManager
+    const auto& infos = cardKindInfos();
+    for (std::size_t position = 0; position < deckSize; ++position) {
+        if (infos[deck[position]].type != CardType::RedThree)
+            return true;
+    }
+    return false;
+}
+
+bool EndgameState::canTakePile() const {
+    if (pileTop == CARD_KIND_COUNT)
+        return false;
+    const CardKindInfo& top = cardKindInfos()[pileTop];
+    if (top.type != CardType::Natural)
+        return false;
+    const auto& teamMelds = melds[getCurrentTeam()];
+    bool hasInitialMeld = std::any_of(teamMelds.begin(), teamMelds.end(), [](std::uint8_t size) { return size > 0; });
+    const auto& hand = hands[currentPlayer];
+    std::size_t topNaturals = hand[cardKindIndex(top.rank, CardColor::RED)] + hand[cardKindIndex(top.rank, CardColor::BLACK)];
+    return SimulationRules::canTakeDiscardPile(topNaturals, teamMelds[rankMeldIndex(top.rank)], hasInitialMeld, pileFrozen);
+}
+
+PolicyView EndgameState::makeView() const {
+    PolicyView view;
+    view.hand = hands[currentPlayer];
+    view.handSize = handSizes[currentPlayer];
+    view.melds = melds[getCurrentTeam()];
+    for (auto size : view.melds) {
+        if (size >= MIN_CANASTA_SIZE)
+            ++view.canastaCount;
+    }
+    return view;
+}
+
+std::optional<Rank> EndgameState::pickUp(bool takePile) {
+    const auto& infos = cardKindInfos();
+    auto& hand = hands[currentPlayer];
+    if (takePile) {
+        Rank rank = infos[pileTop].rank;
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+            hand[kind] += pile[kind];
+        handSizes[currentPlayer] += pileSize;
+        pile = {};
+        pileSize = 0;
+        pileTop = CARD_KIND_COUNT;
+        pileFrozen = false;
+        return rank;
+    }
+    std::uint8_t drawnRedThrees = 0;
+    while (deckSize > 0) {
+        std::uint8_t kind = deck[--deckSize];
+        if (infos[kind].type == CardType::RedThree) {
+            ++drawnRedThrees;
+            continue;
+        }
+        redThrees[getCurrentTeam()] += drawnRedThrees;
+        ++hand[kind];
+        ++handSizes[currentPlayer];
+        break;
+    }
+    return std::nullopt;
+}
+
+void EndgameState::generateMoves(EndgameMoveList& list) const {
+    list.size = 0;
+    if (isOver())
+        return;
+    for (bool takePile : {false, true}) {
+        if (takePile ? !canTakePile() : !canDraw())
+            continue;
+        bool wasFrozen = pileFrozen;
+        EndgameState afterPickUp = *this;
+        std::optional<Rank> takenRank = afterPickUp.pickUp(takePile);
+        PolicyView view = afterPickUp.makeView();
+
+        // Meld nothing, or what the simulated players would meld; the taken pile has to be melded
+        std::array<MeldPlan, 2> plans{};
+        std::size_t planCount = 0;
+        if (!takePile)
+            plans[planCount++] = 0;
+        MeldPlan plan = SimulationPolicy::planMelds(view, takenRank);
+        if (plan != 0 && SimulationRules::isValidMeldPlan(view, plan, takenRank, wasFrozen))
+            plans[planCount++] = plan;
+
+        for (std::size_t i = 0; i < planCount; ++i) {
+            PolicyView afterMeld = view;
+            meldInView(afterMeld, plans[i]);
+            if (afterMeld.handSize == 0) {
+                list.moves[list.size++] = {takePile, plans[i], ENDGAME_NO_DISCARD};
+                continue;
+            }
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+                if (canDiscard(afterMeld, kind))
+                    list.moves[list.size++] = {takePile, plans[i], static_cast<std::uint8_t>(kind)};
+            }
+        }
+    }
+}
+
+EndgameState EndgameState::play(const EndgameMove& move, TurnObservation* observation) const {
+    EndgameState next = *this;
+    std::size_t team = getCurrentTeam();
+    auto& hand = next.hands[currentPlayer];
+    next.pickUp(move.takePile);
+    if (observation) {
+        *observation = TurnObservation{};
+        observation->player = currentPlayer;
+        observation->tookPile = move.takePile;
+        observation->cardsDrawn = static_cast<std::uint8_t>(deckSize - next.deckSize);
+        observation->redThreesSetAside = static_cast<std::uint8_t>(next.redThrees[team] - redThrees[team]);
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+            observation->pickedUp[kind] = static_cast<std::uint8_t>(hand[kind] - hands[currentPlayer][kind]);
+    }
+    for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+        if ((move.plan >> rankMeld & 1u) == 0)
+            continue;
+        Rank rank = rankOfMeld(rankMeld);
+        std::uint8_t naturals = hand[cardKindIndex(rank, CardColor::RED)] + hand[cardKindIndex(rank, CardColor::BLACK)];
+        if (observation) {
+            observation->melded[cardKindIndex(rank, CardColor::RED)] = hand[cardKindIndex(rank, CardColor::RED)];
+            observation->melded[cardKindIndex(rank, CardColor::BLACK)] = hand[cardKindIndex(rank, CardColor::BLACK)];
+        }
+        hand[cardKindIndex(rank, CardColor::RED)] = 0;
+        hand[cardKindIndex(rank, CardColor::BLACK)] = 0;
+        next.handSizes[currentPlayer] -= naturals;
+        next.melds[team][rankMeld] += naturals;
+    }
+    if (move.discard != ENDGAME_NO_DISCARD) {
+        if (observation)
+            observation->discard = move.discard;
+        --hand[move.discard];
+        --next.handSizes[currentPlayer];
+        ++next.pile[move.discard];
+        ++next.pileSize;
+        next.pileTop = move.discard;
+        if (freezesDiscardPile(cardKindInfos()[move.discard].type))
+            next.pileFrozen = true;
+    }
+    if (next.handSizes[currentPlayer] == 0) {
+        next.status = Status::WentOut;
+        next.winningTeam = static_cast<std::uint8_t>(team);
+    }
+    next.currentPlayer = static_cast<std::uint8_t>((currentPlayer + 1) % playerCount);
+    return next;
+}
+
+EndgameState EndgameState::determinize(const BeliefSample& sample) const {
+    CANASTA_INVARIANT(sample.deckSize == deckSize, "The sample should keep the deck size");
+    EndgameState determinized = *this;
+    determinized.hands = sample.hands;
+    determinized.pile = sample.pile;
+    determinized.deck = sample.deck;
+    return determinized;
+}
+
+EndgameState EndgameState::endRound() const {
+    EndgameState ended = *this;
+    ended.status = Status::DeckExhausted;
+    return ended;
+}
+
+std::optional<EndgameMove> EndgameState::policyMove() const {
+    if (isOver())
+        return std::nullopt;
+    // Draw while the deck lasts, then take the pile, as the simulators do
+    bool takePile = !canDraw();
+    if (takePile && !canTakePile())
+        return std::nullopt;
+    bool wasFrozen = pileFrozen;
+    EndgameState afterPickUp = *this;
+    std::optional<Rank> takenRank = afterPickUp.pickUp(takePile);
+    PolicyView view = afterPickUp.makeView();
+    MeldPlan plan = SimulationPolicy::planMelds(view, takenRank);
+    if (plan != 0 && !SimulationRules::isValidMeldPlan(view, plan, takenRank, wasFrozen))
+        plan = 0;
+    if (takePile && plan == 0)
+        return std::nullopt;
+    meldInView(view, plan);
+    if (view.handSize == 0)
+        return EndgameMove{takePile, plan, ENDGAME_NO_DISCARD};
+    std::size_t discard = SimulationPolicy::chooseDiscard(view);
+    if (!canDiscard(view, discard))
+        return std::nullopt;
+    return EndgameMove{takePile, plan, static_cast<std::uint8_t>(discard)};
+}
+
+std::array<int, SIMULATION_TEAM_COUNT> EndgameState::teamScores() const {
+    // Same scoring as BatchSimulator::scorePhase
+    const auto& infos = cardKindInfos();
+    std::array<int, SIMULATION_TEAM_COUNT> scores{};
+    for (std::size_t team = 0; team < SIMULATION_TEAM_COUNT; ++team) {
+        bool hasInitialMeld = false;
+        for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+            int size = melds[team][rankMeld];
+            scores[team] += size * infos[cardKindIndex(rankOfMeld(rankMeld), CardColor::RED)].points;
+            if (size >= static_cast<int>(MIN_CANASTA_SIZE))
+                scores[team] += NATURAL_CANASTA_BONUS;
+            hasInitialMeld = hasInitialMeld || size > 0;
+        }
+        int count = redThrees[team];
+        int points = count * infos[cardKindIndex(Rank::Three, CardColor::RED)].points
+            * (count == static_cast<int>(MAX_SPECIAL_MELD_SIZE) ? 2 : 1);
+        scores[team] += hasInitialMeld ? points : -points;
+    }
+    for (std::size_t player = 0; player < playerCount; ++player) {
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+            scores[player % SIMULATION_TEAM_COUNT] -= hands[player][kind] * infos[kind].points;
+    }
+    if (status == Status::WentOut)
+        scores[winningTeam] += RuleEngine::GOING_OUT_BONUS;
+    return scores;
+}
+
+int EndgameState::scoreForCurrentTeam() const {
+    auto scores = teamScores();
+    std::size_t team = getCurrentTeam();
+    return scores[team] - scores[1 - team];
+}
+
+std::uint64_t EndgameState::hash() const {
+    std::uint64_t hash = zobristPlace(ZobristPlace::DiscardPile, 0, hashCounts(pile))
+        ^ zobristPlace(ZobristPlace::DiscardTop, 0, pileTop)
+        ^ zobristPlace(ZobristPlace::DiscardFrozen, 0, pileFrozen)
+        ^ zobristPlace(ZobristPlace::MainDeckSize, 0, deckSize)
+        ^ zobristPlace(ZobristPlace::CurrentPlayer, 0, currentPlayer);
+    for (std::size_t seat = 0; seat < playerCount; ++seat)
+        hash ^= zobristPlace(ZobristPlace::Hand, seat, hashCounts(hands[seat]));
+    for (std::size_t team = 0; team < SIMULATION_TEAM_COUNT; ++team) {
+        // Meld sizes stand for their cards: the simulated players only meld naturals
+        std::uint64_t teamHash = redThrees[team] > 0 ? zobristPlace(ZobristPlace::Meld, RANK_MELD_COUNT, redThrees[team]) : 0;
+        for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+            if (melds[team][rankMeld] > 0)
+                teamHash ^= zobristPlace(ZobristPlace::Meld, rankMeld, melds[team][rankMeld]);
+        }
+        hash ^= zobristPlace(ZobristPlace::Team, team, teamHash);
+    }
+    return hash;
+}
+
+EndgameSolver::EndgameSolver(EndgameSolverOptions options)
+    : options(options), table(std::size_t{1} << options.tableSizeLog2) {}
+
+EndgameResult EndgameSolver::solve(const EndgameState& root) {
+    auto start = std::chrono::steady_clock::now();
+    deadline = start + options.timeBudget;
+    stop = false;
+    // The hash does not cover the remaining deck, so entries of other searches must not be used
+    if ((++generation & GENERATION_MASK) == 0) {
+        for (auto& entry : table) {
+            entry.keyXorData.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Helpers start one turn deeper every other thread, so they fill the table ahead of the main thread
+    std::size_t threadCount = std::max<std::size_t>(options.threadCount, 1);
+    std::vector<Worker> workers(threadCount);
+    std::vector<std::jthread> helpers;
+    for (std::size_t i = 1; i < threadCount; ++i) {
+        workers[i].index = i;
+        workers[i].canStop = true;
+        helpers.emplace_back([this, &worker = workers[i], &root, i] { iterate(worker, 1 + i % 2, root, nullptr); });
+    }
+    EndgameResult result;
+    iterate(workers[0], 1, root, &result);
+    stop = true;
+    helpers.clear(); // Joins the helpers
+
+    for (const auto& worker : workers)
+        result.nodes += worker.nodes;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void EndgameSolver::iterate(Worker& worker, std::size_t firstDepth, const EndgameState& root, EndgameResult* result) {
+    for (std::size_t depth = firstDepth; depth <= options.maxDepth && !stop; ++depth) {
+        bool complete = true;
+        int value = search(root, depth, 0, -INFINITE_VALUE, INFINITE_VALUE, complete, worker);
+        if (worker.stopped)
+            break;
+        if (result) {
+            result->bestMove = worker.bestMove;
+            result->value = value;
+            result->depth = depth;
+            result->exact = complete;
+        }
+        worker.canStop = true;
+        if (complete)
+            break;
+    }
+}
+
+int EndgameSolver::search(const EndgameState& state, std::size_t depth, std::size_t ply, int alpha, int beta,
+    bool& complete, Worker& worker) {
+    ++worker.nodes;
+    if (worker.canStop && (stop || (worker.nodes % NODES_BETWEEN_CLOCK_CHECKS == 0
+        && std::chrono::steady_clock::now() >= deadline))) {
+        stop = true;
+        worker.stopped = true;
+        return 0;
+    }
+    if (state.isOver())
+        return state.scoreForCurrentTeam();
+
+    std::uint64_t key = state.hash();
+    std::optional<EndgameMove> tableMove;
+    if (auto data = probe(key); data.has_value()) {
+        tableMove = entryMove(*data);
+        std::size_t entryDepthValue = entryDepth(*data);
+        if (ply > 0 && entryDepthValue >= depth) {
+            int value = entryValue(*data);
+            Bound bound = entryBound(*data);
+            if (bound == Bound::Exact || (bound == Bound::Lower && value >= beta) || (bound == Bound::Upper && value <= alpha)) {
+                complete = complete && entryDepthValue == COMPLETE_DEPTH;
+                return value;
+            }
+        }
+    }
+    if (depth == 0) {
+        complete = false;
+        return state.scoreForCurrentTeam();
+    }
+
+    EndgameMoveList list;
+    state.generateMoves(list);
+    if (list.size == 0) // The player cannot finish a turn: the round ends here
+        return state.endRound().scoreForCurrentTeam();
+    orderMoves(list, tableMove, worker);
+
+    int originalAlpha = alpha;
+    int bestValue = -INFINITE_VALUE;
+    EndgameMove bestMove = list.moves[0];
+    bool subtreeComplete = true;
+    for (std::size_t i = 0; i < list.size; ++i) {
+        const EndgameMove& move = list.moves[i];
+        bool childComplete = true;
+        // The next player is of the other team, as players alternate between the teams
+        int value = -search(state.play(move), depth - 1, ply + 1, -beta, -alpha, childComplete, worker);
+        if (worker.stopped)
+            return 0;
+        subtreeComplete = subtreeComplete && childComplete;
+        if (value > bestValue) {
+            bestValue = value;
+            bestMove = move;
+        }
+        alpha = std::max(alpha, value);
+        if (alpha >= beta)
+            break;
+    }
+    if (ply == 0)
+        worker.bestMove = bestMove;
+
+    Bound bound = bestValue <= originalAlpha ? Bound::Upper : bestValue >= beta ? Bound::Lower : Bound::Exact;
+    store(key, packEntry(bestValue, subtreeComplete ? COMPLETE_DEPTH : depth, bound, bestMove, generation));
+    complete = complete && subtreeComplete;
+    return bestValue;
+}
+
+void EndgameSolver::orderMoves(EndgameMoveList& list, std::optional<EndgameMove> tableMove, const Worker& worker) const {
+    // Table move, then going out, melds and taking the pile, then the discards the policy prefers
+    const auto& infos = cardKindInfos();
+    auto orderKey = [&](const EndgameMove& move) {
+        if (tableMove.has_value() && move == *tableMove)
+            return INFINITE_VALUE;
+        int key = move.discard == ENDGAME_NO_DISCARD ? 100000 : 0;
+        key += move.plan != 0 ? 50000 : 0;
+        key += move.takePile ? 20000 : 0;
+        if (move.discard != ENDGAME_NO_DISCARD) {
+            const CardKindInfo& info = infos[move.discard];
+            key += info.type == CardType::BlackThree ? 3000 : info.type == CardType::Natural ? 1000 : 0;
+            key += info.points;
+        }
+        return key;
+    };
+    auto begin = list.moves.begin();
+    auto end = begin + static_cast<std::ptrdiff_t>(list.size);
+    std::stable_sort(begin, end, [&](const EndgameMove& a, const EndgameMove& b) { return orderKey(a) > orderKey(b); });
+    // Helpers try the moves after the first ones in another order, so the threads do not all search the same lines
+    if (worker.index > 0 && list.size > 2)
+        std::rotate(begin + 1, begin + 1 + static_cast<std::ptrdiff_t>(worker.index % (list.size - 1)), end);
+}
+
+std::optional<std::uint64_t> EndgameSolver::probe(std::uint64_t key) const {
+    const TableEntry& entry = table[key & (table.size() - 1)];
+    std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+    if ((entry.keyXorData.load(std::memory_order_relaxed) ^ data) != key || (data >> 60) != (generation & GENERATION_MASK))
+        return std::nullopt;
+    return data;
+}
+
+void EndgameSolver::store(std::uint64_t key, std::uint64_t data) {
+    TableEntry& entry = table[key & (table.size() - 1)];
+    entry.keyXorData.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
@@ -0,0 +1,159 @@
+#include "simulator/scalar_simulator.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+#include "player.hpp"
+#include "team.hpp"
+#include "meld.hpp"
+#include "server/round_manager.hpp"
+
+namespace {
+    PolicyView makeView(const Hand& hand, const TeamRoundState& teamState) {
+        PolicyView view;
+        for (const auto& card : hand.getCards())
+            ++view.hand[cardKindIndex(card)];
+        view.handSize = hand.cardCount();
+        for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+            const BaseMeld* meld = teamState.getMeldForRank(static_cast<Rank>(rankInt));
+            if (!meld || !meld->isInitialized())
+                continue;
+            view.melds[rankMeldIndex(static_cast<Rank>(rankInt))] = static_cast<std::uint8_t>(meld->getCards().size());
+            if (meld->isCanastaMeld())
+                ++view.canastaCount;
+        }
+        return view;
+    }
+
+    std::vector<MeldRequest> makeMeldRequests(const Hand& hand, const PolicyView& view, MeldPlan plan) {
+        std::vector<MeldRequest> requests;
+        for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+            Rank rank = static_cast<Rank>(rankInt);
+            std::size_t index = rankMeldIndex(rank);
+            if ((plan >> index & 1u) == 0)
+                continue;
+            std::vector<Card> cards;
+            for (const auto& card : hand.getCards()) {
+                if (card.getRank() == rank)
+                    cards.push_back(card);
+            }
+            std::optional<Rank> addToRank;
+            if (view.melds[index] > 0)
+                addToRank = rank;
+            requests.emplace_back(cards, addToRank);
+        }
+        return requests;
+    }
+
+    // Same order as BatchSimulator: hands, then team melds, then the deck
+    std::uint64_t digestState(const RoundManager& roundManager, const std::vector<Player>& players,
+        const Team& team1, const Team& team2) {
+        StateDigest digest;
+        for (const auto& player : players) {
+            std::array<std::uint8_t, CARD_KIND_COUNT> hand{};
+            for (const auto& card : player.getHand().getCards())
+                ++hand[cardKindIndex(card)];
+            for (auto count : hand)
+                digest.add(count);
+        }
+        for (const Team* team : {&team1, &team2}) {
+            TeamRoundState teamState = roundManager.getTeamStateForTeam(*team);
+            const BaseMeld* redThreeMeld = teamState.getRedThreeMeld();
+            digest.add(redThreeMeld->isInitialized() ? redThreeMeld->getCards().size() : 0);
+            for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+                const BaseMeld* meld = teamState.getMeldForRank(static_cast<Rank>(rankInt));
+                digest.add(meld->isInitialized() ? meld->getCards().size() : 0);
+            }
+        }
+        ClientDeck deck = roundManager.getClientDeck();
+        digest.add(deck.getMainDeckSize());
+        digest.add(deck.getDiscardPileSize());
+        digest.add(deck.isFrozen());
+        digest.add(deck.getTopDiscardCard().has_value() ? cardKindIndex(*deck.getTopDiscardCard()) : CARD_KIND_COUNT);
+        return digest.value();
+    }
+}
+
+ScalarSimulator::ScalarSimulator(std::size_t playerCount) : playerCount(playerCount) {}
+
+SimulationResult ScalarSimulator::run(std::uint32_t seed, std::vector<std::uint64_t>* stateHashes) const {
+    std::vector<Player> players;
+    players.reserve(playerCount);
+    for (std::size_t i = 0; i < playerCount; ++i)
+        players.emplace_back("Player " + std::to_string(i + 1));
+    Team team1("Team 1");
+    Team team2("Team 2");
+    for (std::size_t i = 0; i < playerCount; ++i)
+        (i % 2 == 0 ? team1 : team2).addPlayer(players[i]);
+    std::vector<std::reference_wrapper<Player>> playerRefs(players.begin(), players.end());
+
+    RoundManager roundManager(playerRefs, std::cref(team1), std::cref(team2), seed);
+    roundManager.startRound();
+    auto recordState = [&] {
+        if (stateHashes)
+            stateHashes->push_back(roundManager.getStateHash());
+    };
+    recordState();
+
+    SimulationResult result;
+    std::size_t currentPlayer = 0;
+    while (result.turns < SIMULATION_MAX_TURNS) {
+        const Hand& hand = players[currentPlayer].getHand();
+        const Team& team = currentPlayer % 2 == 0 ? team1 : team2;
+
+        // Draw, or take the discard pile once the deck is empty
+        std::optional<Rank> takenRank;
+        auto drawStatus = roundManager.handleDrawDeckRequest().getStatus();
+        recordState();
+        if (drawStatus == TurnActionStatus::Error_MainDeckEmpty) {
+            takenRank = roundManager.getClientDeck().getTopDiscardCard()->getRank();
+            roundManager.handleTakeDiscardPileRequest();
+            recordState();
+            if (roundManager.isRoundOver()) {
+                result.outcome = SimulationOutcome::DeckExhausted;
+                break;
+            }
+        } else if (drawStatus != TurnActionStatus::Success_TurnContinues) {
+            break;
+        }
+
+        PolicyView view = makeView(hand, roundManager.getTeamStateForTeam(team));
+        MeldPlan plan = SimulationPolicy::planMelds(view, takenRank);
+        bool melded = false;
+        if (plan != 0) {
+            auto meldStatus = roundManager.handleMeldRequest(makeMeldRequests(hand, view, plan)).getStatus();
+            recordState();
+            if (meldStatus == TurnActionStatus::Success_WentOut) {
+                result.outcome = SimulationOutcome::WentOut;
+                break;
+            }
+            melded = meldStatus == TurnActionStatus::Success_TurnContinues;
+        }
+        if (takenRank.has_value() && !melded) {
+            // The pile cannot be kept without melding; put it back and give up
+            roundManager.handleRevertRequest();
+            recordState();
+            break;
+        }
+        if (melded)
+            view = makeView(hand, roundManager.getTeamStateForTeam(team));
+
+        const CardKindInfo& discard = cardKindInfos()[SimulationPolicy::chooseDiscard(view)];
+        auto discardStatus = roundManager.handleDiscardRequest(Card(discard.rank, discard.color)).getStatus();
+        recordState();
+        if (discardStatus == TurnActionStatus::Success_WentOut) {
+            result.outcome = SimulationOutcome::WentOut;
+            break;
+        }
+        if (discardStatus != TurnActionStatus::Success_TurnOver)
+            break;
+        ++result.turns;
+        currentPlayer = (currentPlayer + 1) % playerCount;
+    }
+
+    if (result.outcome != SimulationOutcome::Stalled) {
+        auto scores = roundManager.calculateScores();
+        result.teamScores = {scores[team1.getName()].calculateTotal(), scores[team2.getName()].calculateTotal()};
+    }
+    result.stateDigest = digestState(roundManager, players, team1, team2);
+    return result;
+}
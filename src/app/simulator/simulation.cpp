@@ -0,0 +1,204 @@
+#include "simulator/simulation.hpp"
+#include <algorithm>
+#include "invariant.hpp"
+#include <random>
+#include "meld.hpp" // For MIN_MELD_SIZE
+#include "rule_engine.hpp"
+
+namespace {
+    constexpr std::size_t INITIAL_HAND_SIZE = 11; // Same deal as RoundManager
+
+    // The deck before shuffling, in the order ServerDeck::initializeMainDeck builds it
+    std::array<std::uint8_t, SIMULATION_DECK_SIZE> unshuffledDeck() {
+        std::array<std::uint8_t, SIMULATION_DECK_SIZE> deck{};
+        std::size_t position = 0;
+        for (int copy = 0; copy < 2; ++copy) {
+            for (int rankInt = static_cast<int>(Rank::Two); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+                for (CardColor color : {CardColor::BLACK, CardColor::RED, CardColor::BLACK, CardColor::RED})
+                    deck[position++] = static_cast<std::uint8_t>(cardKindIndex(static_cast<Rank>(rankInt), color));
+            }
+        }
+        for (CardColor color : {CardColor::RED, CardColor::RED, CardColor::BLACK, CardColor::BLACK})
+            deck[position++] = static_cast<std::uint8_t>(cardKindIndex(Rank::Joker, color));
+        return deck;
+    }
+}
+
+const std::array<CardKindInfo, CARD_KIND_COUNT>& cardKindInfos() {
+    static const std::array<CardKindInfo, CARD_KIND_COUNT> infos = [] {
+        std::array<CardKindInfo, CARD_KIND_COUNT> result{};
+        for (int rankInt = static_cast<int>(Rank::Joker); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+            for (CardColor color : {CardColor::RED, CardColor::BLACK}) {
+                Card card(static_cast<Rank>(rankInt), color);
+                result[cardKindIndex(card)] = {card.getRank(), color, card.getType(), card.getPoints()};
+            }
+        }
+        return result;
+    }();
+    return infos;
+}
+
+SimulationDeal dealSimulatedRound(std::uint32_t seed, std::size_t playerCount) {
+    static const std::array<std::uint8_t, SIMULATION_DECK_SIZE> unshuffled = unshuffledDeck();
+    const auto& infos = cardKindInfos();
+    SimulationDeal deal;
+
+    // Same generator and algorithm as ServerDeck::shuffle, so the same seed gives the same deck
+    deal.deck = unshuffled;
+    std::mt19937 generator(seed);
+    std::shuffle(deal.deck.begin(), deal.deck.end(), generator);
+    deal.deckSize = SIMULATION_DECK_SIZE;
+    auto draw = [&deal] {
+        CANASTA_INVARIANT(deal.deckSize > 0, "Deck should not be empty while dealing");
+        return deal.deck[--deal.deckSize];
+    };
+
+    // Initial discard pile: red threes are set aside, wild cards and black threes freeze the pile
+    while (true) {
+        std::uint8_t kind = draw();
+        CardType type = infos[kind].type;
+        if (type == CardType::RedThree)
+            continue;
+        ++deal.pile[kind];
+        ++deal.pileSize;
+        deal.pileTop = kind;
+        if (freezesDiscardPile(type))
+            deal.pileFrozen = true;
+        if (type == CardType::Natural)
+            break;
+    }
+
+    // Red threes dealt go to the team's meld and are replaced
+    for (std::size_t player = 0; player < playerCount; ++player) {
+        std::size_t team = player % SIMULATION_TEAM_COUNT;
+        for (std::size_t i = 0; i < INITIAL_HAND_SIZE; ++i) {
+            std::uint8_t kind = draw();
+            while (infos[kind].type == CardType::RedThree) {
+                ++deal.redThrees[team];
+                kind = draw();
+            }
+            ++deal.hands[player][kind];
+            ++deal.handSizes[player];
+        }
+    }
+    return deal;
+}
+
+MeldPlan SimulationPolicy::planMelds(const PolicyView& view, std::optional<Rank> priorityRank) {
+    // Keep a card to discard, and one more while the team cannot go out
+    std::size_t minCardsLeft = view.canastaCount > 0 ? 1 : 2;
+    std::size_t cardsLeft = view.handSize;
+    MeldPlan plan = 0;
+    auto tryRank = [&](Rank rank) {
+        std::size_t index = rankMeldIndex(rank);
+        std::size_t naturals = view.hand[cardKindIndex(rank, CardColor::RED)]
+            + view.hand[cardKindIndex(rank, CardColor::BLACK)];
+        if (naturals == 0 || (view.melds[index] == 0 && naturals < MIN_MELD_SIZE)
+            || cardsLeft < naturals + minCardsLeft)
+            return;
+        plan |= static_cast<MeldPlan>(1u << index);
+        cardsLeft -= naturals;
+    };
+    bool hasPriority = priorityRank.has_value()
+        && *priorityRank >= Rank::Four && *priorityRank <= Rank::Ace;
+    if (hasPriority)
+        tryRank(*priorityRank);
+    for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+        Rank rank = static_cast<Rank>(rankInt);
+        if (!hasPriority || rank != *priorityRank)
+            tryRank(rank);
+    }
+    return plan;
+}
+
+std::size_t SimulationPolicy::chooseDiscard(const PolicyView& view) {
+    // Higher is discarded first: black threes, lone naturals, other naturals, wild cards, then the points.
+    // Ties go to the lowest kind. Written without branches on the hand, as it runs every simulated turn.
+    static const auto baseScores = [] {
+        std::array<int, CARD_KIND_COUNT> scores{};
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+            const CardKindInfo& info = cardKindInfos()[kind];
+            int group = info.type == CardType::BlackThree ? 3 : info.type == CardType::Natural ? 1 : 0;
+            scores[kind] = group * 1000 + info.points;
+        }
+        return scores;
+    }();
+    static const auto loneBonuses = [] {
+        std::array<int, CARD_KIND_COUNT> bonuses{};
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind)
+            bonuses[kind] = cardKindInfos()[kind].type == CardType::Natural ? 1000 : 0;
+        return bonuses;
+    }();
+
+    // Score and kind packed in one key, the lowest kind winning ties; absent cards get a negative key
+    int bestKey = -1;
+    for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+        // Both colors of a rank are next to each other
+        int sameRank = view.hand[kind & ~std::size_t{1}] + view.hand[kind | 1];
+        int score = baseScores[kind] + (sameRank == 1) * loneBonuses[kind] + 1;
+        int key = (view.hand[kind] != 0) * score * 32 + static_cast<int>(CARD_KIND_COUNT - kind) - 32;
+        bestKey = std::max(bestKey, key);
+    }
+    return bestKey < 0 ? CARD_KIND_COUNT : CARD_KIND_COUNT - static_cast<std::size_t>(bestKey % 32);
+}
+
+bool SimulationRules::canTakeDiscardPile(std::size_t topNaturalsInHand, std::size_t topMeldSize,
+    bool hasInitialMeld, bool pileFrozen) {
+    bool hasPair = topNaturalsInHand >= RuleEngine::STRICT_COMMITMENT_COUNT - 1;
+    if (hasPair && topMeldSize == 0)
+        return true;
+    if (!hasInitialMeld)
+        return false;
+    if (pileFrozen)
+        return hasPair && topMeldSize > 0;
+    return topMeldSize > 0 && topMeldSize < MIN_CANASTA_SIZE;
+}
+
+bool SimulationRules::isValidMeldPlan(const PolicyView& view, MeldPlan plan, std::optional<Rank> takenRank, bool pileFrozen) {
+    const auto& infos = cardKindInfos();
+    bool hasInitialMeld = std::any_of(view.melds.begin(), view.melds.end(), [](std::uint8_t size) { return size > 0; });
+    std::size_t cardsLeft = view.handSize;
+    std::size_t canastaCount = view.canastaCount;
+    std::size_t initializations = 0;
+    std::size_t additions = 0;
+    int initializationPoints = 0;
+    for (std::size_t rankMeld = 0; rankMeld < RANK_MELD_COUNT; ++rankMeld) {
+        if ((plan >> rankMeld & 1u) == 0)
+            continue;
+        Rank rank = rankOfMeld(rankMeld);
+        std::size_t naturals = naturalsOfRank(view, rank);
+        if (naturals == 0)
+            return false;
+        cardsLeft -= naturals;
+        if (view.melds[rankMeld] == 0) {
+            if (naturals < MIN_MELD_SIZE)
+                return false;
+            ++initializations;
+            initializationPoints += static_cast<int>(naturals) * infos[cardKindIndex(rank, CardColor::RED)].points;
+            if (naturals >= MIN_CANASTA_SIZE) {
+                initializationPoints += NATURAL_CANASTA_BONUS;
+                ++canastaCount;
+            }
+        } else {
+            ++additions;
+            if (view.melds[rankMeld] < MIN_CANASTA_SIZE && view.melds[rankMeld] + naturals >= MIN_CANASTA_SIZE)
+                ++canastaCount;
+        }
+    }
+    if (!hasInitialMeld && (initializations == 0 || additions > 0
+        || !RuleEngine::validatePointsForInitialMelds(initializationPoints, 0).has_value()))
+        return false;
+
+    // Commitment made by taking the discard pile, as in RuleEngine::checkTakingDiscardPile
+    if (takenRank.has_value()) {
+        std::size_t rankMeld = rankMeldIndex(*takenRank);
+        std::size_t required = view.melds[rankMeld] == 0 || pileFrozen
+            ? RuleEngine::STRICT_COMMITMENT_COUNT
+            : RuleEngine::EASY_COMMITMENT_COUNT;
+        if ((plan >> rankMeld & 1u) == 0 || naturalsOfRank(view, *takenRank) < required)
+            return false;
+    }
+
+    bool canGoOut = cardsLeft <= 1 && canastaCount >= RuleEngine::MIN_CANASTAS_TO_GO_OUT;
+    return canGoOut || cardsLeft > 0;
+}
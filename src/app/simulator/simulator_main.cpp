@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "hand.hpp"
+#include "team_round_state.hpp"
+#include "rule_engine.hpp"
+#include "speculative_state.hpp"
+#include "simulator/simulation.hpp"
+#include "simulator/scalar_simulator.hpp"
+#include "simulator/batch_simulator.hpp"
+#include "simulator/endgame_solver.hpp"
+#include "simulator/belief_model.hpp"
+#include "simulator/vec_env.hpp"
+
+// Simulator constants
+constexpr std::size_t DEFAULT_GAME_COUNT = 10000;
+constexpr std::size_t BATCH_SIZE = 4096; // Rounds played in lockstep by one BatchSimulator::run
+
+void printUsage() {
+    std::cerr << "Usage: canasta_simulator [--games=N] [--players=2|4] [--seed=N] [--engine=batch|scalar] [--verify] [--replay]\n"
+              << "       canasta_simulator --endgame=DECK_CARDS [--games=N] [--players=2|4] [--seed=N] [--budget-ms=N] [--threads=N]\n"
+              << "       canasta_simulator --beliefs=SAMPLES [--games=N] [--players=2|4] [--seed=N]\n"
+              << "       canasta_simulator --vec-env=STEPS [--players=2|4] [--seed=N] [--threads=N]\n"
+              << "       canasta_simulator --what-if [--games=N] [--seed=N]\n";
+}
+
+// Play the rounds of the given seeds and report the time taken
+std::vector<SimulationResult> runEngine(const std::string& engine, std::size_t playersCount,
+    const std::vector<std::uint32_t>& seeds, double& seconds) {
+    std::vector<SimulationResult> results;
+    results.reserve(seeds.size());
+    auto start = std::chrono::steady_clock::now();
+    if (engine == "scalar") {
+        ScalarSimulator simulator(playersCount);
+        for (auto seed : seeds)
+            results.push_back(simulator.run(seed));
+    } else {
+        BatchSimulator simulator(playersCount);
+        for (std::size_t first = 0; first < seeds.size(); first += BATCH_SIZE) {
+            std::size_t count = std::min(BATCH_SIZE, seeds.size() - first);
+            auto batch = simulator.run(std::span<const std::uint32_t>(seeds.data() + first, count));
+            results.insert(results.end(), batch.begin(), batch.end());
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return results;
+}
+
+void printSummary(const std::string& engine, const std::vector<SimulationResult>& results, double seconds) {
+    std::size_t outcomes[3] = {};
+    double turns = 0;
+    double scores[SIMULATION_TEAM_COUNT] = {};
+    for (const auto& result : results) {
+        ++outcomes[static_cast<std::size_t>(result.outcome)];
+        turns += result.turns;
+        for (std::size_t team = 0; team < SIMULATION_TEAM_COUNT; ++team)
+            scores[team] += result.teamScores[team];
+    }
+    double count = static_cast<double>(std::max<std::size_t>(results.size(), 1));
+    std::cout << engine << ": " << results.size() << " rounds in " << seconds << " s, "
+              << static_cast<double>(results.size()) / seconds << " rounds/s\n"
+              << "  went out " << outcomes[0] << ", deck exhausted " << outcomes[1]
+              << ", stalled " << outcomes[2] << ", " << turns / count << " turns on average\n"
+              << "  average scores " << scores[0] / count << " / " << scores[1] / count << "\n";
+}
+
+// Determinism check: replaying a seed must go through the same state hash after every action
+std::size_t replayRounds(std::size_t playersCount, const std::vector<std::uint32_t>& seeds) {
+    ScalarSimulator simulator(playersCount);
+    std::size_t mismatches = 0;
+    std::vector<std::uint64_t> firstHashes;
+    std::vector<std::uint64_t> replayHashes;
+    for (auto seed : seeds) {
+        firstHashes.clear();
+        replayHashes.clear();
+        simulator.run(seed, &firstHashes);
+        simulator.run(seed, &replayHashes);
+        auto [first, replay] = std::ranges::mismatch(firstHashes, replayHashes);
+        if (first == firstHashes.end() && replay == replayHashes.end())
+            continue;
+        if (mismatches++ < 10)
+            std::cerr << "Replay of seed " << seed << " diverges after action "
+                      << first - firstHashes.begin() << "\n";
+    }
+    return mismatches;
+}
+
+// Post-game analysis: play every round with the policy until the deck is nearly empty, then solve the rest
+// and compare the best value with what the policy gets from the same position
+void analyzeEndgames(std::size_t playersCount, const std::vector<std::uint32_t>& seeds, std::size_t endgameDeckSize,
+    const EndgameSolverOptions& options) {
+    EndgameSolver solver(options);
+    std::size_t solved = 0;
+    std::size_t exact = 0;
+    std::size_t depths = 0;
+    std::uint64_t nodes = 0;
+    double seconds = 0;
+    double gains = 0;
+    for (auto seed : seeds) {
+        EndgameState state = EndgameState::fromDeal(dealSimulatedRound(seed, playersCount), playersCount);
+        while (!state.isOver() && state.getDeckSize() > endgameDeckSize) {
+            auto move = state.policyMove();
+            if (!move.has_value())
+                break;
+            state = state.play(*move);
+        }
+        EndgameMoveList moves;
+        state.generateMoves(moves);
+        if (state.getDeckSize() > endgameDeckSize || moves.size == 0)
+            continue; // Over or stalled before the endgame
+        EndgameResult result = solver.solve(state);
+
+        EndgameState policyState = state;
+        while (!policyState.isOver()) {
+            auto move = policyState.policyMove();
+            policyState = move.has_value() ? policyState.play(*move) : policyState.endRound();
+        }
+        auto scores = policyState.teamScores();
+        std::size_t team = state.getCurrentTeam();
+        gains += result.value - (scores[team] - scores[1 - team]);
+
+        ++solved;
+        exact += result.exact;
+        depths += result.depth;
+        nodes += result.nodes;
+        seconds += result.seconds;
+    }
+    double count = static_cast<double>(std::max<std::size_t>(solved, 1));
+    std::cout << "endgame: " << solved << " positions with at most " << endgameDeckSize << " cards in the deck, "
+              << exact << " solved exactly\n"
+              << "  " << static_cast<double>(depths) / count << " turns deep on average, "
+              << static_cast<double>(nodes) / std::max(seconds, 1e-9) << " nodes/s on " << options.threadCount << " threads\n"
+              << "  best play scores " << gains / count << " points more than the policy for the team to move\n";
+}
+
+// Bits per card needed to encode the true hidden hands with the expected hands of a model (lower is better)
+double handCrossEntropy(BeliefModel& model, const EndgameState& state, std::size_t playersCount, std::size_t observer) {
+    constexpr double MIN_PROBABILITY = 1e-6;
+    double bits = 0;
+    for (std::size_t player = 0; player < playersCount; ++player) {
+        std::size_t handSize = model.getHandSize(player);
+        if (player == observer || handSize == 0)
+            continue;
+        const auto& expectedHand = model.expectedHand(player);
+        for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+            double probability = std::max(expectedHand[kind] / static_cast<double>(handSize), MIN_PROBABILITY);
+            bits -= state.getHand(player)[kind] * std::log2(probability);
+        }
+    }
+    return bits;
+}
+
+// Belief tracking: play every round with the policy and let the first player follow it with a belief model,
+// scored against plain card counting, with a few determinizations sampled after every turn
+void analyzeBeliefs(std::size_t playersCount, const std::vector<std::uint32_t>& seeds, std::size_t samplesPerTurn) {
+    constexpr std::size_t OBSERVER = 0;
+    BeliefModelOptions countingOnly;
+    countingOnly.meldFactor = countingOnly.discardFactor = countingOnly.declineFactor = 1;
+    std::mt19937_64 generator(seeds.empty() ? 0 : seeds.front());
+    std::size_t turns = 0;
+    std::size_t hiddenCards = 0;
+    double modelBits = 0;
+    double countingBits = 0;
+    double updateSeconds = 0;
+    double sampleSeconds = 0;
+    std::size_t samples = 0;
+    double effectiveSamples = 0;
+    for (auto seed : seeds) {
+        SimulationDeal deal = dealSimulatedRound(seed, playersCount);
+        EndgameState state = EndgameState::fromDeal(deal, playersCount);
+        BeliefModel model(deal, playersCount, OBSERVER);
+        BeliefModel counting(deal, playersCount, OBSERVER, countingOnly);
+        std::vector<BeliefSample> turnSamples(samplesPerTurn);
+        while (!state.isOver()) {
+            auto move = state.policyMove();
+            if (!move.has_value())
+                break;
+            TurnObservation observation;
+            state = state.play(*move, &observation);
+
+            // An update is timed with the query that follows it, as the probabilities are balanced lazily
+            auto start = std::chrono::steady_clock::now();
+            model.observe(observation);
+            model.expectedHand(1);
+            updateSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            counting.observe(observation);
+            modelBits += handCrossEntropy(model, state, playersCount, OBSERVER);
+            countingBits += handCrossEntropy(counting, state, playersCount, OBSERVER);
+            for (std::size_t player = 1; player < playersCount; ++player)
+                hiddenCards += model.getHandSize(player);
+            ++turns;
+
+            if (samplesPerTurn == 0)
+                continue;
+            start = std::chrono::steady_clock::now();
+            for (auto& sample : turnSamples)
+                sample = model.sample(generator);
+            sampleSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double weights = 0;
+            double squaredWeights = 0;
+            for (const auto& sample : turnSamples) {
+                state.determinize(sample); // Checks that the sample fits the position
+                weights += sample.weight;
+                squaredWeights += sample.weight * sample.weight;
+            }
+            samples += samplesPerTurn;
+            effectiveSamples += squaredWeights > 0 ? weights * weights / squaredWeights : 0;
+        }
+    }
+    double turnCount = static_cast<double>(std::max<std::size_t>(turns, 1));
+    double cardCount = static_cast<double>(std::max<std::size_t>(hiddenCards, 1));
+    std::cout << "beliefs: " << turns << " turns followed by player 1 in " << seeds.size() << " rounds\n"
+              << "  " << modelBits / cardCount << " bits per hidden card with the evidence, "
+              << countingBits / cardCount << " with card counting only\n"
+              << "  " << updateSeconds / turnCount * 1e6 << " us per update and query\n";
+    if (samples > 0)
+        std::cout << "  " << sampleSeconds / static_cast<double>(samples) * 1e6 << " us per determinization, "
+                  << effectiveSamples / turnCount << " effective samples out of " << samplesPerTurn << " per turn\n";
+}
+
+// Training environment throughput: step VecEnv with random legal actions for growing numbers of tables
+void benchmarkVecEnv(std::size_t playersCount, std::uint32_t seed, std::size_t steps, std::size_t threadCount) {
+    std::mt19937 generator(seed);
+    for (std::size_t envCount = 1; envCount <= 1024; envCount *= 4) {
+        std::vector<float> observations(envCount * VEC_ENV_OBSERVATION_SIZE);
+        std::vector<std::int8_t> actionMasks(envCount * VEC_ENV_ACTION_COUNT);
+        std::vector<float> rewards(envCount);
+        std::vector<std::uint8_t> dones(envCount);
+        std::vector<std::uint8_t> players(envCount);
+        VecEnv env({playersCount, envCount, threadCount, seed}, {observations, actionMasks, rewards, dones, players});
+        std::vector<std::uint32_t> actions(envCount);
+        std::size_t rounds = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t step = 0; step < steps; ++step) {
+            for (std::size_t index = 0; index < envCount; ++index) {
+                // First legal action from a random offset
+                const std::int8_t* mask = actionMasks.data() + index * VEC_ENV_ACTION_COUNT;
+                std::size_t action = generator() % VEC_ENV_ACTION_COUNT;
+                while (mask[action] == 0)
+                    action = (action + 1) % VEC_ENV_ACTION_COUNT;
+                actions[index] = static_cast<std::uint32_t>(action);
+            }
+            env.step(actions);
+            rounds += static_cast<std::size_t>(std::count(dones.begin(), dones.end(), std::uint8_t{1}));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "vec-env: " << envCount << " tables, " << static_cast<double>(steps * envCount) / seconds
+                  << " steps/s, " << rounds << " rounds finished, " << env.getIllegalActionCount()
+                  << " illegal actions\n";
+    }
+}
+
+// What-if throughput: try every meld of a 22-card hand, with a SpeculativeState and with copies of the hand and melds
+void benchmarkWhatIf(const std::vector<std::uint32_t>& seeds) {
+    std::size_t evaluations = 0;
+    double speculativeSeconds = 0;
+    double copySeconds = 0;
+    int checksum = 0;
+    for (auto seed : seeds) {
+        // Two dealt hands in one, so most ranks can be melded
+        SimulationDeal deal = dealSimulatedRound(seed, 2);
+        Hand hand;
+        for (const auto& dealtHand : {deal.hands[0], deal.hands[1]}) {
+            for (std::size_t kind = 0; kind < CARD_KIND_COUNT; ++kind) {
+                const CardKindInfo& info = cardKindInfos()[kind];
+                for (std::uint8_t copy = 0; copy < dealtHand[kind]; ++copy)
+                    hand.addCard(Card(info.rank, info.color));
+            }
+        }
+        TeamRoundState teamRoundState;
+
+        // Candidates: the naturals of every rank, alone and with each wild card of the hand
+        std::vector<std::pair<Rank, std::vector<Card>>> candidates;
+        for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+            Rank rank = static_cast<Rank>(rankInt);
+            std::vector<Card> naturals;
+            for (const auto& card : hand.getCards()) {
+                if (card.getRank() == rank)
+                    naturals.push_back(card);
+            }
+            candidates.emplace_back(rank, naturals);
+            for (const auto& card : hand.getCards()) {
+                if (card.getType() != CardType::Wild)
+                    continue;
+                candidates.emplace_back(rank, naturals);
+                candidates.back().second.push_back(card);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        SpeculativeState speculation(hand, teamRoundState);
+        for (const auto& [rank, cards] : candidates) {
+            if (speculation.stageMeldInitialization(rank, cards).has_value())
+                checksum += speculation.totalMeldPoints() + speculation.canGoOut();
+            speculation.discard();
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (const auto& [rank, cards] : candidates) {
+            Hand handCopy = hand;
+            TeamRoundState teamCopy = teamRoundState.clone();
+            BaseMeld* meld = teamCopy.getMeldForRank(rank);
+            auto proof = meld->checkInitialization(cards);
+            if (!proof.has_value())
+                continue;
+            meld->initialize(cards, proof.value());
+            for (const auto& card : cards)
+                handCopy.removeCard(card);
+            checksum -= teamCopy.calculateMeldPoints() + RuleEngine::canGoingOut(handCopy.cardCount(), teamCopy);
+        }
+        auto end = std::chrono::steady_clock::now();
+        speculativeSeconds += std::chrono::duration<double>(middle - start).count();
+        copySeconds += std::chrono::duration<double>(end - middle).count();
+        evaluations += candidates.size();
+    }
+    if (checksum != 0)
+        std::cerr << "The speculative state and the copies disagree on some melds.\n";
+    std::cout << "what-if: " << evaluations << " melds tried on " << seeds.size() << " hands\n"
+              << "  speculative state: " << static_cast<double>(evaluations) / speculativeSeconds / 1000 << " per ms\n"
+              << "  copies of the hand and melds: " << static_cast<double>(evaluations) / copySeconds / 1000 << " per ms\n";
+}
+
+int main(int argc, char* argv[]) {
+    spdlog::set_level(spdlog::level::off); // The rule engine logs every action
+    std::size_t gamesCount = DEFAULT_GAME_COUNT;
+    std::size_t playersCount = 2;
+    std::uint32_t firstSeed = 1;
+    std::string engine = "batch";
+    bool verify = false;
+    bool replay = false;
+    std::optional<std::size_t> endgameDeckSize;
+    std::optional<std::size_t> beliefSamples;
+    std::optional<std::size_t> vecEnvSteps;
+    bool whatIf = false;
+    EndgameSolverOptions endgameOptions;
+    endgameOptions.threadCount = std::max(1u, std::thread::hardware_concurrency());
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option.rfind("--games=", 0) == 0)
+                gamesCount = std::stoul(option.substr(8));
+            else if (option.rfind("--players=", 0) == 0)
+                playersCount = std::stoul(option.substr(10));
+            else if (option.rfind("--seed=", 0) == 0)
+                firstSeed = static_cast<std::uint32_t>(std::stoul(option.substr(7)));
+            else if (option.rfind("--engine=", 0) == 0)
+                engine = option.substr(9);
+            else if (option == "--verify")
+                verify = true;
+            else if (option == "--replay")
+                replay = true;
+            else if (option.rfind("--endgame=", 0) == 0)
+                endgameDeckSize = std::stoul(option.substr(10));
+            else if (option.rfind("--beliefs=", 0) == 0)
+                beliefSamples = std::stoul(option.substr(10));
+            else if (option == "--what-if")
+                whatIf = true;
+            else if (option.rfind("--vec-env=", 0) == 0)
+                vecEnvSteps = std::stoul(option.substr(10));
+            else if (option.rfind("--budget-ms=", 0) == 0)
+                endgameOptions.timeBudget = std::chrono::milliseconds(std::stoul(option.substr(12)));
+            else if (option.rfind("--threads=", 0) == 0)
+                endgameOptions.threadCount = std::max<std::size_t>(std::stoul(option.substr(10)), 1);
+            else {
+                printUsage();
+                return 1;
+            }
+        }
+    } catch (const std::exception&) {
+        printUsage();
+        return 1;
+    }
+    if ((playersCount != 2 && playersCount != 4) || (engine != "batch" && engine != "scalar")) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::uint32_t> seeds(gamesCount);
+    std::iota(seeds.begin(), seeds.end(), firstSeed);
+
+    if (endgameDeckSize.has_value()) {
+        analyzeEndgames(playersCount, seeds, *endgameDeckSize, endgameOptions);
+        return 0;
+    }
+    if (whatIf) {
+        benchmarkWhatIf(seeds);
+        return 0;
+    }
+    if (vecEnvSteps.has_value()) {
+        benchmarkVecEnv(playersCount, firstSeed, *vecEnvSteps, endgameOptions.threadCount);
+        return 0;
+    }
+    if (beliefSamples.has_value()) {
+        analyzeBeliefs(playersCount, seeds, *beliefSamples);
+        return 0;
+    }
+    if (replay) {
+        std::size_t mismatches = replayRounds(playersCount, seeds);
+        if (mismatches > 0) {
+            std::cerr << mismatches << " of " << seeds.size() << " rounds diverge when replayed.\n";
+            return 1;
+        }
+        std::cout << "All " << seeds.size() << " rounds replay through the same states.\n";
+        return 0;
+    }
+
+    double seconds = 0;
+    auto results = runEngine(engine, playersCount, seeds, seconds);
+    printSummary(engine, results, seconds);
+    if (!verify)
+        return 0;
+
+    // Differential check: the other engine must give exactly the same result for every seed
+    std::string otherEngine = engine == "batch" ? "scalar" : "batch";
+    double otherSeconds = 0;
+    auto otherResults = runEngine(otherEngine, playersCount, seeds, otherSeconds);
+    printSummary(otherEngine, otherResults, otherSeconds);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < seeds.size(); ++i) {
+        if (results[i] == otherResults[i])
+            continue;
+        if (mismatches++ < 10)
+            std::cerr << "Mismatch for seed " << seeds[i] << ": turns " << results[i].turns << " vs "
+                      << otherResults[i].turns << ", scores " << results[i].teamScores[0] << "/"
+                      << results[i].teamScores[1] << " vs " << otherResults[i].teamScores[0] << "/"
+                      << otherResults[i].teamScores[1] << "\n";
+    }
+    if (mismatches > 0) {
+        std::cerr << mismatches << " of " << seeds.size() << " rounds differ between the engines.\n";
+        return 1;
+    }
+    double batchSeconds = engine == "batch" ? seconds : otherSeconds;
+    double scalarSeconds = engine == "batch" ? otherSeconds : seconds;
+    std::cout << "All " << seeds.size() << " rounds match; batch is " << scalarSeconds / batchSeconds
+              << "x faster than scalar.\n";
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "simulator/vec_env.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr float SCORE_SCALE = 100; // Rewards and scores in hundreds of points
+
+    // A round still running after this many turns is ended as is, like a stalled simulated round
+    constexpr std::uint32_t MAX_TURNS_PER_ROUND = SIMULATION_MAX_TURNS;
+
+    int teamScoreDifference(const EndgameState& state, std::size_t team) {
+        auto scores = state.teamScores();
+        return scores[team] - scores[1 - team];
+    }
+}
+
+VecEnv::VecEnv(VecEnvOptions options, VecEnvBuffers buffers)
+    : options(options), buffers(buffers), tables(options.envCount) {
+    if (options.playerCount != 2 && options.playerCount != 4)
+        throw std::invalid_argument("VecEnv needs 2 or 4 players, got " + std::to_string(options.playerCount));
+    std::size_t envCount = options.envCount;
+    if (buffers.observations.size() != envCount * VEC_ENV_OBSERVATION_SIZE
+        || buffers.actionMasks.size() != envCount * VEC_ENV_ACTION_COUNT
+        || buffers.rewards.size() != envCount || buffers.dones.size() != envCount || buffers.players.size() != envCount)
+        throw std::invalid_argument("VecEnv buffers do not match " + std::to_string(envCount) + " tables");
+
+    this->options.threadCount = std::clamp<std::size_t>(options.threadCount, 1, std::max<std::size_t>(envCount, 1));
+    if (this->options.threadCount > 1) {
+        barrier = std::make_unique<std::barrier<>>(static_cast<std::ptrdiff_t>(this->options.threadCount));
+        for (std::size_t worker = 1; worker < this->options.threadCount; ++worker)
+            workers.emplace_back([this, worker] { work(worker); });
+    }
+    reset();
+}
+
+VecEnv::~VecEnv() {
+    if (!barrier)
+        return;
+    stopping = true;
+    barrier->arrive_and_wait(); // Wakes the workers up to see the flag; the jthreads are joined after
+}
+
+void VecEnv::reset() {
+    for (std::size_t index = 0; index < tables.size(); ++index) {
+        deal(index);
+        buffers.rewards[index] = 0;
+        buffers.dones[index] = 0;
+        publish(index);
+    }
+}
+
+void VecEnv::step(std::span<const std::uint32_t> actions) {
+    if (actions.size() != tables.size())
+        throw std::invalid_argument("VecEnv::step needs one action per table");
+    pendingActions = actions;
+    if (barrier)
+        barrier->arrive_and_wait(); // Start
+    stepRange(0);
+    if (barrier)
+        barrier->arrive_and_wait(); // Done
+}
+
+std::size_t VecEnv::actionIndex(const EndgameMove& move) {
+    std::size_t pickUpAndMeld = static_cast<std::size_t>(move.takePile) * 2 + (move.plan != 0);
+    return pickUpAndMeld * VEC_ENV_DISCARD_CHOICES + move.discard;
+}
+
+void VecEnv::encodeObservation(const EndgameState& state, std::span<float, VEC_ENV_OBSERVATION_SIZE> observation) {
+    std::size_t player = state.getCurrentPlayer();
+    std::size_t team = state.getCurrentTeam();
+    auto out = observation.begin();
+    for (auto count : state.getHand(player))
+        *out++ = count;
+    for (std::size_t meldTeam : {team, 1 - team}) {
+        for (auto size : state.getMelds(meldTeam))
+            *out++ = size;
+    }
+    *out++ = static_cast<float>(state.getRedThrees(team));
+    *out++ = static_cast<float>(state.getRedThrees(1 - team));
+    *out++ = static_cast<float>(state.getDeckSize());
+    *out++ = static_cast<float>(state.getPileSize());
+    auto topBegin = out;
+    std::fill_n(out, VEC_ENV_DISCARD_CHOICES, 0.0f);
+    out += VEC_ENV_DISCARD_CHOICES;
+    topBegin[state.getPileTop()] = 1;
+    *out++ = state.isPileFrozen();
+    for (std::size_t next = 1; next < SIMULATION_MAX_PLAYERS; ++next) {
+        *out++ = next < state.getPlayerCount()
+            ? static_cast<float>(state.getHandSize((player + next) % state.getPlayerCount()))
+            : 0.0f;
+    }
+    auto scores = state.teamScores();
+    *out++ = static_cast<float>(scores[team]) / SCORE_SCALE;
+    *out++ = static_cast<float>(scores[1 - team]) / SCORE_SCALE;
+}
+
+void VecEnv::work(std::size_t worker) {
+    while (true) {
+        barrier->arrive_and_wait(); // Start
+        if (stopping)
+            return;
+        stepRange(worker);
+        barrier->arrive_and_wait(); // Done
+    }
+}
+
+void VecEnv::stepRange(std::size_t worker) {
+    // Contiguous ranges keep each thread on its own rows of the buffers
+    std::size_t first = tables.size() * worker / options.threadCount;
+    std::size_t last = tables.size() * (worker + 1) / options.threadCount;
+    for (std::size_t index = first; index < last; ++index)
+        stepTable(index, pendingActions[index]);
+}
+
+void VecEnv::deal(std::size_t index) {
+    Table& table = tables[index];
+    std::uint32_t seed = options.seed + static_cast<std::uint32_t>(index + table.rounds * tables.size());
+    table.state = EndgameState::fromDeal(dealSimulatedRound(seed, options.playerCount), options.playerCount);
+    ++table.rounds;
+    table.turns = 0;
+}
+
+void VecEnv::publish(std::size_t index) {
+    Table& table = tables[index];
+    table.state.generateMoves(table.moves);
+    table.moveOfAction.fill(static_cast<std::uint8_t>(ENDGAME_MAX_MOVES));
+    auto mask = buffers.actionMasks.subspan(index * VEC_ENV_ACTION_COUNT, VEC_ENV_ACTION_COUNT);
+    std::fill(mask.begin(), mask.end(), std::int8_t{0});
+    for (std::size_t i = 0; i < table.moves.size; ++i) {
+        std::size_t action = actionIndex(table.moves.moves[i]);
+        table.moveOfAction[action] = static_cast<std::uint8_t>(i);
+        mask[action] = 1;
+    }
+    encodeObservation(table.state, buffers.observations.subspan(index * VEC_ENV_OBSERVATION_SIZE)
+        .first<VEC_ENV_OBSERVATION_SIZE>());
+    buffers.players[index] = static_cast<std::uint8_t>(table.state.getCurrentPlayer());
+}
+
+void VecEnv::stepTable(std::size_t index, std::uint32_t action) {
+    Table& table = tables[index];
+    std::size_t team = table.state.getCurrentTeam();
+    int before = teamScoreDifference(table.state, team);
+
+    std::size_t move = action < VEC_ENV_ACTION_COUNT ? table.moveOfAction[action] : ENDGAME_MAX_MOVES;
+    if (move == ENDGAME_MAX_MOVES) {
+        illegalActions.fetch_add(1, std::memory_order_relaxed);
+        move = 0; // A dealt round always starts with a legal move, and rounds end when none is left
+    }
+    table.state = table.state.play(table.moves.moves[move]);
+    ++table.turns;
+
+    // The next player may be left without a legal move (the deck only holds red threes, the pile cannot be taken):
+    // the round ends there, as in the simulators
+    bool over = table.state.isOver();
+    if (!over) {
+        publish(index);
+        over = table.moves.size == 0 || table.turns >= MAX_TURNS_PER_ROUND;
+        if (over)
+            table.state = table.state.endRound();
+    }
+    buffers.rewards[index] = static_cast<float>(teamScoreDifference(table.state, team) - before) / SCORE_SCALE;
+    buffers.dones[index] = over;
+    if (over) {
+        deal(index);
+        publish(index);
+    }
+}
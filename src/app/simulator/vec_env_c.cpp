@@ -0,0 +1,50 @@
+#include "simulator/vec_env_c.h"
+#include <stdexcept>
+#include "simulator/vec_env.hpp"
+
+struct CanastaVecEnv {
+    std::size_t envCount;
+    VecEnv env;
+};
+
+size_t canasta_vec_env_observation_size(void) {
+    return VEC_ENV_OBSERVATION_SIZE;
+}
+
+size_t canasta_vec_env_action_count(void) {
+    return VEC_ENV_ACTION_COUNT;
+}
+
+CanastaVecEnv* canasta_vec_env_create(size_t player_count, size_t env_count, size_t thread_count, uint32_t seed,
+    float* observations, int8_t* action_masks, float* rewards, uint8_t* dones, uint8_t* players) {
+    VecEnvOptions options{player_count, env_count, thread_count, seed};
+    VecEnvBuffers buffers{
+        {observations, env_count * VEC_ENV_OBSERVATION_SIZE},
+        {action_masks, env_count * VEC_ENV_ACTION_COUNT},
+        {rewards, env_count},
+        {dones, env_count},
+        {players, env_count}
+    };
+    // Exceptions must not cross the C boundary
+    try {
+        return new CanastaVecEnv{env_count, VecEnv(options, buffers)};
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void canasta_vec_env_reset(CanastaVecEnv* env) {
+    env->env.reset();
+}
+
+void canasta_vec_env_step(CanastaVecEnv* env, const uint32_t* actions) {
+    env->env.step({actions, env->envCount});
+}
+
+uint64_t canasta_vec_env_illegal_actions(const CanastaVecEnv* env) {
+    return env->env.getIllegalActionCount();
+}
+
+void canasta_vec_env_destroy(CanastaVecEnv* env) {
+    delete env;
+}
@@ -0,0 +1,365 @@
+#include "speculative_state.hpp"
+#include "invariant.hpp"
+#include <stdexcept>
+#include <string>
+#include "rule_engine.hpp" // For MIN_CANASTAS_TO_GO_OUT
+
+namespace {
+    constexpr std::size_t CHANGES_RESERVED = 32; // More than a whole turn stages, so staging does not allocate
+
+    std::size_t rankMeldIndex(Rank rank) {
+        return static_cast<std::size_t>(rank) - static_cast<std::size_t>(Rank::Four);
+    }
+
+    bool isRankMeldRank(Rank rank) {
+        return rank >= Rank::Four && rank <= Rank::Ace;
+    }
+}
+
+SpeculativeState::SpeculativeState(const Hand& hand, const TeamRoundState& teamRoundState, const ClientDeck& deck)
+    : baseHand(&hand), baseTeamRoundState(&teamRoundState) {
+    for (const auto& card : hand.getCards())
+        ++base.hand[cardKindIndex(card)];
+    base.handSize = hand.cardCount();
+    for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+        Rank rank = static_cast<Rank>(rankInt);
+        const BaseMeld* meld = teamRoundState.getMeldForRank(rank);
+        if (!meld || !meld->isInitialized())
+            continue;
+        MeldCounts& counts = base.rankMelds[rankMeldIndex(rank)];
+        counts.initialized = true;
+        for (const auto& card : meld->getNaturalCardsView()) {
+            ++counts.naturals;
+            counts.cardPoints += card.getPoints();
+        }
+        for (const auto& card : meld->getWildCardsView()) {
+            ++counts.wilds;
+            counts.cardPoints += card.getPoints();
+        }
+    }
+    const BaseMeld* blackThreeMeld = teamRoundState.getBlackThreeMeld();
+    if (blackThreeMeld && blackThreeMeld->isInitialized()) {
+        base.blackThrees = static_cast<std::uint8_t>(blackThreeMeld->getCards().size());
+        base.blackThreePoints = blackThreeMeld->getPoints();
+    }
+    base.deck = deck;
+    current = base;
+    changes.reserve(CHANGES_RESERVED);
+}
+
+// --- Staging ---
+
+Status SpeculativeState::stageMeldInitialization(Rank rank, std::span<const Card> cards) {
+    if (!isRankMeldRank(rank))
+        return std::unexpected("No meld of rank " + to_string(rank));
+    if (rankMeld(rank).initialized)
+        return std::unexpected("Meld is already initialized");
+    if (cards.size() < MIN_MELD_SIZE)
+        return std::unexpected("Meld must contain at least " + std::to_string(MIN_MELD_SIZE) + " cards");
+    if (auto status = checkRankCards(rank, cards, 0, 0); !status.has_value())
+        return status;
+    if (auto status = checkInHand(cards); !status.has_value())
+        return status;
+
+    markStaged(rank);
+    stageRankCards(rank, cards, Change::Type::MeldInitialization);
+    return {};
+}
+
+Status SpeculativeState::stageMeldInitialization(Rank rank, std::span<const Card> cards, const MeldProof& proof) {
+    if (!acceptsProof(rank, cards, proof) || rankMeld(rank).initialized)
+        return stageMeldInitialization(rank, cards);
+    if (auto status = checkInHand(cards); !status.has_value())
+        return status;
+
+    markStaged(rank);
+    stageRankCards(rank, cards, Change::Type::MeldInitialization);
+    proofs.initializations[rankMeldIndex(rank)] = proof;
+    return {};
+}
+
+Status SpeculativeState::stageMeldAddition(Rank rank, std::span<const Card> cards) {
+    if (!isRankMeldRank(rank))
+        return std::unexpected("No meld of rank " + to_string(rank));
+    if (!rankMeld(rank).initialized)
+        return std::unexpected("Meld is not initialized");
+    if (cards.empty())
+        return std::unexpected("You must add at least 1 card");
+    if (auto status = checkRankCards(rank, cards, rankMeld(rank).naturals, rankMeld(rank).wilds); !status.has_value())
+        return status;
+    if (auto status = checkInHand(cards); !status.has_value())
+        return status;
+
+    markStaged(rank);
+    stageRankCards(rank, cards, Change::Type::MeldAddition);
+    return {};
+}
+
+Status SpeculativeState::stageMeldAddition(Rank rank, std::span<const Card> cards, const MeldProof& proof) {
+    if (!acceptsProof(rank, cards, proof) || !rankMeld(rank).initialized)
+        return stageMeldAddition(rank, cards);
+    if (auto status = checkInHand(cards); !status.has_value())
+        return status;
+
+    markStaged(rank);
+    stageRankCards(rank, cards, Change::Type::MeldAddition);
+    proofs.additions[rankMeldIndex(rank)] = proof;
+    return {};
+}
+
+Status SpeculativeState::stageBlackThreeMeld(std::span<const Card> cards) {
+    // Same checks as BlackThreeMeld::checkInitialization
+    if (current.blackThrees > 0)
+        return std::unexpected("Black Three Meld is already initialized");
+    if (cards.size() < MIN_MELD_SIZE)
+        return std::unexpected("Black Three Meld must contain at least " + std::to_string(MIN_MELD_SIZE) + " cards");
+    if (cards.size() > MAX_SPECIAL_MELD_SIZE)
+        return std::unexpected("Black Three Meld can contain at most " + std::to_string(MAX_SPECIAL_MELD_SIZE) + " cards");
+    for (const auto& card : cards) {
+        if (card.getType() != CardType::BlackThree)
+            return std::unexpected("Invalid card " + card.toString() + " for Black Three Meld");
+    }
+    if (auto status = checkInHand(cards); !status.has_value())
+        return status;
+
+    for (const auto& card : cards) {
+        ++current.blackThrees;
+        current.blackThreePoints += card.getPoints();
+        removeFromHand(card);
+        changes.push_back({Change::Type::BlackThreeMeld, card});
+    }
+    return {};
+}
+
+Status SpeculativeState::stageBlackThreeMeld(std::span<const Card> cards, const MeldProof& proof) {
+    const BaseMeld* meld = baseTeamRoundState->getBlackThreeMeld();
+    if (current.blackThrees > 0 || !meld || !proof.holdsFor(*meld, cards))
+        return stageBlackThreeMeld(cards);
+    if (auto status = checkInHand(cards); !status.has_value())
+        return status;
+
+    for (const auto& card : cards) {
+        ++current.blackThrees;
+        current.blackThreePoints += card.getPoints();
+        removeFromHand(card);
+        changes.push_back({Change::Type::BlackThreeMeld, card});
+    }
+    proofs.blackThrees = proof;
+    return {};
+}
+
+Status SpeculativeState::stageDraw(const Card& card) {
+    if (current.deck.getMainDeckSize() == 0)
+        return std::unexpected("The main deck is empty");
+    ClientDeck& deck = current.deck;
+    deck = ClientDeck(deck.getMainDeckSize() - 1, deck.getTopDiscardCard(), deck.getDiscardPileSize(), deck.isFrozen());
+    addToHand(card);
+    return {};
+}
+
+Status SpeculativeState::stageTakeDiscardPile(std::span<const Card> pileCards) {
+    if (pileCards.size() != current.deck.getDiscardPileSize())
+        return std::unexpected("The discard pile has " + std::to_string(current.deck.getDiscardPileSize()) + " cards");
+    if (pileCards.empty())
+        return std::unexpected("The discard pile is empty");
+    current.deck = ClientDeck(current.deck.getMainDeckSize(), std::nullopt, 0, false);
+    for (const auto& card : pileCards)
+        addToHand(card);
+    return {};
+}
+
+Status SpeculativeState::stageDiscard(const Card& card) {
+    if (current.hand[cardKindIndex(card)] == 0)
+        return std::unexpected("Card " + card.toString() + " is not in hand");
+    removeFromHand(card);
+    changes.push_back({Change::Type::HandRemoval, card});
+    ClientDeck& deck = current.deck;
+    bool freezes = deck.isFrozen() || card.getType() == CardType::Wild || card.getType() == CardType::BlackThree;
+    deck = ClientDeck(deck.getMainDeckSize(), card, deck.getDiscardPileSize() + 1, freezes);
+    return {};
+}
+
+void SpeculativeState::discard() {
+    current = base;
+    changes.clear();
+    proofs = {};
+}
+
+void SpeculativeState::commit(Hand& hand, TeamRoundState& teamRoundState) {
+    CANASTA_INVARIANT(&hand == baseHand && &teamRoundState == baseTeamRoundState, "A speculative state should be committed to the objects it was built from");
+
+    // Cards come into the hand before any leaves it, so every removal finds its card
+    for (const auto& change : changes) {
+        if (change.type == Change::Type::HandAddition)
+            hand.addCard(change.card);
+    }
+    // One initialization, then one addition per meld, in staging order; the counts were checked when staging.
+    // A rank with a proof had a single staged change, so the cards the proof checked are applied as they are;
+    // the meld checks the cards once more only when no proof came with them
+    auto applyMelds = [&](Change::Type type) {
+        const auto& typeProofs = type == Change::Type::MeldInitialization ? proofs.initializations : proofs.additions;
+        std::vector<Card> cards;
+        cards.reserve(changes.size());
+        for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+            Rank rank = static_cast<Rank>(rankInt);
+            BaseMeld* meld = teamRoundState.getMeldForRank(rank);
+            if (const auto& proof = typeProofs[rankMeldIndex(rank)]) {
+                if (type == Change::Type::MeldInitialization)
+                    meld->initialize(proof->getCards(), *proof);
+                else
+                    meld->addCards(proof->getCards(), *proof, /*reversible = */true);
+                continue;
+            }
+            cards.clear();
+            for (const auto& change : changes) {
+                if (change.type == type && change.rank == rank)
+                    cards.push_back(change.card);
+            }
+            if (cards.empty())
+                continue;
+            if (type == Change::Type::MeldInitialization)
+                meld->initialize(cards);
+            else
+                meld->addCards(cards, /*reversible = */true);
+        }
+    };
+    applyMelds(Change::Type::MeldInitialization);
+    applyMelds(Change::Type::MeldAddition);
+    if (proofs.blackThrees) {
+        teamRoundState.getBlackThreeMeld()->initialize(proofs.blackThrees->getCards(), *proofs.blackThrees);
+    } else {
+        std::vector<Card> blackThrees;
+        for (const auto& change : changes) {
+            if (change.type == Change::Type::BlackThreeMeld)
+                blackThrees.push_back(change.card);
+        }
+        if (!blackThrees.empty())
+            teamRoundState.getBlackThreeMeld()->initialize(blackThrees);
+    }
+    for (const auto& change : changes) {
+        if (change.type != Change::Type::HandAddition && !hand.removeCard(change.card))
+            throw std::logic_error("SpeculativeState: card " + change.card.toString() + " is no longer in hand");
+    }
+
+    base = current;
+    changes.clear();
+    proofs = {};
+}
+
+// --- Queries ---
+
+std::optional<CanastaType> SpeculativeState::canastaType(Rank rank) const {
+    const MeldCounts& meld = rankMeld(rank);
+    if (!meld.initialized || meld.naturals + meld.wilds < MIN_CANASTA_SIZE)
+        return std::nullopt;
+    return meld.wilds == 0 ? CanastaType::Natural : CanastaType::Mixed;
+}
+
+int SpeculativeState::meldPoints(Rank rank) const {
+    const MeldCounts& meld = rankMeld(rank);
+    return meld.cardPoints + (meld.initialized ? canastaBonus(meld.naturals, meld.wilds) : 0);
+}
+
+int SpeculativeState::totalMeldPoints() const {
+    int points = current.blackThreePoints;
+    for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt)
+        points += meldPoints(static_cast<Rank>(rankInt));
+    return points;
+}
+
+std::size_t SpeculativeState::canastaCount() const {
+    std::size_t count = 0;
+    for (const auto& meld : current.rankMelds)
+        count += meld.naturals + meld.wilds >= MIN_CANASTA_SIZE;
+    return count;
+}
+
+bool SpeculativeState::hasInitialRankMeld() const {
+    for (const auto& meld : current.rankMelds) {
+        if (meld.initialized)
+            return true;
+    }
+    return false;
+}
+
+bool SpeculativeState::canGoOut() const {
+    return current.handSize <= 1 && canastaCount() >= RuleEngine::MIN_CANASTAS_TO_GO_OUT;
+}
+
+// --- Helpers ---
+
+const SpeculativeState::MeldCounts& SpeculativeState::rankMeld(Rank rank) const {
+    CANASTA_INVARIANT(isRankMeldRank(rank), "Only the ranks Four to Ace have a rank meld");
+    return current.rankMelds[rankMeldIndex(rank)];
+}
+
+SpeculativeState::MeldCounts& SpeculativeState::rankMeld(Rank rank) {
+    CANASTA_INVARIANT(isRankMeldRank(rank), "Only the ranks Four to Ace have a rank meld");
+    return current.rankMelds[rankMeldIndex(rank)];
+}
+
+Status SpeculativeState::checkInHand(std::span<const Card> cards) const {
+    // Count the copies asked for against the copies in hand, without touching the counts
+    for (std::size_t i = 0; i < cards.size(); ++i) {
+        std::size_t kind = cardKindIndex(cards[i]);
+        std::size_t asked = 0;
+        for (std::size_t j = 0; j <= i; ++j)
+            asked += cardKindIndex(cards[j]) == kind;
+        if (asked > current.hand[kind])
+            return std::unexpected("Card " + cards[i].toString() + " not in hand");
+    }
+    return {};
+}
+
+Status SpeculativeState::checkRankCards(Rank rank, std::span<const Card> cards,
+    std::size_t naturals, std::size_t wilds) const {
+    // Same checks as Meld<R>::validateCards
+    for (const auto& card : cards) {
+        if (card.getType() == CardType::Wild)
+            ++wilds;
+        else if (card.getRank() == rank)
+            ++naturals;
+        else
+            return std::unexpected("Invalid card " + card.toString() + " for this meld");
+    }
+    if (wilds > naturals)
+        return std::unexpected("Too many wild cards for this meld");
+    return {};
+}
+
+bool SpeculativeState::acceptsProof(Rank rank, std::span<const Card> cards, const MeldProof& proof) const {
+    // A proof holds for the meld of the snapshot: once the rank has a staged change, the counts are checked again
+    if (!isRankMeldRank(rank) || (proofs.stagedRanks >> rankMeldIndex(rank) & 1))
+        return false;
+    const BaseMeld* meld = baseTeamRoundState->getMeldForRank(rank);
+    return meld && proof.holdsFor(*meld, cards);
+}
+
+void SpeculativeState::markStaged(Rank rank) {
+    std::size_t index = rankMeldIndex(rank);
+    proofs.stagedRanks |= static_cast<std::uint16_t>(1u << index);
+    proofs.initializations[index].reset();
+    proofs.additions[index].reset();
+}
+
+void SpeculativeState::stageRankCards(Rank rank, std::span<const Card> cards, Change::Type type) {
+    MeldCounts& meld = rankMeld(rank);
+    meld.initialized = true;
+    for (const auto& card : cards) {
+        ++(card.getType() == CardType::Wild ? meld.wilds : meld.naturals);
+        meld.cardPoints += card.getPoints();
+        removeFromHand(card);
+        changes.push_back({type, card, rank});
+    }
+}
+
+void SpeculativeState::removeFromHand(const Card& card) {
+    --current.hand[cardKindIndex(card)];
+    --current.handSize;
+}
+
+void SpeculativeState::addToHand(const Card& card) {
+    ++current.hand[cardKindIndex(card)];
+    ++current.handSize;
+    changes.push_back({Change::Type::HandAddition, card});
+}
@@ -0,0 +1,50 @@
+#include "team_melds_info.hpp"
+#include <string>
+
+namespace {
+    // Runs the rule checks of the meld, so a restored meld is as consistent as one built in play
+    Status initializeMeld(BaseMeld& meld, const std::vector<Card>& cards) {
+        auto proof = meld.checkInitialization(cards);
+        if (!proof)
+            return std::unexpected(proof.error());
+        meld.initialize(cards, *proof);
+        return {};
+    }
+}
+
+TeamMeldsInfo::TeamMeldsInfo(const TeamRoundState& teamState) {
+    const BaseMeld* redThreeMeld = teamState.getRedThreeMeld();
+    if (redThreeMeld->isInitialized())
+        redThreeCount = static_cast<std::uint8_t>(redThreeMeld->getNaturalCardsView().size());
+    const BaseMeld* blackThreeMeld = teamState.getBlackThreeMeld();
+    if (blackThreeMeld->isInitialized())
+        blackThreeCount = static_cast<std::uint8_t>(blackThreeMeld->getNaturalCardsView().size());
+    for (int rankInt = static_cast<int>(Rank::Four); rankInt <= static_cast<int>(Rank::Ace); ++rankInt) {
+        Rank rank = static_cast<Rank>(rankInt);
+        const BaseMeld* meld = teamState.getMeldForRank(rank);
+        if (meld->isInitialized())
+            rankMelds.emplace_back(rank, meld->getCards());
+    }
+}
+
+Status TeamMeldsInfo::restore(TeamRoundState& teamState) const {
+    teamState.reset();
+    if (redThreeCount > 0) {
+        std::vector<Card> redThrees(redThreeCount, Card(Rank::Three, CardColor::RED));
+        if (auto status = initializeMeld(*teamState.getRedThreeMeld(), redThrees); !status)
+            return std::unexpected("Red Three meld: " + status.error());
+    }
+    if (blackThreeCount > 0) {
+        std::vector<Card> blackThrees(blackThreeCount, Card(Rank::Three, CardColor::BLACK));
+        if (auto status = initializeMeld(*teamState.getBlackThreeMeld(), blackThrees); !status)
+            return std::unexpected("Black Three meld: " + status.error());
+    }
+    for (const auto& rankMeld : rankMelds) {
+        BaseMeld* meld = teamState.getMeldForRank(rankMeld.getRank());
+        if (!meld)
+            return std::unexpected("No meld for rank " + to_string(rankMeld.getRank()));
+        if (auto status = initializeMeld(*meld, rankMeld.getCards()); !status)
+            return std::unexpected("Meld of rank " + to_string(rankMeld.getRank()) + ": " + status.error());
+    }
+    return {};
+}
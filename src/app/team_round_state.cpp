@@ -175,6 +175,16 @@ const BaseMeld* TeamRoundState::getRedThreeMeld() const {
     return const_cast<TeamRoundState*>(this)->getRedThreeMeld();
 }
 
+// Combine the meld hashes; empty melds are skipped so they cost nothing
+std::uint64_t TeamRoundState::getHash() const {
+    std::uint64_t hash = 0;
+    for (std::size_t i = 0; i < melds.size(); ++i) {
+        if (melds[i] && melds[i]->getHash() != 0)
+            hash ^= zobristPlace(ZobristPlace::Meld, i, melds[i]->getHash());
+    }
+    return hash;
+}
+
 // Clone the TeamRoundState object
 TeamRoundState TeamRoundState::clone() const {
     TeamRoundState clone;
@@ -0,0 +1,111 @@
+// Connection churn benchmark for the server sessions.
+// Opens and closes connections against an in-process server, one after the other, and reports the
+// heap allocations and CPU time of the server's I/O thread per connection.
+// Usage: canasta_session_churn_bench [connections] [--login]
+// With --login every connection also sends a Login the server turns down, so decoding and replying are included.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include "server/sharded_server.hpp"
+
+namespace {
+    constexpr unsigned short BENCH_PORT = 23457;
+    constexpr int WARMUP_CONNECTIONS = 200;
+
+    // CPU time consumed by the given thread so far
+    std::chrono::nanoseconds threadCpuTime(pthread_t thread) {
+        clockid_t clock;
+        timespec time{};
+        if (pthread_getcpuclockid(thread, &clock) != 0 || clock_gettime(clock, &time) != 0)
+            return std::chrono::nanoseconds{0};
+        return std::chrono::seconds{time.tv_sec} + std::chrono::nanoseconds{time.tv_nsec};
+    }
+
+    // Allocations the I/O thread has made once it has handled everything queued before
+    std::uint64_t serverAllocations(asio::io_context& ioContext) {
+        std::promise<std::uint64_t> count;
+        asio::post(ioContext, [&count] { count.set_value(ServerProfiling::threadAllocationCount()); });
+        return count.get_future().get();
+    }
+
+    // Connects, optionally logs in with a name the server refuses, and closes once the server has answered
+    void churn(asio::io_context& clientContext, const asio::ip::tcp::endpoint& endpoint,
+        const std::vector<char>& login) {
+        asio::ip::tcp::socket socket(clientContext);
+        socket.connect(endpoint);
+        if (!login.empty()) {
+            asio::write(socket, asio::buffer(login));
+            char reply[64];
+            asio::error_code error;
+            socket.read_some(asio::buffer(reply), error); // The LoginFailure
+        }
+        socket.close();
+    }
+
+    // Waits until the server has released every session, so their teardown is measured too
+    void awaitSessionsReleased(const ShardedServer& server) {
+        for (int i = 0; i < 100 && server.getLiveSessionCount() > 0; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int connections = 20000;
+    bool withLogin = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--login")
+            withLogin = true;
+        else
+            connections = std::atoi(argv[i]);
+    }
+    if (connections <= 0) {
+        std::cerr << "Usage: canasta_session_churn_bench [connections] [--login]" << std::endl;
+        return 1;
+    }
+    spdlog::set_level(spdlog::level::off); // Every connection would log its start and end
+
+    asio::ip::tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), BENCH_PORT);
+    ShardedServer server(1, endpoint, 2, HostingMode::SingleGame);
+    asio::io_context& ioContext = server.getShard(0).getIoContext();
+    std::thread ioThread([&server] { server.run(); });
+
+    // An empty name is turned down without joining, so the server keeps running
+    std::vector<char> login;
+    if (withLogin)
+        login = serializeMessage(ClientMessageType::Login, NO_REQUEST_ID, std::string(), WireFormat::Compact);
+
+    asio::io_context clientContext;
+    for (int i = 0; i < WARMUP_CONNECTIONS; ++i)
+        churn(clientContext, endpoint, login);
+    awaitSessionsReleased(server);
+
+    std::uint64_t startAllocations = serverAllocations(ioContext);
+    auto startCpu = threadCpuTime(ioThread.native_handle());
+    auto startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < connections; ++i)
+        churn(clientContext, endpoint, login);
+    awaitSessionsReleased(server);
+    auto wallTime = std::chrono::steady_clock::now() - startTime;
+    auto cpuTime = threadCpuTime(ioThread.native_handle()) - startCpu;
+    std::uint64_t allocations = serverAllocations(ioContext) - startAllocations;
+
+    std::cout << connections << " connections" << (withLogin ? " with login" : "") << ": "
+              << static_cast<double>(allocations) / connections << " server allocations/connection, "
+              << std::chrono::duration<double, std::micro>(cpuTime).count() / connections
+              << " us server CPU/connection, "
+              << std::chrono::duration<double, std::micro>(wallTime).count() / connections
+              << " us wall/connection" << std::endl;
+
+    server.stop();
+    ioThread.join();
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Shard scaling benchmark for the server.
+// Runs an in-process server hosting tables on 1, 2, ... shards and, for each shard count, as many
+// load generator threads playing bots against it. Every bot logs in, waits for its game to start
+// and then keeps a window of Revert requests in flight, each answered by the server's game logic
+// (a state update or an error). Reports the requests answered per second for each shard count.
+// Usage: canasta_shard_scaling_bench [max shards] [--tables=N] [--seconds=S] [--window=W]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "server/sharded_server.hpp"
+
+namespace {
+    constexpr unsigned short BENCH_PORT = 23458;
+    constexpr std::size_t PLAYERS_PER_TABLE = 2;
+
+    struct BenchOptions {
+        std::size_t maxShards = std::max(1u, std::thread::hardware_concurrency() / 2);
+        std::size_t tables = 64;
+        int seconds = 5;
+        std::size_t window = 4; ///< Requests each bot keeps in flight
+    };
+
+    // Counters shared by the bots of every generator thread
+    struct BenchCounters {
+        std::atomic<std::size_t> playing{0};    ///< Bots whose game has started
+        std::atomic<std::size_t> failed{0};     ///< Bots turned down or disconnected
+        std::atomic<std::uint64_t> answered{0}; ///< Replies to the bots' own requests
+    };
+
+    // Logs in as the given player, then keeps window Revert requests in flight until disconnected
+    asio::awaitable<void> playBot(asio::ip::tcp::endpoint endpoint, std::string playerName,
+        std::size_t window, BenchCounters& counters) {
+        asio::ip::tcp::socket socket(co_await asio::this_coro::executor);
+        asio::error_code error;
+        co_await socket.async_connect(endpoint, asio::redirect_error(asio::use_awaitable, error));
+        if (error) {
+            ++counters.failed;
+            co_return;
+        }
+        socket.set_option(asio::ip::tcp::no_delay(true));
+        auto login = serializeMessage(ClientMessageType::Login, NO_REQUEST_ID, playerName, WireFormat::Compact);
+        co_await asio::async_write(socket, asio::buffer(login), asio::redirect_error(asio::use_awaitable, error));
+
+        WireFormat format = WireFormat::Binary; // Until the LoginSuccess
+        bool started = false;
+        RequestId nextRequestId = NO_REQUEST_ID;
+        std::size_t owed = 0; // Requests to send to refill the window
+        std::vector<char> requests;
+        FrameReader reader;
+        while (!error) {
+            std::size_t bytesRead = co_await socket.async_read_some(reader.prepare(),
+                asio::redirect_error(asio::use_awaitable, error));
+            if (error)
+                break;
+            reader.commit(bytesRead);
+            std::uint64_t repliesRead = 0;
+            while (auto frame = reader.next()) {
+                FrameStreamBuffer frameBuffer(*frame);
+                std::istream is(&frameBuffer);
+                decodeMessage(format, is, [&](auto& archive) {
+                    ServerMessageType msgType;
+                    archive(msgType);
+                    switch (msgType) {
+                        case ServerMessageType::LoginSuccess:
+                            if (hasMoreFields(is))
+                                archive(format);
+                            break;
+                        case ServerMessageType::LoginFailure:
+                            error = asio::error::connection_refused;
+                            break;
+                        case ServerMessageType::GameStateUpdate: {
+                            ClientGameState gameState;
+                            archive(gameState);
+                            if (!started) {
+                                started = true;
+                                owed = window;
+                                ++counters.playing;
+                            } else if (gameState.getRequestId() != NO_REQUEST_ID) {
+                                ++repliesRead; // Other players' actions are broadcast without our id
+                            }
+                            break;
+                        }
+                        case ServerMessageType::ActionError:
+                            ++repliesRead;
+                            break;
+                    }
+                });
+            }
+            if (error)
+                break;
+            counters.answered.fetch_add(repliesRead, std::memory_order_relaxed);
+            owed += repliesRead;
+            if (owed == 0)
+                continue;
+            // The refills of a whole read go out in one write
+            requests.clear();
+            for (; owed > 0; --owed) {
+                auto request = serializeMessage(format, ClientMessageType::Revert, ++nextRequestId);
+                requests.insert(requests.end(), request.begin(), request.end());
+            }
+            co_await asio::async_write(socket, asio::buffer(requests), asio::redirect_error(asio::use_awaitable, error));
+        }
+        if (!started)
+            ++counters.failed;
+    }
+
+    // Requests answered per second by a server of the given number of shards
+    double measure(std::size_t shardCount, const BenchOptions& options) {
+        asio::ip::tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), BENCH_PORT);
+        ShardedServer server(shardCount, endpoint, PLAYERS_PER_TABLE, HostingMode::Tables);
+        server.setActionRateLimit(0, DEFAULT_ACTION_BURST); // The bots go as fast as they are answered
+        std::thread serverThread([&server] { server.run(); });
+
+        // One generator thread per shard, each running a share of the bots
+        BenchCounters counters;
+        std::size_t botCount = options.tables * PLAYERS_PER_TABLE;
+        std::vector<std::unique_ptr<asio::io_context>> generators;
+        for (std::size_t i = 0; i < shardCount; ++i)
+            generators.push_back(std::make_unique<asio::io_context>(1));
+        for (std::size_t bot = 0; bot < botCount; ++bot)
+            asio::co_spawn(*generators[bot % shardCount],
+                playBot(endpoint, "bot" + std::to_string(bot), options.window, counters), asio::detached);
+        std::vector<std::thread> generatorThreads;
+        for (auto& generator : generators)
+            generatorThreads.emplace_back([&generator] { generator->run(); });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (counters.playing + counters.failed < botCount && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        double rate = 0;
+        if (counters.failed > 0 || counters.playing < botCount) {
+            std::cerr << shardCount << " shards: only " << counters.playing << " of " << botCount
+                      << " bots got to play" << std::endl;
+        } else {
+            std::uint64_t startAnswered = counters.answered.load();
+            auto startTime = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+            std::uint64_t answered = counters.answered.load() - startAnswered;
+            rate = answered / std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        }
+
+        for (auto& generator : generators)
+            generator->stop();
+        for (auto& thread : generatorThreads)
+            thread.join();
+        generators.clear(); // Closes the bots' sockets
+        server.stop();
+        serverThread.join();
+        return rate;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.starts_with("--tables="))
+            options.tables = static_cast<std::size_t>(std::max(1, std::atoi(arg.c_str() + 9)));
+        else if (arg.starts_with("--seconds="))
+            options.seconds = std::max(1, std::atoi(arg.c_str() + 10));
+        else if (arg.starts_with("--window="))
+            options.window = static_cast<std::size_t>(std::max(1, std::atoi(arg.c_str() + 9)));
+        else if (std::atoi(argv[i]) > 0)
+            options.maxShards = static_cast<std::size_t>(std::atoi(argv[i]));
+        else {
+            std::cerr << "Usage: canasta_shard_scaling_bench [max shards] [--tables=N] [--seconds=S] [--window=W]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    spdlog::set_level(spdlog::level::off); // Every login and request would be logged
+
+    std::cout << "Cores: " << std::thread::hardware_concurrency() << ", tables: " << options.tables
+              << ", window: " << options.window << std::endl;
+    double baseline = 0;
+    for (std::size_t shards = 1; shards <= options.maxShards; ++shards) {
+        double rate = measure(shards, options);
+        if (shards == 1)
+            baseline = rate;
+        std::cout << shards << " shards: " << static_cast<std::uint64_t>(rate) << " requests/s";
+        if (baseline > 0)
+            std::cout << " (x" << rate / baseline << ")";
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+// libFuzzer target for the decoding of client frames.
+// Mirrors Session::processMessage: a frame body is the message type, the request id and a payload.
+// The first input byte picks the wire format the session agreed on, so both input archives are covered.
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include <vector>
+#include "network.hpp"
+#include "bounded_serialization.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    if (size < 1 || size - 1 > MAX_MESSAGE_SIZE)
+        return -1; // Rejected by the header check before decoding
+    WireFormat format = data[0] % 2 ? WireFormat::Compact : WireFormat::Binary;
+    try {
+        // Decoded in place like the frames of the session's FrameReader, so reads past the end are caught
+        FrameStreamBuffer frameBuffer(std::span<const char>(reinterpret_cast<const char*>(data + 1), size - 1));
+        std::istream is(&frameBuffer);
+        decodeMessage(format, is, [&](auto& archive) {
+            ClientMessageType msgType;
+            RequestId requestId = NO_REQUEST_ID;
+            archive(msgType, requestId);
+            switch (msgType) {
+                case ClientMessageType::Login: {
+                    std::string name;
+                    loadBoundedString(archive, name, MAX_DECODED_STRING_SIZE);
+                    WireFormat requestedFormat = WireFormat::Binary;
+                    if (hasMoreFields(is))
+                        archive(requestedFormat);
+                    break;
+                }
+                case ClientMessageType::Meld: {
+                    std::vector<MeldRequest> requests;
+                    loadBoundedVector(archive, requests, MAX_DECODED_MELD_REQUESTS);
+                    for (const auto& request : requests) {
+                        for (const auto& card : request.getCards())
+                            (void)card.toString(); // Decoded cards must be safe to use
+                    }
+                    break;
+                }
+                case ClientMessageType::Discard: {
+                    Card card;
+                    archive(card);
+                    (void)card.toString();
+                    break;
+                }
+                default:
+                    break;
+            }
+        });
+    } catch (const cereal::Exception&) {
+        // Malformed frames are rejected, which is the expected outcome
+    }
+    return 0;
+}
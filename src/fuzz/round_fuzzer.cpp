@@ -0,0 +1,103 @@
+// libFuzzer target driving a RoundManager with action sequences read from the input.
+// The input starts with the deck seed, then every byte picks an action for the current player;
+// meld and discard actions take their cards from the following bytes. The rule checks must reject invalid actions without crashing,
+// and the Zobrist hashes kept up to date by hands and melds must match the ones computed from scratch after every action.
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "player.hpp"
+#include "team.hpp"
+#include "server/round_manager.hpp"
+
+namespace {
+    // Reads the input a byte at a time, then zeros once it is exhausted
+    class ByteReader {
+    public:
+        ByteReader(const std::uint8_t* data, std::size_t size) : data(data), size(size) {}
+        bool empty() const { return position >= size; }
+        std::uint8_t next() { return position < size ? data[position++] : 0; }
+
+    private:
+        const std::uint8_t* data;
+        std::size_t size;
+        std::size_t position = 0;
+    };
+
+    // Either a card of the current hand or, rarely, any card, so missing cards are exercised too
+    Card pickCard(ByteReader& reader, const Hand& hand) {
+        std::uint8_t selector = reader.next();
+        const auto& cards = hand.getCards();
+        if (cards.empty() || selector >= 240) {
+            auto rank = static_cast<Rank>(selector % CARD_COUNT + 1);
+            return Card(rank, selector % 2 == 0 ? CardColor::RED : CardColor::BLACK);
+        }
+        return cards[selector % cards.size()];
+    }
+
+    std::vector<MeldRequest> pickMeldRequests(ByteReader& reader, const Hand& hand) {
+        std::vector<MeldRequest> requests(reader.next() % 4 + 1);
+        for (auto& request : requests) {
+            std::vector<Card> cards(reader.next() % 8 + 1);
+            for (auto& card : cards)
+                card = pickCard(reader, hand);
+            std::uint8_t rankSelector = reader.next();
+            std::optional<Rank> rank;
+            if (rankSelector % 2 == 1)
+                rank = static_cast<Rank>(rankSelector / 2 % CARD_COUNT + 1);
+            request = MeldRequest(cards, rank);
+        }
+        return requests;
+    }
+
+    void checkHashes(const std::vector<Player>& players, const RoundManager& roundManager,
+        const Team& team1, const Team& team2) {
+        for (const auto& player : players) {
+            const Hand& hand = player.getHand();
+            if (hand.getHash() != CardMultisetHash(hand.getCards()).value())
+                std::abort();
+        }
+        for (const Team* team : {&team1, &team2}) {
+            TeamRoundState teamState = roundManager.getTeamStateForTeam(*team);
+            for (const auto& meld : teamState.getMelds()) {
+                if (meld->getHash() != CardMultisetHash(meld->getCards()).value())
+                    std::abort();
+            }
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    spdlog::set_level(spdlog::level::off);
+    std::vector<Player> players = {Player("P1"), Player("P2")};
+    Team team1("Team 1");
+    Team team2("Team 2");
+    team1.addPlayer(players[0]);
+    team2.addPlayer(players[1]);
+    std::vector<std::reference_wrapper<Player>> playerRefs(players.begin(), players.end());
+
+    // The first bytes seed the deck, so every input replays the same round
+    ByteReader reader(data, size);
+    std::uint32_t deckSeed = 0;
+    for (int i = 0; i < 4; ++i)
+        deckSeed = deckSeed << 8 | reader.next();
+    RoundManager roundManager(playerRefs, std::cref(team1), std::cref(team2), deckSeed);
+    roundManager.startRound();
+
+    while (!reader.empty() && !roundManager.isRoundOver()) {
+        Hand& hand = roundManager.getCurrentPlayer().getHand();
+        switch (reader.next() % 5) {
+            case 0: roundManager.handleDrawDeckRequest(); break;
+            case 1: roundManager.handleTakeDiscardPileRequest(); break;
+            case 2: roundManager.handleMeldRequest(pickMeldRequests(reader, hand)); break;
+            case 3: roundManager.handleDiscardRequest(pickCard(reader, hand)); break;
+            default: roundManager.handleRevertRequest(); break;
+        }
+        checkHashes(players, roundManager, team1, team2);
+    }
+    if (roundManager.isRoundOver())
+        roundManager.calculateScores();
+    return 0;
+}
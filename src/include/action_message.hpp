@@ -0,0 +1,168 @@
+#ifndef ACTION_MESSAGE_HPP
+#define ACTION_MESSAGE_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "cereal/cereal.hpp"
+#include "cereal/archives/binary.hpp"
+#include <cereal/types/string.hpp>
+#include "card.hpp"
+#include "bounded_serialization.hpp"
+
+/**
+ * @enum ActionMessageCode
+ * @brief Enum naming what happened to an action, sent instead of the text describing it.
+ * @details The text is rendered by ActionMessage::toString, on the side that shows it.
+ * New codes go at the end, so the codes of older peers keep their meaning.
+ */
+enum class ActionMessageCode : std::uint8_t {
+    None,                          ///< No action (default constructed)
+    // Successes, broadcast to every player
+    GameStarted,
+    NewRoundStarted,
+    CardDrawn,
+    DiscardPileTaken,
+    MeldsProcessed,
+    WentOut,
+    TurnOver,
+    TurnReverted,
+    // Errors, sent to the player who acted
+    RoundNotActive,
+    NotYourTurn,
+    TooManyRequests,
+    RoundNotInProgress,
+    AlreadyDrewFromDeck,
+    DrawAfterTakingPile,
+    TakePileAfterDrawing,
+    AlreadyTookPile,
+    MainDeckEmpty,
+    MainDeckEmptyPileCantBeTaken,
+    MeldBeforeDrawing,
+    MeldsAlreadyHandled,
+    NoMeldRequest,
+    MeldCardNotInHand,             ///< Card argument
+    BlackThreesBeforeThreshold,
+    SecondBlackThreeMeld,
+    NoInitialMeld,
+    InitialMeldPointsNotMet,       ///< Number argument: the points required
+    BlackThreeMeldWithoutGoingOut,
+    AddWithoutInitialMelds,
+    CommitmentMeldMissing,         ///< Rank argument
+    CommitmentMeldTooSmall,        ///< Rank and number arguments: the cards required
+    CommitmentCardNotAdded,        ///< Rank argument
+    CommitmentAdditionTooSmall,    ///< Rank and number arguments: the cards required
+    CannotGoOut,
+    DiscardBeforeDrawing,
+    DiscardNotInHand,
+    DiscardBeforeMelding,
+    GoingOutRequirementsNotMet,
+    NothingToRevert,
+    RuleViolation,                 ///< Detail argument: the text of a rule check (meld, discard pile)
+};
+
+/**
+ * @class ActionMessage
+ * @brief Class describing the outcome of an action as a code and its typed arguments.
+ * @details Only the arguments the code uses are sent, so most messages take a single byte.
+ */
+class ActionMessage {
+private:
+    ActionMessageCode code = ActionMessageCode::None;
+    Rank rank = Rank::Joker;   ///< Rank argument, when the code has one
+    std::int32_t number = 0;   ///< Count or points argument, when the code has one
+    std::optional<Card> card;  ///< Card argument, when the code has one
+    std::string detail;        ///< Text of a rule check, for RuleViolation only
+
+    /// Arguments a code carries, as a bitmask
+    enum Argument : std::uint8_t {
+        RankArgument = 1,
+        NumberArgument = 2,
+        CardArgument = 4,
+        DetailArgument = 8,
+    };
+    static constexpr std::uint8_t argumentsOf(ActionMessageCode code) {
+        switch (code) {
+            case ActionMessageCode::MeldCardNotInHand: return CardArgument;
+            case ActionMessageCode::InitialMeldPointsNotMet: return NumberArgument;
+            case ActionMessageCode::CommitmentMeldMissing:
+            case ActionMessageCode::CommitmentCardNotAdded: return RankArgument;
+            case ActionMessageCode::CommitmentMeldTooSmall:
+            case ActionMessageCode::CommitmentAdditionTooSmall: return RankArgument | NumberArgument;
+            case ActionMessageCode::RuleViolation: return DetailArgument;
+            default: return 0;
+        }
+    }
+public:
+    /**
+     * @brief Default constructor for ActionMessage only for serialization purposes.
+     */
+    ActionMessage() = default;
+    ActionMessage(ActionMessageCode code) : code(code) {}
+    ActionMessage(ActionMessageCode code, std::int32_t number) : code(code), number(number) {}
+    ActionMessage(ActionMessageCode code, Rank rank, std::int32_t number = 0)
+        : code(code), rank(rank), number(number) {}
+    ActionMessage(ActionMessageCode code, const Card& card) : code(code), card(card) {}
+    /**
+     * @brief Message carrying the text of a failed rule check.
+     */
+    explicit ActionMessage(std::string ruleViolation)
+        : code(ActionMessageCode::RuleViolation), detail(std::move(ruleViolation)) {}
+
+    ActionMessageCode getCode() const { return code; }
+    Rank getRank() const { return rank; }
+    std::int32_t getNumber() const { return number; }
+    const std::optional<Card>& getCard() const { return card; }
+    const std::string& getDetail() const { return detail; }
+
+    /**
+     * @brief Render the message as English text.
+     */
+    std::string toString() const;
+
+    template <class Archive>
+    void save(Archive& ar) const {
+        ar(CEREAL_NVP(code));
+        std::uint8_t arguments = argumentsOf(code);
+        if (arguments & RankArgument) {
+            auto rankValue = static_cast<std::uint8_t>(rank); // Ranks fit in a byte
+            ar(CEREAL_NVP(rankValue));
+        }
+        if (arguments & NumberArgument)
+            ar(CEREAL_NVP(number));
+        if (arguments & CardArgument) {
+            Card cardValue = card.value_or(Card(Rank::Joker, CardColor::RED));
+            ar(CEREAL_NVP(cardValue));
+        }
+        if (arguments & DetailArgument)
+            ar(CEREAL_NVP(detail));
+    }
+    /**
+     * @throws cereal::Exception if the code or an argument is out of range.
+     */
+    template <class Archive>
+    void load(Archive& ar) {
+        ar(CEREAL_NVP(code));
+        if (code > ActionMessageCode::RuleViolation)
+            throw cereal::Exception("Invalid action message code");
+        std::uint8_t arguments = argumentsOf(code);
+        if (arguments & RankArgument) {
+            std::uint8_t rankValue = 0;
+            ar(CEREAL_NVP(rankValue));
+            rank = static_cast<Rank>(rankValue);
+            if (!isValidRank(rank))
+                throw cereal::Exception("Invalid action message rank");
+        }
+        if (arguments & NumberArgument)
+            ar(CEREAL_NVP(number));
+        if (arguments & CardArgument) {
+            Card cardValue;
+            ar(CEREAL_NVP(cardValue));
+            card = cardValue;
+        }
+        if (arguments & DetailArgument)
+            loadBoundedString(ar, detail, MAX_DECODED_STRING_SIZE);
+    }
+};
+
+#endif // ACTION_MESSAGE_HPP
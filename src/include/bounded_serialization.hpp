@@ -0,0 +1,48 @@
+#ifndef BOUNDED_SERIALIZATION_HPP
+#define BOUNDED_SERIALIZATION_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <cereal/cereal.hpp>
+
+// Largest containers a peer may send; anything bigger is rejected before memory is reserved
+constexpr std::size_t MAX_DECODED_CARDS = 108;         ///< Cards in one container: the whole deck
+constexpr std::size_t MAX_DECODED_MELD_REQUESTS = 16;  ///< Meld requests in one message: one per meld
+constexpr std::size_t MAX_DECODED_STRING_SIZE = 256;   ///< Characters in one string (player names, messages)
+constexpr std::size_t MAX_DECODED_RANK_MELDS = 11;     ///< Rank melds of one team: Four to Ace
+
+/**
+ * @brief Load a vector saved by cereal, refusing more than maxSize elements.
+ * @details Same wire format as cereal's own vector load, which resizes to whatever size it reads,
+ * so a few forged bytes could make it allocate gigabytes.
+ * @throws cereal::Exception if the stored size exceeds maxSize.
+ */
+template <class Archive, class T>
+void loadBoundedVector(Archive& archive, std::vector<T>& values, std::size_t maxSize) {
+    cereal::size_type size = 0;
+    archive(cereal::make_size_tag(size));
+    if (size > maxSize)
+        throw cereal::Exception("Container of " + std::to_string(size) +
+            " elements exceeds the limit of " + std::to_string(maxSize));
+    values.resize(static_cast<std::size_t>(size));
+    for (auto& value : values)
+        archive(value);
+}
+
+/**
+ * @brief Load a string saved by cereal, refusing more than maxSize characters.
+ * @throws cereal::Exception if the stored size exceeds maxSize.
+ */
+template <class Archive>
+void loadBoundedString(Archive& archive, std::string& value, std::size_t maxSize) {
+    cereal::size_type size = 0;
+    archive(cereal::make_size_tag(size));
+    if (size > maxSize)
+        throw cereal::Exception("String of " + std::to_string(size) +
+            " characters exceeds the limit of " + std::to_string(maxSize));
+    value.resize(static_cast<std::size_t>(size));
+    archive(cereal::binary_data(value.data(), value.size()));
+}
+
+#endif // BOUNDED_SERIALIZATION_HPP
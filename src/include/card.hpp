@@ -5,6 +5,7 @@
 
 #include <string>
 #include <array>
+#include <cstddef>
 #include <cereal/types/string.hpp>  // For serialization
 
 
@@ -53,6 +54,13 @@ enum class Rank {
     Eight, Nine, Ten, Jack, Queen, King, Ace
 };
 
+/**
+ * @brief Check whether a rank read from the network is one of the enumerators.
+ */
+constexpr bool isValidRank(Rank rank) {
+    return rank >= Rank::Joker && rank <= Rank::Ace;
+}
+
 // Overload std::to_string for Rank
 inline std::string to_string(Rank rank) {
     return rankNames[static_cast<int>(rank) - 1];
@@ -127,11 +135,25 @@ public:
     bool operator>=(const Card& other) const;
 
     /**
-     * @brief Serialize the Card object using Cereal.
+     * @brief Save the Card object using Cereal.
+     */
+    template <class Archive>
+    void save(Archive& archive) const {
+        archive(CEREAL_NVP(rank), CEREAL_NVP(color), CEREAL_NVP(type), CEREAL_NVP(points));
+    }
+
+    /**
+     * @brief Load the Card object using Cereal.
+     * @details The type and points sent by the peer are not trusted and are derived from the rank and color.
+     * @throws cereal::Exception if the rank or the color is out of range.
      */
     template <class Archive>
-    void serialize(Archive& archive) {
+    void load(Archive& archive) {
         archive(CEREAL_NVP(rank), CEREAL_NVP(color), CEREAL_NVP(type), CEREAL_NVP(points));
+        if (!isValidRank(rank) || (color != CardColor::RED && color != CardColor::BLACK))
+            throw cereal::Exception("Invalid card");
+        type = determineCardType(rank, color);
+        points = calculatePoints(rank, type);
     }
 
 private:
@@ -148,4 +170,20 @@ private:
     static int calculatePoints(Rank rank, CardType type);
 };
 
+/**
+ * @brief Number of distinct cards: every rank in both colors.
+ */
+constexpr std::size_t CARD_KIND_COUNT = CARD_COUNT * CARD_COLOR_COUNT;
+
+/**
+ * @brief Index of a card among the CARD_KIND_COUNT distinct cards, for counting cards by rank and color.
+ */
+constexpr std::size_t cardKindIndex(Rank rank, CardColor color) {
+    return (static_cast<std::size_t>(rank) - 1) * CARD_COLOR_COUNT + static_cast<std::size_t>(color);
+}
+
+inline std::size_t cardKindIndex(const Card& card) {
+    return cardKindIndex(card.getRank(), card.getColor());
+}
+
 #endif //CARD_HPP
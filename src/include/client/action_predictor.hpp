@@ -0,0 +1,51 @@
+#ifndef ACTION_PREDICTOR_HPP
+#define ACTION_PREDICTOR_HPP
+
+#include <vector>
+#include <string>
+#include <expected>
+#include "card.hpp"
+#include "hand.hpp"
+#include "meld.hpp"
+#include "client_deck.hpp"
+#include "team_round_state.hpp"
+#include "rule_engine.hpp"
+
+/**
+ * @class ActionPredictor
+ * @brief Applies draw-independent actions to a local copy of the player's state.
+ * @details Runs the same RuleEngine checks as the server's TurnManager, so the client can show
+ * the outcome of a meld or a discard before the server confirms it. The only rule not checked
+ * locally is the discard pile commitment, which the client does not know, so a meld accepted
+ * here may still be rejected by the server; a rejection here is always final.
+ */
+class ActionPredictor {
+public:
+    ActionPredictor() = delete;   ///< no instances of ActionPredictor
+    ~ActionPredictor() = delete;  ///< no instances of ActionPredictor
+
+    /**
+     * @brief Apply meld requests to the given hand and team state.
+     * @param meldRequests The meld requests as they will be sent to the server.
+     * @param hand The player's hand, updated in place.
+     * @param teamRoundState The state of the player's team, updated in place.
+     * @param teamTotalScore Total score of the player's team, for the initial meld threshold.
+     * @return Whether the melds take the player out, or the error message the server would send.
+     * On error the hand and team state are left partially updated and must be discarded.
+     */
+    static std::expected<bool, std::string> applyMelds(const std::vector<MeldRequest>& meldRequests,
+        Hand& hand, TeamRoundState& teamRoundState, int teamTotalScore);
+
+    /**
+     * @brief Apply a discard to the given hand and deck view.
+     * @param cardToDiscard The card to discard.
+     * @param hand The player's hand, updated in place.
+     * @param deck The deck view, updated in place.
+     * @param teamRoundState The state of the player's team, to check going out.
+     * @return Whether the discard takes the player out, or the error message the server would send.
+     */
+    static std::expected<bool, std::string> applyDiscard(const Card& cardToDiscard,
+        Hand& hand, ClientDeck& deck, const TeamRoundState& teamRoundState);
+};
+
+#endif // ACTION_PREDICTOR_HPP
@@ -0,0 +1,180 @@
+#ifndef BOARD_STATE_HPP
+#define BOARD_STATE_HPP
+
+#include <deque>
+#include <vector>
+#include <optional>
+#include <span>
+#include <cstdint>
+#include <algorithm>
+#include "card.hpp"
+#include "hand.hpp"
+#include "score_details.hpp"
+#include "game_state.hpp"
+#include "player_public_info.hpp"
+#include "client_deck.hpp"
+#include "team_round_state.hpp"
+
+/**
+ * @class MeldView
+ * @brief Class representing a meld view for display purposes.
+ * @details The view references the cards of a meld owned by a TeamRoundState instead of copying
+ * them, so it is only valid while that state is alive. Wild cards come first, then naturals.
+ */
+class MeldView {
+private:
+    Rank rank = Rank::Three;
+    std::span<const Card> wildCards;
+    std::span<const Card> naturalCards;
+    bool isInitializedFlag = false;
+public:
+    MeldView() = default;
+    MeldView(Rank rank, std::span<const Card> wildCards, std::span<const Card> naturalCards, bool isInitialized)
+        : rank(rank), wildCards(wildCards), naturalCards(naturalCards), isInitializedFlag(isInitialized) {}
+
+    Rank getRank() const { return rank; }
+    bool isInitialized() const { return isInitializedFlag; }
+    std::span<const Card> getWildCards() const { return wildCards; }
+    std::span<const Card> getNaturalCards() const { return naturalCards; }
+    std::size_t size() const { return wildCards.size() + naturalCards.size(); }
+    /**
+     * @brief Get the card at the given position, wild cards first.
+     */
+    const Card& operator[](std::size_t index) const {
+        return index < wildCards.size() ? wildCards[index] : naturalCards[index - wildCards.size()];
+    }
+    const Card& front() const { return (*this)[0]; }
+    const Card& back() const { return (*this)[size() - 1]; }
+
+    /**
+     * @brief Compare the shown content, not the storage the views point to.
+     */
+    bool operator==(const MeldView& other) const {
+        return rank == other.rank && isInitializedFlag == other.isInitializedFlag &&
+            std::ranges::equal(wildCards, other.wildCards) &&
+            std::ranges::equal(naturalCards, other.naturalCards);
+    }
+};
+
+/**
+ * @class BoardState
+ * @brief Class representing the game board state for display purposes.
+ * @details The board is patched in place on every update. Melds and the hand reference the storage
+ * of the caller's ClientGameState; each of them carries a revision that changes only when its
+ * content does, so renderers can cache what they built from it.
+ */
+class BoardState {
+private:
+    std::vector<MeldView> myTeamMelds;
+    std::vector<MeldView> opponentTeamMelds;
+    const Hand* myHand = nullptr;
+    std::deque<Card> myHandCards; ///< Cards last shown; the Hand may be overwritten in place by the next state
+    ClientDeck deckState;
+    PlayerPublicInfo myPlayer;
+    PlayerPublicInfo oppositePlayer;
+    std::optional<PlayerPublicInfo> leftPlayer;
+    std::optional<PlayerPublicInfo> rightPlayer;
+    int myTeamTotalScore = 0;
+    int opponentTeamTotalScore = 0;
+    int myTeamMeldPoints = 0;
+    int opponentTeamMeldPoints = 0;
+
+    std::uint64_t myTeamMeldsRevision = 0;
+    std::uint64_t opponentTeamMeldsRevision = 0;
+    std::uint64_t myHandRevision = 0;
+
+    static constexpr int RANK_MELD_OFFSET = 2; // Offset for rank melds (Four to Ace)
+
+    /**
+     * @brief Point the views at the melds of the team state.
+     * @return True if the shown content changed.
+     */
+    static bool updateMeldViews(std::vector<MeldView>& views, const TeamRoundState& teamState);
+    /**
+     * @brief Get a revision number never handed out before.
+     */
+    static std::uint64_t nextRevision();
+public:
+
+    // Getters
+    const std::vector<MeldView>& getMyTeamMelds() const { return myTeamMelds; }
+    const std::vector<MeldView>& getOpponentTeamMelds() const { return opponentTeamMelds; }
+    const Hand& getMyHand() const;
+    const ClientDeck& getDeckState() const { return deckState; }
+    const PlayerPublicInfo& getMyPlayer() const { return myPlayer; }
+    const PlayerPublicInfo& getOppositePlayer() const { return oppositePlayer; }
+    const std::optional<PlayerPublicInfo>& getLeftPlayer() const { return leftPlayer; }
+    const std::optional<PlayerPublicInfo>& getRightPlayer() const { return rightPlayer; }
+    int getMyTeamTotalScore() const { return myTeamTotalScore; }
+    int getOpponentTeamTotalScore() const { return opponentTeamTotalScore; }
+    int getMyTeamMeldPoints() const { return myTeamMeldPoints; }
+    int getOpponentTeamMeldPoints() const { return opponentTeamMeldPoints; }
+    std::uint64_t getMyTeamMeldsRevision() const { return myTeamMeldsRevision; }
+    std::uint64_t getOpponentTeamMeldsRevision() const { return opponentTeamMeldsRevision; }
+    std::uint64_t getMyHandRevision() const { return myHandRevision; }
+
+    // Setters
+    /**
+     * @brief Point the player's team melds at the given team state.
+     * @details The state previously set must still be alive: it is compared with the new one
+     * to decide whether the revision changes.
+     */
+    void setMyTeamMelds(const TeamRoundState& teamState);
+    /**
+     * @brief Point the opponent team melds at the given team state.
+     * @details The state previously set must still be alive (see setMyTeamMelds).
+     */
+    void setOpponentTeamMelds(const TeamRoundState& teamState);
+    /**
+     * @brief Point the player's hand at the given hand.
+     * @details The hand previously set must still be alive (see setMyTeamMelds).
+     */
+    void setMyHand(const Hand& hand);
+    void setDeckState(const ClientDeck& deck) { deckState = deck; }
+    void setMyPlayer(const PlayerPublicInfo& player) { myPlayer = player; }
+    void setOppositePlayer(const PlayerPublicInfo& player) { oppositePlayer = player; }
+    void setLeftPlayer(const PlayerPublicInfo& player) { leftPlayer = player; }
+    void setRightPlayer(const PlayerPublicInfo& player) { rightPlayer = player; }
+    void setMyTeamTotalScore(int score) { myTeamTotalScore = score; }
+    void setOpponentTeamTotalScore(int score) { opponentTeamTotalScore = score; }
+    void setMyTeamMeldPoints(int points) { myTeamMeldPoints = points; }
+    void setOpponentTeamMeldPoints(int points) { opponentTeamMeldPoints = points; }
+
+    static std::optional<std::size_t> getMeldIndexForRank(Rank rank);
+};
+
+/**
+ * @class ScoreState
+ * @brief Class representing the score state for display purposes.
+ */
+class ScoreState {
+private:
+    ScoreBreakdown myTeamScoreBreakdown;
+    ScoreBreakdown opponentTeamScoreBreakdown;
+    std::size_t playersCount;
+    int myTeamTotalScore;
+    int opponentTeamTotalScore;
+    bool isGameOver;
+    std::optional<ClientGameOutcome> gameOutcome;
+public:
+
+    // Getters
+    ScoreBreakdown getMyTeamScoreBreakdown() const { return myTeamScoreBreakdown; }
+    ScoreBreakdown getOpponentTeamScoreBreakdown() const { return opponentTeamScoreBreakdown; }
+    std::size_t getPlayersCount() const { return playersCount; }
+    int getMyTeamTotalScore() const { return myTeamTotalScore; }
+    int getOpponentTeamTotalScore() const { return opponentTeamTotalScore; }
+    bool getIsGameOver() const { return isGameOver; }
+    std::optional<ClientGameOutcome> getGameOutcome() const { return gameOutcome; }
+
+    // Setters
+    void setMyTeamScoreBreakdown(const ScoreBreakdown& breakdown) { myTeamScoreBreakdown = breakdown; }
+    void setOpponentTeamScoreBreakdown(const ScoreBreakdown& breakdown) { opponentTeamScoreBreakdown = breakdown; }
+    void setPlayersCount(std::size_t count) { playersCount = count; }
+    void setMyTeamTotalScore(int score) { myTeamTotalScore = score; }
+    void setOpponentTeamTotalScore(int score) { opponentTeamTotalScore = score; }
+    void setIsGameOver(bool gameOver) { isGameOver = gameOver; }
+    void setGameOutcome(std::optional<ClientGameOutcome> outcome) { gameOutcome = outcome; }
+};
+
+#endif // BOARD_STATE_HPP
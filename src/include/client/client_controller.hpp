@@ -4,36 +4,36 @@
 #include <string>
 #include <functional>
 #include <vector>
+#include <memory>
+#include <deque>
+#include <chrono>
+#include <optional>
+#include <asio.hpp>
 #include "client_network.hpp"
-#include "game_view.hpp"
+#include "client_frontend.hpp"
 #include "game_state.hpp" // For ClientGameState, ActionError, MeldRequest, Card
 
 // Forward declarations
 class ClientNetwork;
-class GameView;
-
-/**
- * @enum ActionAttemptStatus
- * @brief Represents the status of an attempted player action, tracked internally by ClientController.
- */
-enum class ActionAttemptStatus {
-    NotAttempted,   ///< The action has not yet been tried in the current context/turn.
-    Attempting,     ///< The action has been initiated with the server, awaiting response.
-    Succeeded      ///< The server confirmed the action was successful.
-};
+
+/// Pause before retrying an action the server shed under its rate limit
+constexpr std::chrono::milliseconds SHED_RETRY_DELAY{50};
 
 class ClientController {
 public:
     /**
      * @brief Constructor for ClientController.
      * @param clientNetwork A shared pointer to the ClientNetwork instance.
-     * @param gameView A reference to the GameView instance for user interaction.
+     * @param frontend The front-end used for player interaction (terminal UI or headless).
+     * @param uiExecutor The executor the front-end runs on. Network events are handled there,
+     * so the network thread never waits for the player.
      */
-    ClientController(std::shared_ptr<ClientNetwork> clientNetwork);
+    ClientController(std::shared_ptr<ClientNetwork> clientNetwork, std::unique_ptr<ClientFrontend> frontend,
+        asio::any_io_executor uiExecutor);
 
     /**
      * @brief Initiates the connection process to the server.
-     * Prompts the user for their name via GameView, then calls ClientNetwork::connect.
+     * Prompts the user for their name via the front-end, then calls ClientNetwork::connect.
      * Sets up the necessary callbacks on ClientNetwork.
      * @param host The server host address.
      * @param port The server port.
@@ -43,76 +43,169 @@ public:
 private:
     std::shared_ptr<ClientNetwork> network; /// Pointer to the ClientNetwork instance for network operations
     std::string localPlayerName;            ///< To store the player's name after successful input
-    GameView view;                         ///< Reference to the GameView instance for user interaction
+    std::unique_ptr<ClientFrontend> view;   ///< Front-end used for player interaction
+    asio::any_io_executor uiExecutor;       ///< Executor running the front-end and every handler below
+    ClientGameState latestGameState;        ///< Last state received; owns the cards currentBoardState points to
     BoardState currentBoardState;           ///< To keep track of the current board state
 
-    static constexpr std::size_t SCORE_TIME = 25; ///< Time to display the score screen before returning to the game
+    /**
+     * @enum TurnPhase
+     * @brief Step of the player's turn, telling which actions are offered next.
+     */
+    enum class TurnPhase {
+        Start,                  ///< Draw from the deck or take the discard pile
+        AfterDrawing,           ///< Meld or discard
+        AfterTakingDiscardPile, ///< Meld or revert
+        AfterMelding,           ///< Discard or revert
+        Over                    ///< The turn has ended
+    };
+    /**
+     * @struct TurnStep
+     * @brief Where the turn goes on from after a step.
+     */
+    struct TurnStep {
+        TurnPhase phase;                    ///< Phase the turn continues in
+        std::optional<std::string> message{}; ///< Shown with the next prompt, e.g. why an action was rejected
+        bool awaitsReply = false;           ///< The phase is decided by the server's reply to the last action
+        bool backOff = false;               ///< The server shed the last action under its rate limit
+    };
 
-    // --- Internal Action State Tracking ---
-    // These statuses help the controller decide what to do next based on the game state
-    // and the results of previous actions.
-    ActionAttemptStatus drawDeckAttemptStatus;
-    ActionAttemptStatus takeDiscardPileAttemptStatus;
-    ActionAttemptStatus meldAttemptStatus;
-    ActionAttemptStatus discardAttemptStatus;
+    /**
+     * @struct PendingAction
+     * @brief An action sent, or queued to be sent, to the server and not answered yet.
+     * @details Replies are matched with the front of the queue by the request id the server echoes.
+     */
+    struct PendingAction {
+        RequestId requestId;                 ///< Id sent with the request and echoed in its reply
+        ClientMessageType type;              ///< Type of the request
+        bool flowContinued;                  ///< The turn went on from the predicted state without waiting for the reply
+        TurnPhase nextPhase;                 ///< Phase the turn continues in once confirmed, unless it went on already
+        TurnPhase rollbackPhase;             ///< Phase the turn resumes in if rejected
+        std::function<void(RequestId)> send; ///< Sends the request; run once every action ahead of it is confirmed
+        bool sent = false;                   ///< Whether the request is on the wire
+    };
+    /**
+     * @struct PredictedState
+     * @brief The player's own state with the pending actions applied locally.
+     */
+    struct PredictedState {
+        Hand hand;
+        TeamRoundState teamState;
+        ClientDeck deck;
+    };
 
-    /// Helper to reset action statuses, e.g., at the start of a new turn.
-    void resetTurnActionStatuses();
+    std::deque<PendingAction> pendingActions;       ///< Actions awaiting a reply, oldest first
+    RequestId nextRequestId = NO_REQUEST_ID + 1;    ///< Id of the next action
+    std::unique_ptr<PredictedState> predictedState; ///< Shown instead of latestGameState while set
+
+    bool turnActive = false;             ///< Whether a turn coroutine is running
+    std::optional<TurnStep> turnReply;   ///< Step the server's reply leads to, until the turn takes it
+    asio::steady_timer replySignal;      ///< Never expires while awaiting a reply; cancelled to wake the turn
+    asio::steady_timer scoreTimer;       ///< Expires when the round score has been shown long enough
+    bool showingScore = false;           ///< Whether the round score is on screen; new states wait meanwhile
+    std::deque<ClientGameState> statesAfterScore; ///< States received while the score is shown, oldest first
 
     // --- Callback Handlers from ClientNetwork ---
-    // These methods are the entry points for server-driven events.
-    void handleGameStateUpdate(const ClientGameState& gameState);
+    // These methods are the entry points for server-driven events, posted to the UI executor.
+    void handleGameStateUpdate(ClientGameState gameState);
     void handleActionError(const ActionError& error);
     void handleLoginSuccess();
     void handleLoginFailure(const std::string& reason);
     void handleDisconnect();
 
-    // --- Internal Game Logic ---
-    /// Process the current player's turn.
-    void processPlayerTurn(std::optional<const std::string> message = std::nullopt); 
-    
+    // --- Turn Flow ---
+    // A turn is a coroutine on the UI executor: it prompts the player, submits the chosen action
+    // and, when the next step depends on the server, suspends until the handlers above resume it.
+    // Rejections and retries loop back to an earlier phase, so the stack does not grow with them.
+
+    /// Starts the turn coroutine for a turn the server has just given the player.
+    void startTurn();
+    /// Plays the turn from its start until it ends or the connection does.
+    asio::awaitable<void> playTurn();
+    /**
+     * @brief Waits until a reply resumes the turn or the deadline passes.
+     * @return The step the reply leads to, or nullopt at the deadline.
+     */
+    asio::awaitable<std::optional<TurnStep>> awaitReply(
+        asio::steady_timer::time_point deadline = asio::steady_timer::time_point::max());
+    /// Hands the step a reply leads to over to the waiting turn.
+    void resumeTurn(TurnStep step);
+    /// Leaves the round score on screen for its display time, then handles the states that came meanwhile.
+    asio::awaitable<void> holdScore(std::chrono::steady_clock::duration displayTime);
+    /// Prompts the player for the action of the given phase and performs it.
+    TurnStep takeStep(TurnPhase phase, std::optional<const std::string> message);
+
     // Methods to prompt user for actions via GameView and then call ClientNetwork
     /**
      * @brief Prompts the user to choose between drawing a card from the deck or taking the discard pile.
      */
-    void promptAndProcessDrawCardOrTakeDiscardPile
-    (std::optional<const std::string> message = std::nullopt);
+    TurnStep promptAndProcessDrawCardOrTakeDiscardPile(std::optional<const std::string> message);
     /**
      * @brief Processes the turn flow after drawing a card from the deck.
      */
-    void processAfterDrawing(std::optional<const std::string> message = std::nullopt);
+    TurnStep processAfterDrawing(std::optional<const std::string> message);
     /**
      * @brief Processes the turn flow after taking the discard pile.
      */
-    void processAfterTakingDiscardPile(std::optional<const std::string> message = std::nullopt);
+    TurnStep processAfterTakingDiscardPile(std::optional<const std::string> message);
     /**
      * @brief Processes the turn flow after melding.
      */
-    void processAfterMelding(std::optional<const std::string> message = std::nullopt);
+    TurnStep processAfterMelding(std::optional<const std::string> message);
     /**
      * @brief Processes the melding action.
+     * @param phase The phase melding was chosen in, resumed if the melds are rejected.
      */
-    void processMelding(ActionAttemptStatus& previousAttemptStatus);
+    TurnStep processMelding(TurnPhase phase);
     /**
      * @brief Processes the revert action.
+     * @param phase The phase reverting was chosen in, resumed if the revert is rejected.
      */
-    void processRevert();
-        /**
+    TurnStep processRevert(TurnPhase phase);
+    /**
      * @brief Processes the discard action.
+     * @param phase The phase discarding was chosen in, resumed if the discard is rejected.
      */
-    void processDiscard();
+    TurnStep processDiscard(TurnPhase phase);
 
     /// Internal helper to setup callbacks on ClientNetwork
     void setupNetworkCallbacks();
 
     /**
-     * @brief Gets the meld views from the team round state.
+     * @brief Queues an action for the server.
+     * @details The request is sent right away unless an earlier action is still unconfirmed;
+     * it then waits, so that nothing reaches the server on top of a prediction it may reject.
+     * @param type The type of the request.
+     * @param flowContinued Whether the turn goes on without waiting for the reply.
+     * @param nextPhase The phase the turn continues in once the action is confirmed.
+     * @param rollbackPhase The phase the turn resumes in if the action is rejected.
+     * @param send Sends the request through the network.
+     */
+    void submitAction(ClientMessageType type, bool flowContinued, TurnPhase nextPhase, TurnPhase rollbackPhase,
+        std::function<void(RequestId)> send);
+    /**
+     * @brief Sends the oldest pending action if it is not on the wire yet.
+     */
+    void sendNextAction();
+    /**
+     * @brief Creates a prediction starting from what the board shows now.
+     */
+    std::unique_ptr<PredictedState> makePrediction() const;
+    /**
+     * @brief Shows the given prediction on the board.
      */
-    std::vector<MeldView> getMeldViewsFromTeamRoundState(const TeamRoundState& teamRoundState) const;
+    void showPrediction(std::unique_ptr<PredictedState> prediction);
+    /**
+     * @brief Discards the prediction and shows the latest state received from the server.
+     */
+    void dropPrediction();
+
     /**
-     * @brief Gets the board state from the game state.
+     * @brief Patches currentBoardState with the parts of the game state that changed.
+     * @details The player's own melds, hand and deck view are taken from predictedState when set.
+     * The board keeps pointing into the given state, which must outlive its use.
      */
-    BoardState getBoardState(const ClientGameState& gameState) const;
+    void updateBoardState(const ClientGameState& gameState);
     /**
      * @brief Gets the score state from the game state.
      */
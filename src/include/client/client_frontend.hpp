@@ -0,0 +1,110 @@
+#ifndef CLIENT_FRONTEND_HPP
+#define CLIENT_FRONTEND_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <optional>
+#include "card.hpp"
+#include "meld.hpp"
+#include "client/board_state.hpp"
+
+/**
+ * @enum TurnAction
+ * @brief The actions offered to the player at the steps of a turn.
+ */
+enum class TurnAction { DrawDeck, TakeDiscardPile, Meld, Discard, Revert };
+
+/**
+ * @brief Get the label a turn action is shown with.
+ */
+constexpr std::string_view turnActionLabel(TurnAction action) {
+    switch (action) {
+        case TurnAction::DrawDeck: return "Draw a card from deck";
+        case TurnAction::TakeDiscardPile: return "Take discard pile";
+        case TurnAction::Meld: return "Melding";
+        case TurnAction::Discard: return "Discard a card";
+        case TurnAction::Revert: return "Revert";
+    }
+    return "";
+}
+
+/**
+ * @class ClientFrontend
+ * @brief Interface through which ClientController talks to the player.
+ * @details GameView implements it with an interactive terminal UI, HeadlessView plays
+ * without a terminal from a scripted policy or from stdin commands.
+ */
+class ClientFrontend {
+public:
+    virtual ~ClientFrontend() = default;
+
+    /**
+     * @brief Prompt the player for a text input.
+     * @param question The question to display.
+     * @param placeholder The placeholder text to display.
+     * @return The player's input as a string.
+     */
+    virtual std::string promptString(const std::string& question, std::string& placeholder) = 0;
+    /**
+     * @brief Display the game board and let the player choose one of the options.
+     * @param question The question to display.
+     * @param options The options for the player to choose from.
+     * @param boardState The current state of the game board.
+     * @param message Optional message to display.
+     * @return The index of the selected option.
+     */
+    virtual int promptChoiceWithBoard(const std::string& question, const std::vector<std::string>& options,
+        const BoardState& boardState, std::optional<const std::string> message = std::nullopt) = 0;
+    /**
+     * @brief Display the game board and let the player choose the next action of the turn.
+     * @details Shows the actions' labels through promptChoiceWithBoard unless overridden.
+     * @param actions The actions the player can choose from.
+     * @param boardState The current state of the game board.
+     * @param message Optional message to display, set when the previous action was rejected.
+     * @return The selected action.
+     */
+    virtual TurnAction promptTurnAction(const std::vector<TurnAction>& actions, const BoardState& boardState,
+        std::optional<const std::string> message = std::nullopt) {
+        std::vector<std::string> labels;
+        for (auto action : actions)
+            labels.emplace_back(turnActionLabel(action));
+        return actions.at(static_cast<std::size_t>(
+            promptChoiceWithBoard("Choose an action:", labels, boardState, std::move(message))));
+    }
+    /**
+     * @brief Get the player's meld requests.
+     * @param boardState The current state of the game board.
+     * @return A vector of meld requests, empty to go back.
+     */
+    virtual std::vector<MeldRequest> runMeldWizard(const BoardState& boardState) = 0;
+    /**
+     * @brief Get the card the player wants to discard.
+     * @param boardState The current state of the game board.
+     * @return The selected card to discard.
+     */
+    virtual Card runDiscardWizard(const BoardState& boardState) = 0;
+    /**
+     * @brief Display the game board with messages, without waiting for input.
+     * @param messages The messages to display.
+     * @param boardState The current state of the game board.
+     */
+    virtual void showStaticBoardWithMessages(
+        const std::vector<std::string>& messages, const BoardState& boardState) = 0;
+    /**
+     * @brief Display the round score, without waiting for input.
+     * @param scoreState The current state of the game score.
+     */
+    virtual void showStaticScore(const ScoreState& scoreState) = 0;
+    /**
+     * @brief Get how long the round score stays on screen before play resumes.
+     */
+    virtual std::chrono::seconds getScoreDisplayTime() const = 0;
+    /**
+     * @brief Check whether the client should disconnect once the game is over.
+     */
+    virtual bool shouldLeaveAfterGame() const = 0;
+};
+
+#endif // CLIENT_FRONTEND_HPP
@@ -6,9 +6,14 @@
 #include <vector>
 #include <deque>
 #include <functional>
+#include <chrono>
+#include <unordered_map>
+#include <atomic>
 #include "game_state.hpp"
 #include "network.hpp"
 
+constexpr std::chrono::seconds CONNECT_TIMEOUT{10}; // Time allowed to reach the server
+
 /**
  * @class ClientNetwork
  * @brief Handles the network connection from the client to the server.
@@ -19,8 +24,8 @@
 class ClientNetwork : public std::enable_shared_from_this<ClientNetwork> {
 public:
     // --- Callback Types ---
-    /// Called when a new game state is received from the server.
-    using GameStateCallback = std::function<void(const ClientGameState&)>;
+    /// Called when a new game state is received from the server; the state is handed over to the callee.
+    using GameStateCallback = std::function<void(ClientGameState)>;
     /// Called when the server reports an error related to a client action.
     using ErrorCallback = std::function<void(const ActionError&)>;
     /// Called for simple notifications like successful login or disconnection.
@@ -63,15 +68,22 @@ public:
      */
     bool isConnected() const;
 
+    /**
+     * @brief Sets the wire format asked for at login (Compact by default).
+     * @details The server may grant a less compact one; messages use Binary until it answers.
+     */
+    void setWireFormat(WireFormat format);
+
     /// --- Sending Actions ---
     /// These methods serialize the corresponding action and send it to the server.
     /// They should only be called after a successful connection and login.
+    /// The request id is echoed in the reply; it should be unique and not NO_REQUEST_ID.
 
-    void sendDrawDeck();
-    void sendTakeDiscardPile();
-    void sendMeld(std::vector<MeldRequest> requests);
-    void sendDiscard(Card card);
-    void sendRevert();
+    void sendDrawDeck(RequestId requestId);
+    void sendTakeDiscardPile(RequestId requestId);
+    void sendMeld(RequestId requestId, std::vector<MeldRequest> requests);
+    void sendDiscard(RequestId requestId, Card card);
+    void sendRevert(RequestId requestId);
 
     // --- Setting Callbacks ---
     /// Register functions to be called when specific events occur.
@@ -83,56 +95,55 @@ public:
     void setOnDisconnect(VoidCallback callback); ///< Called on unexpected or explicit disconnect
 
 private:
-    // --- Internal ASIO Handlers ---
-    /// These handle the steps of the asynchronous connection and read/write operations.
-    void doResolve(const std::string& host, const std::string& port, const std::string& playerName);
-    void handleResolve(const asio::error_code& ec, const asio::ip::tcp::resolver::results_type& endpoints, const std::string& playerName);
-    void doConnect(const asio::ip::tcp::resolver::results_type& endpoints, const std::string& playerName);
-    void handleConnect(const asio::error_code& ec, const std::string& playerName);
+    // --- Internal ASIO Coroutines ---
+    /// Each runs on the I/O context until the connection fails or is closed.
+
+    /**
+     * @brief Resolves the server address, connects (timing out after CONNECT_TIMEOUT), logs in
+     *        and then runs the read loop.
+     */
+    asio::awaitable<void> run(std::string host, std::string port, std::string playerName);
 
     /// Sends the initial login message after physical connection.
     void sendLogin(const std::string& playerName);
 
-    /// Handles reading the message size header.
-    void doReadHeader();
-    void handleReadHeader(const asio::error_code& error, std::size_t bytes_transferred);
-    /// Handles reading the message body based on the header size.
-    void doReadBody();
-    void handleReadBody(const asio::error_code& error, std::size_t bytes_transferred);
+    /// Reads the socket and processes every complete message received before reading again.
+    asio::awaitable<void> readLoop();
 
-    /// Handles writing messages from the queue.
-    void doWrite();
-    void handleWrite(const asio::error_code& error, std::size_t bytes_transferred);
+    /// Writes the queued messages, all those queued at the time in one write timing out after WRITE_TIMEOUT.
+    asio::awaitable<void> writeLoop();
 
     // --- Message Processing ---
 
     /**
-     * @brief Deserializes the received message body and triggers appropriate callbacks.
+     * @brief Deserializes a received message body and triggers appropriate callbacks.
+     * @param frame The body, decoded where it was read.
      */
-    void processMessage();
+    void processMessage(std::span<const char> frame);
 
     // --- Sending Logic ---
 
     /**
      * @brief Internal helper to queue a message for sending.
      *        Handles serialization and adding the size header.
-     * @tparam T The type of the data payload.
+     * @tparam T The type of the data payload (none for messages without payload).
      * @param msgType The type of the client message.
+     * @param requestId The id of the request, recorded to measure the round trip.
      * @param data The data payload to serialize and send.
      */
-    template <typename T>
-    void queueMessage(ClientMessageType msgType, const T& data);
+    template <typename... T>
+    void queueMessage(ClientMessageType msgType, RequestId requestId, const T&... data);
 
     /**
-     * @brief Internal helper to queue a message with no payload for sending.
-     * @param msgType The type of the client message.
+     * @brief Logs the round-trip time of the request a reply answers.
+     * @param requestId The id echoed by the server.
      */
-    void queueMessage(ClientMessageType msgType);
+    void recordReply(RequestId requestId);
 
 
     /// --- Callback Invocation ---
     /// Safely invokes the registered callbacks.
-    void invokeGameStateCallback(const ClientGameState& state);
+    void invokeGameStateCallback(ClientGameState&& state);
     void invokeActionErrorCallback(const ActionError& actionError);
     void invokeLoginSuccessCallback();
     void invokeLoginFailureCallback(const std::string& errorMsg);
@@ -143,12 +154,14 @@ private:
     asio::io_context& ioContext; ///< Reference to the application's I/O context
     asio::ip::tcp::socket socket; ///< Socket for the server connection
     asio::ip::tcp::resolver resolver; ///< Used for resolving server address
-    bool connected; ///< Flag indicating connection status
+    std::atomic<bool> connected; ///< Flag indicating connection status, set and cleared from either thread
 
     // Buffers and message queue
-    std::vector<char> readMsgBuffer; ///< Buffer for incoming messages
-    std::uint32_t incomingMsgSize; ///< Size of the message currently being read
+    FrameReader reader; ///< Buffer the incoming messages are read into and parsed from
     std::deque<std::vector<char>> writeMsgs; ///< Queue for outgoing messages (serialized with header)
+    asio::steady_timer writeSignal; ///< Never expires; cancelled to wake the write loop
+    /// Time each request awaiting a reply was queued, by request id
+    std::unordered_map<RequestId, std::chrono::steady_clock::time_point> requestSendTimes;
 
     // Callbacks provided by the client application
     GameStateCallback onGameStateUpdateCallback;
@@ -159,6 +172,10 @@ private:
 
     /// Store player name after successful login attempt initiation
     std::string clientPlayerName;
+
+    WireFormat requestedWireFormat = WireFormat::Compact; ///< Format asked for at login
+    /// Format granted by the server, read when serializing on the caller's thread
+    std::atomic<WireFormat> wireFormat{WireFormat::Binary};
 };
 
 
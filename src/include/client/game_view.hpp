@@ -12,6 +12,9 @@
 #include <ftxui/component/loop.hpp>
 #include <optional>
 #include <map>
+#include <array>
+#include <cstdint>
+#include <memory>
 #include "card.hpp"
 #include "hand.hpp"
 #include "score_details.hpp"
@@ -20,7 +23,8 @@
 #include "meld.hpp"
 #include "client_deck.hpp"
 #include "client/canasta_console.hpp"
-#include "client/input_guard.hpp"
+#include "client/board_state.hpp"
+#include "client/client_frontend.hpp"
 
 using namespace ftxui;
 
@@ -41,116 +45,38 @@ public:
 };
 
 /**
- * @class MeldView
- * @brief Class representing a meld view for display purposes.
+ * @class CachedElement
+ * @brief Memoizes a rendered board part together with the view data it was built from.
+ * @details The element is rebuilt only when the data passed to get() differs from the cached copy,
+ * so unchanged parts of the board are reused between frames.
  */
-class MeldView {
+template <typename Source>
+class CachedElement {
 private:
-    Rank rank;
-    std::vector<Card> cards;
-    bool isInitializedFlag;
+    std::optional<Source> source;
+    Element element;
 public:
-    MeldView(Rank rank, const std::vector<Card>& cards, bool isInitialized)
-        : rank(rank), cards(cards), isInitializedFlag(isInitialized) {}
-
-    Rank getRank() const { return rank; }
-    const std::vector<Card>& getCards() const { return cards; }
-    bool isInitialized() const { return isInitializedFlag; }
-};
-
-/**
- * @class BoardState
- * @brief Class representing the game board state for display purposes.
- */
-class BoardState {
-private:
-    std::vector<MeldView> myTeamMelds;
-    std::vector<MeldView> opponentTeamMelds;
-    Hand myHand;
-    ClientDeck deckState;
-    PlayerPublicInfo myPlayer;
-    PlayerPublicInfo oppositePlayer;
-    std::optional<PlayerPublicInfo> leftPlayer;
-    std::optional<PlayerPublicInfo> rightPlayer;
-    int myTeamTotalScore;
-    int opponentTeamTotalScore;
-    int myTeamMeldPoints;
-    int opponentTeamMeldPoints;
-
-    static constexpr int RANK_MELD_OFFSET = 2; // Offset for rank melds (Four to Ace)
-public:
-
-    // Getters
-    std::vector<MeldView> getMyTeamMelds() const { return myTeamMelds; }
-    std::vector<MeldView> getOpponentTeamMelds() const { return opponentTeamMelds; }
-    Hand getMyHand() const { return myHand; }
-    ClientDeck getDeckState() const { return deckState; }
-    PlayerPublicInfo getMyPlayer() const { return myPlayer; }
-    PlayerPublicInfo getOppositePlayer() const { return oppositePlayer; }
-    std::optional<PlayerPublicInfo> getLeftPlayer() const { return leftPlayer; }
-    std::optional<PlayerPublicInfo> getRightPlayer() const { return rightPlayer; }
-    int getMyTeamTotalScore() const { return myTeamTotalScore; }
-    int getOpponentTeamTotalScore() const { return opponentTeamTotalScore; }
-    int getMyTeamMeldPoints() const { return myTeamMeldPoints; }
-    int getOpponentTeamMeldPoints() const { return opponentTeamMeldPoints; }
-
-    // Setters
-    void setMyTeamMelds(const std::vector<MeldView>& melds) { myTeamMelds = melds; }
-    void setOpponentTeamMelds(const std::vector<MeldView>& melds) { opponentTeamMelds = melds; }
-    void setMyHand(const Hand& hand) { myHand = hand; }
-    void setDeckState(const ClientDeck& deck) { deckState = deck; }
-    void setMyPlayer(const PlayerPublicInfo& player) { myPlayer = player; }
-    void setOppositePlayer(const PlayerPublicInfo& player) { oppositePlayer = player; }
-    void setLeftPlayer(const PlayerPublicInfo& player) { leftPlayer = player; }
-    void setRightPlayer(const PlayerPublicInfo& player) { rightPlayer = player; }
-    void setMyTeamTotalScore(int score) { myTeamTotalScore = score; }
-    void setOpponentTeamTotalScore(int score) { opponentTeamTotalScore = score; }
-    void setMyTeamMeldPoints(int points) { myTeamMeldPoints = points; }
-    void setOpponentTeamMeldPoints(int points) { opponentTeamMeldPoints = points; }
-
-    static std::optional<std::size_t> getMeldIndexForRank(Rank rank);
-};
-
-/**
- * @class ScoreState
- * @brief Class representing the score state for display purposes.
- */
-class ScoreState {
-private:
-    ScoreBreakdown myTeamScoreBreakdown;
-    ScoreBreakdown opponentTeamScoreBreakdown;
-    std::size_t playersCount;
-    int myTeamTotalScore;
-    int opponentTeamTotalScore;
-    bool isGameOver;
-    std::optional<ClientGameOutcome> gameOutcome;
-public:
-
-    // Getters
-    ScoreBreakdown getMyTeamScoreBreakdown() const { return myTeamScoreBreakdown; }
-    ScoreBreakdown getOpponentTeamScoreBreakdown() const { return opponentTeamScoreBreakdown; }
-    std::size_t getPlayersCount() const { return playersCount; }
-    int getMyTeamTotalScore() const { return myTeamTotalScore; }
-    int getOpponentTeamTotalScore() const { return opponentTeamTotalScore; }
-    bool getIsGameOver() const { return isGameOver; }
-    std::optional<ClientGameOutcome> getGameOutcome() const { return gameOutcome; }
-
-    // Setters
-    void setMyTeamScoreBreakdown(const ScoreBreakdown& breakdown) { myTeamScoreBreakdown = breakdown; }
-    void setOpponentTeamScoreBreakdown(const ScoreBreakdown& breakdown) { opponentTeamScoreBreakdown = breakdown; }
-    void setPlayersCount(std::size_t count) { playersCount = count; }
-    void setMyTeamTotalScore(int score) { myTeamTotalScore = score; }
-    void setOpponentTeamTotalScore(int score) { opponentTeamTotalScore = score; }
-    void setIsGameOver(bool gameOver) { isGameOver = gameOver; }
-    void setGameOutcome(std::optional<ClientGameOutcome> outcome) { gameOutcome = outcome; }
+    /**
+     * @brief Get the element for the given data, rebuilding it only if the data has changed.
+     * @param current The data the element should display.
+     * @param build Callable creating the element from the data.
+     * @return The cached or freshly built element.
+     */
+    template <typename Builder>
+    Element get(const Source& current, Builder&& build) {
+        if (!source.has_value() || !(*source == current)) {
+            element = build(current);
+            source = current;
+        }
+        return element;
+    }
 };
 
-
 /**
  * @class GameView
  * @brief Class responsible for displaying the game state and handling user input.
  */
-class GameView {
+class GameView : public ClientFrontend {
 public:
     /**
      * @brief Constructor for GameView.
@@ -162,7 +88,7 @@ public:
      * @param placeholder The placeholder text to display.
      * @return The user's input as a string.
      */
-    std::string promptString(const std::string& question, std::string& placeholder);
+    std::string promptString(const std::string& question, std::string& placeholder) override;
     /**
      * @brief Display the game board and prompt the user for input.
      * @param question The question to display.
@@ -172,37 +98,41 @@ public:
      * @return The index of the selected option.
      */
     int promptChoiceWithBoard(const std::string& question, const std::vector<std::string>& options,
-        const BoardState& boardState, std::optional<const std::string> message = std::nullopt);
+        const BoardState& boardState, std::optional<const std::string> message = std::nullopt) override;
     /**
      * @brief Display the game board and get the user's meld requests.
      * @param boardState The current state of the game board.
      * @return A vector of meld requests.
      */
-    std::vector<MeldRequest> runMeldWizard(const BoardState& boardState);
+    std::vector<MeldRequest> runMeldWizard(const BoardState& boardState) override;
     /**
      * @brief Display the game board and get the user's discard card.
      * @param boardState The current state of the game board.
      * @return The selected card to discard.
      */
-    Card runDiscardWizard(const BoardState& boardState);
+    Card runDiscardWizard(const BoardState& boardState) override;
     /**
      * @brief Display the game board with messages.
-     * @details This method clears the console, disables input, and shows the game board with messages.
+     * @details The board stays on screen without reacting to keys until the next prompt.
      * @param messages The messages to display.
      * @param boardState The current state of the game board.
      */
     void showStaticBoardWithMessages(
-        const std::vector<std::string>& messages, const BoardState& boardState);
+        const std::vector<std::string>& messages, const BoardState& boardState) override;
     /**
      * @brief Display the game score.
-     * @details This method clears the console, disables input, and shows the game score.
+     * @details The score stays on screen without reacting to keys until the next prompt.
      * @param scoreState The current state of the game score.
      */
-    void showStaticScore(const ScoreState& scoreState);
+    void showStaticScore(const ScoreState& scoreState) override;
+    /**
+     * @brief The score screen is kept long enough for the player to read it.
+     */
+    std::chrono::seconds getScoreDisplayTime() const override { return SCORE_TIME; }
     /**
-     * @brief Restore the input for the console.
+     * @brief The final score stays on screen until the server closes the game.
      */
-    void restoreInput();
+    bool shouldLeaveAfterGame() const override { return false; }
 
 private:
     static constexpr int PANE_HIGHT = 6; ///< Height of the pane for displaying options
@@ -211,10 +141,24 @@ private:
     static constexpr int SCORE_WIDTH = 25; ///< Width of the score display
     static constexpr std::size_t MAX_NAME_LENGTH = 10; ///< Maximum length of player names
     static constexpr std::size_t MAX_MELD_GRID_ROWS = 8; ///< Maximum rows in the meld grid
+    static constexpr std::chrono::seconds SCORE_TIME{25}; ///< Time to display the score screen before returning to the game
 
     CanastaConsole console;                 ///< Console for output
-    ScreenInteractive screen;               ///< Screen for interactive input/output
-    std::optional<InputGuard> inputGuard;   /// Input guard for console state
+    ScreenInteractive screen;               ///< Screen kept for the whole session
+    std::unique_ptr<Loop> loop;             ///< Loop driving the screen, installed on first use
+    Component root;                         ///< Root component forwarding to the active modal
+    Component activeModal;                  ///< Modal currently rendered and receiving events
+
+    // Board parts cached between frames, each invalidated by its own part of the BoardState
+    CachedElement<std::uint64_t> myMeldGridCache;       // keyed by meld revision
+    CachedElement<std::uint64_t> opponentMeldGridCache; // keyed by meld revision
+    CachedElement<std::uint64_t> handGridCache;         // keyed by hand revision
+    CachedElement<ClientDeck> deckInfoCache;
+    CachedElement<std::array<int, 4>> scoreInfoCache;
+    CachedElement<PlayerPublicInfo> myPlayerInfoCache;
+    CachedElement<PlayerPublicInfo> oppositePlayerInfoCache;
+    CachedElement<std::optional<PlayerPublicInfo>> leftPlayerInfoCache;
+    CachedElement<std::optional<PlayerPublicInfo>> rightPlayerInfoCache;
     
     /**
      * @brief Get the card view for display purposes.
@@ -273,9 +217,17 @@ private:
      */
     Element makePlayerInfo(const PlayerPublicInfo& player);
     /**
-     * @brief Disable input for the console.
+     * @brief Make the modal active and pump the screen until it reports completion.
+     * @param modal The sub-component handling the prompt.
+     * @param done Flag set by the modal once the user has answered.
+     * @throws std::runtime_error if the screen loop quits before the modal is done.
+     */
+    void runModal(Component modal, const bool& done);
+    /**
+     * @brief Show a non-interactive frame; keys pressed while it is shown are dropped.
+     * @param document The element to display.
      */
-    void disableInput();
+    void showFrame(Element document);
 };
 
 #endif // GAME_VIEW_HPP
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef HEADLESS_VIEW_HPP
+#define HEADLESS_VIEW_HPP
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <iostream>
+#include "card.hpp"
+#include "meld.hpp"
+#include "client/client_frontend.hpp"
+
+/**
+ * @enum HeadlessMode
+ * @brief Source of the decisions taken by a HeadlessView.
+ */
+enum class HeadlessMode {
+    Policy, ///< Decisions are taken by a simple built-in policy
+    Stdin   ///< Decisions are read as text commands from the input stream
+};
+
+/**
+ * @class HeadlessView
+ * @brief Front-end playing without a terminal UI.
+ * @details Lets the real client (networking and deserialization included) be driven by scripts
+ * or profiled without a TTY. Cards are written and read as short tokens: a rank character
+ * (@ for Joker, 2-9, X for Ten, J, Q, K, A) followed by R or B for the color, e.g. "XR" or "@B".
+ */
+class HeadlessView : public ClientFrontend {
+public:
+    /**
+     * @brief Constructor for HeadlessView.
+     * @param mode Source of the decisions.
+     * @param playerName Name used at login; if empty, it is read from the input in stdin mode.
+     * @param input Stream the commands are read from in stdin mode.
+     * @param output Stream the prompts and board summaries are written to in stdin mode.
+     */
+    HeadlessView(HeadlessMode mode, std::string playerName,
+        std::istream& input = std::cin, std::ostream& output = std::cout);
+
+    std::string promptString(const std::string& question, std::string& placeholder) override;
+    int promptChoiceWithBoard(const std::string& question, const std::vector<std::string>& options,
+        const BoardState& boardState, std::optional<const std::string> message = std::nullopt) override;
+    /**
+     * @brief Choose the action with the built-in policy, or through promptChoiceWithBoard in stdin mode.
+     */
+    TurnAction promptTurnAction(const std::vector<TurnAction>& actions, const BoardState& boardState,
+        std::optional<const std::string> message = std::nullopt) override;
+    std::vector<MeldRequest> runMeldWizard(const BoardState& boardState) override;
+    Card runDiscardWizard(const BoardState& boardState) override;
+    void showStaticBoardWithMessages(
+        const std::vector<std::string>& messages, const BoardState& boardState) override;
+    void showStaticScore(const ScoreState& scoreState) override;
+    /**
+     * @brief Scripted play does not pause between rounds.
+     */
+    std::chrono::seconds getScoreDisplayTime() const override { return std::chrono::seconds(0); }
+    /**
+     * @brief Scripted play ends the session once the game is over.
+     */
+    bool shouldLeaveAfterGame() const override { return true; }
+
+    /**
+     * @brief Get the token of a card, e.g. "XR" for a red Ten.
+     */
+    static std::string cardToken(const Card& card);
+    /**
+     * @brief Parse a card token.
+     * @return The card, or nullopt if the token is malformed.
+     */
+    static std::optional<Card> parseCardToken(const std::string& token);
+
+private:
+    static constexpr std::size_t MIN_CARDS_LEFT_AFTER_MELD = 2; ///< Cards the policy keeps to be able to discard
+    static constexpr std::size_t MIN_NATURALS_FOR_NEW_MELD = 3; ///< Naturals the policy needs to open a meld
+
+    HeadlessMode mode;
+    std::string playerName;
+    std::istream& input;
+    std::ostream& output;
+
+    /**
+     * @enum PolicyAction
+     * @brief Last action chosen by the policy, used to react to a rejected action.
+     */
+    enum class PolicyAction { None, Draw, TakeDiscardPile, Meld, Discard };
+    PolicyAction lastAction = PolicyAction::None;
+    std::size_t rejectedDiscards = 0; ///< Discards rejected in a row, to try another card
+
+    /**
+     * @brief Choose an action with the built-in policy.
+     */
+    TurnAction choosePolicyAction(const std::vector<TurnAction>& actions,
+        const BoardState& boardState, bool lastActionRejected);
+    /**
+     * @brief Build the melds the policy would play from the current board.
+     */
+    std::vector<MeldRequest> planMelds(const BoardState& boardState) const;
+    /**
+     * @brief Order the cards of the hand from the most to the least preferred discard.
+     */
+    std::vector<Card> rankDiscards(const BoardState& boardState) const;
+    /**
+     * @brief Read one non-empty line from the input.
+     * @throws std::runtime_error if the input is closed.
+     */
+    std::string readLine();
+    /**
+     * @brief Write a compact text summary of the board to the output.
+     */
+    void printBoard(const BoardState& boardState);
+};
+
+#endif // HEADLESS_VIEW_HPP
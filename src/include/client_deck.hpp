@@ -54,6 +54,8 @@ public:
     std::size_t getMainDeckSize() const { return mainDeckSize; }
     bool isFrozen() const { return isDiscardPileFrozen; }
 
+    bool operator==(const ClientDeck& other) const = default;
+
     // --- Serialization ---
     template <class Archive>
     void serialize(Archive& archive) {
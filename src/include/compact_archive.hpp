@@ -0,0 +1,190 @@
+#ifndef COMPACT_ARCHIVE_HPP
+#define COMPACT_ARCHIVE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>       // For std::addressof
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <cereal/cereal.hpp>
+
+// Archive pair writing the same fields as cereal's binary archives, with smaller integers.
+// It plugs into the existing serialize/save/load templates unchanged.
+namespace cereal {
+
+constexpr std::streamsize MAX_VARINT_SIZE = 10; ///< Bytes of the LEB128 encoding of a 64-bit value
+
+/**
+ * @class CompactOutputArchive
+ * @brief Output archive writing integers as LEB128 varints.
+ * @details Unsigned integers (container sizes, counts, request ids) take one byte below 128,
+ * signed ones (points, scores, enums through their underlying type) are zigzag encoded first so
+ * small negative values stay small. Single bytes, bools and floating point values are written as
+ * is, as are strings and other binary data.
+ */
+class CompactOutputArchive : public OutputArchive<CompactOutputArchive, AllowEmptyClassElision> {
+public:
+    explicit CompactOutputArchive(std::ostream& stream)
+        : OutputArchive<CompactOutputArchive, AllowEmptyClassElision>(this), stream(stream) {}
+
+    /**
+     * @brief Write size bytes as they are.
+     * @throws cereal::Exception if the stream does not take them all.
+     */
+    void saveBinary(const void* data, std::streamsize size) {
+        auto writtenSize = stream.rdbuf()->sputn(static_cast<const char*>(data), size);
+        if (writtenSize != size)
+            throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " +
+                std::to_string(writtenSize));
+    }
+
+    /**
+     * @brief Write value 7 bits at a time, low bits first, the high bit telling whether more follow.
+     */
+    void saveVarint(std::uint64_t value) {
+        char buffer[MAX_VARINT_SIZE];
+        std::streamsize size = 0;
+        while (value >= 0x80) {
+            buffer[size++] = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        buffer[size++] = static_cast<char>(value);
+        saveBinary(buffer, size);
+    }
+
+private:
+    std::ostream& stream;
+};
+
+/**
+ * @class CompactInputArchive
+ * @brief Input archive reading what CompactOutputArchive writes.
+ * @details Input comes from the network: truncated or overlong varints, values that do not fit
+ * the field they are read into and bools other than 0 or 1 are rejected rather than wrapped.
+ */
+class CompactInputArchive : public InputArchive<CompactInputArchive, AllowEmptyClassElision> {
+public:
+    explicit CompactInputArchive(std::istream& stream)
+        : InputArchive<CompactInputArchive, AllowEmptyClassElision>(this), stream(stream) {}
+
+    /**
+     * @brief Read size bytes as they are.
+     * @throws cereal::Exception if the stream ends first.
+     */
+    void loadBinary(void* const data, std::streamsize size) {
+        auto readSize = stream.rdbuf()->sgetn(static_cast<char*>(data), size);
+        if (readSize != size)
+            throw Exception("Failed to read " + std::to_string(size) + " bytes from input stream! Read " +
+                std::to_string(readSize));
+    }
+
+    /**
+     * @brief Read a varint written by CompactOutputArchive::saveVarint.
+     * @throws cereal::Exception if the stream ends inside it or it does not fit 64 bits.
+     */
+    std::uint64_t loadVarint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            auto byte = stream.rdbuf()->sbumpc();
+            if (byte == std::char_traits<char>::eof())
+                throw Exception("Truncated varint");
+            // The tenth byte only has room for the top bit
+            if (shift == 63 && (byte & 0x7E))
+                throw Exception("Varint exceeds 64 bits");
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        throw Exception("Varint longer than " + std::to_string(MAX_VARINT_SIZE) + " bytes");
+    }
+
+private:
+    std::istream& stream;
+};
+
+namespace compact_detail {
+    // Integers wider than a byte go through varints; bytes, bools and floats are copied
+    template <class T>
+    constexpr bool isVarint = std::is_integral_v<T> && sizeof(T) > 1;
+
+    constexpr std::uint64_t zigzagEncode(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+    constexpr std::int64_t zigzagDecode(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+}
+
+//! Saving for arithmetic types to the compact archive
+template <class T> inline
+typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_SAVE_FUNCTION_NAME(CompactOutputArchive& ar, T const& t) {
+    if constexpr (!compact_detail::isVarint<T>)
+        ar.saveBinary(std::addressof(t), sizeof(t));
+    else if constexpr (std::is_unsigned_v<T>)
+        ar.saveVarint(static_cast<std::uint64_t>(t));
+    else
+        ar.saveVarint(compact_detail::zigzagEncode(static_cast<std::int64_t>(t)));
+}
+
+//! Loading for arithmetic types from the compact archive
+template <class T> inline
+typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_LOAD_FUNCTION_NAME(CompactInputArchive& ar, T& t) {
+    if constexpr (std::is_same_v<T, bool>) {
+        // Any other byte would not be a valid bool
+        std::uint8_t value = 0;
+        ar.loadBinary(&value, 1);
+        if (value > 1)
+            throw Exception("Invalid bool " + std::to_string(value));
+        t = value != 0;
+    } else if constexpr (!compact_detail::isVarint<T>) {
+        ar.loadBinary(std::addressof(t), sizeof(t));
+    } else if constexpr (std::is_unsigned_v<T>) {
+        std::uint64_t value = ar.loadVarint();
+        if (value > std::numeric_limits<T>::max())
+            throw Exception("Varint " + std::to_string(value) + " out of range");
+        t = static_cast<T>(value);
+    } else {
+        std::int64_t value = compact_detail::zigzagDecode(ar.loadVarint());
+        if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+            throw Exception("Varint " + std::to_string(value) + " out of range");
+        t = static_cast<T>(value);
+    }
+}
+
+//! Serializing NVP types to the compact archive: the name is dropped, as in the binary archive
+template <class Archive, class T> inline
+CEREAL_ARCHIVE_RESTRICT(CompactInputArchive, CompactOutputArchive)
+CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, NameValuePair<T>& t) {
+    ar(t.value);
+}
+
+//! Serializing SizeTags to the compact archive: the size is a varint like any unsigned integer
+template <class Archive, class T> inline
+CEREAL_ARCHIVE_RESTRICT(CompactInputArchive, CompactOutputArchive)
+CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, SizeTag<T>& t) {
+    ar(t.size);
+}
+
+//! Saving binary data (strings, vectors of arithmetic types) as is
+template <class T> inline
+void CEREAL_SAVE_FUNCTION_NAME(CompactOutputArchive& ar, BinaryData<T> const& bd) {
+    ar.saveBinary(bd.data, static_cast<std::streamsize>(bd.size));
+}
+
+//! Loading binary data as is
+template <class T> inline
+void CEREAL_LOAD_FUNCTION_NAME(CompactInputArchive& ar, BinaryData<T>& bd) {
+    ar.loadBinary(bd.data, static_cast<std::streamsize>(bd.size));
+}
+
+} // namespace cereal
+
+CEREAL_REGISTER_ARCHIVE(cereal::CompactOutputArchive)
+CEREAL_REGISTER_ARCHIVE(cereal::CompactInputArchive)
+CEREAL_SETUP_ARCHIVE_TRAITS(cereal::CompactInputArchive, cereal::CompactOutputArchive)
+
+#endif // COMPACT_ARCHIVE_HPP
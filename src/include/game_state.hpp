@@ -2,11 +2,15 @@
 #define GAME_STATE_HPP
 
 #include <string>
+#include <cstdint>
 #include "cereal/cereal.hpp"
 #include "cereal/archives/binary.hpp"
 #include "player_public_info.hpp"
-#include "player.hpp"           // Includes Hand, Card
+#include "hand.hpp"             // Includes Card
 #include "team_round_state.hpp" // Includes Meld, ScoreBreakdown
+#include "team_melds_info.hpp"  // Wire form of the team melds
+#include "action_message.hpp"   // Code of the last action
+#include "bounded_serialization.hpp"
 #include "client_deck.hpp"      // Public view of deck/discard state
 #include "score_details.hpp"     // For ScoreBreakdown
 #include <vector>
@@ -18,6 +22,9 @@
 static constexpr int TWO_PLAYERS_GAME = 2; ///< Number of players in a two-player game
 static constexpr int FOUR_PLAYERS_GAME = 4; ///< Number of players in a four-player game
 
+using RequestId = std::uint32_t; ///< Id a client gives to a request, echoed in the reply
+static constexpr RequestId NO_REQUEST_ID = 0; ///< Id of messages that do not answer a request
+
 /**
  * @enum ClientGameOutcome
  * @brief Enum representing the outcome of the game for the client.
@@ -46,7 +53,10 @@ enum class TurnActionStatus {
 /**
  * @class ClientGameState
  * @brief Class representing the game state visible to a client.
- * @details This class is used to send game state information to clients.
+ * @details This class is used to send game state information to clients. It holds the hand and
+ * the team states the client works with, but only what the player may see goes on the wire:
+ * the cards of the hand and the melds as TeamMeldsInfo, without the backups the server keeps
+ * to revert a pile take.
  */
 class ClientGameState {
 private:
@@ -57,9 +67,9 @@ private:
      */
     ClientDeck deckState;
     /**
-     * @brief The player's data, full Player object (including Hand).
+     * @brief The player's hand; only its cards are sent.
      */
-    Player myPlayerData;
+    Hand myHand;
 
     /**
      * @brief Public information about all players in the game.
@@ -68,11 +78,11 @@ private:
 
     // Team States (Round Specific)
     /**
-     * @brief The full round state for the player's team.
+     * @brief The round state for the player's team, sent as TeamMeldsInfo.
      */
     TeamRoundState myTeamState;
     /**
-     * @brief The full round state for the opponent's team.
+     * @brief The round state for the opponent's team, sent as TeamMeldsInfo.
      */
     TeamRoundState opponentTeamState;
 
@@ -89,8 +99,9 @@ private:
     std::optional<ClientGameOutcome> gameOutcome; ///< Outcome of the game (only if game is over)
 
     // Context
-    std::string lastActionDescription; ///< Description of the last successful action
+    ActionMessage lastAction; ///< Code and arguments of the last successful action
     std::optional<TurnActionStatus> status; ///< Status of the last action (if applicable)
+    RequestId requestId = NO_REQUEST_ID; ///< Request this state answers (only for the player who sent it)
 
 public:
     /**
@@ -100,7 +111,7 @@ public:
 
     // Setters
     void setDeckState(const ClientDeck& deck) { deckState = deck; }
-    void setMyPlayerData(const Player& player) { myPlayerData = player; }
+    void setMyHand(const Hand& hand) { myHand = hand; }
     void setAllPlayersPublicInfo(const std::vector<PlayerPublicInfo>& players) { allPlayersPublicInfo = players; }
     void setMyTeamState(const TeamRoundState& teamState) { myTeamState = teamState.clone(); }
     void setOpponentTeamState(const TeamRoundState& teamState) { opponentTeamState = teamState.clone(); }
@@ -111,12 +122,13 @@ public:
     void setOpponentTeamScoreBreakdown(const ScoreBreakdown& breakdown) { opponentTeamScoreBreakdown = breakdown; }
     void setIsGameOver(bool gameOver) { isGameOver = gameOver; }
     void setGameOutcome(ClientGameOutcome outcome) { gameOutcome = outcome; }
-    void setLastActionDescription(const std::string& description) { lastActionDescription = description; }
+    void setLastAction(const ActionMessage& action) { lastAction = action; }
     void setStatus(std::optional<TurnActionStatus> actionStatus) { status = actionStatus; }
+    void setRequestId(RequestId id) { requestId = id; }
 
     // Getters
     const ClientDeck& getDeckState() const { return deckState; }
-    const Player& getMyPlayerData() const { return myPlayerData; }
+    const Hand& getMyHand() const { return myHand; }
     const std::vector<PlayerPublicInfo>& getAllPlayersPublicInfo() const { return allPlayersPublicInfo; }
     const TeamRoundState& getMyTeamState() const { return myTeamState; }
     const TeamRoundState& getOpponentTeamState() const { return opponentTeamState; }
@@ -127,22 +139,49 @@ public:
     const std::optional<ScoreBreakdown>& getOpponentTeamScoreBreakdown() const { return opponentTeamScoreBreakdown; }
     bool getIsGameOver() const { return isGameOver; }
     const std::optional<ClientGameOutcome>& getGameOutcome() const { return gameOutcome; }
-    const std::string& getLastActionDescription() const { return lastActionDescription; }
+    const ActionMessage& getLastAction() const { return lastAction; }
     const std::optional<TurnActionStatus>& getStatus() const { return status; }
+    RequestId getRequestId() const { return requestId; }
 
     /**
      * @brief Serialize the ClientGameState object using Cereal.
      */
     template <class Archive>
-    void serialize(Archive& ar) {
-        ar(CEREAL_NVP(deckState), CEREAL_NVP(myPlayerData),
-            CEREAL_NVP(allPlayersPublicInfo), 
-            CEREAL_NVP(myTeamState), CEREAL_NVP(opponentTeamState),
+    void save(Archive& ar) const {
+        std::vector<Card> myHandCards(myHand.getCards().begin(), myHand.getCards().end());
+        TeamMeldsInfo myTeamMelds(myTeamState);
+        TeamMeldsInfo opponentTeamMelds(opponentTeamState);
+        ar(CEREAL_NVP(deckState), CEREAL_NVP(myHandCards),
+            CEREAL_NVP(allPlayersPublicInfo), CEREAL_NVP(myTeamMelds), CEREAL_NVP(opponentTeamMelds),
+            CEREAL_NVP(myTeamTotalScore), CEREAL_NVP(opponentTeamTotalScore),
+            CEREAL_NVP(isRoundOver),
+            CEREAL_NVP(myTeamScoreBreakdown), CEREAL_NVP(opponentTeamScoreBreakdown),
+            CEREAL_NVP(isGameOver), CEREAL_NVP(gameOutcome),
+            CEREAL_NVP(lastAction), CEREAL_NVP(requestId));
+    }
+    /**
+     * @brief Deserialize the ClientGameState object, rebuilding the hand and the team states.
+     * @throws cereal::Exception if the melds break the rules.
+     */
+    template <class Archive>
+    void load(Archive& ar) {
+        std::vector<Card> myHandCards;
+        TeamMeldsInfo myTeamMelds;
+        TeamMeldsInfo opponentTeamMelds;
+        ar(CEREAL_NVP(deckState));
+        loadBoundedVector(ar, myHandCards, MAX_DECODED_CARDS);
+        ar(CEREAL_NVP(allPlayersPublicInfo), CEREAL_NVP(myTeamMelds), CEREAL_NVP(opponentTeamMelds),
             CEREAL_NVP(myTeamTotalScore), CEREAL_NVP(opponentTeamTotalScore),
             CEREAL_NVP(isRoundOver),
             CEREAL_NVP(myTeamScoreBreakdown), CEREAL_NVP(opponentTeamScoreBreakdown),
             CEREAL_NVP(isGameOver), CEREAL_NVP(gameOutcome),
-            CEREAL_NVP(lastActionDescription));
+            CEREAL_NVP(lastAction), CEREAL_NVP(requestId));
+        myHand.reset();
+        myHand.addCards(myHandCards);
+        if (auto status = myTeamMelds.restore(myTeamState); !status)
+            throw cereal::Exception("Invalid team melds: " + status.error());
+        if (auto status = opponentTeamMelds.restore(opponentTeamState); !status)
+            throw cereal::Exception("Invalid opponent team melds: " + status.error());
     }
 };
 
@@ -7,6 +7,7 @@
 #include <cereal/types/deque.hpp> // Include for vector serialization
 #include <algorithm> // Needed for std::lower_bound, std::find
 #include "card.hpp" // Assuming card.hpp defines the Card class
+#include "zobrist.hpp"
 
 /**
  * @class Hand
@@ -77,12 +78,20 @@ public:
      */
     int calculatePenalty() const;
 
+    /**
+     * @brief Gets the Zobrist hash of the cards in the hand, kept up to date as cards are added and removed.
+     * @details Equal for hands holding the same cards, whatever the order they were added in.
+     */
+    std::uint64_t getHash() const { return cardsHash.value(); }
+
     /**
      * * @brief Serialize the Hand using Cereal.
      */
     template <class Archive>
     void serialize(Archive& ar) {
         ar(CEREAL_NVP(cards), CEREAL_NVP(backupCards), CEREAL_NVP(hasPendingReversible)); // Serialize the cards vector
+        if constexpr (Archive::is_loading::value)
+            cardsHash = CardMultisetHash(cards); // The hash is not sent
     }
 
 private:
@@ -94,6 +103,7 @@ private:
     std::deque<Card> cards; // Stores cards, kept sorted by Card::operator<
     std::deque<Card> backupCards; // Backup for undo/redo operations
     bool hasPendingReversible = false; // Whether there is a pending reversible action
+    CardMultisetHash cardsHash; // Zobrist hash of cards
 };
 
 #endif // HAND_HPP
\ No newline at end of file
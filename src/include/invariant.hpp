@@ -0,0 +1,59 @@
+#ifndef INVARIANT_HPP
+#define INVARIANT_HPP
+
+#include <cstdlib>
+#include <source_location>
+#include "spdlog/spdlog.h"
+
+// --- Invariant modes, chosen at build time with CANASTA_INVARIANTS ---
+#define CANASTA_INVARIANTS_OFF   0 ///< No check is compiled in
+#define CANASTA_INVARIANTS_CHEAP 1 ///< O(1) checks only, for optimized builds
+#define CANASTA_INVARIANTS_FULL  2 ///< Every check, including the ones that scan a container
+
+#ifndef CANASTA_INVARIANTS
+    #ifdef NDEBUG
+        #define CANASTA_INVARIANTS CANASTA_INVARIANTS_CHEAP
+    #else
+        #define CANASTA_INVARIANTS CANASTA_INVARIANTS_FULL
+    #endif
+#endif
+
+/**
+ * @brief Logs a broken invariant and aborts; called by the CANASTA_INVARIANT macros only.
+ */
+[[noreturn]] inline void invariantViolated(const char* condition, const char* message,
+    std::source_location location = std::source_location::current()) {
+    spdlog::critical("Invariant violated at {}:{} ({}): {} [{}]",
+        location.file_name(), location.line(), location.function_name(), message, condition);
+    spdlog::shutdown();
+    std::abort();
+}
+
+/**
+ * @def CANASTA_INVARIANT(condition, message)
+ * @brief Checks an O(1) invariant unless the checks are off.
+ * @details The condition must have no side effects: with the checks off it is not evaluated at all,
+ * only type-checked. Work the program needs goes before the check, into a variable.
+ */
+/**
+ * @def CANASTA_INVARIANT_FULL(condition, message)
+ * @brief Checks a costly invariant (a scan, a recount) in full mode only; same rules as CANASTA_INVARIANT.
+ */
+#define CANASTA_INVARIANT_CHECK(condition, message) \
+    ((condition) ? void(0) : invariantViolated(#condition, message))
+#define CANASTA_INVARIANT_SKIP(condition, message) \
+    ((void)sizeof(!(condition)))
+
+#if CANASTA_INVARIANTS >= CANASTA_INVARIANTS_CHEAP
+    #define CANASTA_INVARIANT(condition, message) CANASTA_INVARIANT_CHECK(condition, message)
+#else
+    #define CANASTA_INVARIANT(condition, message) CANASTA_INVARIANT_SKIP(condition, message)
+#endif
+
+#if CANASTA_INVARIANTS >= CANASTA_INVARIANTS_FULL
+    #define CANASTA_INVARIANT_FULL(condition, message) CANASTA_INVARIANT_CHECK(condition, message)
+#else
+    #define CANASTA_INVARIANT_FULL(condition, message) CANASTA_INVARIANT_SKIP(condition, message)
+#endif
+
+#endif // INVARIANT_HPP
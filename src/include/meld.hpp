@@ -4,14 +4,17 @@
 #define MELD_HPP
 
 #include "card.hpp"
+#include "zobrist.hpp"
+#include "bounded_serialization.hpp"
 #include <expected>
 #include <vector>
 #include <cereal/types/vector.hpp>
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/memory.hpp>
 #include <cereal/access.hpp>
-#include <cassert>
+#include "invariant.hpp"
 #include <optional>
+#include <span>
 #include "spdlog/spdlog.h"
 
 
@@ -47,6 +50,71 @@ constexpr int MIXED_CANASTA_BONUS = 300;
 constexpr std::size_t MIN_MELD_SIZE = 3; // Minimum size for a meld
 constexpr std::size_t MAX_SPECIAL_MELD_SIZE = 4; // Maximum size for a special meld (Red Three, Black Three)
 
+/**
+ * @brief Gets the canasta bonus of a rank meld with the given card counts, 0 if it is not a canasta.
+ */
+constexpr int canastaBonus(std::size_t naturalCount, std::size_t wildCount) {
+    if (naturalCount + wildCount < MIN_CANASTA_SIZE)
+        return 0;
+    return wildCount == 0 ? NATURAL_CANASTA_BONUS : MIXED_CANASTA_BONUS;
+}
+
+class BaseMeld;
+
+/**
+ * @class MeldProof
+ * @brief Token that cards passed the checks of one meld, returned by checkInitialization and checkCardsAddition.
+ * @details Carries what the check computed, so initialize and addCards apply the cards without checking them
+ * again. Only melds issue proofs, and a proof holds only for the meld that issued it while that meld is unchanged,
+ * and for the very cards it checked: the same span, not an equal copy, so holding costs no pass over the cards.
+ * The checked cards must stay alive and unchanged until they are applied.
+ */
+class MeldProof {
+public:
+    /**
+     * @brief Gets the number of non-wild cards the meld will hold once the cards are in.
+     */
+    std::size_t getNaturalCount() const { return naturalCount; }
+    /**
+     * @brief Gets the number of wild cards the meld will hold once the cards are in.
+     */
+    std::size_t getWildCount() const { return wildCount; }
+    /**
+     * @brief Gets the points the meld will have once the cards are in, canasta bonus included.
+     */
+    int getPoints() const { return points; }
+    /**
+     * @brief Gets the cards the proof was issued for.
+     */
+    std::span<const Card> getCards() const { return {cards, cardCount}; }
+    /**
+     * @brief Checks whether the proof was issued by the meld, as it is now, for this span of cards.
+     */
+    bool holdsFor(const BaseMeld& meld, std::span<const Card> cards) const;
+
+private:
+    friend class BaseMeld;
+
+    MeldProof(const BaseMeld* meld, std::uint64_t meldHash, std::span<const Card> cards,
+        std::size_t naturalCount, std::size_t wildCount, int points)
+        : meld(meld), meldHash(meldHash), cards(cards.data()), cardCount(static_cast<std::uint32_t>(cards.size())),
+          naturalCount(static_cast<std::uint16_t>(naturalCount)), wildCount(static_cast<std::uint16_t>(wildCount)),
+          points(points) {}
+
+    const BaseMeld* meld;     ///< The meld that issued the proof
+    std::uint64_t meldHash;   ///< Hash of the meld when the cards were checked
+    const Card* cards;        ///< The checked cards
+    std::uint32_t cardCount;  ///< Number of checked cards
+    std::uint16_t naturalCount;
+    std::uint16_t wildCount;
+    int points;
+};
+
+/**
+ * @brief Result of a meld check: a proof to apply the cards with, or the reason they do not fit.
+ */
+using MeldCheck = std::expected<MeldProof, std::string>;
+
 /**
  * @class BaseMeld
  * @brief Abstract base class for melds in the game.
@@ -65,6 +133,10 @@ protected:
      * @brief Indicates whether there is a pending reversible action of adding cards.
      */
     bool hasPendingReversible;
+    /**
+     * @brief Zobrist hash of the cards in the meld.
+     */
+    CardMultisetHash cardsHash;
 public:
     /**
      * @brief Default constructor for BaseMeld.
@@ -73,31 +145,45 @@ public:
     virtual ~BaseMeld() = default;
 
     /**
-     * @brief Checks if the meld is initialized.
+     * @brief Checks if the meld can be initialized with the cards.
      * @param cards The cards to check for initialization.
+     * @return A proof to pass to initialize, or the reason the cards do not fit.
      * @details This method should be called before initializing the meld.
      */
-    virtual Status checkInitialization(const std::vector<Card>& cards) const = 0;
+    virtual MeldCheck checkInitialization(const std::vector<Card>& cards) const = 0;
     /**
-     * @brief Initializes the meld with the given cards.
-     * @param cards The cards to initialize the meld with.
+     * @brief Initializes the meld with cards that passed checkInitialization, without checking them again.
+     * @param cards The cards to initialize the meld with, the ones checkInitialization was given.
+     * @param proof The proof checkInitialization returned for these cards.
      * @details This method should be called only once to set up the meld.
-     *  It asserts if initialization check fails.
      */
-    virtual void initialize(const std::vector<Card>& cards) = 0;
+    virtual void initialize(std::span<const Card> cards, const MeldProof& proof) = 0;
+    /**
+     * @brief Checks the cards, then initializes the meld with them.
+     * @throws std::logic_error if the initialization check fails.
+     */
+    void initialize(const std::vector<Card>& cards);
     /**
      * @brief Checks if the cards can be added to the meld.
      * @param cards The cards to check for addition.
+     * @return A proof to pass to addCards, or the reason the cards do not fit.
      * @details This method should be called before adding cards to ensure validity.
      */
-    virtual Status checkCardsAddition(const std::vector<Card>& cards) const = 0;
+    virtual MeldCheck checkCardsAddition(const std::vector<Card>& cards) const = 0;
     /**
-     * @brief Adds cards to the meld.
+     * @brief Adds cards that passed checkCardsAddition to the meld, without checking them again.
+     * @param cards The cards to add to the meld, the ones checkCardsAddition was given.
+     * @param proof The proof checkCardsAddition returned for these cards.
+     * @param reversible Indicates if the addition is reversible.
+     */
+    virtual void addCards(std::span<const Card> cards, const MeldProof& proof, bool reversible = false) = 0;
+    /**
+     * @brief Checks the cards, then adds them to the meld.
      * @param cards The cards to add to the meld.
      * @param reversible Indicates if the addition is reversible.
-     * @details This method should be called after a successful checkCardsAddition.
+     * @throws std::logic_error if the addition check fails.
      */
-    virtual void addCards(const std::vector<Card>& cards, bool reversible = false) = 0;
+    void addCards(const std::vector<Card>& cards, bool reversible = false);
     /**
      * @brief Gets the points of the meld.
      * @return The cached points value.
@@ -115,6 +201,12 @@ public:
      */
     bool isInitialized() const { return isActive; }
 
+    /**
+     * @brief Gets the Zobrist hash of the cards in the meld, kept up to date as cards are added.
+     * @return The hash, 0 for an empty meld.
+     */
+    std::uint64_t getHash() const { return cardsHash.value(); }
+
     /**
      * @brief Checks if the meld is a canasta.
      * @details Default: Not a canasta.
@@ -143,6 +235,15 @@ public:
      * @details This method should be called to retrieve the current cards in the meld.
      */
     virtual std::vector<Card> getCards() const = 0;
+    /**
+     * @brief Gets a read-only view of the wild cards in the meld, without copying them.
+     * @details Melds of threes hold no wild cards.
+     */
+    virtual std::span<const Card> getWildCardsView() const { return {}; }
+    /**
+     * @brief Gets a read-only view of the non-wild cards in the meld, without copying them.
+     */
+    virtual std::span<const Card> getNaturalCardsView() const = 0;
     /**
      * @brief Clones the meld object.
      * @return A unique pointer to a new instance of the meld.
@@ -160,8 +261,32 @@ public:
         // Removed updatePoints() call - assume points are updated when state changes
         archive(CEREAL_NVP(isActive), CEREAL_NVP(points), CEREAL_NVP(hasPendingReversible));
     }
+
+protected:
+    /**
+     * @brief Issues a proof for cards that passed the checks of this meld.
+     * @param cards The checked cards.
+     * @param naturalCount The number of non-wild cards in the meld once the cards are in.
+     * @param wildCount The number of wild cards in the meld once the cards are in.
+     * @param points The points of the meld once the cards are in.
+     */
+    MeldProof prove(std::span<const Card> cards, std::size_t naturalCount, std::size_t wildCount, int points) const {
+        return MeldProof(this, getHash(), cards, naturalCount, wildCount, points);
+    }
+
+    /**
+     * @brief Throws unless the proof holds for this meld and the cards about to be applied with it.
+     * @details Checked in every build: a proof lets the cards skip the rules, so it must not cover other cards.
+     * @throws std::logic_error if the proof does not hold.
+     */
+    void requireProof(const MeldProof& proof, std::span<const Card> cards) const;
 };
 
+inline bool MeldProof::holdsFor(const BaseMeld& meld, std::span<const Card> cards) const {
+    return this->meld == &meld && meldHash == meld.getHash() && this->cards == cards.data() &&
+        cardCount == cards.size();
+}
+
 /**
  * * @class Meld
  * * @brief Templated class for ranked melds (Ranks Four → Ace).
@@ -180,10 +305,12 @@ private:
 public:
     Meld() : isCanasta(false) {}
 
-    Status checkInitialization(const std::vector<Card>& cards) const override;
-    void initialize(const std::vector<Card>& cards) override;
-    Status checkCardsAddition(const std::vector<Card>& cards) const override;
-    void addCards(const std::vector<Card>& cards, bool reversible) override;
+    using BaseMeld::initialize;
+    using BaseMeld::addCards;
+    MeldCheck checkInitialization(const std::vector<Card>& cards) const override;
+    void initialize(std::span<const Card> cards, const MeldProof& proof) override;
+    MeldCheck checkCardsAddition(const std::vector<Card>& cards) const override;
+    void addCards(std::span<const Card> cards, const MeldProof& proof, bool reversible) override;
     int getPoints() const override;
     void updatePoints() override;
     bool isCanastaMeld() const override { return isCanasta; }
@@ -194,6 +321,8 @@ public:
     void revertAddCards() override;
 
     std::vector<Card> getCards() const override;
+    std::span<const Card> getWildCardsView() const override { return wildCards; }
+    std::span<const Card> getNaturalCardsView() const override { return naturalCards; }
     std::unique_ptr<BaseMeld> clone() const override;
 
     template <class Archive>
@@ -201,6 +330,8 @@ public:
         archive(cereal::base_class<BaseMeld>(this), CEREAL_NVP(isCanasta),
         CEREAL_NVP(naturalCards), CEREAL_NVP(wildCards), CEREAL_NVP(backupNaturalCards),
         CEREAL_NVP(backupWildCards));
+        if constexpr (Archive::is_loading::value)
+            cardsHash = CardMultisetHash(getCards()); // The hash is not sent
     }
 private:
     /**
@@ -208,13 +339,15 @@ private:
      */
     void updateCanastaStatus();
     /**
-     * @brief Validates the cards for the meld.
+     * @brief Validates the cards for the meld, on top of the cards it holds.
      * @param cards The cards to validate.
-     * @param naturalCardCount The count of natural cards in the meld.
-     * @param wildCardCount The count of wild cards in the meld.
+     * @return A proof with the counts and points of the meld once the cards are in.
      */
-    Status validateCards(const std::vector<Card>& cards,
-        std::size_t naturalCardCount = 0, std::size_t wildCardCount = 0) const;
+    MeldCheck validateCards(const std::vector<Card>& cards) const;
+    /**
+     * @brief Adds the cards to the natural and wild lists and the hash.
+     */
+    void appendCards(std::span<const Card> cards);
 };
 
 /**
@@ -228,10 +361,12 @@ private:
 
 public:
 
-    Status checkInitialization(const std::vector<Card>& cards) const override;
-    void initialize(const std::vector<Card>& cards) override;
-    Status checkCardsAddition(const std::vector<Card>& cards) const override;
-    void addCards(const std::vector<Card>& cards, bool reversible) override;
+    using BaseMeld::initialize;
+    using BaseMeld::addCards;
+    MeldCheck checkInitialization(const std::vector<Card>& cards) const override;
+    void initialize(std::span<const Card> cards, const MeldProof& proof) override;
+    MeldCheck checkCardsAddition(const std::vector<Card>& cards) const override;
+    void addCards(std::span<const Card> cards, const MeldProof& proof, bool reversible) override;
     int getPoints() const override;
     void updatePoints() override;
 
@@ -239,20 +374,23 @@ public:
     void revertAddCards() override;
 
     std::vector<Card> getCards() const override;
+    std::span<const Card> getNaturalCardsView() const override { return redThreeCards; }
     std::unique_ptr<BaseMeld> clone() const override;
 
     template <class Archive>
     void serialize(Archive& archive) {
         archive(cereal::base_class<BaseMeld>(this), CEREAL_NVP(redThreeCards),
         CEREAL_NVP(backupRedThreeCards));
+        if constexpr (Archive::is_loading::value)
+            cardsHash = CardMultisetHash(redThreeCards); // The hash is not sent
     }
 private:
     /**
-     * @brief Validates the cards for the meld.
+     * @brief Validates the cards for the meld, on top of the cards it holds.
      * @param cards The cards to validate.
-     * @param redThreeCount The count of red three cards in the meld.
+     * @return A proof with the count and points of the meld once the cards are in.
      */
-    Status validateCards(const std::vector<Card>& cards, std::size_t redThreeCount = 0) const;
+    MeldCheck validateCards(const std::vector<Card>& cards) const;
 };
 
 /**
@@ -264,18 +402,20 @@ private:
     std::vector<Card> blackThreeCards;
 
 public:
-    Status checkInitialization(const std::vector<Card>& cards) const override;
-    void initialize(const std::vector<Card>& cards) override;
+    using BaseMeld::initialize;
+    using BaseMeld::addCards;
+    MeldCheck checkInitialization(const std::vector<Card>& cards) const override;
+    void initialize(std::span<const Card> cards, const MeldProof& proof) override;
     /**
      * @brief BlackThreeMeld does not support adding cards.
-     * @details This method will throw an exception if called.
+     * @details This method always returns an error.
      */
-    Status checkCardsAddition(const std::vector<Card>& cards) const override;
+    MeldCheck checkCardsAddition(const std::vector<Card>& cards) const override;
     /**
      * @brief BlackThreeMeld does not support adding cards.
      * @details This method will throw an exception if called.
      */
-    void addCards(const std::vector<Card>& cards, bool reversible) override;
+    void addCards(std::span<const Card> cards, const MeldProof& proof, bool reversible) override;
     int getPoints() const override;
     void updatePoints() override;
 
@@ -287,11 +427,14 @@ public:
     void revertAddCards() override;
 
     std::vector<Card> getCards() const override;
+    std::span<const Card> getNaturalCardsView() const override { return blackThreeCards; }
     std::unique_ptr<BaseMeld> clone() const override;
 
     template <class Archive>
     void serialize(Archive& archive) {
         archive(cereal::base_class<BaseMeld>(this), CEREAL_NVP(blackThreeCards));
+        if constexpr (Archive::is_loading::value)
+            cardsHash = CardMultisetHash(blackThreeCards); // The hash is not sent
     }
 };
 
@@ -351,39 +494,40 @@ public:
                     std::make_move_iterator(more.begin()),
                     std::make_move_iterator(more.end()));
     }
-    // Add Cereal serialize method
+    // Cereal save/load methods
     template <class Archive>
-    void serialize(Archive& ar) {
-        // Need to serialize Rank enum as underlying type (e.g., int)
-        // Assuming Rank has a Cereal serialization function defined elsewhere
+    void save(Archive& ar) const {
         ar(CEREAL_NVP(cards), CEREAL_NVP(addToRank));
     }
+    // Requests come from clients: the card count and the rank are checked while loading
+    template <class Archive>
+    void load(Archive& ar) {
+        loadBoundedVector(ar, cards, MAX_DECODED_CARDS);
+        ar(CEREAL_NVP(addToRank));
+        if (addToRank.has_value() && !isValidRank(addToRank.value()))
+            throw cereal::Exception("Invalid meld request rank");
+    }
 };
 
 
 // Implementation of Meld<R>::initialize
 template <Rank R>
-void Meld<R>::initialize(const std::vector<Card>& cards) {
-    Status status = checkInitialization(cards);
-    assert(status.has_value() && "Meld initialization failed");
-    for (const auto& card : cards) {
-        if (card.getType() == CardType::Wild) {
-            wildCards.push_back(card);
-        } else {
-            naturalCards.push_back(card);
-        }
-    }
+void Meld<R>::initialize(std::span<const Card> cards, const MeldProof& proof) {
+    requireProof(proof, cards);
+    naturalCards.reserve(proof.getNaturalCount());
+    wildCards.reserve(proof.getWildCount());
+    appendCards(cards);
     isActive = true;
     updateCanastaStatus();
-    updatePoints(); // Update points after initialization
+    points = proof.getPoints(); // Computed by the check
 }
 
 // Implementation of Meld<R>::validateCards
 template <Rank R>
-Status Meld<R>::validateCards(const std::vector<Card>& cards,
-    std::size_t naturalCardCount, std::size_t wildCardCount) const {
-    std::size_t naturalCount = naturalCardCount;
-    std::size_t wildCount    = wildCardCount;    
+MeldCheck Meld<R>::validateCards(const std::vector<Card>& cards) const {
+    std::size_t naturalCount = naturalCards.size();
+    std::size_t wildCount    = wildCards.size();
+    int cardPoints = points - canastaBonus(naturalCount, wildCount);
     for (const auto& card : cards) {
         if (card.getType() == CardType::Wild) {
             wildCount++;
@@ -392,16 +536,30 @@ Status Meld<R>::validateCards(const std::vector<Card>& cards,
         } else {
             return std::unexpected("Invalid card " + card.toString() + " for this meld");
         }
+        cardPoints += card.getPoints();
     }
     if (wildCount > naturalCount) {
         return std::unexpected("Too many wild cards for this meld");
     }
-    return {};
+    return prove(cards, naturalCount, wildCount, cardPoints + canastaBonus(naturalCount, wildCount));
+}
+
+// Implementation of Meld<R>::appendCards
+template <Rank R>
+void Meld<R>::appendCards(std::span<const Card> cards) {
+    for (const auto& card : cards) {
+        if (card.getType() == CardType::Wild) {
+            wildCards.push_back(card);
+        } else {
+            naturalCards.push_back(card);
+        }
+        cardsHash.add(card);
+    }
 }
 
 // Implementation of Meld<R>::checkInitialization
 template <Rank R>
-Status Meld<R>::checkInitialization(const std::vector<Card>& cards) const {
+MeldCheck Meld<R>::checkInitialization(const std::vector<Card>& cards) const {
     if (isActive) {
         return std::unexpected("Meld is already initialized");
     }
@@ -413,9 +571,8 @@ Status Meld<R>::checkInitialization(const std::vector<Card>& cards) const {
 
 // Implementation of Meld<R>::addCard
 template <Rank R>
-void Meld<R>::addCards(const std::vector<Card>& cards, bool reversible) {
-    auto status = checkCardsAddition(cards);
-    assert(status.has_value() && "Meld addition failed");
+void Meld<R>::addCards(std::span<const Card> cards, const MeldProof& proof, bool reversible) {
+    requireProof(proof, cards);
 
     if (reversible) {
         backupNaturalCards = naturalCards; // Copy current state
@@ -424,27 +581,21 @@ void Meld<R>::addCards(const std::vector<Card>& cards, bool reversible) {
     } else {
         hasPendingReversible = false; // No reversible action
     }
-    for (const auto& card : cards) {
-        if (card.getType() == CardType::Wild) {
-            wildCards.push_back(card);
-        } else {
-            naturalCards.push_back(card);
-        }
-    }
+    appendCards(cards);
     updateCanastaStatus();
-    updatePoints(); // Update points after adding a card
+    points = proof.getPoints(); // Computed by the check
 }
 
 // Implementation of Meld<R>::checkCardAddition
 template <Rank R>
-Status Meld<R>::checkCardsAddition(const std::vector<Card>& cards) const {
+MeldCheck Meld<R>::checkCardsAddition(const std::vector<Card>& cards) const {
     if (!isActive) {
         return std::unexpected("Meld is not initialized");
     }
     if (cards.empty()) {
         return std::unexpected("You must add at least 1 card");
     }
-    return validateCards(cards, naturalCards.size(), wildCards.size());
+    return validateCards(cards);
 }
 
 // Implementation of Meld<R>::updateCanastaStatus
@@ -528,6 +679,7 @@ void Meld<R>::revertAddCards() {
     }
     naturalCards = backupNaturalCards; // Restore previous state
     wildCards = backupWildCards;       // Restore previous state
+    cardsHash = CardMultisetHash(getCards());
     hasPendingReversible = false;      // Clear the reversible state
     updateCanastaStatus(); // Update canasta status
     updatePoints(); // Update points after reverting
@@ -5,6 +5,10 @@
 #include <asio/error.hpp> // For error codes
 #include <asio/post.hpp> // For asio::post
 #include <cstdint> 
+#include <chrono>
+#include <span>
+#include <stdexcept>
+#include <streambuf>
 #include <vector>
 #include <cereal/archives/binary.hpp>
 #include <cereal/types/string.hpp>
@@ -17,10 +21,13 @@
 #include "card.hpp"
 #include "meld.hpp"
 #include "game_state.hpp"
+#include "compact_archive.hpp"
 
 /**
  * @enum ClientMessageType
  * @brief Enum representing the type of the action sent from the client to the server.
+ * @details Every client message carries a RequestId right after its type; the server echoes it
+ * in the ActionError or the GameStateUpdate answering the request.
  */
 enum class ClientMessageType : uint8_t {
     Login,
@@ -42,48 +49,68 @@ enum class ServerMessageType : uint8_t {
     LoginFailure,
 };
 
+/**
+ * @enum WireFormat
+ * @brief Enum representing the archive the messages following the login are encoded with.
+ * @details The client asks for a format after its name in the Login, the server answers with the one
+ * it picked in the LoginSuccess. A peer that sends nothing there gets Binary, so older clients and
+ * servers keep working. Login messages themselves are always Binary.
+ */
+enum class WireFormat : std::uint8_t {
+    Binary,  ///< cereal::BinaryOutputArchive, fixed-width integers
+    Compact, ///< cereal::CompactOutputArchive, varint integers
+};
+
 constexpr std::size_t MAX_MESSAGE_SIZE = 64 * 1024; // 64 KB
+constexpr std::size_t READ_BUFFER_SIZE = 16 * 1024; // Grows once for larger messages
+constexpr std::chrono::seconds WRITE_TIMEOUT{10}; // Time a peer has to take in the queued messages
 
 /**
  * @class ActionError
  * @brief Class representing an error message sent from the server to the client.
- * @details Contains a message and an optional status code.
+ * @details Contains a message code and an optional status code.
  */
 class ActionError {
 private:
-    std::string     message;
+    ActionMessage   message;
     std::optional<TurnActionStatus> status;
+    RequestId       requestId = NO_REQUEST_ID; ///< Request the error answers
 public:
     ActionError() = default; // Default constructor for serialization
-    ActionError(const std::string& msg, std::optional<TurnActionStatus> stat = std::nullopt)
-        : message(msg), status(stat) {}
+    ActionError(const ActionMessage& msg, std::optional<TurnActionStatus> stat = std::nullopt,
+        RequestId reqId = NO_REQUEST_ID)
+        : message(msg), status(stat), requestId(reqId) {}
 
-    const std::string& getMessage() const { return message; }
+    const ActionMessage& getMessage() const { return message; }
     std::optional<TurnActionStatus> getStatus() const { return status; }
+    RequestId getRequestId() const { return requestId; }
 
     template <class Archive>
     void serialize(Archive& ar) {
-        ar(CEREAL_NVP(message), CEREAL_NVP(status));
+        ar(CEREAL_NVP(message), CEREAL_NVP(status), CEREAL_NVP(requestId));
     }
 };
 
 // Helper function to serialize data with size header
 
 /**
- * @brief Serialize a message of type M with additional data.
+ * @brief Serialize a message of type M followed by its fields with the given archive.
+ * @details Client messages are written as the type, the RequestId and the payload (if any);
+ * server messages as the type and the payload (if any).
+ * @tparam Archive Output archive (cereal::BinaryOutputArchive or cereal::CompactOutputArchive)
  * @tparam M Message type (ClientMessageType or ServerMessageType)
- * @tparam T Data type to serialize
+ * @tparam T Types of the fields to serialize
  * @param msgType Message type
- * @param data Data to serialize
+ * @param data Fields to serialize, in order
  * @return Serialized message as a vector of chars
  */
-template <typename M, typename T> // M = ClientMessageType or ServerMessageType, T = some data type
-std::vector<char> serializeMessage(M msgType, const T& data) {
+template <class Archive, typename M, typename... T> // M = ClientMessageType or ServerMessageType
+std::vector<char> serializeMessageWith(M msgType, const T&... data) {
     std::ostringstream os(std::ios::binary);
     { // Scope for the archive
-        cereal::BinaryOutputArchive archive(os);
+        Archive archive(os);
         archive(msgType); // Write message type first
-        archive(data);    // Write the actual data payload
+        (archive(data), ...); // Write the fields in order
     } // Archive goes out of scope, flushes data to os
 
     std::string serializedData = os.str();
@@ -102,27 +129,145 @@ std::vector<char> serializeMessage(M msgType, const T& data) {
 }
 
 /**
- * @brief Serialize a message of type M without additional data.
- * @tparam M Message type (ClientMessageType or ServerMessageType)
- * @param msgType Message type
- * @return Serialized message as a vector of chars
+ * @brief Serialize a message in the Binary format (logins, and peers that did not negotiate).
  */
-template <typename M>
-std::vector<char> serializeMessage(M msgType) {
-    std::ostringstream os(std::ios::binary);
-    {
-        cereal::BinaryOutputArchive archive(os);
-        archive(msgType);
+template <typename M, typename... T>
+std::vector<char> serializeMessage(M msgType, const T&... data) {
+    return serializeMessageWith<cereal::BinaryOutputArchive>(msgType, data...);
+}
+
+/**
+ * @brief Serialize a message in the format negotiated with the peer.
+ */
+template <typename M, typename... T>
+std::vector<char> serializeMessage(WireFormat format, M msgType, const T&... data) {
+    if (format == WireFormat::Compact)
+        return serializeMessageWith<cereal::CompactOutputArchive>(msgType, data...);
+    return serializeMessageWith<cereal::BinaryOutputArchive>(msgType, data...);
+}
+
+/**
+ * @brief Run decode on an input archive of the given format reading payload.
+ * @param decode Callable taking the archive, generic over its type.
+ */
+template <typename Decode>
+void decodeMessage(WireFormat format, std::istream& payload, Decode&& decode) {
+    if (format == WireFormat::Compact) {
+        cereal::CompactInputArchive archive(payload);
+        decode(archive);
+    } else {
+        cereal::BinaryInputArchive archive(payload);
+        decode(archive);
     }
-    std::string serializedData = os.str();
-    std::uint32_t dataSize = static_cast<std::uint32_t>(serializedData.size());
-    std::uint32_t networkDataSize = asio::detail::socket_ops::host_to_network_long(dataSize);
+}
 
-    std::vector<char> messageBuffer;
-    messageBuffer.resize(sizeof(networkDataSize) + dataSize);
-    std::memcpy(messageBuffer.data(), &networkDataSize, sizeof(networkDataSize));
-    std::memcpy(messageBuffer.data() + sizeof(networkDataSize), serializedData.data(), dataSize);
-    return messageBuffer;
+/**
+ * @class FrameStreamBuffer
+ * @brief Read-only stream buffer over a received message, so archives decode it where it was read.
+ */
+class FrameStreamBuffer : public std::streambuf {
+public:
+    explicit FrameStreamBuffer(std::span<const char> frame) {
+        char* begin = const_cast<char*>(frame.data()); // The get area is never written to
+        setg(begin, begin, begin + frame.size());
+    }
+};
+
+/**
+ * @class FrameReader
+ * @brief Splits the bytes read from a socket into messages (a 4-byte size header and a body).
+ * @details Reads go straight into the free end of the buffer, and every complete message is then
+ * handed out in place, so a read bringing several messages is parsed in one go. A partial message
+ * left at the end is moved to the front before the next read; the buffer grows to fit it if needed.
+ */
+class FrameReader {
+public:
+    explicit FrameReader(std::size_t capacity = READ_BUFFER_SIZE) : buffer(capacity) {}
+
+    /**
+     * @brief Read into a buffer handed over from a reader that is done, grown to READ_BUFFER_SIZE if smaller.
+     */
+    explicit FrameReader(std::vector<char> buffer) : buffer(std::move(buffer)) {
+        if (this->buffer.size() < READ_BUFFER_SIZE)
+            this->buffer.resize(READ_BUFFER_SIZE);
+    }
+
+    /**
+     * @brief Hand the buffer over, for another reader to use; this one is left empty.
+     */
+    std::vector<char> releaseBuffer() {
+        begin = end = 0;
+        return std::move(buffer);
+    }
+
+    /**
+     * @brief Free space for the next read, after moving the partial message to the front.
+     */
+    asio::mutable_buffer prepare() {
+        if (begin > 0) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if (end >= sizeof(std::uint32_t)) {
+            std::size_t frameSize = sizeof(std::uint32_t) + bodySize();
+            if (frameSize > buffer.size())
+                buffer.resize(frameSize); // next() rejected sizes over MAX_MESSAGE_SIZE
+        }
+        return asio::buffer(buffer.data() + end, buffer.size() - end);
+    }
+
+    /**
+     * @brief Account for the bytes read into the space given by prepare().
+     */
+    void commit(std::size_t bytesRead) {
+        end += bytesRead;
+    }
+
+    /**
+     * @brief Whether part of a message is waiting for more bytes.
+     */
+    bool hasPartialMessage() const {
+        return begin != end;
+    }
+
+    /**
+     * @brief Take the next complete message out of the buffer.
+     * @return Its body, valid until the next prepare(); std::nullopt until it is complete.
+     * @throws std::length_error if its header announces more than MAX_MESSAGE_SIZE bytes.
+     */
+    std::optional<std::span<const char>> next() {
+        if (end - begin < sizeof(std::uint32_t))
+            return std::nullopt;
+        std::uint32_t size = bodySize();
+        if (size > MAX_MESSAGE_SIZE)
+            throw std::length_error("Incoming message size too large (" + std::to_string(size) + ")");
+        if (end - begin - sizeof(std::uint32_t) < size)
+            return std::nullopt;
+        std::span<const char> body(buffer.data() + begin + sizeof(std::uint32_t), size);
+        begin += sizeof(std::uint32_t) + size;
+        return body;
+    }
+
+private:
+    // Size in the header at begin, converted from network byte order
+    std::uint32_t bodySize() const {
+        std::uint32_t size;
+        std::memcpy(&size, buffer.data() + begin, sizeof(size));
+        return asio::detail::socket_ops::network_to_host_long(size);
+    }
+
+    std::vector<char> buffer;
+    std::size_t begin = 0; ///< Start of the first message not handed out
+    std::size_t end = 0;   ///< End of the bytes read
+};
+
+/**
+ * @brief Whether a message has bytes left after the fields read so far.
+ * @details Used for the fields added to the login messages, which older peers do not send.
+ */
+inline bool hasMoreFields(std::istream& payload) {
+    return payload.rdbuf()->sgetc() != std::char_traits<char>::eof();
 }
 
 #endif // NETWORK_HPP
\ No newline at end of file
@@ -30,6 +30,8 @@ public:
     std::size_t getHandCardCount() const { return handCardCount; }
     bool isCurrentPlayer() const { return isCurrentTurn; }
 
+    bool operator==(const PlayerPublicInfo& other) const = default;
+
     template <class Archive>
     void serialize(Archive& ar) {
         ar(CEREAL_NVP(name), CEREAL_NVP(handCardCount), CEREAL_NVP(isCurrentTurn));
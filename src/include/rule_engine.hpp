@@ -14,6 +14,7 @@
 #include "meld.hpp"
 #include "game_state.hpp"
 #include "team_round_state.hpp"
+#include "action_message.hpp"
 
 /**
  * @enum CandidateMeldType
@@ -153,10 +154,10 @@ enum class GameOutcome {
 class TurnActionResult {
 private:
     TurnActionStatus status; ///< Status of the action
-    std::string     message; ///< Message describing the result
+    ActionMessage   message; ///< Code and arguments describing the result
 public:
-    TurnActionResult(TurnActionStatus status, const std::string& message)
-        : status(status), message(message) {}
+    TurnActionResult(TurnActionStatus status, ActionMessage message)
+        : status(status), message(std::move(message)) {}
 
     /**
      * @brief Get the status of the action.
@@ -168,7 +169,7 @@ public:
      * @brief Get the message describing the result.
      * @return The message describing the result.
      */
-    const std::string& getMessage() const { return message; }
+    const ActionMessage& getMessage() const { return message; }
 };
 
 /**
@@ -192,26 +193,36 @@ public:
     static constexpr std::size_t EASY_COMMITMENT_COUNT = 1; ///< top card from pile for adding to a meld
 
     /**
-     * @brief Validates the initialization proposals for rank melds.
-     * @returns the total points of the initialized melds if valid, or an error message.
+     * @brief Validates the initialization proposals for rank melds against the melds of the team.
+     * @returns one proof per proposal, in order, if valid, or an error message.
+     * @details Each proposal is checked against the meld as it is, not as the proposals before would leave it.
      */
-    static std::expected<int, std::string> validateRankMeldInitializationProposals(
-        const std::vector<RankMeldProposal>& proposals);
+    static std::expected<std::vector<MeldProof>, std::string> validateRankMeldInitializationProposals(
+        const std::vector<RankMeldProposal>& proposals,
+        const TeamRoundState& teamRoundState);
 
     /**
      * @brief Validates the initialization proposal for a Black Three meld.
+     * @returns the proof to initialize the meld with if valid, or an error message.
      */
-    static Status validateBlackThreeMeldInitializationProposal(
+    static std::expected<MeldProof, std::string> validateBlackThreeMeldInitializationProposal(
         const BlackThreeMeldProposal& blackThreeProposal,
         const TeamRoundState& teamRoundState);
 
     /**
      * @brief Validates the addition proposals for rank melds.
+     * @returns one proof per proposal, in order, if valid, or an error message.
+     * @details Each proposal is checked against the meld as it is, not as the proposals before would leave it.
      */
-    static Status validateRankMeldAdditionProposals(
+    static std::expected<std::vector<MeldProof>, std::string> validateRankMeldAdditionProposals(
         const std::vector<RankMeldProposal>& proposals,
         const TeamRoundState& teamRoundState);
 
+    /**
+     * @brief Calculates the total points the melds will have once the proven cards are in.
+     */
+    static int calculateMeldPoints(const std::vector<MeldProof>& proofs);
+
     /**
      * @brief Validates the initial meld points based on the team's total score.
      * @details Checks if it is enough of initial meld points to make the initial melding.
@@ -295,18 +306,15 @@ private:
     static bool checkIfHandHasCardsWithRank(const Hand& playerHand, Rank rank, std::size_t count = 1);
 
     /**
-     * @brief Creates a Meld<R> and initializes it with the provided cards.
-     * @param cards The cards to initialize the meld with.
-     * @param rank The rank of the meld (should be from Four to Ace).
-     * @returns A unique_ptr to the initialized meld on success, or an error message on failure.
+     * @brief Checks if the meld of the specified rank (Four to Ace) can be initialized with the cards.
      */
-    static std::expected<std::unique_ptr<BaseMeld>, std::string>
-    createAndInitializeRankMeld(const std::vector<Card>& cards, Rank rank);
+    static MeldCheck checkInitialization(const std::vector<Card>& cards,
+        Rank rank, const TeamRoundState& teamRoundState);
 
     /**
      * @brief Checks if the cards can be added to the existing meld of the specified rank.
      */
-    static Status checkCardsAddition(const std::vector<Card>& cards,
+    static MeldCheck checkCardsAddition(const std::vector<Card>& cards,
         Rank rank, const TeamRoundState& teamRoundState);
 };
 
@@ -0,0 +1,166 @@
+#ifndef GAME_TABLE_HPP
+#define GAME_TABLE_HPP
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "invariant.hpp"
+#include "spdlog/spdlog.h"
+
+#include "game_manager.hpp"
+#include "server/lobby.hpp"
+#include "server/server_network.hpp"
+
+/**
+ * @class GameTable
+ * @brief One game of a server: its GameManager, the strand running it and the sessions of its players.
+ * @details A table lives on one shard and is only touched from the thread of that shard; the
+ * sessions of its players are moved there when they sit down. Game logic calls run on the table's
+ * strand, so a table needs no lock.
+ */
+class GameTable : public std::enable_shared_from_this<GameTable> {
+public:
+    /**
+     * @brief Constructor.
+     * @param serverNetwork The network of the shard hosting the table.
+     * @param id The id the lobby gave the table.
+     * @param playersCount Number of players in the game (2 or 4).
+     */
+    GameTable(ServerNetwork& serverNetwork, TableId id, std::size_t playersCount);
+
+    /**
+     * @brief Gets the id of the table.
+     */
+    TableId getId() const;
+
+    /**
+     * @brief Gets the strand game logic calls of the table run on.
+     */
+    asio::strand<asio::io_context::executor_type>& getStrand();
+
+    /**
+     * @brief Registers a session and associates it with a player name, starting the game once every player is there.
+     * @param session The session pointer.
+     * @param playerName The name provided by the client upon connection.
+     * @return Why the player cannot sit down; the LoginFailure is left to the caller.
+     */
+    Status join(SessionPtr session, const std::string& playerName);
+
+    /**
+     * @brief Removes a session when a client disconnects, which ends the game.
+     * @param session The session pointer.
+     */
+    void leave(SessionPtr session);
+
+    /**
+     * @brief Closes the connections of the players still seated, e.g. when the game ended.
+     */
+    void closeConnections();
+
+    /**
+     * @brief Serializes a message in the wire format of a player's session and delivers it to them.
+     * @param playerName The name of the player to send the message to.
+     * @param msgType The type of the message.
+     * @param data The fields of the message.
+     */
+    template <typename... T>
+    void deliverToOne(const std::string& playerName, ServerMessageType msgType, const T&... data);
+
+    /**
+     * @brief Delivers a serialized message to all the players of the table.
+     * @details The bytes go as they are to every session, so only for messages written alike in
+     * every wire format (a type without fields).
+     * @param message The serialized message data.
+     */
+    void deliverToAll(const std::vector<char>& message);
+
+    /// --- Action Handling (Called by Session) ---
+    /// A Session calls these on the table's strand when it receives a complete message, its
+    /// parameters already deserialized. The request id is echoed in the reply to the player.
+
+    void handleClientDrawDeck(const std::string& playerName, RequestId requestId);
+    void handleClientTakeDiscardPile(const std::string& playerName, RequestId requestId);
+    void handleClientMeld(const std::string& playerName, RequestId requestId,
+        const std::vector<MeldRequest>& meldRequests);
+    void handleClientDiscard(const std::string& playerName, RequestId requestId, const Card& cardToDiscard);
+    void handleClientRevert(const std::string& playerName, RequestId requestId);
+
+private:
+    /**
+     * @brief Dispatches an action to the RoundManager for the current player.
+     * @details This function ensures that the action is executed on the correct strand
+     * @param playerName The name of the player who sent the request.
+     * @param requestId The id of the request, echoed in the reply.
+     * @param action Callable running the action on the RoundManager.
+     */
+    template<typename ActionFn>
+    void dispatchAction(const std::string& playerName, RequestId requestId, ActionFn&& action);
+
+    /**
+     * @brief Sends an error message back to the client.
+     * @param playerName The name of the player to send the error to.
+     * @param errorMsg The error message to send.
+     * @param status Optional status code for the error.
+     * @param requestId The id of the request the error answers.
+     */
+    void sendActionError(const std::string& playerName, const ActionMessage& errorMsg,
+        std::optional<TurnActionStatus> status = std::nullopt, RequestId requestId = NO_REQUEST_ID);
+
+    /**
+     * @brief Broadcasts the game state to all players.
+     * @param lastActionMsg The message describing the last action taken.
+     * @param status Optional status code for the last action.
+     * @param requestingPlayer The player whose request led to this state, if any.
+     * @param requestId The id of that request, set only in the state sent to that player.
+     */
+    void broadcastGameState(const ActionMessage& lastActionMsg,
+        std::optional<TurnActionStatus> status = std::nullopt,
+        const std::string& requestingPlayer = "", RequestId requestId = NO_REQUEST_ID);
+
+    // --- Member Variables ---
+    ServerNetwork& serverNetwork; ///< Network of the shard hosting the table
+    TableId id; ///< Id given by the lobby
+    std::size_t playersCount; ///< Seats at the table
+    GameManager gameManager; ///< The game logic orchestrator
+
+    /// Use a strand to ensure game logic calls happen sequentially for the game
+    asio::strand<asio::io_context::executor_type> gameStrand;
+    /// Sessions of the players seated (map player name to session)
+    std::map<std::string, SessionPtr> sessions;
+    bool closed = false; ///< Set once a player left, after which the table ignores the others leaving
+};
+
+template<typename ActionFn>
+void GameTable::dispatchAction(const std::string& playerName, RequestId requestId, ActionFn&& action) {
+    CANASTA_INVARIANT(gameStrand.running_in_this_thread(), "The game state should only be touched on the game strand");
+    auto *rm = gameManager.getCurrentRoundManager();
+    if (!rm) {
+        sendActionError(playerName, ActionMessageCode::RoundNotActive, std::nullopt, requestId);
+        return;
+    }
+    if (rm->getCurrentPlayer().getName() != playerName) {
+        sendActionError(playerName, ActionMessageCode::NotYourTurn, std::nullopt, requestId);
+        return;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    TurnActionResult result = [&] {
+        TraceSpan span("handle_action");
+        return action(*rm);
+    }();
+    if (spdlog::should_log(spdlog::level::debug)) // The text is only rendered to be logged
+        spdlog::debug("Request #{} from {} handled in {} us: {}", requestId, playerName,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - startTime).count(),
+            result.getMessage().toString());
+    if (result.getStatus() < TurnActionStatus::Error_MainDeckEmpty) {
+        // success → broadcast the result.message
+        broadcastGameState(result.getMessage(), result.getStatus(), playerName, requestId);
+    } else {
+        // failure → send error back to just that player
+        sendActionError(playerName, result.getMessage(), result.getStatus(), requestId);
+    }
+}
+
+#endif // GAME_TABLE_HPP
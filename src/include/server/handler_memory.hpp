@@ -0,0 +1,118 @@
+#ifndef HANDLER_MEMORY_HPP
+#define HANDLER_MEMORY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+constexpr std::size_t HANDLER_MEMORY_SIZE = 256; ///< Largest handler kept in a HandlerMemory slot
+
+/**
+ * @class HandlerMemory
+ * @brief One slot of memory for the handlers an object posts, reused from one handler to the next.
+ * @details The slot pins its owner while a handler uses it: asio frees a handler's memory after
+ * destroying the handler, which may hold the last reference to the owner. Handlers that do not fit,
+ * or come while the slot is taken, fall back to the heap. Thread safe.
+ * @tparam Owner Object holding the memory, counting its references with addReference() and releaseReference().
+ */
+template <class Owner>
+class HandlerMemory {
+public:
+    explicit HandlerMemory(Owner& owner) : owner(owner) {}
+
+    HandlerMemory(const HandlerMemory&) = delete;
+    HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+    /**
+     * @brief Memory for a handler of the given size, the slot if it is free and large enough.
+     */
+    void* allocate(std::size_t size) {
+        if (size <= sizeof(storage) && !inUse.exchange(true, std::memory_order_acquire)) {
+            owner.addReference();
+            return storage;
+        }
+        return ::operator new(size);
+    }
+
+    /**
+     * @brief Give back memory from allocate().
+     */
+    void deallocate(void* pointer) noexcept {
+        if (pointer != storage) {
+            ::operator delete(pointer);
+            return;
+        }
+        Owner& slotOwner = owner;
+        inUse.store(false, std::memory_order_release);
+        slotOwner.releaseReference(); // May destroy the owner, and this memory with it
+    }
+
+private:
+    Owner& owner;
+    alignas(std::max_align_t) unsigned char storage[HANDLER_MEMORY_SIZE];
+    std::atomic<bool> inUse{false};
+};
+
+/**
+ * @class HandlerAllocator
+ * @brief Allocator drawing from a HandlerMemory, the associated allocator of handlers bound to it.
+ */
+template <class T, class Owner>
+class HandlerAllocator {
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory<Owner>& memory) noexcept : memory(&memory) {}
+    template <class U>
+    HandlerAllocator(const HandlerAllocator<U, Owner>& other) noexcept : memory(other.memory) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(memory->allocate(sizeof(T) * n));
+    }
+    void deallocate(T* pointer, std::size_t) noexcept {
+        memory->deallocate(pointer);
+    }
+
+    template <class U>
+    bool operator==(const HandlerAllocator<U, Owner>& other) const noexcept { return memory == other.memory; }
+
+private:
+    template <class U, class O> friend class HandlerAllocator;
+    HandlerMemory<Owner>* memory;
+};
+
+/**
+ * @class MemoryBoundHandler
+ * @brief Handler whose operation memory asio takes from a HandlerMemory.
+ */
+template <class Owner, class Handler>
+class MemoryBoundHandler {
+public:
+    using allocator_type = HandlerAllocator<std::byte, Owner>;
+
+    MemoryBoundHandler(HandlerMemory<Owner>& memory, Handler handler)
+        : memory(memory), handler(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return allocator_type(memory); }
+
+    template <class... Args>
+    void operator()(Args&&... args) {
+        handler(std::forward<Args>(args)...);
+    }
+
+private:
+    HandlerMemory<Owner>& memory;
+    Handler handler;
+};
+
+/**
+ * @brief Bind a handler to the memory its operation should be allocated in.
+ */
+template <class Owner, class Handler>
+MemoryBoundHandler<Owner, std::decay_t<Handler>> bindHandlerMemory(HandlerMemory<Owner>& memory, Handler&& handler) {
+    return {memory, std::forward<Handler>(handler)};
+}
+
+#endif // HANDLER_MEMORY_HPP
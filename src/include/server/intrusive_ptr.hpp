@@ -0,0 +1,56 @@
+#ifndef INTRUSIVE_PTR_HPP
+#define INTRUSIVE_PTR_HPP
+
+#include <cstddef>
+#include <utility>
+
+/**
+ * @class IntrusivePtr
+ * @brief Shared pointer to an object that counts its own references.
+ * @details T provides addReference() and releaseReference(), the latter destroying the object when
+ * the count drops to zero. There is no separate control block, and a pointer made from `this` costs
+ * one increment instead of the weak count check of std::enable_shared_from_this.
+ * @tparam T Type of the object pointed to.
+ */
+template <class T>
+class IntrusivePtr {
+public:
+    IntrusivePtr() noexcept = default;
+    IntrusivePtr(std::nullptr_t) noexcept {}
+
+    /**
+     * @brief Take a reference to the object.
+     * @param object The object, or nullptr.
+     */
+    explicit IntrusivePtr(T* object) noexcept : object(object) {
+        if (object)
+            object->addReference();
+    }
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept : IntrusivePtr(other.object) {}
+    IntrusivePtr(IntrusivePtr&& other) noexcept : object(std::exchange(other.object, nullptr)) {}
+
+    ~IntrusivePtr() {
+        if (object)
+            object->releaseReference();
+    }
+
+    IntrusivePtr& operator=(IntrusivePtr other) noexcept {
+        std::swap(object, other.object);
+        return *this;
+    }
+
+    T* get() const noexcept { return object; }
+    T& operator*() const noexcept { return *object; }
+    T* operator->() const noexcept { return object; }
+    explicit operator bool() const noexcept { return object != nullptr; }
+
+    friend bool operator==(const IntrusivePtr& lhs, const IntrusivePtr& rhs) noexcept {
+        return lhs.object == rhs.object;
+    }
+
+private:
+    T* object = nullptr;
+};
+
+#endif // INTRUSIVE_PTR_HPP
@@ -0,0 +1,87 @@
+#ifndef LOBBY_HPP
+#define LOBBY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+// Type alias for the id of a table, unique across the shards of a server
+using TableId = std::uint64_t;
+
+/**
+ * @enum HostingMode
+ * @brief What the server does with the players logging in.
+ */
+enum class HostingMode {
+    SingleGame, ///< One table; the server shuts down when one of its players leaves
+    Tables      ///< Opens tables as players log in, and closes a table when one of its players leaves
+};
+
+/**
+ * @struct TableSeat
+ * @brief A table, identified by the shard hosting it and its id.
+ */
+struct TableSeat {
+    std::size_t shard; ///< Index of the shard hosting the table
+    TableId table;     ///< Id of the table
+
+    auto operator<=>(const TableSeat&) const = default;
+};
+
+/**
+ * @class Lobby
+ * @brief Matchmaking of a server: gives the players logging in their seats at the tables.
+ * @details Player names are unique across the server. Tables are filled one at a time, and opened
+ * on the shards in turn. Not thread safe: the lobby lives on one shard and the others reach it
+ * through their mailboxes.
+ */
+class Lobby {
+public:
+    /**
+     * @brief Constructs an empty lobby.
+     * @param shardCount Number of shards tables are opened on.
+     * @param playersCount Number of players at each table (2 or 4).
+     * @param mode SingleGame to open one table only, on the first shard.
+     */
+    Lobby(std::size_t shardCount, std::size_t playersCount, HostingMode mode);
+
+    /**
+     * @brief Gives a player a seat at the table being filled, opening one if needed.
+     * @param playerName Name the player logs in with.
+     * @return The table, or why the player is turned down.
+     */
+    std::expected<TableSeat, std::string> seat(const std::string& playerName);
+
+    /**
+     * @brief Gives up the seat of a player whose connection was lost before they sat down.
+     * @return True if the table has to close, its seat being no longer offered.
+     */
+    bool abandonSeat(const std::string& playerName, const TableSeat& seat);
+
+    /**
+     * @brief Forgets a table its shard closed, freeing the names of its players.
+     */
+    void closeTable(const TableSeat& seat);
+
+    /**
+     * @brief Whether a table was opened and not closed yet.
+     */
+    bool isOpen(const TableSeat& seat) const;
+
+private:
+    std::size_t shardCount;
+    std::size_t playersCount;
+    HostingMode mode;
+    std::set<std::string> playerNames;                          ///< Names of every seated player
+    std::map<TableSeat, std::vector<std::string>> openTables;   ///< Players seated at each open table
+    std::optional<TableSeat> fillingTable;                      ///< Table new players sit at, if any
+    TableId nextTableId = 0;
+    std::size_t nextShard = 0;                                  ///< Shard the next table opens on
+};
+
+#endif // LOBBY_HPP
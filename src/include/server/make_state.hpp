@@ -10,7 +10,7 @@
  * @param player The player whose state is being created.
  * @param roundManager The current round manager.
  * @param gameManager The current game manager.
- * @param actionDescription Description of the last action taken.
+ * @param lastAction Code of the last action taken.
  * @param status Optional status of the last action.
  * @return A ClientGameState object containing the relevant game state.
  */
@@ -18,12 +18,12 @@ inline ClientGameState makeClientGameState(
     const Player& player,
     const RoundManager& roundManager,
     const GameManager& gameManager,
-    const std::string& actionDescription,
+    const ActionMessage& lastAction,
     std::optional<TurnActionStatus> status = std::nullopt
 ) {
     ClientGameState s;
     s.setDeckState(roundManager.getClientDeck());
-    s.setMyPlayerData(player);
+    s.setMyHand(player.getHand());
     s.setAllPlayersPublicInfo(roundManager.getAllPlayersPublicInfo(player));
     auto team1 = gameManager.getTeam1();
     auto team2 = gameManager.getTeam2();
@@ -49,7 +49,7 @@ inline ClientGameState makeClientGameState(
             s.setGameOutcome(ClientGameOutcome::Draw);
         }
     }
-    s.setLastActionDescription(actionDescription);
+    s.setLastAction(lastAction);
     s.setStatus(status);
     return s;
 }
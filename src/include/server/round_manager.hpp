@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <optional>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <functional> // For std::reference_wrapper
@@ -15,7 +16,7 @@
 #include "card.hpp"
 #include "turn_manager.hpp" // Includes TurnActionResult, MeldRequest etc.
 #include "score_details.hpp"
-#include "server/rule_engine.hpp" // For GameOutcome
+#include "rule_engine.hpp" // For GameOutcome
 #include "client_deck.hpp"
 #include "player_public_info.hpp"
 
@@ -34,11 +35,13 @@ public:
      * @param players Vector of all players in turn order
      * @param team1 Reference to the first team
      * @param team2 Reference to the second team
+     * @param deckSeed Seed of the deck shuffle, to replay a round; random when not given
      */
     RoundManager(
         const std::vector<std::reference_wrapper<Player>>& players,
         std::reference_wrapper<const Team> team1,
-        std::reference_wrapper<const Team> team2
+        std::reference_wrapper<const Team> team2,
+        std::optional<std::uint32_t> deckSeed = std::nullopt
     );
 
     /**
@@ -122,6 +125,15 @@ public:
      */
     TeamRoundState getTeamStateForTeam(const Team& team) const;
 
+    /**
+     * @brief Gets the Zobrist hash of the round position.
+     * @return Hash of the hands by seat, the melds of both teams, the deck state and the current player.
+     * @details The hands, melds and discard pile keep their hashes up to date on every change, so this only
+     * combines a few values. Two equal hashes identify the same position, e.g. to key transposition tables
+     * or to check that a replayed round follows the same path.
+     */
+    std::uint64_t getStateHash() const;
+
 private:
 
     static constexpr std::size_t INITIAL_HAND_SIZE = 11; ///< Number of cards dealt to each player at the start
@@ -2,12 +2,14 @@
 #define SERVER_DECK_HPP
 
 #include "card.hpp"
+#include "zobrist.hpp"
 #include <vector>
 #include <algorithm>
 #include <random>
 #include <cereal/types/vector.hpp>
 #include <cereal/access.hpp>
 #include <optional>
+#include <cstdint>
 #include <expected>
 
 
@@ -23,10 +25,12 @@ private:
     bool isDiscardPileFrozen;         // Whether the discard pile is frozen
     bool backupIsDiscardPileFrozen; // Backup discard pile frozen state
     bool hasPendingReversible;      // Whether there is a pending reversible action
+    CardMultisetHash discardPileHash; // Zobrist hash of the discard pile cards
     /**
      * @brief Shuffles the main deck.
+     * @param seed Seed of the shuffle; the same seed always gives the same order.
      */
-    void shuffle();
+    void shuffle(std::uint32_t seed);
 
     /**
      * @brief Initializes a standard 108-card Canasta main deck.
@@ -52,6 +56,12 @@ public:
      */
     ServerDeck();
 
+    /**
+     * @brief Constructor for a ServerDeck shuffled from a given seed.
+     * @details Used to replay a round, e.g. by the simulators and fuzzers.
+     */
+    explicit ServerDeck(std::uint32_t seed);
+
     /**
      * @brief Draw a card from the main deck.
      * @return An optional card. If the deck is empty, returns std::nullopt.
@@ -107,6 +117,13 @@ public:
      */
     bool isFrozen() const;
 
+    /**
+     * @brief Get the Zobrist hash of the deck state visible in a round position.
+     * @details Covers the discard pile cards, its top card, whether it is frozen and the main deck size.
+     * The pile part is kept up to date as cards are discarded and taken.
+     */
+    std::uint64_t getHash() const;
+
     /**
      * @brief Serialize the ServerDeck object using Cereal.
      */
@@ -115,6 +132,8 @@ public:
         archive(CEREAL_NVP(mainDeck), CEREAL_NVP(discardPile), CEREAL_NVP(isDiscardPileFrozen),
                 CEREAL_NVP(backupDiscardPile), CEREAL_NVP(backupIsDiscardPileFrozen),
                 CEREAL_NVP(hasPendingReversible));
+        if constexpr (Archive::is_loading::value)
+            discardPileHash = CardMultisetHash(discardPile); // The hash is not sent
     }
 };
 
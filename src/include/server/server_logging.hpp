@@ -2,6 +2,13 @@
 #define SERVER_LOGGING_HPP
 
 #include <spdlog/spdlog.h>
+#include <filesystem>
+
+/**
+ * @brief Get the directory the server writes its logs and traces to.
+ * @details Taken from the LOG_DIR environment variable, or a "logs" directory next to the build tree.
+ */
+std::filesystem::path getLogDirectory();
 
 /**
  * @brief Initializes the logger for the server.
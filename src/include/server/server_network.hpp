@@ -2,42 +2,98 @@
 #define SERVER_NETWORK_HPP
 
 #include <memory>
+#include "invariant.hpp"
 #include <vector>
 #include <string>
 #include <set>
-#include <deque>
+#include <map>
+#include <optional>
 #include <mutex> // For thread safety if needed later, though game logic runs on one strand
 #include <functional> // For std::function
+#include <chrono>
+#include <atomic>
+#include "spdlog/spdlog.h"
 
 #include "game_manager.hpp" // To interact with the game logic
 #include "game_state.hpp"   // For ClientGameState
 #include "network.hpp"
-
-// Forward declaration
+#include "server/server_tracing.hpp"
+#include "server/server_profiling.hpp"
+#include "server/token_bucket.hpp"
+#include "server/intrusive_ptr.hpp"
+#include "server/handler_memory.hpp"
+#include "server/session_pool.hpp"
+#include "server/lobby.hpp"
+
+// Forward declarations
 class Session;
+class GameTable;
+class ShardedServer;
+
+// Type alias for the pointer to a Session, which counts its own references
+using SessionPtr = IntrusivePtr<Session>;
+
+// Default per-client limits on game actions
+constexpr double DEFAULT_ACTIONS_PER_SECOND = 100;
+constexpr double DEFAULT_ACTION_BURST = 200;
+// Time a new connection has to log in, from connecting until it asks for a seat
+constexpr std::chrono::seconds LOGIN_TIMEOUT{30};
+
+/**
+ * @class ConnectionHandoff
+ * @brief The connection of a logged in player, released by the shard that accepted it and on its
+ * way to the shard of their table.
+ * @details Closes the connection if dropped before being adopted, as when the server shuts down.
+ */
+class ConnectionHandoff {
+public:
+    /**
+     * @brief Constructor.
+     * @param protocol Protocol of the socket.
+     * @param handle The released native socket.
+     * @param playerName Name the player logged in with.
+     * @param wireFormat Format agreed on at login.
+     */
+    ConnectionHandoff(asio::ip::tcp protocol, asio::ip::tcp::socket::native_handle_type handle,
+        std::string playerName, WireFormat wireFormat);
+    ConnectionHandoff(ConnectionHandoff&& other) noexcept;
+    ConnectionHandoff& operator=(ConnectionHandoff&&) = delete;
+    ~ConnectionHandoff();
 
-// Type alias for shared pointer to Session
-using SessionPtr = std::shared_ptr<Session>;
+    /**
+     * @brief Makes a socket of the connection on the io_context of the shard adopting it.
+     * @throws asio::system_error if the socket cannot be registered.
+     */
+    asio::ip::tcp::socket adopt(asio::io_context& ioContext);
 
-// Type alias for message queue
-using MessageQueue = std::deque<std::vector<char>>; // Store serialized messages as byte vectors
+    const std::string& getPlayerName() const;
+    WireFormat getWireFormat() const;
+
+private:
+    asio::ip::tcp protocol;
+    std::optional<asio::ip::tcp::socket::native_handle_type> handle; ///< Empty once adopted or moved from
+    std::string playerName;
+    WireFormat wireFormat;
+};
 
 /**
  * @class ServerNetwork
- * @brief Handles network connections, message framing, serialization,
- *        and dispatching actions to the RoundManager. Manages client sessions.
+ * @brief Network of one shard of the server: accepts connections, logs clients in through the
+ *        lobby and hosts the tables the lobby opens on the shard.
  */
 class ServerNetwork {
 public:
     /**
      * @brief Constructor.
-     * @param ioContext The ASIO I/O context to run on.
+     * @param server The server the shard belongs to.
+     * @param shardIndex Index of the shard.
+     * @param ioContext The I/O context of the shard.
      * @param endpoint The TCP endpoint to listen on (e.g., tcp::v4(), port).
-     * @param gameManager Reference to the single GameManager instance.
+     * @param reusePort Whether other shards listen on the same endpoint (SO_REUSEPORT).
      */
-    ServerNetwork(asio::io_context& ioContext,
-                const asio::ip::tcp::endpoint& endpoint,
-                GameManager& gameManager);
+    ServerNetwork(ShardedServer& server, std::size_t shardIndex, asio::io_context& ioContext,
+                const asio::ip::tcp::endpoint& endpoint, bool reusePort);
+    ~ServerNetwork();
 
     /**
      * @brief Starts the server listening for incoming connections.
@@ -45,132 +101,174 @@ public:
     void startAccept();
 
     /**
-     * @brief Delivers a serialized message (e.g., game state update) to a specific player/session.
-     * @param playerName The name of the player to send the message to.
-     * @param message The serialized message data.
+     * @brief Sets the rate limit applied to the game actions of each client connecting from now on.
+     * @param actionsPerSecond Actions allowed per second in the long run; 0 disables the limit.
+     * @param burst Actions allowed in a burst.
      */
-    void deliverToOne(const std::string& playerName, const std::vector<char>& message);
+    void setActionRateLimit(double actionsPerSecond, double burst);
 
     /**
-     * @brief Delivers a serialized message to all currently connected sessions.
-     * @param message The serialized message data.
+     * @brief Sets the most compact wire format granted to clients asking for it.
+     * @param format WireFormat::Binary to keep every client on the binary archive.
+     */
+    void setWireFormat(WireFormat format);
+
+    /**
+     * @brief Gets the number of sessions alive, connected or still being torn down.
      */
-    void deliverToAll(const std::vector<char>& message);
+    std::size_t getLiveSessionCount() const;
 
-    /// --- Action Handling (Called by Session) ---
-    /// These methods will be called by a Session when it receives a complete message.
-    /// They need to deserialize the action parameters and dispatch to GameManager/RoundManager
-    /// on the correct strand/thread.
+    /// --- Seating (called on this shard with the lobby's answers) ---
 
-    void handleClientDrawDeck(const std::string& playerName);
-    void handleClientTakeDiscardPile(const std::string& playerName);
-    void handleClientMeld(const std::string& playerName, const std::vector<MeldRequest>& meldRequests);
-    void handleClientDiscard(const std::string& playerName, const Card& cardToDiscard);
-    void handleClientRevert(const std::string& playerName);
-    // Add handlers for other potential client messages (e.g., connect, disconnect, chat)
+    /**
+     * @brief Seats a player who logged in on this shard at one of its tables, opening it if needed.
+     */
+    void seat(SessionPtr session, TableId tableId);
 
-private:
-    friend class Session; // Allow Session to access private members
+    /**
+     * @brief Releases the connection of a player who logged in on this shard and sends it to the
+     * shard of their table.
+     */
+    void handOff(SessionPtr session, TableSeat seat);
 
     /**
-     * @brief Registers a new session and associates it with a player name.
-     * @param session The session pointer.
-     * @param playerName The name provided by the client upon connection.
+     * @brief Takes over the connection of a player seated at a table of this shard.
      */
-    Status join(SessionPtr session, const std::string& playerName);
+    void adopt(ConnectionHandoff connection, TableId tableId);
 
     /**
-     * @brief Removes a session when a client disconnects.
-     * @param session The session pointer.
+     * @brief Turns down the login of a player, who may try again on the same connection.
      */
-    void leave(SessionPtr session);
+    void refuseLogin(SessionPtr session, const std::string& reason);
 
     /**
-     * @brief Dispatches an action to the RoundManager for the current player.
-     * @details This function ensures that the action is executed on the correct strand
+     * @brief Takes back a connection the lobby could not seat and turns down its login.
      */
-    template<typename ActionFn>
-    void dispatchAction(const std::string& playerName, ActionFn&& action);
+    void refuseLogin(ConnectionHandoff connection, const std::string& reason);
 
     /**
-     * @brief Sends an error message back to the client.
-     * @param playerName The name of the player to send the error to.
-     * @param errorMsg The error message to send.
-     * @param status Optional status code for the error.
+     * @brief Closes a table, if still open, and tells the lobby.
+     * @details Players the lobby seated at the table meanwhile are turned down when they arrive,
+     * until the lobby has acknowledged the closing (forgetTable()).
      */
-    void sendActionError(const std::string& playerName, const std::string& errorMsg,
-        std::optional<TurnActionStatus> status = std::nullopt);
+    void closeTable(TableId tableId);
 
     /**
-     * @brief Broadcasts the game state to all players.
-     * @param lastActionMsg The message describing the last action taken.
-     * @param status Optional status code for the last action.
+     * @brief Forgets a closed table once the lobby knows, no player being on their way to it any more.
      */
-    void broadcastGameState(const std::string& lastActionMsg,
-        std::optional<TurnActionStatus> status = std::nullopt);
+    void forgetTable(TableId tableId);
+
+private:
+    friend class Session; // Allow Session to access private members
+    friend class GameTable; // Allow GameTable to access private members
+
+    /**
+     * @brief Asks the lobby for a seat for a player who sent their Login.
+     */
+    void login(SessionPtr session);
+
+    /**
+     * @brief Removes a session when a client disconnects, from its table if it has one.
+     * @param session The session pointer.
+     */
+    void leave(SessionPtr session);
+
+    /**
+     * @brief Ends a table one of whose players left: closes it, or stops the server hosting a single game.
+     */
+    void endTable(TableId tableId);
 
     // --- Member Variables ---
-    asio::io_context& ioContext; ///< Reference to the main I/O context
+    ShardedServer& server; ///< The server the shard belongs to
+    std::size_t shardIndex; ///< Index of the shard
+    asio::io_context& ioContext; ///< Reference to the I/O context of the shard
     asio::ip::tcp::acceptor acceptor; ///< Accepts incoming connections
-    GameManager& gameManager; ///< Reference to the game logic orchestrator
-
-    /// Use a strand to ensure game logic calls happen sequentially for the single game instance
-    asio::strand<asio::io_context::executor_type> gameStrand;
-    /// Manages active sessions (map player name to session)
-    std::map<std::string, SessionPtr> sessions;
-    /// Mutex for protecting access to sessions map if accessed from multiple threads (acceptor vs session handlers)
-    std::mutex sessionsMutex;
+    /// Memory of the sessions and their buffers, shared with them since they may outlive the server
+    std::shared_ptr<SessionPool> sessionPool;
+    /// Tables open on the shard, by id
+    std::map<TableId, std::shared_ptr<GameTable>> tables;
+    /// Tables closed whose closing the lobby has not acknowledged yet
+    std::set<TableId> closingTables;
+    double actionsPerSecond = DEFAULT_ACTIONS_PER_SECOND; ///< Rate limit of new sessions
+    double actionBurst = DEFAULT_ACTION_BURST; ///< Burst allowed to new sessions
+    WireFormat maxWireFormat = WireFormat::Compact; ///< Most compact format granted at login
 };
 
-template<typename ActionFn>
-void ServerNetwork::dispatchAction(const std::string& playerName, ActionFn&& action) {
-    assert(gameStrand.running_in_this_thread());
-    auto *rm = gameManager.getCurrentRoundManager();
-    if (!rm) {
-        sendActionError(playerName, "Round not active.");
-        return;
-    }
-    if (rm->getCurrentPlayer().getName() != playerName) {
-        sendActionError(playerName, "Not your turn.");
-        return;
-    }
-    TurnActionResult result = action(*rm);
-    if (result.getStatus() < TurnActionStatus::Error_MainDeckEmpty) {
-        // success → broadcast the result.message
-        broadcastGameState(result.getMessage(), result.getStatus());
-    } else {
-        // failure → send error back to just that player
-        sendActionError(playerName, result.getMessage(), result.getStatus());
-    }
-}
-
 //----------------------------------------------------------------------
 
 /**
  * @class Session
  * @brief Represents a single client connection session.
  * Handles reading/writing messages for one client.
+ * @details Sessions live in the blocks of a SessionPool and count their own references: each loop
+ * and each handler posted for the session holds a SessionPtr, and the last one to go gives the
+ * block and the buffers back to the pool.
  */
-class Session : public std::enable_shared_from_this<Session> {
+class Session {
 public:
     /**
-     * @brief Constructor.
+     * @brief Creates a session in a block of the pool.
+     * @param pool The pool of the server's sessions.
      * @param socket The socket for this session.
-     * @param serverNetwork Reference to the server network.
-     * @param gameStrand Strand for dispatching game logic calls.
+     * @param serverNetwork Reference to the network of the shard.
      */
-    Session(asio::ip::tcp::socket socket, ServerNetwork& serverNetwork, asio::strand<asio::io_context::executor_type>& gameStrand);
+    static SessionPtr create(std::shared_ptr<SessionPool> pool, asio::ip::tcp::socket socket,
+        ServerNetwork& serverNetwork);
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
 
     /**
      * @brief Starts the session (begins reading messages).
      */
     void start();
 
+    /**
+     * @brief Starts a session taking over the connection of a player who logged in on another shard.
+     * @param playerName Name the player logged in with.
+     * @param format Format agreed on at login.
+     */
+    void resume(std::string playerName, WireFormat format);
+
+    /**
+     * @brief Records the table the player sat down at; their game messages go to it from now on.
+     */
+    void joinTable(std::shared_ptr<GameTable> table);
+
+    /**
+     * @brief Lets the player send another Login, once the lobby turned the last one down.
+     */
+    void endSeatRequest();
+
+    /**
+     * @brief Gets the table of the player, null until they sat down.
+     */
+    const std::shared_ptr<GameTable>& getTable() const;
+
+    /**
+     * @brief Whether the connection is still open.
+     */
+    bool isConnected() const;
+
+    /**
+     * @brief Gives up the connection so another shard can take it over; both loops end.
+     * @throws asio::system_error where sockets cannot be released (Windows).
+     */
+    ConnectionHandoff releaseConnection();
+
+    /**
+     * @brief Closes the socket and wakes the write loop, so both loops end.
+     */
+    void close();
+
     /**
      * @brief Delivers a pre-serialized message to this client.
+     * @details The message is queued on the socket's executor, inline when called from it, and
+     * written by the write loop.
      * @param message The serialized message data.
+     * @param traceId The request that led to the message, for tracing; by default the current trace.
      */
-    void deliver(const std::vector<char>& message);
+    void deliver(std::vector<char> message, TraceId traceId = ServerTracing::currentTrace());
 
     /**
      * @brief Gets the player name associated with this session.
@@ -178,70 +276,112 @@ public:
      */
     const std::string& getPlayerName() const;
 
-private:
     /**
-     * @brief Initiates an asynchronous read for the message header (size).
+     * @brief Records whether it is this player's turn, so actions sent out of turn are rejected
+     * without reaching the game strand.
+     * @details Set on the game strand before the state announcing the turn is delivered.
      */
-    void doReadHeader();
+    void setHasTurn(bool hasTurn);
 
     /**
-     * @brief Callback for when the message header has been read.
+     * @brief Gets the format agreed on at login, Binary until then.
      */
-    void handleReadHeader(const asio::error_code& error, std::size_t /*bytes_transferred*/);
+    WireFormat getWireFormat() const;
+
+    /// Counts a new SessionPtr to this session.
+    void addReference() noexcept;
+    /// Drops a SessionPtr to this session, destroying it and giving its memory back to the pool with the last one.
+    void releaseReference() noexcept;
+
+private:
+    Session(std::shared_ptr<SessionPool> pool, SessionBuffers buffers, asio::ip::tcp::socket socket,
+        ServerNetwork& serverNetwork);
+    ~Session();
 
     /**
-     * @brief Initiates an asynchronous read for the message body.
+     * @brief Spawns the read and write loops.
+     * @param awaitingLogin Whether the connection is closed unless it logs in within LOGIN_TIMEOUT.
      */
-    void doReadBody();
+    void spawnLoops(bool awaitingLogin);
 
     /**
-     * @brief Callback for when the message body has been read.
+     * @brief Closes the connection when loginDeadline expires before the player asked for a seat.
+     * @details While the lobby handles a Login the deadline is pushed back, since the answer may be a refusal.
      */
-    void handleReadBody(const asio::error_code& error, std::size_t /*bytes_transferred*/);
+    void awaitLoginDeadline();
 
     /**
-     * @brief Initiates an asynchronous write operation.
+     * @brief Reads the socket and processes every complete message received, until the connection fails.
      */
-    void doWrite();
+    asio::awaitable<void> readLoop();
 
     /**
-     * @brief Callback for when a write operation completes.
+     * @brief Writes the queued messages, all those queued at the time in one write, until the connection fails.
+     * @details Waits on writeSignal while the queue is empty; each write times out after WRITE_TIMEOUT.
      */
-    void handleWrite(const asio::error_code& error, std::size_t /*bytes_transferred*/);
+    asio::awaitable<void> writeLoop();
 
     /**
-     * @brief Parses the received message body and dispatches the action.
+     * @brief Parses a received message body and dispatches the action.
+     * @param frame The body, decoded where it was read.
      */
-    void processMessage();
+    void processMessage(std::span<const char> frame);
 
     /**
      * @brief Processes a login message from the client.
      * @param msgType The type of the message.
+     * @param payload The stream the archive reads, to tell whether a wire format was asked for.
      * @param archive The archive containing the serialized data.
      */
-    void processLoginMessage(ClientMessageType msgType, cereal::BinaryInputArchive& archive);
+    void processLoginMessage(ClientMessageType msgType, std::istream& payload, cereal::BinaryInputArchive& archive);
 
     /**
      * @brief Processes a game message from the client.
      * @param msgType The type of the message.
-     * @param archive The archive containing the serialized data.
+     * @param requestId The id the client gave to the request.
+     * @param archive The archive containing the serialized data, in the format agreed on at login.
+     */
+    template <class Archive>
+    void processGameMessage(ClientMessageType msgType, RequestId requestId, Archive& archive);
+
+    /**
+     * @brief Posts a request handler to the strand of the player's table, in the current trace, tracing the
+     * time it waits there and profiling the work it does there.
+     */
+    template <typename Handler>
+    void postToGameStrand(ClientMessageType msgType, Handler&& handler);
+
+    /**
+     * @brief Answers a game action with an error without posting it to the game strand.
+     * @param requestId The id of the rejected request.
+     * @param reason Why the action is shed, counted in the server stats.
      */
-    void processGameMessage(ClientMessageType msgType, cereal::BinaryInputArchive& archive);
+    void shedAction(RequestId requestId, ShedReason reason);
 
     // --- Member Variables ---
+    std::atomic<std::uint32_t> references{0}; ///< Number of SessionPtr to this session
+    std::shared_ptr<SessionPool> pool; ///< Pool the session and its buffers go back to
     asio::ip::tcp::socket socket; ///< Socket for this client connection
     ServerNetwork& serverNetwork; ///< Reference back to the server network
-    asio::strand<asio::io_context::executor_type>& gameStrand; ///< Strand for dispatching game logic calls
+    std::shared_ptr<GameTable> table; ///< Table of the player, whose strand runs their game messages
 
-    // Buffer for reading incoming messages
-    std::vector<char> readMsgBuffer; ///< Buffer for reading incoming messages
-    std::uint32_t incomingMsgSize; ///< Size of the message currently being read
+    FrameReader reader; ///< Buffer the incoming messages are read into and parsed from
+    TraceClock::time_point readStartTime; ///< When the first bytes of the current message arrived (only set while tracing)
 
     // Queue for outgoing messages
     MessageQueue writeMsgs; ///< Queue of messages to be sent to the client
+    std::vector<asio::const_buffer> writeBuffers; ///< Buffers of the queued messages, gathered into one write
+    asio::steady_timer writeSignal; ///< Never expires; cancelled to wake the write loop
+    asio::steady_timer loginDeadline; ///< End of the time a new connection has to log in, whatever it sends
+    HandlerMemory<Session> deliverMemory; ///< Memory of the handler queuing a message from off the socket's executor
+    HandlerMemory<Session> requestMemory; ///< Memory of the handler taking a request to the game strand
 
     std::string playerName; ///< Player's name associated with this session after successful join/login
     bool joined = false; ///< Flag indicating if the player has successfully joined
+    bool seatRequested = false; ///< Set while the lobby handles the Login, which holds a name and a seat
+    std::atomic<bool> hasTurn{false}; ///< Whether the last state sent to the player gave them the turn
+    std::atomic<WireFormat> wireFormat{WireFormat::Binary}; ///< Format of the messages after the login
+    TokenBucket actionLimiter; ///< Limits the game actions of this client
 };
 
 
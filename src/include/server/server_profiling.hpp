@@ -0,0 +1,168 @@
+#ifndef SERVER_PROFILING_HPP
+#define SERVER_PROFILING_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include "network.hpp" // For ClientMessageType
+
+/**
+ * @struct PerfCounts
+ * @brief Hardware counter values, or differences of them.
+ */
+struct PerfCounts {
+    std::uint64_t cycles = 0;       ///< CPU cycles spent in user space
+    std::uint64_t instructions = 0; ///< Instructions retired in user space
+    std::uint64_t cacheMisses = 0;  ///< Last level cache misses
+};
+
+/**
+ * @class PerfCounterGroup
+ * @brief Cycles, instructions and cache misses of the calling thread, read through perf_event_open.
+ * @details The counters run from construction on; the work done by a piece of code is the difference
+ * of two reads. When the counters cannot be opened (not Linux, no PMU in a VM, perf_event_paranoid
+ * too strict) the group is unavailable and read() returns zeros.
+ */
+class PerfCounterGroup {
+public:
+    /**
+     * @brief Open the counters for the calling thread.
+     */
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    /**
+     * @brief Check whether the counters could be opened.
+     */
+    bool isAvailable() const;
+
+    /**
+     * @brief Read the current values of all the counters at once.
+     */
+    PerfCounts read() const;
+
+private:
+    int leaderFd = -1;       ///< Cycles counter, leader of the group
+    int instructionsFd = -1; ///< Instructions counter
+    int cacheMissesFd = -1;  ///< Cache misses counter
+};
+
+/**
+ * @enum ShedReason
+ * @brief Why a game action was rejected before reaching the game strand.
+ */
+enum class ShedReason {
+    RateLimited, ///< The client exceeded its action rate limit
+    OutOfTurn,   ///< The client acted while it was not its turn
+};
+
+/**
+ * @struct ActionStats
+ * @brief Accumulated cost of the game strand work done for one message type.
+ */
+struct ActionStats {
+    std::uint64_t count = 0;          ///< Messages handled
+    std::uint64_t wallNs = 0;         ///< Time spent on the strand
+    std::uint64_t allocations = 0;    ///< Calls to operator new
+    std::uint64_t allocatedBytes = 0; ///< Bytes requested from operator new
+    PerfCounts counters;              ///< Hardware counters, zero when unavailable
+};
+
+/**
+ * @class ServerProfiling
+ * @brief Aggregates the cost of the game strand work per ClientMessageType.
+ * @details Allocations are always counted, by the global operator new of the server.
+ * Profiling of the strand work and the hardware counters are off until enable() is called.
+ * The stats are exported as a Prometheus text file, to be picked up by the node exporter.
+ */
+class ServerProfiling {
+public:
+    ServerProfiling() = delete;   ///< no instances of ServerProfiling
+    ~ServerProfiling() = delete;  ///< no instances of ServerProfiling
+
+    /// One entry per ClientMessageType
+    static constexpr std::size_t MESSAGE_TYPE_COUNT = static_cast<std::size_t>(ClientMessageType::Revert) + 1;
+
+    /**
+     * @brief Turns profiling on, with hardware counters where they are available.
+     */
+    static void enable();
+
+    /**
+     * @brief Check whether profiling is on.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Get the number of allocations made by the calling thread so far.
+     */
+    static std::uint64_t threadAllocationCount();
+
+    /**
+     * @brief Get the number of bytes allocated by the calling thread so far.
+     */
+    static std::uint64_t threadAllocatedBytes();
+
+    /**
+     * @brief Add the cost of handling one message to the stats of its type, kept by the calling thread.
+     */
+    static void record(ClientMessageType msgType, const ActionStats& cost);
+
+    /**
+     * @brief Count an action shed by a session; always counted, even when profiling is off.
+     */
+    static void recordShedAction(ShedReason reason);
+
+    /**
+     * @brief Get the number of actions shed for the given reason so far.
+     */
+    static std::uint64_t shedActionCount(ShedReason reason);
+
+    /**
+     * @brief Count a game state frame sent to a client and its size; always counted, even when profiling is off.
+     */
+    static void recordStateFrame(std::size_t bytes);
+
+    /**
+     * @brief Get the stats of all message types, summed over the threads that recorded them.
+     */
+    static std::array<ActionStats, MESSAGE_TYPE_COUNT> snapshot();
+
+    /**
+     * @brief Write the stats in the Prometheus text exposition format.
+     * @details The file is replaced atomically, so a scrape never sees it half written.
+     * @param path File to write.
+     * @return Whether the file was written.
+     */
+    static bool writePrometheusFile(const std::filesystem::path& path);
+};
+
+/**
+ * @class ActionProfile
+ * @brief Records the cost of the work done during its lifetime for a message type.
+ */
+class ActionProfile {
+public:
+    /**
+     * @brief Start measuring; does nothing when profiling is off.
+     * @param msgType The type of the message being handled.
+     */
+    explicit ActionProfile(ClientMessageType msgType);
+    ~ActionProfile();
+    ActionProfile(const ActionProfile&) = delete;
+    ActionProfile& operator=(const ActionProfile&) = delete;
+
+private:
+    ClientMessageType msgType;
+    bool active;
+    std::chrono::steady_clock::time_point startTime;
+    std::uint64_t startAllocations = 0;
+    std::uint64_t startAllocatedBytes = 0;
+    PerfCounts startCounters;
+};
+
+#endif // SERVER_PROFILING_HPP
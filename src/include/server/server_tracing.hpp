@@ -0,0 +1,128 @@
+#ifndef SERVER_TRACING_HPP
+#define SERVER_TRACING_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+
+using TraceClock = std::chrono::steady_clock;
+
+/// Server-wide id of a traced request; client request ids are only unique per client
+using TraceId = std::uint64_t;
+constexpr TraceId NO_TRACE_ID = 0; ///< Work that is not traced: unsampled requests, broadcasts of the server's own
+
+/**
+ * @class ServerTracing
+ * @brief Records timed spans of the stages a client request goes through on the server.
+ * @details Spans are written into a fixed-size ring buffer owned by the recording thread, without
+ * locks, and can be dumped at any time as Chrome trace-event JSON (chrome://tracing, Perfetto).
+ * Tracing is off until enable() is called. Each request decoded gets a TraceId, or NO_TRACE_ID when
+ * it is not sampled, and the work it leads to runs under a TraceScope, so either all the spans of a
+ * request are kept or none of them.
+ */
+class ServerTracing {
+public:
+    ServerTracing() = delete;   ///< no instances of ServerTracing
+    ~ServerTracing() = delete;  ///< no instances of ServerTracing
+
+    static constexpr std::size_t RING_CAPACITY = 8192; ///< Spans kept per thread, older ones are overwritten
+
+    /**
+     * @brief Turns tracing on.
+     * @param sampleInterval Keep one request out of sampleInterval (1 keeps all of them).
+     */
+    static void enable(std::uint32_t sampleInterval);
+
+    /**
+     * @brief Check whether tracing is on.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Start the trace of a request decoded on this thread.
+     * @details Ids pair the thread with a count of the requests it decoded, so they are unique across
+     * the server and the sampling does not depend on the ids clients choose.
+     * @return The id of the request, or NO_TRACE_ID if tracing is off or the request is not sampled.
+     */
+    static TraceId startTrace();
+
+    /**
+     * @brief Get the trace of the work running on this thread, set by the innermost TraceScope.
+     */
+    static TraceId currentTrace();
+
+    /**
+     * @brief Get the current time if tracing is on, a default time point otherwise.
+     * @details Lets call sites take timestamps before the request id is known at no cost when off.
+     */
+    static TraceClock::time_point now();
+
+    /**
+     * @brief Record a finished span.
+     * @param name Name of the stage; must be a string literal (only the pointer is stored).
+     * @param traceId The request the span belongs to; nothing is recorded for NO_TRACE_ID.
+     * @param start Start of the span, ignored if it is a default time point.
+     * @param end End of the span.
+     */
+    static void record(const char* name, TraceId traceId,
+        TraceClock::time_point start, TraceClock::time_point end);
+
+    /**
+     * @brief Write the spans currently held by all threads as Chrome trace-event JSON.
+     * @param path File to write.
+     * @return The number of spans written, or nullopt if the file could not be written.
+     */
+    static std::optional<std::size_t> dumpChromeTrace(const std::filesystem::path& path);
+
+private:
+    friend class TraceScope;
+    static void setCurrentTrace(TraceId traceId);
+};
+
+/**
+ * @class TraceScope
+ * @brief Makes a request's trace the current one on this thread for its own lifetime.
+ * @details Set where a request is decoded and again in the handlers it is posted to, so the spans
+ * and messages of the work it leads to are tagged with it.
+ */
+class TraceScope {
+public:
+    explicit TraceScope(TraceId traceId) : previous(ServerTracing::currentTrace()) {
+        ServerTracing::setCurrentTrace(traceId);
+    }
+    ~TraceScope() { ServerTracing::setCurrentTrace(previous); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceId previous;
+};
+
+/**
+ * @class TraceSpan
+ * @brief Records a span covering its own lifetime, in the current trace.
+ */
+class TraceSpan {
+public:
+    /**
+     * @brief Start the span.
+     * @param name Name of the stage; must be a string literal.
+     */
+    explicit TraceSpan(const char* name)
+        : name(name), traceId(ServerTracing::currentTrace()),
+          start(traceId != NO_TRACE_ID ? TraceClock::now() : TraceClock::time_point{}) {}
+    ~TraceSpan() {
+        if (start != TraceClock::time_point{})
+            ServerTracing::record(name, traceId, start, TraceClock::now());
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    TraceId traceId;
+    TraceClock::time_point start;
+};
+
+#endif // SERVER_TRACING_HPP
@@ -0,0 +1,87 @@
+#ifndef SESSION_POOL_HPP
+#define SESSION_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "network.hpp"
+#include "server/server_tracing.hpp"
+
+constexpr std::size_t SESSIONS_PER_SLAB = 64; ///< Sessions the pool makes room for at a time
+
+/**
+ * @struct OutgoingMessage
+ * @brief A serialized message waiting in a session's write queue.
+ */
+struct OutgoingMessage {
+    std::vector<char> data;          ///< Serialized message with its size header
+    TraceId traceId;                 ///< Request that led to the message, for tracing
+    TraceClock::time_point queuedAt; ///< When the message was handed to the session (only set while tracing)
+};
+
+// Type alias for message queue; a vector, as it is written out whole and keeps its capacity when moved
+using MessageQueue = std::vector<OutgoingMessage>;
+
+/**
+ * @struct SessionBuffers
+ * @brief The heap buffers of a session, handed on to the next session when it ends.
+ */
+struct SessionBuffers {
+    std::vector<char> readBuffer;                  ///< Buffer of the session's FrameReader
+    MessageQueue writeQueue;                       ///< Queue of messages to be sent, empty between sessions
+    std::vector<asio::const_buffer> writeBuffers;  ///< Buffers gathered into one write, empty between sessions
+};
+
+/**
+ * @class SessionPool
+ * @brief Slab allocator for the sessions of a server and their buffers.
+ * @details Memory for sessions is carved out of slabs of SESSIONS_PER_SLAB blocks and goes back to
+ * a free list when a session ends, as do its buffers, so a server whose connections come and go
+ * stops allocating once it has seen its peak number of sessions. Thread safe. Sessions keep the pool
+ * alive, since they may be released after the server when the I/O context drops its handlers.
+ */
+class SessionPool {
+public:
+    /**
+     * @brief Create an empty pool.
+     * @param sessionSize Size of a session object; its alignment must not exceed alignof(std::max_align_t).
+     */
+    explicit SessionPool(std::size_t sessionSize);
+
+    /**
+     * @brief Memory for one session, from a new slab if every block is in use.
+     */
+    void* allocate();
+
+    /**
+     * @brief Give back the memory of a session that has been destroyed.
+     */
+    void deallocate(void* block) noexcept;
+
+    /**
+     * @brief Buffers for a new session, those of an ended session when there is one.
+     */
+    SessionBuffers acquireBuffers();
+
+    /**
+     * @brief Take back the buffers of an ended session.
+     * @details A read buffer grown past READ_BUFFER_SIZE for a large message is freed rather than kept.
+     */
+    void releaseBuffers(SessionBuffers buffers) noexcept;
+
+    /**
+     * @brief Number of sessions allocated and not deallocated yet.
+     */
+    std::size_t liveSessions() const;
+
+private:
+    std::size_t blockSize;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<std::byte[]>> slabs; ///< Every slab allocated, kept until the pool goes
+    std::vector<void*> freeBlocks;                   ///< Blocks not holding a session
+    std::vector<SessionBuffers> freeBuffers;         ///< Buffers of ended sessions
+    std::size_t liveCount = 0;
+};
+
+#endif // SESSION_POOL_HPP
@@ -0,0 +1,189 @@
+#ifndef SHARDED_SERVER_HPP
+#define SHARDED_SERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "asio.hpp"
+
+#include "server/lobby.hpp"
+#include "server/server_network.hpp"
+#include "server/spsc_queue.hpp"
+
+constexpr std::size_t LOBBY_SHARD = 0;              ///< Shard the lobby lives on
+constexpr std::size_t SHARD_MAILBOX_CAPACITY = 128; ///< Tasks a mailbox holds before spilling over
+
+// Type alias for the work one shard hands to another
+using ShardTask = std::move_only_function<void()>;
+
+/**
+ * @class ShardMailbox
+ * @brief Carries tasks from one shard to another, in order, through an SpscQueue.
+ * @details The producer only wakes the consumer, by posting a drain to its io_context, when no
+ * drain is pending already, so a burst of tasks costs one cross-thread post. Tasks that find the
+ * queue full wait in an overflow list of the producer, which keeps moving them over as the
+ * consumer makes room.
+ */
+class ShardMailbox {
+public:
+    /**
+     * @brief Constructor.
+     * @param producerContext The io_context of the sending shard.
+     * @param consumerContext The io_context of the receiving shard, which runs the tasks.
+     */
+    ShardMailbox(asio::io_context& producerContext, asio::io_context& consumerContext);
+
+    ShardMailbox(const ShardMailbox&) = delete;
+    ShardMailbox& operator=(const ShardMailbox&) = delete;
+
+    /**
+     * @brief Sends a task to the receiving shard; on the sending shard only.
+     */
+    void send(ShardTask task);
+
+private:
+    /// Wakes the consumer unless a drain is already pending.
+    void scheduleDrain();
+    /// Runs the tasks received so far, on the consumer.
+    void drain();
+    /// Moves the tasks that found the queue full into it, on the producer.
+    void flushOverflow();
+
+    asio::io_context& producerContext;
+    asio::io_context& consumerContext;
+    SpscQueue<ShardTask, SHARD_MAILBOX_CAPACITY> queue;
+    std::atomic<bool> drainPending{false}; ///< Set by the producer when it posts a drain, cleared by the drain
+    std::deque<ShardTask> overflow; ///< Producer's tasks waiting for room in the queue
+    bool flushPending = false; ///< Whether a flush of the overflow is posted (producer only)
+};
+
+class ShardedServer;
+
+/**
+ * @class ServerShard
+ * @brief One shard of a server: an io_context run by its own thread, and the network and tables on it.
+ */
+class ServerShard {
+public:
+    /**
+     * @brief Constructor.
+     * @param server The server the shard belongs to.
+     * @param index Index of the shard.
+     * @param endpoint The TCP endpoint to listen on.
+     * @param reusePort Whether every shard listens on the endpoint, with SO_REUSEPORT.
+     */
+    ServerShard(ShardedServer& server, std::size_t index, const asio::ip::tcp::endpoint& endpoint, bool reusePort);
+
+    asio::io_context& getIoContext();
+    ServerNetwork& getNetwork();
+    const ServerNetwork& getNetwork() const;
+
+private:
+    asio::io_context ioContext; ///< Only ever run by the shard's thread
+    ServerNetwork network;
+};
+
+/**
+ * @class ShardedServer
+ * @brief Server made of shards that share no mutable state, one per core.
+ * @details Every shard accepts connections on the same port (the kernel spreads them with
+ * SO_REUSEPORT), and hosts tables whose sessions and game logic only run on the shard's thread,
+ * pinned to its core. Shards only talk through mailboxes: logins go to the lobby on LOBBY_SHARD,
+ * which seats the player and moves the connection to the shard of their table.
+ */
+class ShardedServer {
+public:
+    /**
+     * @brief Constructor.
+     * @param shardCount Number of shards; more than one needs SO_REUSEPORT.
+     * @param endpoint The TCP endpoint to listen on.
+     * @param playersCount Number of players at each table (2 or 4).
+     * @param mode SingleGame to host one game and shut down when it ends.
+     */
+    ShardedServer(std::size_t shardCount, const asio::ip::tcp::endpoint& endpoint, std::size_t playersCount,
+        HostingMode mode);
+    ~ShardedServer();
+
+    ShardedServer(const ShardedServer&) = delete;
+    ShardedServer& operator=(const ShardedServer&) = delete;
+
+    /**
+     * @brief Accepts connections on every shard and runs them, the first one on the calling thread,
+     * until stop() is called.
+     */
+    void run();
+
+    /**
+     * @brief Stops every shard. Thread safe.
+     */
+    void stop();
+
+    /**
+     * @brief Sets the rate limit applied to the game actions of each client connecting from now on.
+     * @param actionsPerSecond Actions allowed per second in the long run; 0 disables the limit.
+     * @param burst Actions allowed in a burst.
+     */
+    void setActionRateLimit(double actionsPerSecond, double burst);
+
+    /**
+     * @brief Sets the most compact wire format granted to clients asking for it.
+     */
+    void setWireFormat(WireFormat format);
+
+    std::size_t getShardCount() const;
+    ServerShard& getShard(std::size_t index);
+    std::size_t getPlayersCount() const;
+    HostingMode getHostingMode() const;
+
+    /**
+     * @brief Gets the number of sessions alive on every shard.
+     */
+    std::size_t getLiveSessionCount() const;
+
+    /**
+     * @brief Runs a task on another shard, or later on the same one.
+     * @param from Index of the shard calling, whose mailbox to the other shard is used.
+     * @param to Index of the shard to run the task on.
+     * @param task The task.
+     */
+    void send(std::size_t from, std::size_t to, ShardTask task);
+
+    /// --- Lobby (called by the shards' networks) ---
+
+    /**
+     * @brief Asks the lobby for a seat for a player who logged in on a shard.
+     * @details The answer comes back to that shard, which seats the player, moves them or turns them down.
+     */
+    void requestSeat(std::size_t from, SessionPtr session);
+
+    /**
+     * @brief Takes a connection released by a shard to the shard of its table, if the table is still open.
+     */
+    void forwardConnection(std::size_t from, ConnectionHandoff connection, TableSeat seat);
+
+    /**
+     * @brief Tells the lobby a player's connection was lost before they sat down.
+     */
+    void abandonSeat(std::size_t from, const std::string& playerName, TableSeat seat);
+
+    /**
+     * @brief Tells the lobby a shard closed one of its tables.
+     */
+    void reportTableClosed(std::size_t from, TableId table);
+
+private:
+    std::size_t playersCount;
+    HostingMode mode;
+    std::vector<std::unique_ptr<ServerShard>> shards;
+    /// Mailbox of each pair of shards, at [from * shardCount + to], made when first used by its producer
+    std::vector<std::unique_ptr<ShardMailbox>> mailboxes;
+    Lobby lobby; ///< Only touched on LOBBY_SHARD
+    std::vector<std::thread> threads; ///< Threads running the shards but the first
+};
+
+#endif // SHARDED_SERVER_HPP
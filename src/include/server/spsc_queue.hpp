@@ -0,0 +1,67 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+constexpr std::size_t CACHE_LINE_SIZE = 64; ///< Kept apart so the two ends of a queue do not share a line
+
+/**
+ * @class SpscQueue
+ * @brief Bounded lock-free queue between one producer thread and one consumer thread.
+ * @details A ring of Capacity slots. Each end owns its index and keeps a copy of the other one,
+ * only reloading it when the ring looks full (producer) or empty (consumer), so the cache line of
+ * the other end is only fetched when needed.
+ * @tparam T Type of the elements, default constructible and movable.
+ * @tparam Capacity Number of slots, a power of two.
+ */
+template <class T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity should be a power of two");
+
+public:
+    /**
+     * @brief Append an element; producer only.
+     * @return False, leaving the value untouched, if the queue is full.
+     */
+    bool tryPush(T&& value) {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == Capacity)
+                return false;
+        }
+        slots[position & (Capacity - 1)] = std::move(value);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest element; consumer only.
+     * @return False if the queue is empty.
+     */
+    bool tryPop(T& value) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail)
+                return false;
+        }
+        T& slot = slots[position & (Capacity - 1)];
+        value = std::move(slot);
+        slot = T{}; // Whatever the element held goes now, not when the slot is reused
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head{0}; ///< Next slot to pop, written by the consumer
+    std::size_t cachedTail = 0;                                 ///< Consumer's copy of tail
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail{0}; ///< Next slot to push, written by the producer
+    std::size_t cachedHead = 0;                                 ///< Producer's copy of head
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> slots{};
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,48 @@
+#ifndef TOKEN_BUCKET_HPP
+#define TOKEN_BUCKET_HPP
+
+#include <algorithm>
+#include <chrono>
+
+/**
+ * @class TokenBucket
+ * @brief Rate limiter allowing bursts of up to capacity events, refilled at a steady rate.
+ * @details Not thread safe; each bucket is meant to be used by a single session.
+ */
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Create a full bucket.
+     * @param capacity Largest burst allowed.
+     * @param refillPerSecond Events allowed per second in the long run; 0 disables the limit.
+     */
+    TokenBucket(double capacity, double refillPerSecond)
+        : capacity(capacity), refillPerSecond(refillPerSecond), tokens(capacity), lastRefill(Clock::now()) {}
+
+    /**
+     * @brief Take a token if one is available.
+     * @param now The current time.
+     * @return Whether the event is allowed.
+     */
+    bool tryConsume(Clock::time_point now = Clock::now()) {
+        if (refillPerSecond <= 0)
+            return true;
+        std::chrono::duration<double> elapsed = now - lastRefill;
+        tokens = std::min(capacity, tokens + elapsed.count() * refillPerSecond);
+        lastRefill = now;
+        if (tokens < 1)
+            return false;
+        tokens -= 1;
+        return true;
+    }
+
+private:
+    double capacity;
+    double refillPerSecond;
+    double tokens;
+    Clock::time_point lastRefill;
+};
+
+#endif // TOKEN_BUCKET_HPP
@@ -11,8 +11,9 @@
 #include "hand.hpp"
 #include "player.hpp"
 #include "team_round_state.hpp"
+#include "speculative_state.hpp"
 #include "server/server_deck.hpp"
-#include "server/rule_engine.hpp" // For MeldProposal definition and static methods
+#include "rule_engine.hpp" // For MeldProposal definition and static methods
 
 
 /**
@@ -142,27 +143,27 @@ private:
     /**
      * @brief Processes the rank initialization proposals and validates them.
      * @param rankInitializationProposals The proposals for initializing rank melds.
-     * @return An error message if any issue occurs, or void on success.
+     * @return An error message if any issue occurs, or one proof per proposal on success.
      */
-    std::expected<void, TurnActionResult> processRankInitializationProposals
+    std::expected<std::vector<MeldProof>, TurnActionResult> processRankInitializationProposals
     (const std::vector<RankMeldProposal>& rankInitializationProposals) const;
 
     /**
      * @brief Processes the Black Three initialization proposal and validates it.
      * @param blackThreeProposal The proposal for initializing a Black Three meld.
      * @param canGoingOut Indicates if the player can go out this turn.
-     * @return An error message if any issue occurs, or void on success.
+     * @return An error message if any issue occurs, or the proof of the proposal (if any) on success.
      */
-    std::expected<void, TurnActionResult> processBlackThreeInitializationProposal
+    std::expected<std::optional<MeldProof>, TurnActionResult> processBlackThreeInitializationProposal
     (const std::optional<BlackThreeMeldProposal>& blackThreeProposal,
         bool canGoingOut) const;
 
     /**
      * @brief Processes the rank addition proposals and validates them.
      * @param rankAdditionProposals The proposals for adding cards to existing melds.
-     * @return An error message if any issue occurs, or void on success.
+     * @return An error message if any issue occurs, or one proof per proposal on success.
      */
-    std::expected<void, TurnActionResult> processRankAdditionProposals
+    std::expected<std::vector<MeldProof>, TurnActionResult> processRankAdditionProposals
     (const std::vector<RankMeldProposal>& rankAdditionProposals) const;
 
     /**
@@ -195,12 +196,20 @@ private:
         const MeldCommitment& AddToExistingCommitment) const;
 
     /**
-     * @brief Initializes the rank melds based on the proposals.
+     * @brief Stages the validated rank meld proposals, so the checks that depend on the melds made
+     * can run before anything is changed.
+     * @param speculation The speculative state over the player's hand and the team melds.
      * @param rankInitializationProposals The proposals for initializing rank melds.
+     * @param initializationProofs The proofs of the initialization proposals, in order.
+     * @param additionProposals The proposals for adding cards to existing melds.
+     * @param additionProofs The proofs of the addition proposals, in order.
+     * @return An error message if proposals of the same rank do not fit together, or void on success.
      */
-    void initializeRankMelds
-    (const std::vector<RankMeldProposal>& rankInitializationProposals);
-
+    static std::expected<void, TurnActionResult> stageRankMelds(SpeculativeState& speculation,
+        const std::vector<RankMeldProposal>& rankInitializationProposals,
+        const std::vector<MeldProof>& initializationProofs,
+        const std::vector<RankMeldProposal>& additionProposals,
+        const std::vector<MeldProof>& additionProofs);
     /**
      * @brief Reverts the initialization of rank melds based on the proposals.
      * @param rankInitializationProposals The proposals for initializing rank melds.
@@ -208,13 +217,6 @@ private:
     void revertRankMeldsInitialization
     (const std::vector<RankMeldProposal>& rankInitializationProposals);
 
-    /**
-     * @brief Adds cards to existing melds based on the proposals.
-     * @param additionProposals The proposals for adding cards to existing melds.
-     */
-    void addCardsToExistingMelds
-    (const std::vector<RankMeldProposal>& additionProposals);
-
     /**
      * @brief Reverts the addition of cards to existing melds based on the proposals.
      * @param additionProposals The proposals for adding cards to existing melds.
@@ -222,13 +224,6 @@ private:
     void revertRankMeldsAddition
     (const std::vector<RankMeldProposal>& additionProposals);
 
-    /**
-     * @brief Initializes the Black Three meld based on the proposal.
-     * @param blackThreeProposal The proposal for initializing a Black Three meld.
-     */
-    void initializeBlackThreeMeld
-    (const std::optional<BlackThreeMeldProposal>& blackThreeProposal);
-
     /**
      * @brief Reverts taking the discard pile.
      */
@@ -0,0 +1,91 @@
+#ifndef BATCH_SIMULATOR_HPP
+#define BATCH_SIMULATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "simulator/simulation.hpp"
+
+/**
+ * @class BatchSimulator
+ * @brief Plays many rounds in lockstep with the SimulationPolicy, on a structure of arrays.
+ * @details The state of all rounds is kept in columns indexed by round: card counts per hand, deck
+ * sizes, discard piles and meld sizes. Every step plays one turn of every running round, one phase
+ * at a time (draw, take, meld, discard), and the final scoring runs as loops over whole columns.
+ * The rules are a re-implementation of the RuleEngine checks, restricted to the actions the policy
+ * can make, and must give the same results as ScalarSimulator for every seed.
+ */
+class BatchSimulator {
+public:
+    /**
+     * @brief Constructor for BatchSimulator.
+     * @param playerCount Number of players per round, 2 or 4; players alternate between the two teams.
+     */
+    explicit BatchSimulator(std::size_t playerCount);
+
+    /**
+     * @brief Play one round per seed.
+     * @param seeds Seeds of the deck shuffles.
+     * @return The outcome of each round, in the order of the seeds.
+     */
+    std::vector<SimulationResult> run(std::span<const std::uint32_t> seeds);
+
+private:
+    static constexpr std::uint8_t NO_CARD = CARD_KIND_COUNT; ///< Empty discard pile top, or no rank taken
+
+    /**
+     * @brief State of a round in the batch.
+     */
+    enum class RoundStatus : std::uint8_t {
+        Running,
+        WentOut,
+        DeckExhausted,
+        Stalled
+    };
+
+    std::size_t playerCount;
+    std::size_t gameCount = 0;
+    std::vector<std::uint32_t> runningGames; ///< Rounds not finished yet
+
+    // Columns, indexed by [... * gameCount + game]
+    std::vector<std::uint8_t> decks;        ///< [game * SIMULATION_DECK_SIZE + position], drawn from the back
+    std::vector<std::uint8_t> deckSizes;    ///< [game]
+    std::vector<std::uint8_t> deckEmpty;    ///< [game] a draw found the deck empty
+    std::vector<std::uint8_t> pileCounts;   ///< [kind * gameCount + game]
+    std::vector<std::uint8_t> pileSizes;    ///< [game]
+    std::vector<std::uint8_t> pileTops;     ///< [game] kind of the top card, NO_CARD if empty
+    std::vector<std::uint8_t> pileFrozen;   ///< [game]
+    std::vector<std::uint8_t> hands;        ///< [(player * CARD_KIND_COUNT + kind) * gameCount + game]
+    std::vector<std::uint8_t> handSizes;    ///< [player * gameCount + game]
+    std::vector<std::uint8_t> melds;        ///< [(team * RANK_MELD_COUNT + rank meld) * gameCount + game]
+    std::vector<std::uint8_t> redThrees;    ///< [team * gameCount + game]
+    std::vector<std::uint8_t> takenRanks;   ///< [game] rank of the pile taken this turn, NO_CARD if none
+    std::vector<std::uint8_t> statuses;     ///< [game] RoundStatus
+    std::vector<std::uint8_t> winningTeams; ///< [game] team of the player who went out
+    std::vector<std::uint32_t> turns;       ///< [game]
+    std::vector<std::int32_t> scores;       ///< [team * gameCount + game]
+    std::vector<PolicyView> views;          ///< [game] view of the current player, from the meld to the discard phase
+
+    std::uint8_t& hand(std::size_t player, std::size_t kind, std::size_t game) {
+        return hands[(player * CARD_KIND_COUNT + kind) * gameCount + game];
+    }
+    std::uint8_t& meld(std::size_t team, std::size_t rankMeld, std::size_t game) {
+        return melds[(team * RANK_MELD_COUNT + rankMeld) * gameCount + game];
+    }
+
+    void reset(std::size_t games);
+    void dealRound(std::size_t game, std::uint32_t seed);
+    PolicyView makeView(std::size_t player, std::size_t game);
+    void finishRound(std::size_t game, RoundStatus status);
+
+    // --- Lockstep phases, over all running rounds ---
+    void drawPhase(std::size_t player);
+    void takePhase(std::size_t player);
+    void meldPhase(std::size_t player);
+    void discardPhase(std::size_t player, std::uint32_t turn);
+    void scorePhase();
+    std::uint64_t digestState(std::size_t game) const;
+};
+
+#endif // BATCH_SIMULATOR_HPP
@@ -0,0 +1,132 @@
+#ifndef BELIEF_MODEL_HPP
+#define BELIEF_MODEL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include "simulator/simulation.hpp"
+
+constexpr std::size_t BELIEF_LOCATION_COUNT = SIMULATION_MAX_PLAYERS + 2; ///< The hands, the deck and the buried pile cards
+
+/**
+ * @struct TurnObservation
+ * @brief What a successful turn changed, as the players see it once the turn is broadcast.
+ * @details Everything but pickedUp is public. pickedUp is only read by the model of the player who made the turn.
+ */
+struct TurnObservation {
+    std::size_t player = 0;
+    bool tookPile = false;                                 ///< Took the discard pile instead of drawing
+    std::uint8_t cardsDrawn = 0;                           ///< Cards taken off the deck, red threes included
+    std::uint8_t redThreesSetAside = 0;                    ///< Red threes drawn and set aside for the team
+    std::array<std::uint8_t, CARD_KIND_COUNT> pickedUp{};  ///< Cards added to the hand, the drawn card or the whole pile
+    std::array<std::uint8_t, CARD_KIND_COUNT> melded{};    ///< Cards moved from the hand to the team melds
+    std::uint8_t discard = CARD_KIND_COUNT;                ///< cardKindIndex of the discarded card, CARD_KIND_COUNT if none
+};
+
+/**
+ * @struct BeliefModelOptions
+ * @brief How much the choices of a player say about the cards they keep hidden.
+ * @details Each factor scales the weight of the naturals of a rank in the hidden part of the hand;
+ * 1 ignores the evidence, 0 rules the rank out. Cards drawn later start again at weight 1.
+ */
+struct BeliefModelOptions {
+    double meldFactor = 0.2;     ///< After melding naturals of a rank: the rest of the rank was likely melded too
+    double discardFactor = 0.5;  ///< After discarding a natural: players seldom throw away a rank they collect
+    double declineFactor = 1.0;  ///< After drawing instead of taking a pile with a natural on top
+    std::size_t iterations = 12; ///< Balancing passes when the probabilities are recomputed
+};
+
+/**
+ * @struct BeliefSample
+ * @brief A determinization: every hidden card given a place, drawn from the belief of one player.
+ * @details Samples are drawn from the card counting prior and weighted by the evidence (importance sampling);
+ * only the ratios between the weights of samples from the same model are meaningful.
+ */
+struct BeliefSample {
+    std::array<std::array<std::uint8_t, CARD_KIND_COUNT>, SIMULATION_MAX_PLAYERS> hands{};
+    std::array<std::uint8_t, CARD_KIND_COUNT> pile{};      ///< Every card of the discard pile, buried ones included
+    std::array<std::uint8_t, SIMULATION_DECK_SIZE> deck{};  ///< Card kinds, drawn from the back
+    std::size_t deckSize = 0;
+    double weight = 1;
+};
+
+/**
+ * @class BeliefModel
+ * @brief What one player can infer about the cards they cannot see, updated after every turn.
+ * @details Card counting gives how many copies of each kind are still hidden, and where hidden cards lie: in
+ * the other hands, in the deck, or buried in the discard pile (wild cards and black threes dealt under its first
+ * natural). Cards a player took with the pile stay known to be in their hand until they are melded or discarded.
+ * The evidence of the turns weights ranks per hand (BeliefModelOptions). The probabilities balance the weights
+ * so that every place holds its number of hidden cards and every kind its number of hidden copies, by iterative
+ * proportional fitting. Updates only touch counters; the balancing runs on the next query, in a few microseconds.
+ */
+class BeliefModel {
+public:
+    /**
+     * @brief Belief of a player right after the deal, from the public part of the deal and their own hand.
+     * @param playerCount Number of players, 2 or 4; players alternate between the two teams.
+     * @param observer Seat of the player holding the belief.
+     */
+    BeliefModel(const SimulationDeal& deal, std::size_t playerCount, std::size_t observer, BeliefModelOptions options = {});
+
+    /**
+     * @brief Account for a successful turn of any player, the observer included.
+     */
+    void observe(const TurnObservation& turn);
+
+    /**
+     * @brief Expected number of cards of each kind in the hand of a player; exact for the observer.
+     * @return Per kind counts adding up to the hand size; divide by it for the probability of each kind per card.
+     */
+    const std::array<double, CARD_KIND_COUNT>& expectedHand(std::size_t player);
+
+    /**
+     * @brief Get the number of cards in the hand of a player.
+     */
+    std::size_t getHandSize(std::size_t player) const;
+
+    /**
+     * @brief Draw a determinization of the hidden cards.
+     * @details Buried pile cards are placed first, then the hidden cards of each hand, then the deck in random
+     * order. Each card is drawn in proportion to its hidden copies times its weight at that place.
+     */
+    BeliefSample sample(std::mt19937_64& generator) const;
+
+private:
+    enum Location : std::size_t {
+        DeckLocation = SIMULATION_MAX_PLAYERS,
+        BuriedPileLocation
+    };
+
+    BeliefModelOptions options;
+    std::size_t playerCount;
+    std::size_t observer;
+    std::array<std::uint8_t, CARD_KIND_COUNT> hiddenCopies{};  ///< Copies of every kind the observer has not seen
+    std::array<std::size_t, BELIEF_LOCATION_COUNT> hiddenSlots{};
+    std::array<std::array<double, CARD_KIND_COUNT>, BELIEF_LOCATION_COUNT> weights{};
+    std::array<std::array<std::uint8_t, CARD_KIND_COUNT>, SIMULATION_MAX_PLAYERS> knownCards{}; ///< Seen in each hand
+    std::array<std::uint8_t, CARD_KIND_COUNT> knownPile{};     ///< Cards seen going to the discard pile
+    std::uint8_t pileTop = CARD_KIND_COUNT;
+    std::array<std::array<double, CARD_KIND_COUNT>, BELIEF_LOCATION_COUNT> expected{};
+    bool expectedUpToDate = false;
+
+    /**
+     * @brief Remove a card the player melded or discarded from their hand, known cards first.
+     */
+    void revealFromHand(std::size_t player, std::size_t kind, std::uint8_t count);
+    /**
+     * @brief Add hidden cards to a place, their weights starting from the ones of the place they come from.
+     */
+    void addHiddenSlots(std::size_t location, std::size_t from, std::size_t count);
+    /**
+     * @brief Scale the weight of the naturals of a rank in the hidden part of a hand.
+     */
+    void weighRank(std::size_t player, Rank rank, double factor);
+    /**
+     * @brief Recompute the expected hidden cards of every place.
+     */
+    void balance();
+};
+
+#endif // BELIEF_MODEL_HPP
@@ -0,0 +1,272 @@
+#ifndef ENDGAME_SOLVER_HPP
+#define ENDGAME_SOLVER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "simulator/simulation.hpp"
+#include "simulator/belief_model.hpp"
+
+constexpr std::size_t ENDGAME_MAX_MOVES = 128;          ///< 2 ways to pick up x 2 meld plans x the cards to discard
+constexpr std::uint8_t ENDGAME_NO_DISCARD = CARD_KIND_COUNT; ///< The turn went out by melding its last cards
+
+/**
+ * @struct EndgameMove
+ * @brief A whole turn of a player: how the cards are picked up, which ranks are melded and what is discarded.
+ */
+struct EndgameMove {
+    bool takePile = false;                       ///< Take the discard pile instead of drawing
+    MeldPlan plan = 0;                           ///< Ranks melded, all their naturals together
+    std::uint8_t discard = ENDGAME_NO_DISCARD;   ///< cardKindIndex of the discarded card
+
+    bool operator==(const EndgameMove& other) const = default;
+};
+
+/**
+ * @struct EndgameMoveList
+ * @brief The moves of a position, in a fixed buffer so the search does not allocate.
+ */
+struct EndgameMoveList {
+    std::array<EndgameMove, ENDGAME_MAX_MOVES> moves{};
+    std::size_t size = 0;
+};
+
+/**
+ * @class EndgameState
+ * @brief A determinized round position: every hand and the order of the remaining deck are known.
+ * @details The players make the moves of the simulated players (SimulationPolicy) and any discard: draw or
+ * take the pile, meld all the naturals the policy would meld or nothing, then discard any card. With the deck
+ * order known, drawing is deterministic, so the round is a two-team game of perfect information.
+ */
+class EndgameState {
+public:
+    /**
+     * @brief Position at the start of a dealt round, first player to move.
+     * @param playerCount Number of players, 2 or 4; players alternate between the two teams.
+     */
+    static EndgameState fromDeal(const SimulationDeal& deal, std::size_t playerCount);
+
+    /**
+     * @brief Check whether the round is over.
+     */
+    bool isOver() const { return status != Status::Running; }
+
+    /**
+     * @brief Get the number of cards left in the main deck.
+     */
+    std::size_t getDeckSize() const { return deckSize; }
+
+    /**
+     * @brief Get the seat of the player to move.
+     */
+    std::size_t getCurrentPlayer() const { return currentPlayer; }
+
+    /**
+     * @brief Get the team of the player to move.
+     */
+    std::size_t getCurrentTeam() const { return currentPlayer % SIMULATION_TEAM_COUNT; }
+
+    /**
+     * @brief Get the hand of a player, by cardKindIndex.
+     */
+    const std::array<std::uint8_t, CARD_KIND_COUNT>& getHand(std::size_t player) const { return hands[player]; }
+
+    /**
+     * @brief Get the number of cards in the hand of a player.
+     */
+    std::size_t getHandSize(std::size_t player) const { return handSizes[player]; }
+
+    /**
+     * @brief Get the number of players, 2 or 4.
+     */
+    std::size_t getPlayerCount() const { return playerCount; }
+
+    /**
+     * @brief Get the size of the meld of every rank of a team, by rankMeldIndex; 0 if not initialized.
+     */
+    const std::array<std::uint8_t, RANK_MELD_COUNT>& getMelds(std::size_t team) const { return melds[team]; }
+
+    /**
+     * @brief Get the number of red threes set aside for a team.
+     */
+    std::size_t getRedThrees(std::size_t team) const { return redThrees[team]; }
+
+    /**
+     * @brief Get the number of cards in the discard pile.
+     */
+    std::size_t getPileSize() const { return pileSize; }
+
+    /**
+     * @brief Get the cardKindIndex of the top card of the discard pile, CARD_KIND_COUNT if the pile is empty.
+     */
+    std::size_t getPileTop() const { return pileTop; }
+
+    /**
+     * @brief Check whether the discard pile is frozen.
+     */
+    bool isPileFrozen() const { return pileFrozen; }
+
+    /**
+     * @brief List the legal moves of the player to move; empty when the player cannot finish a turn.
+     */
+    void generateMoves(EndgameMoveList& list) const;
+
+    /**
+     * @brief Get the position after a legal move, with the next player to move (also when the move ends the round).
+     * @param observation If given, receives what the move changed, to feed the BeliefModel of the players.
+     */
+    EndgameState play(const EndgameMove& move, TurnObservation* observation = nullptr) const;
+
+    /**
+     * @brief Get the position with the hidden cards placed as in a sample of a BeliefModel.
+     * @details Hands, discard pile and deck are replaced; the sample must come from a model kept up to date
+     * with this position, so every hand and the deck keep their sizes.
+     */
+    EndgameState determinize(const BeliefSample& sample) const;
+
+    /**
+     * @brief Get the position with the round ended as is, for a player left without a legal move.
+     */
+    EndgameState endRound() const;
+
+    /**
+     * @brief Get the move the simulated players would make, if they have one.
+     */
+    std::optional<EndgameMove> policyMove() const;
+
+    /**
+     * @brief Calculate the round score of both teams as if the round ended now, with the going out bonus once over.
+     */
+    std::array<int, SIMULATION_TEAM_COUNT> teamScores() const;
+
+    /**
+     * @brief Score difference between the team to move and the other team.
+     */
+    int scoreForCurrentTeam() const;
+
+    /**
+     * @brief Zobrist hash of the position, with the same keys and places as RoundManager::getStateHash().
+     */
+    std::uint64_t hash() const;
+
+private:
+    enum class Status : std::uint8_t {
+        Running,
+        WentOut,
+        DeckExhausted
+    };
+
+    std::array<std::uint8_t, SIMULATION_DECK_SIZE> deck{};  ///< Card kinds, drawn from the back
+    std::uint8_t deckSize = 0;
+    std::array<std::array<std::uint8_t, CARD_KIND_COUNT>, SIMULATION_MAX_PLAYERS> hands{};
+    std::array<std::uint8_t, SIMULATION_MAX_PLAYERS> handSizes{};
+    std::array<std::array<std::uint8_t, RANK_MELD_COUNT>, SIMULATION_TEAM_COUNT> melds{};
+    std::array<std::uint8_t, SIMULATION_TEAM_COUNT> redThrees{};
+    std::array<std::uint8_t, CARD_KIND_COUNT> pile{};
+    std::uint8_t pileSize = 0;
+    std::uint8_t pileTop = CARD_KIND_COUNT;                 ///< CARD_KIND_COUNT if the pile is empty
+    bool pileFrozen = false;
+    std::uint8_t playerCount = 2;
+    std::uint8_t currentPlayer = 0;
+    Status status = Status::Running;
+    std::uint8_t winningTeam = 0;                           ///< Team of the player who went out
+
+    bool canDraw() const;
+    bool canTakePile() const;
+    PolicyView makeView() const;
+
+    /**
+     * @brief Draw a card or take the pile into the current hand.
+     * @return Rank of the top card taken, to be honored by the melds.
+     */
+    std::optional<Rank> pickUp(bool takePile);
+};
+
+/**
+ * @struct EndgameSolverOptions
+ * @brief Limits of an endgame search.
+ */
+struct EndgameSolverOptions {
+    std::chrono::milliseconds timeBudget{100}; ///< Iterative deepening stops starting new iterations after this
+    std::size_t threadCount = 1;               ///< Threads searching the same position (lazy SMP)
+    std::size_t maxDepth = 64;                 ///< Turns searched at most
+    std::size_t tableSizeLog2 = 20;            ///< Transposition table entries, as a power of two
+};
+
+/**
+ * @struct EndgameResult
+ * @brief The best move found and its value.
+ */
+struct EndgameResult {
+    EndgameMove bestMove;
+    int value = 0;              ///< Score difference for the team to move, with both teams playing their best
+    std::size_t depth = 0;      ///< Turns searched by the last finished iteration
+    bool exact = false;         ///< Every line was searched to the end of the round, so the value is exact
+    std::uint64_t nodes = 0;    ///< Positions visited by all the threads
+    double seconds = 0;
+
+    double nodesPerSecond() const { return seconds > 0 ? static_cast<double>(nodes) / seconds : 0; }
+};
+
+/**
+ * @class EndgameSolver
+ * @brief Alpha-beta search of an EndgameState, meant for the last turns of a round when the deck is nearly empty.
+ * @details Negamax over whole turns with a transposition table keyed by EndgameState::hash(), the table move and
+ * the melds tried first, and iterative deepening until the time budget runs out or the search reaches the end
+ * of the round on every line. Extra threads run the same iterative deepening with other move orders and share
+ * the table (lazy SMP); the result is the one of the main thread. Positions cut at the depth limit are scored
+ * as if the round ended there.
+ */
+class EndgameSolver {
+public:
+    /**
+     * @brief Constructor for EndgameSolver; allocates the transposition table.
+     */
+    explicit EndgameSolver(EndgameSolverOptions options = {});
+
+    /**
+     * @brief Search the position for the best move of the player to move.
+     * @param root A running position where the player to move has a legal move.
+     */
+    EndgameResult solve(const EndgameState& root);
+
+private:
+    /**
+     * @brief Transposition table entry, written without locks: the key is stored XORed with the data,
+     * so an entry torn by two threads writing at once fails the key check.
+     */
+    struct TableEntry {
+        std::atomic<std::uint64_t> keyXorData{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    /**
+     * @brief Search state of one thread.
+     */
+    struct Worker {
+        std::size_t index = 0;
+        std::uint64_t nodes = 0;
+        bool canStop = false;      ///< False until an iteration is finished, so there is always a move
+        bool stopped = false;
+        EndgameMove bestMove;      ///< Best root move of the current iteration
+    };
+
+    EndgameSolverOptions options;
+    std::vector<TableEntry> table;
+    std::atomic<bool> stop{false};
+    std::uint64_t generation = 0;  ///< Number of searches, tags the table entries they write
+    std::chrono::steady_clock::time_point deadline;
+
+    int search(const EndgameState& state, std::size_t depth, std::size_t ply, int alpha, int beta,
+        bool& complete, Worker& worker);
+    void orderMoves(EndgameMoveList& list, std::optional<EndgameMove> tableMove, const Worker& worker) const;
+    std::optional<std::uint64_t> probe(std::uint64_t key) const;
+    void store(std::uint64_t key, std::uint64_t data);
+    void iterate(Worker& worker, std::size_t firstDepth, const EndgameState& root, EndgameResult* result);
+};
+
+#endif // ENDGAME_SOLVER_HPP
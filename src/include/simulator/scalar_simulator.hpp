@@ -0,0 +1,35 @@
+#ifndef SCALAR_SIMULATOR_HPP
+#define SCALAR_SIMULATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "simulator/simulation.hpp"
+
+/**
+ * @class ScalarSimulator
+ * @brief Plays rounds one at a time through the server's RoundManager, with the SimulationPolicy.
+ * @details This is the reference the batch simulator is checked against: every rule is enforced by
+ * the same TurnManager and RuleEngine code as in a networked game.
+ */
+class ScalarSimulator {
+public:
+    /**
+     * @brief Constructor for ScalarSimulator.
+     * @param playerCount Number of players per round, 2 or 4; players alternate between the two teams.
+     */
+    explicit ScalarSimulator(std::size_t playerCount);
+
+    /**
+     * @brief Play one round.
+     * @param seed Seed of the deck shuffle.
+     * @param stateHashes If given, receives RoundManager::getStateHash() after the deal and after every action.
+     * @return The outcome of the round.
+     */
+    SimulationResult run(std::uint32_t seed, std::vector<std::uint64_t>* stateHashes = nullptr) const;
+
+private:
+    std::size_t playerCount;
+};
+
+#endif // SCALAR_SIMULATOR_HPP
@@ -0,0 +1,198 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "card.hpp"
+
+constexpr std::size_t SIMULATION_TEAM_COUNT = 2;
+constexpr std::size_t SIMULATION_MAX_PLAYERS = 4;
+constexpr std::size_t SIMULATION_DECK_SIZE = 108;
+constexpr std::size_t RANK_MELD_COUNT = static_cast<std::size_t>(Rank::Ace) - static_cast<std::size_t>(Rank::Four) + 1;
+constexpr std::uint32_t SIMULATION_MAX_TURNS = 1000; ///< Rounds still running after this many turns are stalled
+
+/**
+ * @brief Index of the meld of a rank among the RANK_MELD_COUNT rank melds (Four to Ace).
+ */
+constexpr std::size_t rankMeldIndex(Rank rank) {
+    return static_cast<std::size_t>(rank) - static_cast<std::size_t>(Rank::Four);
+}
+
+/**
+ * @brief Rank of the meld at a rankMeldIndex.
+ */
+constexpr Rank rankOfMeld(std::size_t rankMeld) {
+    return static_cast<Rank>(static_cast<std::size_t>(Rank::Four) + rankMeld);
+}
+
+/**
+ * @brief Whether discarding a card of this type freezes the discard pile (wild cards and black threes).
+ */
+constexpr bool freezesDiscardPile(CardType type) {
+    return type == CardType::BlackThree || type == CardType::Wild;
+}
+
+/**
+ * @struct CardKindInfo
+ * @brief Rank, color, type and points of one of the CARD_KIND_COUNT distinct cards.
+ */
+struct CardKindInfo {
+    Rank rank;
+    CardColor color;
+    CardType type;
+    int points;
+};
+
+/**
+ * @brief Get the CardKindInfo of every card, indexed by cardKindIndex.
+ */
+const std::array<CardKindInfo, CARD_KIND_COUNT>& cardKindInfos();
+
+/**
+ * @enum SimulationOutcome
+ * @brief How a simulated round ended.
+ */
+enum class SimulationOutcome : std::uint8_t {
+    WentOut,       ///< A player went out
+    DeckExhausted, ///< The main deck ran out and the discard pile could not be taken
+    Stalled,       ///< The policy had no acceptable action left, or the turn limit was hit
+};
+
+/**
+ * @struct SimulationResult
+ * @brief Outcome of one simulated round, compared field by field between the simulators.
+ */
+struct SimulationResult {
+    SimulationOutcome outcome = SimulationOutcome::Stalled;
+    std::uint32_t turns = 0;                                 ///< Turns passed on to the next player
+    std::array<int, SIMULATION_TEAM_COUNT> teamScores{};     ///< Round scores, zero when stalled
+    std::uint64_t stateDigest = 0;                           ///< Digest of the final hands, melds and deck
+
+    bool operator==(const SimulationResult& other) const = default;
+};
+
+/**
+ * @struct PolicyView
+ * @brief What the simulation policy sees of the round: the hand of the current player and the team melds.
+ * @details The simulated players only meld naturals, so a meld is fully described by its card count.
+ */
+struct PolicyView {
+    std::array<std::uint8_t, CARD_KIND_COUNT> hand{};     ///< Cards in hand, by cardKindIndex
+    std::size_t handSize = 0;                              ///< Total number of cards in hand
+    std::array<std::uint8_t, RANK_MELD_COUNT> melds{};    ///< Cards in the team meld of each rank, 0 if not initialized
+    std::size_t canastaCount = 0;                          ///< Canastas of the team
+};
+
+/**
+ * @brief Number of naturals of a rank in the hand of a view, both colors together.
+ */
+inline std::size_t naturalsOfRank(const PolicyView& view, Rank rank) {
+    return view.hand[cardKindIndex(rank, CardColor::RED)] + view.hand[cardKindIndex(rank, CardColor::BLACK)];
+}
+
+/**
+ * @struct SimulationDeal
+ * @brief A round as dealt by RoundManager, as card counts: the same seed gives the same deal as ServerDeck.
+ */
+struct SimulationDeal {
+    std::array<std::uint8_t, SIMULATION_DECK_SIZE> deck{};  ///< Card kinds, drawn from the back
+    std::size_t deckSize = 0;
+    std::array<std::uint8_t, CARD_KIND_COUNT> pile{};      ///< Discard pile cards, by cardKindIndex
+    std::size_t pileSize = 0;
+    std::uint8_t pileTop = CARD_KIND_COUNT;                 ///< Kind of the top card, CARD_KIND_COUNT if empty
+    bool pileFrozen = false;
+    std::array<std::array<std::uint8_t, CARD_KIND_COUNT>, SIMULATION_MAX_PLAYERS> hands{};
+    std::array<std::uint8_t, SIMULATION_MAX_PLAYERS> handSizes{};
+    std::array<std::uint8_t, SIMULATION_TEAM_COUNT> redThrees{}; ///< Red threes dealt, set aside for the team
+};
+
+/**
+ * @brief Deal a round: shuffle like ServerDeck, build the initial discard pile and deal the hands.
+ * @param seed Seed of the deck shuffle.
+ * @param playerCount Number of players, 2 or 4; players alternate between the two teams.
+ */
+SimulationDeal dealSimulatedRound(std::uint32_t seed, std::size_t playerCount);
+
+/**
+ * @brief Set of ranks to meld this turn, one bit per rankMeldIndex; all the naturals of a rank are melded together.
+ */
+using MeldPlan = std::uint16_t;
+
+/**
+ * @class SimulationPolicy
+ * @brief The fixed strategy played by every simulated player, shared by the scalar and batch simulators.
+ * @details The player draws from the deck, and takes the discard pile only once the deck is empty.
+ * It melds whole groups of naturals, keeping enough cards to discard, and discards its least useful card.
+ * The policy does not check the initial meld threshold itself, so the rule engines get to reject plans.
+ */
+class SimulationPolicy {
+public:
+    SimulationPolicy() = delete;   ///< no instances of SimulationPolicy
+    ~SimulationPolicy() = delete;  ///< no instances of SimulationPolicy
+
+    /**
+     * @brief Choose the ranks to meld.
+     * @param view The current player's view.
+     * @param priorityRank Rank of the discard pile top card just taken, melded first to honor the commitment.
+     */
+    static MeldPlan planMelds(const PolicyView& view, std::optional<Rank> priorityRank);
+
+    /**
+     * @brief Choose the card to discard: black threes, then lone naturals, then other naturals, then wild cards;
+     * the most expensive card first within a group.
+     * @return The cardKindIndex of the card.
+     */
+    static std::size_t chooseDiscard(const PolicyView& view);
+};
+
+/**
+ * @class SimulationRules
+ * @brief The RuleEngine checks for the actions simulated players can make, on card counts.
+ * @details Shared by BatchSimulator and EndgameSolver. ScalarSimulator goes through the real RuleEngine,
+ * and `canasta_simulator --verify` checks that both give the same rounds.
+ */
+class SimulationRules {
+public:
+    SimulationRules() = delete;   ///< no instances of SimulationRules
+    ~SimulationRules() = delete;  ///< no instances of SimulationRules
+
+    /**
+     * @brief Check whether the discard pile can be taken from under a natural top card, as RuleEngine::checkTakingDiscardPile.
+     * @param topNaturalsInHand Naturals of the top card rank in the hand.
+     * @param topMeldSize Cards in the team meld of the top card rank, 0 if not initialized.
+     * @param hasInitialMeld Whether the team has made its initial meld.
+     * @param pileFrozen Whether the pile is frozen.
+     */
+    static bool canTakeDiscardPile(std::size_t topNaturalsInHand, std::size_t topMeldSize,
+        bool hasInitialMeld, bool pileFrozen);
+
+    /**
+     * @brief Check a meld plan as TurnManager would: meld sizes, the initial meld threshold (for a team with no
+     * score yet), the commitment made by taking the pile, and keeping a card to discard unless going out.
+     * @param view The view of the player, with the taken pile already in the hand.
+     * @param takenRank Rank of the pile top card taken this turn, if any.
+     * @param pileFrozen Whether the pile was frozen when taken.
+     */
+    static bool isValidMeldPlan(const PolicyView& view, MeldPlan plan, std::optional<Rank> takenRank, bool pileFrozen);
+};
+
+/**
+ * @class StateDigest
+ * @brief FNV style digest of the final state of a round, fed the same values in the same order by both simulators.
+ * @details Values are mixed in whole rather than byte by byte; it only has to tell states apart, not resist attacks.
+ */
+class StateDigest {
+public:
+    void add(std::uint64_t value) {
+        hash = (hash ^ value) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    std::uint64_t value() const { return hash; }
+
+private:
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+};
+
+#endif // SIMULATION_HPP
@@ -0,0 +1,131 @@
+#ifndef VEC_ENV_HPP
+#define VEC_ENV_HPP
+
+#include <atomic>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+#include "simulator/endgame_solver.hpp"
+
+/**
+ * @brief Number of discard choices of an action: every card kind, or none when going out.
+ */
+constexpr std::size_t VEC_ENV_DISCARD_CHOICES = CARD_KIND_COUNT + 1;
+/**
+ * @brief Size of the action space: draw or take the pile, meld nothing or what the policy would meld, then the discard.
+ */
+constexpr std::size_t VEC_ENV_ACTION_COUNT = 2 * 2 * VEC_ENV_DISCARD_CHOICES;
+/**
+ * @brief Floats in the observation of one table, laid out as in VecEnv::encodeObservation.
+ */
+constexpr std::size_t VEC_ENV_OBSERVATION_SIZE = CARD_KIND_COUNT + 2 * RANK_MELD_COUNT + 2 + 2
+    + VEC_ENV_DISCARD_CHOICES + 1 + (SIMULATION_MAX_PLAYERS - 1) + 2;
+
+/**
+ * @struct VecEnvOptions
+ * @brief Shape of a VecEnv.
+ */
+struct VecEnvOptions {
+    std::size_t playerCount = 2;  ///< Players per table, 2 or 4
+    std::size_t envCount = 1;     ///< Independent tables stepped together
+    std::size_t threadCount = 1;  ///< Threads stepping the tables, the calling thread included
+    std::uint32_t seed = 1;       ///< Seed of the first deal; every round of every table gets its own seed
+};
+
+/**
+ * @struct VecEnvBuffers
+ * @brief Caller-owned buffers the environment writes into, one row per table.
+ * @details Bound once at construction, so a step does not allocate and other languages can share the memory.
+ */
+struct VecEnvBuffers {
+    std::span<float> observations;        ///< envCount x VEC_ENV_OBSERVATION_SIZE, seen by the player to move
+    std::span<std::int8_t> actionMasks;   ///< envCount x VEC_ENV_ACTION_COUNT, 1 for the legal actions
+    std::span<float> rewards;             ///< envCount, for the team of the player who made the last action
+    std::span<std::uint8_t> dones;        ///< envCount, 1 when the last action ended the round
+    std::span<std::uint8_t> players;      ///< envCount, seat of the player to move
+};
+
+/**
+ * @class VecEnv
+ * @brief Many Canasta tables stepped in lockstep, for training policies offline.
+ * @details Each table is an EndgameState played from a dealt round, so the actions are the whole turns of
+ * EndgameSolver: draw or take the pile, meld nothing or what SimulationPolicy would meld, then discard. An action
+ * index is (takePile * 2 + melds) * VEC_ENV_DISCARD_CHOICES + discard. The reward is the change of the round score
+ * difference for the team that acted, in hundreds of points. A finished round is dealt again at once, so after a
+ * step that ends it the row already holds the first observation of the next round.
+ * Extra threads each step a contiguous range of tables and meet the calling thread at a barrier twice per step.
+ */
+class VecEnv {
+public:
+    /**
+     * @brief Constructor for VecEnv; starts the threads and deals every table.
+     * @throws std::invalid_argument if the player count is not 2 or 4, or a buffer has the wrong size.
+     */
+    VecEnv(VecEnvOptions options, VecEnvBuffers buffers);
+    ~VecEnv();
+
+    VecEnv(const VecEnv&) = delete;
+    VecEnv& operator=(const VecEnv&) = delete;
+
+    /**
+     * @brief Deal a new round on every table and write the first observations; rewards and dones are cleared.
+     */
+    void reset();
+
+    /**
+     * @brief Play one action on every table.
+     * @param actions One action index per table; an action that is not legal is replaced by the first legal one.
+     */
+    void step(std::span<const std::uint32_t> actions);
+
+    /**
+     * @brief Get the action index of a move, as listed by EndgameState::generateMoves.
+     */
+    static std::size_t actionIndex(const EndgameMove& move);
+
+    /**
+     * @brief Write the observation of the player to move.
+     * @details Hand by card kind; meld sizes of the own team then the other; red threes of both; deck and
+     * pile sizes; pile top as one-hot over the card kinds and empty; frozen flag; hand sizes of the next
+     * players in turn order; round scores of both teams in hundreds of points.
+     */
+    static void encodeObservation(const EndgameState& state, std::span<float, VEC_ENV_OBSERVATION_SIZE> observation);
+
+    /**
+     * @brief Get the number of actions replaced because they were not legal, since the construction.
+     */
+    std::uint64_t getIllegalActionCount() const { return illegalActions.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @brief A table: the round being played and its legal moves by action index.
+     */
+    struct Table {
+        EndgameState state;
+        EndgameMoveList moves;
+        std::array<std::uint8_t, VEC_ENV_ACTION_COUNT> moveOfAction{}; ///< Index in moves, ENDGAME_MAX_MOVES if illegal
+        std::uint32_t rounds = 0;   ///< Rounds dealt on the table, for the seeds
+        std::uint32_t turns = 0;    ///< Turns of the current round
+    };
+
+    VecEnvOptions options;
+    VecEnvBuffers buffers;
+    std::vector<Table> tables;
+    std::span<const std::uint32_t> pendingActions;
+    std::atomic<std::uint64_t> illegalActions{0};
+    bool stopping = false;
+    std::unique_ptr<std::barrier<>> barrier;
+    std::vector<std::jthread> workers;
+
+    void work(std::size_t worker);
+    void stepRange(std::size_t worker);
+    void deal(std::size_t index);
+    void publish(std::size_t index);
+    void stepTable(std::size_t index, std::uint32_t action);
+};
+
+#endif // VEC_ENV_HPP
@@ -0,0 +1,42 @@
+#ifndef VEC_ENV_C_H
+#define VEC_ENV_C_H
+
+/*
+ * C interface of VecEnv, for bindings in other languages (e.g. Python ctypes with NumPy arrays).
+ * The buffers are owned by the caller and written in place by every call, so no data is copied.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CanastaVecEnv CanastaVecEnv;
+
+/* Floats in the observation of one table. */
+size_t canasta_vec_env_observation_size(void);
+/* Number of action indices of one table. */
+size_t canasta_vec_env_action_count(void);
+
+/*
+ * Create the environment and deal every table. Buffers hold env_count rows: observations of
+ * canasta_vec_env_observation_size() floats, action masks of canasta_vec_env_action_count() bytes,
+ * and one reward, done flag and seat to move per table. Returns NULL if the arguments are invalid.
+ */
+CanastaVecEnv* canasta_vec_env_create(size_t player_count, size_t env_count, size_t thread_count, uint32_t seed,
+    float* observations, int8_t* action_masks, float* rewards, uint8_t* dones, uint8_t* players);
+/* Deal every table again. */
+void canasta_vec_env_reset(CanastaVecEnv* env);
+/* Play one action per table, env_count indices. */
+void canasta_vec_env_step(CanastaVecEnv* env, const uint32_t* actions);
+/* Actions replaced because they were not legal. */
+uint64_t canasta_vec_env_illegal_actions(const CanastaVecEnv* env);
+void canasta_vec_env_destroy(CanastaVecEnv* env);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VEC_ENV_C_H */
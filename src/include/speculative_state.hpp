@@ -0,0 +1,224 @@
+#ifndef SPECULATIVE_STATE_HPP
+#define SPECULATIVE_STATE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "card.hpp"
+#include "hand.hpp"
+#include "meld.hpp"
+#include "client_deck.hpp"
+#include "team_round_state.hpp"
+
+/**
+ * @class SpeculativeState
+ * @brief A what-if overlay over a hand, the melds of its team and the deck, which are never modified while staging.
+ * @details Staged changes are checked with the same meld rules as BaseMeld::checkInitialization and
+ * BaseMeld::checkCardsAddition, but on card counts, and queries (points, canastas, going out) read the counts.
+ * discard() drops every staged change and commit() applies them to the real hand and melds, both in
+ * O(changes), so a bot can try thousands of melds per millisecond from one snapshot.
+ * Cards staged with a MeldProof from the real meld skip the rule checks, and commit() hands the proof to the meld,
+ * as long as the rank has no other staged change; otherwise the counts are checked as without a proof.
+ * The deck is only a view (ClientDeck): committing leaves the real deck to the caller's own action.
+ * Turn rules (initial meld threshold, discard pile commitment) stay with RuleEngine and TurnManager.
+ */
+class SpeculativeState {
+public:
+    /**
+     * @brief Take a snapshot of the hand, the team melds and the deck, in O(cards).
+     */
+    SpeculativeState(const Hand& hand, const TeamRoundState& teamRoundState, const ClientDeck& deck = {});
+
+    // --- Staging ---
+
+    /**
+     * @brief Stage the initialization of the meld of a rank (Four to Ace) with cards from the hand.
+     */
+    Status stageMeldInitialization(Rank rank, std::span<const Card> cards);
+
+    /**
+     * @brief Stage the initialization of the meld of a rank with cards checked by that meld.
+     * @param proof The proof BaseMeld::checkInitialization returned for these cards; they must stay alive until commit(), which applies them.
+     */
+    Status stageMeldInitialization(Rank rank, std::span<const Card> cards, const MeldProof& proof);
+
+    /**
+     * @brief Stage the addition of cards from the hand to the meld of a rank, initialized or staged.
+     */
+    Status stageMeldAddition(Rank rank, std::span<const Card> cards);
+
+    /**
+     * @brief Stage the addition of cards checked by the meld of a rank.
+     * @param proof The proof BaseMeld::checkCardsAddition returned for these cards; they must stay alive until commit(), which applies them.
+     */
+    Status stageMeldAddition(Rank rank, std::span<const Card> cards, const MeldProof& proof);
+
+    /**
+     * @brief Stage the Black Three meld with cards from the hand.
+     */
+    Status stageBlackThreeMeld(std::span<const Card> cards);
+
+    /**
+     * @brief Stage the Black Three meld with cards checked by that meld.
+     * @param proof The proof BaseMeld::checkInitialization returned for these cards; they must stay alive until commit(), which applies them.
+     */
+    Status stageBlackThreeMeld(std::span<const Card> cards, const MeldProof& proof);
+
+    /**
+     * @brief Stage a card drawn from the main deck into the hand.
+     */
+    Status stageDraw(const Card& card);
+
+    /**
+     * @brief Stage taking the discard pile, whose cards are given by the caller, into the hand.
+     */
+    Status stageTakeDiscardPile(std::span<const Card> pileCards);
+
+    /**
+     * @brief Stage discarding a card from the hand.
+     */
+    Status stageDiscard(const Card& card);
+
+    /**
+     * @brief Drop every staged change, back to the snapshot.
+     */
+    void discard();
+
+    /**
+     * @brief Apply the staged hand and meld changes to the objects of the snapshot, then take them as the new snapshot.
+     * @details Melds are initialized first, then added to (reversible, so the turn can still be reverted), then the
+     * Black Three meld; the hand gets its cards after. Staged deck actions are not applied to any deck.
+     * @param hand The hand the state was built from.
+     * @param teamRoundState The team state the state was built from.
+     */
+    void commit(Hand& hand, TeamRoundState& teamRoundState);
+
+    // --- Queries ---
+
+    /**
+     * @brief Get the number of cards in the hand.
+     */
+    std::size_t handSize() const { return current.handSize; }
+
+    /**
+     * @brief Get the number of copies of a card in the hand.
+     */
+    std::size_t countInHand(const Card& card) const { return current.hand[cardKindIndex(card)]; }
+
+    /**
+     * @brief Check whether the meld of a rank (Four to Ace) is initialized.
+     */
+    bool isMeldInitialized(Rank rank) const { return rankMeld(rank).initialized; }
+
+    /**
+     * @brief Get the number of cards in the meld of a rank, 0 if not initialized.
+     */
+    std::size_t meldSize(Rank rank) const { return rankMeld(rank).naturals + rankMeld(rank).wilds; }
+
+    /**
+     * @brief Get the canasta type of the meld of a rank, nullopt if it is not a canasta.
+     */
+    std::optional<CanastaType> canastaType(Rank rank) const;
+
+    /**
+     * @brief Get the points of the meld of a rank, canasta bonus included, as BaseMeld::getPoints.
+     */
+    int meldPoints(Rank rank) const;
+
+    /**
+     * @brief Get the points of every meld but the red threes, as TeamRoundState::calculateMeldPoints.
+     */
+    int totalMeldPoints() const;
+
+    /**
+     * @brief Get the number of canastas of the team.
+     */
+    std::size_t canastaCount() const;
+
+    /**
+     * @brief Check whether the team has initialized a rank meld.
+     */
+    bool hasInitialRankMeld() const;
+
+    /**
+     * @brief Check whether the player could go out with the hand as staged, as RuleEngine::canGoingOut.
+     */
+    bool canGoOut() const;
+
+    /**
+     * @brief Get the deck as staged.
+     */
+    const ClientDeck& getDeck() const { return current.deck; }
+
+    /**
+     * @brief Get the number of staged changes.
+     */
+    std::size_t stagedChangeCount() const { return changes.size(); }
+
+private:
+    static constexpr std::size_t RANK_MELD_COUNT = static_cast<std::size_t>(Rank::Ace) - static_cast<std::size_t>(Rank::Four) + 1;
+
+    /**
+     * @brief Card counts of a rank meld.
+     */
+    struct MeldCounts {
+        std::uint8_t naturals = 0;
+        std::uint8_t wilds = 0;
+        int cardPoints = 0;        ///< Points of the cards, without the canasta bonus
+        bool initialized = false;
+    };
+
+    /**
+     * @brief Everything the queries read; small and trivially copyable, so dropping the changes is one copy.
+     */
+    struct Counts {
+        std::array<std::uint8_t, CARD_KIND_COUNT> hand{};
+        std::size_t handSize = 0;
+        std::array<MeldCounts, RANK_MELD_COUNT> rankMelds{};
+        std::uint8_t blackThrees = 0;
+        int blackThreePoints = 0;
+        ClientDeck deck;
+    };
+
+    /**
+     * @brief A staged change of one card, replayed by commit().
+     */
+    struct Change {
+        enum class Type : std::uint8_t { MeldInitialization, MeldAddition, BlackThreeMeld, HandAddition, HandRemoval };
+        Type type;
+        Card card;
+        Rank rank = Rank::Joker;   ///< Rank of the meld, for the meld changes
+    };
+
+    /**
+     * @brief Proofs of the staged meld changes, for the ranks with a single staged change.
+     */
+    struct Proofs {
+        std::array<std::optional<MeldProof>, RANK_MELD_COUNT> initializations;
+        std::array<std::optional<MeldProof>, RANK_MELD_COUNT> additions;
+        std::optional<MeldProof> blackThrees;
+        std::uint16_t stagedRanks = 0;   ///< Bit per rank meld with a staged change
+    };
+
+    const Hand* baseHand;
+    const TeamRoundState* baseTeamRoundState;
+    Counts base;
+    Counts current;
+    std::vector<Change> changes;
+    Proofs proofs;
+
+    const MeldCounts& rankMeld(Rank rank) const;
+    MeldCounts& rankMeld(Rank rank);
+    Status checkInHand(std::span<const Card> cards) const;
+    Status checkRankCards(Rank rank, std::span<const Card> cards, std::size_t naturals, std::size_t wilds) const;
+    bool acceptsProof(Rank rank, std::span<const Card> cards, const MeldProof& proof) const;
+    void markStaged(Rank rank);
+    void stageRankCards(Rank rank, std::span<const Card> cards, Change::Type type);
+    void removeFromHand(const Card& card);
+    void addToHand(const Card& card);
+};
+
+#endif // SPECULATIVE_STATE_HPP
@@ -0,0 +1,93 @@
+#ifndef TEAM_MELDS_INFO_HPP
+#define TEAM_MELDS_INFO_HPP
+
+#include <cstdint>
+#include <vector>
+#include "cereal/cereal.hpp"
+#include "cereal/archives/binary.hpp"
+#include <cereal/types/vector.hpp>
+#include "card.hpp"
+#include "meld.hpp"                 // For Status
+#include "team_round_state.hpp"
+#include "bounded_serialization.hpp"
+
+/**
+ * @class MeldPublicInfo
+ * @brief Class representing the cards of one initialized rank meld, as sent to clients.
+ */
+class MeldPublicInfo {
+private:
+    Rank rank = Rank::Four;
+    std::vector<Card> cards; ///< Natural and wild cards of the meld
+public:
+    /**
+     * @brief Default constructor for MeldPublicInfo for serialization purposes.
+     */
+    MeldPublicInfo() = default;
+    MeldPublicInfo(Rank meldRank, std::vector<Card> meldCards)
+        : rank(meldRank), cards(std::move(meldCards)) {}
+
+    Rank getRank() const { return rank; }
+    const std::vector<Card>& getCards() const { return cards; }
+
+    template <class Archive>
+    void save(Archive& ar) const {
+        ar(CEREAL_NVP(rank), CEREAL_NVP(cards));
+    }
+    // Sent by the server, but a meld still cannot hold more than the deck
+    template <class Archive>
+    void load(Archive& ar) {
+        ar(CEREAL_NVP(rank));
+        if (!isValidRank(rank))
+            throw cereal::Exception("Invalid meld rank");
+        loadBoundedVector(ar, cards, MAX_DECODED_CARDS);
+    }
+};
+
+/**
+ * @class TeamMeldsInfo
+ * @brief Class representing the melds of a team as sent to clients.
+ * @details Only what a client can see: the cards of the initialized rank melds and the number of
+ * red and black threes, which are all alike. Uninitialized melds, points, canasta flags and the
+ * backups kept to revert a pile take stay on the server; the client rebuilds a TeamRoundState
+ * with restore(), which recomputes the rest.
+ */
+class TeamMeldsInfo {
+private:
+    std::uint8_t redThreeCount = 0;   ///< Cards in the Red Three meld
+    std::uint8_t blackThreeCount = 0; ///< Cards in the Black Three meld (only when going out)
+    std::vector<MeldPublicInfo> rankMelds; ///< Initialized rank melds, by ascending rank
+public:
+    /**
+     * @brief Default constructor for TeamMeldsInfo for serialization purposes.
+     */
+    TeamMeldsInfo() = default;
+    /**
+     * @brief Take the visible part of the melds of a team.
+     */
+    explicit TeamMeldsInfo(const TeamRoundState& teamState);
+
+    std::size_t getRedThreeCount() const { return redThreeCount; }
+    std::size_t getBlackThreeCount() const { return blackThreeCount; }
+    const std::vector<MeldPublicInfo>& getRankMelds() const { return rankMelds; }
+
+    /**
+     * @brief Reset the team state and initialize its melds with these cards.
+     * @details Every meld goes through the rule checks, so the state is consistent (points,
+     * canasta flags, hashes) or the melds are refused.
+     * @return An error naming the meld that does not hold, in which case the state is left partly filled.
+     */
+    Status restore(TeamRoundState& teamState) const;
+
+    template <class Archive>
+    void save(Archive& ar) const {
+        ar(CEREAL_NVP(redThreeCount), CEREAL_NVP(blackThreeCount), CEREAL_NVP(rankMelds));
+    }
+    template <class Archive>
+    void load(Archive& ar) {
+        ar(CEREAL_NVP(redThreeCount), CEREAL_NVP(blackThreeCount));
+        loadBoundedVector(ar, rankMelds, MAX_DECODED_RANK_MELDS);
+    }
+};
+
+#endif // TEAM_MELDS_INFO_HPP
@@ -89,6 +89,12 @@ public:
      */
     const BaseMeld* getRedThreeMeld() const;
 
+    /**
+     * @brief Get the Zobrist hash of the team's melds.
+     * @details Combines the hashes the melds keep up to date, each at the place of its rank.
+     */
+    std::uint64_t getHash() const;
+
     /**
      * @brief Reset the state of the team round.
      * @details This function clears all melds and resets the state.
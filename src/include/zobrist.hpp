@@ -0,0 +1,110 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "card.hpp"
+
+constexpr std::size_t ZOBRIST_MAX_COPIES = 4; ///< Most copies of one card kind in the 108-card deck
+
+/**
+ * @brief Mixes all the bits of a 64-bit value (splitmix64 finalizer).
+ */
+constexpr std::uint64_t zobristMix(std::uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Random keys of the copies of every card kind, indexed by [kind * ZOBRIST_MAX_COPIES + copy].
+ * @details Generated at compile time, so every build of the client and the server uses the same keys.
+ */
+constexpr std::array<std::uint64_t, CARD_KIND_COUNT * ZOBRIST_MAX_COPIES> ZOBRIST_CARD_KEYS = [] {
+    std::array<std::uint64_t, CARD_KIND_COUNT * ZOBRIST_MAX_COPIES> keys{};
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        keys[i] = zobristMix(0x9e3779b97f4a7c15ULL * (i + 1));
+    return keys;
+}();
+
+/**
+ * @enum ZobristPlace
+ * @brief Where a part of the round state lies, so equal parts in different places hash differently.
+ */
+enum class ZobristPlace : std::uint64_t {
+    Hand,           // Index: seat of the player
+    Team,           // Index: team of the melds
+    Meld,           // Index: position of the meld in the TeamRoundState
+    DiscardPile,
+    DiscardTop,     // Value: kind of the top card, CARD_KIND_COUNT if the pile is empty
+    DiscardFrozen,
+    MainDeckSize,
+    CurrentPlayer   // Value: seat of the player
+};
+
+/**
+ * @brief Hash of a value (a card set hash, a size, a seat) at a given place of the round state.
+ * @details The hashes of the places are XORed together into the hash of the state.
+ */
+constexpr std::uint64_t zobristPlace(ZobristPlace place, std::uint64_t index, std::uint64_t value) {
+    return zobristMix(value ^ zobristMix((static_cast<std::uint64_t>(place) << 32 | index) + 1));
+}
+
+/**
+ * @class CardMultisetHash
+ * @brief Zobrist hash of a set of cards, where a card may appear several times.
+ * @details The n-th copy of a card kind XORs its own key, so adding and removing a card are O(1)
+ * and the hash only depends on how many copies of each kind are in the set, not on their order.
+ */
+class CardMultisetHash {
+public:
+    CardMultisetHash() = default;
+
+    /**
+     * @brief Hash of the given cards, computed from scratch.
+     */
+    template <class Cards>
+    explicit CardMultisetHash(const Cards& cards) {
+        for (const auto& card : cards)
+            add(card);
+    }
+
+    /**
+     * @brief Account for one more copy of the card.
+     */
+    void add(const Card& card) {
+        std::size_t kind = cardKindIndex(card);
+        hash ^= key(kind, counts[kind]++);
+    }
+
+    /**
+     * @brief Account for one copy less of the card; the card must be in the set.
+     */
+    void remove(const Card& card) {
+        std::size_t kind = cardKindIndex(card);
+        hash ^= key(kind, --counts[kind]);
+    }
+
+    /**
+     * @brief Empty the set.
+     */
+    void clear() { *this = CardMultisetHash(); }
+
+    /**
+     * @brief Get the hash, 0 for an empty set.
+     */
+    std::uint64_t value() const { return hash; }
+
+private:
+    static std::uint64_t key(std::size_t kind, std::uint8_t copy) {
+        return ZOBRIST_CARD_KEYS[kind * ZOBRIST_MAX_COPIES + copy % ZOBRIST_MAX_COPIES];
+    }
+
+    std::array<std::uint8_t, CARD_KIND_COUNT> counts{}; ///< Copies of every card kind
+    std::uint64_t hash = 0;
+};
+
+#endif // ZOBRIST_HPP
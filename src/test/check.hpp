@@ -0,0 +1,43 @@
+#ifndef TEST_CHECK_HPP
+#define TEST_CHECK_HPP
+
+// Minimal checks for the CTest executables: a failed check is reported and the test exits non-zero.
+#include <exception>
+#include <iostream>
+
+namespace test {
+    inline int failures = 0;
+
+    inline int result() {
+        if (failures > 0)
+            std::cerr << failures << " check(s) failed" << std::endl;
+        return failures > 0 ? 1 : 0;
+    }
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++test::failures; \
+        } \
+    } while (false)
+
+// Checks that the statement throws an exception of the given type
+#define CHECK_THROWS(ExceptionType, statement) \
+    do { \
+        bool thrown = false; \
+        try { \
+            statement; \
+        } catch (const ExceptionType&) { \
+            thrown = true; \
+        } catch (const std::exception& e) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": unexpected exception: " << e.what() << std::endl; \
+        } \
+        if (!thrown) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected " #ExceptionType " from: " #statement << std::endl; \
+            ++test::failures; \
+        } \
+    } while (false)
+
+#endif // TEST_CHECK_HPP
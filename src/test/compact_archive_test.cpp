@@ -0,0 +1,122 @@
+// Deterministic checks of the compact archive: varint and zigzag round trips at the boundaries,
+// and the rejection of malformed input (truncated or overlong varints, out of range values, bad bools).
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include "compact_archive.hpp"
+#include "check.hpp"
+
+namespace {
+    template <class T>
+    std::string encode(const T& value) {
+        std::ostringstream os(std::ios::binary);
+        {
+            cereal::CompactOutputArchive archive(os);
+            archive(value);
+        }
+        return os.str();
+    }
+
+    template <class T>
+    T decode(const std::string& bytes) {
+        std::istringstream is(bytes, std::ios::binary);
+        cereal::CompactInputArchive archive(is);
+        T value{};
+        archive(value);
+        return value;
+    }
+
+    // Checks that the value comes back unchanged and took the expected number of bytes
+    template <class T>
+    void checkRoundTrip(T value, std::size_t expectedSize) {
+        std::string bytes = encode(value);
+        CHECK(bytes.size() == expectedSize);
+        CHECK(decode<T>(bytes) == value);
+    }
+
+    std::string bytesOf(std::initializer_list<unsigned char> bytes) {
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    void testUnsignedBoundaries() {
+        checkRoundTrip<std::uint64_t>(0, 1);
+        checkRoundTrip<std::uint64_t>(127, 1);
+        checkRoundTrip<std::uint64_t>(128, 2);
+        checkRoundTrip<std::uint64_t>(16383, 2);
+        checkRoundTrip<std::uint64_t>(16384, 3);
+        checkRoundTrip<std::uint64_t>(std::numeric_limits<std::uint64_t>::max(), 10);
+        checkRoundTrip<std::uint32_t>(std::numeric_limits<std::uint32_t>::max(), 5);
+        checkRoundTrip<std::uint16_t>(std::numeric_limits<std::uint16_t>::max(), 3);
+        CHECK(encode<std::uint64_t>(128) == bytesOf({0x80, 0x01}));
+        CHECK(encode<std::uint64_t>(300) == bytesOf({0xAC, 0x02}));
+    }
+
+    void testSignedBoundaries() {
+        CHECK(cereal::compact_detail::zigzagEncode(0) == 0);
+        CHECK(cereal::compact_detail::zigzagEncode(-1) == 1);
+        CHECK(cereal::compact_detail::zigzagEncode(1) == 2);
+        CHECK(cereal::compact_detail::zigzagEncode(std::numeric_limits<std::int64_t>::max()) ==
+            std::numeric_limits<std::uint64_t>::max() - 1);
+        CHECK(cereal::compact_detail::zigzagEncode(std::numeric_limits<std::int64_t>::min()) ==
+            std::numeric_limits<std::uint64_t>::max());
+        checkRoundTrip<std::int64_t>(0, 1);
+        checkRoundTrip<std::int64_t>(-1, 1);
+        checkRoundTrip<std::int64_t>(63, 1);
+        checkRoundTrip<std::int64_t>(-64, 1);
+        checkRoundTrip<std::int64_t>(64, 2);
+        checkRoundTrip<std::int64_t>(-65, 2);
+        checkRoundTrip<std::int64_t>(std::numeric_limits<std::int64_t>::max(), 10);
+        checkRoundTrip<std::int64_t>(std::numeric_limits<std::int64_t>::min(), 10);
+        checkRoundTrip<std::int32_t>(std::numeric_limits<std::int32_t>::min(), 5);
+        checkRoundTrip<std::int16_t>(std::numeric_limits<std::int16_t>::max(), 3);
+    }
+
+    void testBytesAndContainers() {
+        // Single bytes are copied as they are
+        checkRoundTrip<std::uint8_t>(255, 1);
+        checkRoundTrip<std::int8_t>(-128, 1);
+        checkRoundTrip<bool>(true, 1);
+        checkRoundTrip<bool>(false, 1);
+        std::string text(200, 'x'); // The size takes two bytes
+        CHECK(encode(text).size() == 2 + text.size());
+        CHECK(decode<std::string>(encode(text)) == text);
+        std::vector<int> numbers{0, -1, 1000, std::numeric_limits<int>::min()};
+        CHECK(decode<std::vector<int>>(encode(numbers)) == numbers);
+    }
+
+    void testMalformedInput() {
+        CHECK_THROWS(cereal::Exception, decode<std::uint64_t>(""));
+        CHECK_THROWS(cereal::Exception, decode<std::uint64_t>(bytesOf({0x80})));
+        CHECK_THROWS(cereal::Exception, decode<std::uint64_t>(bytesOf({0xFF, 0xFF, 0xFF})));
+        // The tenth byte only carries bit 63
+        std::string topBit(9, static_cast<char>(0x80));
+        topBit += static_cast<char>(0x01);
+        CHECK(decode<std::uint64_t>(topBit) == std::uint64_t{1} << 63);
+        std::string tooWide(9, static_cast<char>(0x80));
+        tooWide += static_cast<char>(0x02);
+        CHECK_THROWS(cereal::Exception, decode<std::uint64_t>(tooWide));
+        std::string overlong(11, static_cast<char>(0x80));
+        CHECK_THROWS(cereal::Exception, decode<std::uint64_t>(overlong));
+        // Values that do not fit the field read
+        CHECK_THROWS(cereal::Exception, decode<std::uint16_t>(encode<std::uint32_t>(70000)));
+        CHECK_THROWS(cereal::Exception, decode<std::int16_t>(encode<std::int32_t>(-40000)));
+        CHECK_THROWS(cereal::Exception, decode<std::int32_t>(encode(std::numeric_limits<std::int64_t>::min())));
+        // Bools other than 0 or 1
+        CHECK_THROWS(cereal::Exception, decode<bool>(bytesOf({0x02})));
+        CHECK_THROWS(cereal::Exception, decode<bool>(bytesOf({0xFF})));
+        // A container announcing more elements than it holds
+        CHECK_THROWS(cereal::Exception, decode<std::string>(bytesOf({0x05, 'a', 'b'})));
+    }
+}
+
+int main() {
+    testUnsignedBoundaries();
+    testSignedBoundaries();
+    testBytesAndContainers();
+    testMalformedInput();
+    return test::result();
+}
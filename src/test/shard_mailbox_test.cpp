@@ -0,0 +1,153 @@
+// Deterministic checks of the queues between shards: SpscQueue wrap-around and ordering, on one
+// thread and between two, and ShardMailbox keeping tasks in order while they spill over.
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "server/sharded_server.hpp"
+#include "check.hpp"
+
+namespace {
+    constexpr std::size_t BURSTS = 50;
+    constexpr std::size_t BURST_SIZE = 3 * SHARD_MAILBOX_CAPACITY; // Spills over on every burst
+
+    void testWrapAround() {
+        SpscQueue<std::shared_ptr<int>, 4> queue;
+        auto tracked = std::make_shared<int>(0);
+        int next = 0;
+        int expected = 0;
+        // Three elements in and out per round, so the indexes wrap many times around the four slots
+        for (int round = 0; round < 10; ++round) {
+            for (int i = 0; i < 3; ++i)
+                CHECK(queue.tryPush(std::make_shared<int>(next++)));
+            std::shared_ptr<int> value;
+            for (int i = 0; i < 3; ++i) {
+                CHECK(queue.tryPop(value));
+                CHECK(value && *value == expected++);
+            }
+            CHECK(!queue.tryPop(value));
+        }
+
+        // Full: the value pushed is left to the caller
+        for (int i = 0; i < 4; ++i)
+            CHECK(queue.tryPush(std::make_shared<int>(i)));
+        auto rejected = tracked;
+        CHECK(!queue.tryPush(std::move(rejected)));
+        CHECK(rejected == tracked);
+
+        // A popped slot lets go of its element
+        std::shared_ptr<int> value;
+        while (queue.tryPop(value)) {}
+        CHECK(queue.tryPush(std::move(rejected)));
+        CHECK(queue.tryPop(value));
+        value.reset();
+        CHECK(tracked.use_count() == 1);
+    }
+
+    void testTwoThreads() {
+        constexpr std::uint64_t COUNT = 1'000'000;
+        SpscQueue<std::uint64_t, 8> queue;
+        std::thread producer([&queue] {
+            for (std::uint64_t i = 1; i <= COUNT; ++i) {
+                std::uint64_t value = i;
+                while (!queue.tryPush(std::move(value)))
+                    std::this_thread::yield();
+            }
+        });
+        std::uint64_t expected = 1;
+        bool ordered = true;
+        while (expected <= COUNT) {
+            std::uint64_t value = 0;
+            if (!queue.tryPop(value)) {
+                std::this_thread::yield();
+                continue;
+            }
+            ordered = ordered && value == expected;
+            ++expected;
+        }
+        producer.join();
+        CHECK(ordered);
+        std::uint64_t value = 0;
+        CHECK(!queue.tryPop(value));
+    }
+
+    // Runs the handlers ready on both contexts until neither has any left
+    void runUntilIdle(asio::io_context& producerContext, asio::io_context& consumerContext) {
+        for (std::size_t handled = 1; handled > 0;) {
+            producerContext.restart();
+            consumerContext.restart();
+            handled = producerContext.poll() + consumerContext.poll();
+        }
+    }
+
+    void testMailboxSendBehindOverflow() {
+        // Both ends on this thread, so the consumer makes room exactly between the sends below
+        asio::io_context producerContext(1);
+        asio::io_context consumerContext(1);
+        ShardMailbox mailbox(producerContext, consumerContext);
+        std::vector<std::size_t> received;
+        std::size_t sent = 0;
+        auto sendNext = [&] {
+            mailbox.send([&received, sequence = sent++] { received.push_back(sequence); });
+        };
+        for (std::size_t i = 0; i < SHARD_MAILBOX_CAPACITY + 10; ++i)
+            sendNext(); // The last ten wait in the overflow
+        consumerContext.poll(); // The queue is emptied, the overflow is not flushed yet
+        sendNext(); // Room in the queue, but it must still go behind the overflow
+        runUntilIdle(producerContext, consumerContext);
+
+        CHECK(received.size() == sent);
+        bool ordered = true;
+        for (std::size_t i = 0; i < received.size(); ++i)
+            ordered = ordered && received[i] == i;
+        CHECK(ordered);
+    }
+
+    void testMailboxOverflowOrder() {
+        asio::io_context producerContext(1);
+        asio::io_context consumerContext(1);
+        auto producerWork = asio::make_work_guard(producerContext);
+        auto consumerWork = asio::make_work_guard(consumerContext);
+        ShardMailbox mailbox(producerContext, consumerContext);
+
+        std::vector<std::size_t> received; // Only touched by the consumer
+        std::promise<void> done;
+        std::thread consumer([&consumerContext] { consumerContext.run(); });
+        std::thread producer([&producerContext] { producerContext.run(); });
+
+        // Every burst is sent from its own handler, so the overflow flushes run in between
+        for (std::size_t burst = 0; burst < BURSTS; ++burst) {
+            asio::post(producerContext, [&, burst] {
+                for (std::size_t i = 0; i < BURST_SIZE; ++i) {
+                    std::size_t sequence = burst * BURST_SIZE + i;
+                    mailbox.send([&received, &done, sequence] {
+                        received.push_back(sequence);
+                        if (sequence == BURSTS * BURST_SIZE - 1)
+                            done.set_value();
+                    });
+                }
+            });
+        }
+        done.get_future().wait();
+        producerWork.reset();
+        consumerWork.reset();
+        producer.join();
+        consumer.join();
+
+        CHECK(received.size() == BURSTS * BURST_SIZE);
+        bool ordered = true;
+        for (std::size_t i = 0; i < received.size(); ++i)
+            ordered = ordered && received[i] == i;
+        CHECK(ordered);
+    }
+}
+
+int main() {
+    testWrapAround();
+    testTwoThreads();
+    testMailboxSendBehindOverflow();
+    testMailboxOverflowOrder();
+    return test::result();
+}